@@ -0,0 +1,211 @@
+#include "hal/unix/FlashFileUnix.hpp"
+#include "infra/event/EventDispatcher.hpp"
+#include "infra/util/ReallyAssert.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace hal
+{
+    namespace
+    {
+        uint32_t NumberOfPages(infra::ConstByteRange buffer, uint32_t address, uint32_t pageSize)
+        {
+            return (address % pageSize + buffer.size() + pageSize - 1) / pageSize;
+        }
+
+        uint32_t FlashSize(uint32_t numberOfSectors, uint32_t sizeOfEachSector)
+        {
+            // Flash is addressed with 32 bits, so images of 4 GB or more cannot be represented
+            uint64_t size = static_cast<uint64_t>(numberOfSectors) * sizeOfEachSector;
+            really_assert(size <= std::numeric_limits<uint32_t>::max());
+            return static_cast<uint32_t>(size);
+        }
+    }
+
+    MemoryMappedFlashFileUnix::MemoryMappedFlashFileUnix(const std::string& path, uint32_t size, const FlashFileUnixConfig& config)
+        : config(config)
+    {
+        fileDescriptor = open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+        if (fileDescriptor == -1)
+            throw std::runtime_error("Could not open flash file " + path + ": " + strerror(errno));
+
+        struct stat status;
+        if (fstat(fileDescriptor, &status) == -1 || (static_cast<uint64_t>(status.st_size) < size && ftruncate(fileDescriptor, size) == -1))
+        {
+            close(fileDescriptor);
+            throw std::runtime_error("Could not size flash file " + path + ": " + strerror(errno));
+        }
+
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+        if (address == MAP_FAILED)
+        {
+            close(fileDescriptor);
+            throw std::runtime_error("Could not map flash file " + path + ": " + strerror(errno));
+        }
+
+        memory = infra::ByteRange(static_cast<uint8_t*>(address), static_cast<uint8_t*>(address) + size);
+
+        if (static_cast<uint64_t>(status.st_size) < size)
+            std::fill(memory.begin() + status.st_size, memory.end(), 0xff);
+    }
+
+    MemoryMappedFlashFileUnix::~MemoryMappedFlashFileUnix()
+    {
+        munmap(memory.begin(), memory.size());
+        close(fileDescriptor);
+    }
+
+    void MemoryMappedFlashFileUnix::Program(infra::ConstByteRange buffer, uint32_t address)
+    {
+        really_assert(address <= memory.size() && buffer.size() <= memory.size() - address);
+
+        auto size = ConsumePower(buffer.size());
+        for (std::size_t i = 0; i != size; ++i)
+        {
+            auto& byte = memory[address + i];
+            really_assert(!config.strictProgramming || (byte & buffer[i]) == buffer[i]);
+            byte &= buffer[i];
+        }
+    }
+
+    void MemoryMappedFlashFileUnix::Read(infra::ByteRange buffer, uint32_t address) const
+    {
+        really_assert(address <= memory.size() && buffer.size() <= memory.size() - address);
+        std::copy(memory.begin() + address, memory.begin() + address + buffer.size(), buffer.begin());
+    }
+
+    void MemoryMappedFlashFileUnix::Erase(uint32_t begin, uint32_t end)
+    {
+        really_assert(begin <= end && end <= memory.size());
+
+        auto size = ConsumePower(end - begin);
+        std::fill(memory.begin() + begin, memory.begin() + begin + size, 0xff);
+    }
+
+    void MemoryMappedFlashFileUnix::CutPowerAfter(uint32_t bytes)
+    {
+        powerCutArmed = true;
+        powerBudget = bytes;
+    }
+
+    bool MemoryMappedFlashFileUnix::PowerLost() const
+    {
+        return powerCutArmed && powerBudget == 0;
+    }
+
+    const FlashFileUnixConfig& MemoryMappedFlashFileUnix::Config() const
+    {
+        return config;
+    }
+
+    uint32_t MemoryMappedFlashFileUnix::ConsumePower(uint32_t bytes)
+    {
+        if (!powerCutArmed)
+            return bytes;
+
+        auto size = std::min(bytes, powerBudget);
+        powerBudget -= size;
+        return size;
+    }
+
+    FlashFileUnix::FlashFileUnix(const std::string& path, uint32_t numberOfSectors, uint32_t sizeOfEachSector, const Config& config)
+        : hal::FlashHomogeneous(numberOfSectors, sizeOfEachSector)
+        , file(path, FlashSize(numberOfSectors, sizeOfEachSector), config)
+    {}
+
+    void FlashFileUnix::CutPowerAfter(uint32_t bytes)
+    {
+        file.CutPowerAfter(bytes);
+    }
+
+    bool FlashFileUnix::PowerLost() const
+    {
+        return file.PowerLost();
+    }
+
+    void FlashFileUnix::WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+    {
+        this->onDone = onDone;
+        writeBuffer = buffer;
+        this->address = address;
+
+        // Data is programmed on completion, so that a process that stops during the latency leaves the flash unchanged
+        CompleteAfter(file.Config().programLatency * NumberOfPages(buffer, address, file.Config().pageSize), [this]()
+            {
+                file.Program(writeBuffer, this->address);
+                this->onDone(); });
+    }
+
+    void FlashFileUnix::ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+    {
+        file.Read(buffer, address);
+        this->onDone = onDone;
+        infra::EventDispatcher::Instance().Schedule([this]()
+            { this->onDone(); });
+    }
+
+    void FlashFileUnix::EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone)
+    {
+        this->onDone = onDone;
+        address = AddressOfSector(beginIndex);
+        eraseEnd = EndAddressOfSectors(endIndex);
+
+        CompleteAfter(file.Config().eraseLatency * (endIndex - beginIndex), [this]()
+            {
+                file.Erase(address, eraseEnd);
+                this->onDone(); });
+    }
+
+    void FlashFileUnix::CompleteAfter(infra::Duration latency, const infra::Function<void()>& action)
+    {
+        if (latency == infra::Duration::zero())
+            infra::EventDispatcher::Instance().Schedule(action);
+        else
+            latencyTimer.Start(latency, action);
+    }
+
+    uint32_t FlashFileUnix::EndAddressOfSectors(uint32_t endIndex) const
+    {
+        return endIndex == NumberOfSectors() ? TotalSize() : AddressOfSector(endIndex);
+    }
+
+    SynchronousFlashFileUnix::SynchronousFlashFileUnix(const std::string& path, uint32_t numberOfSectors, uint32_t sizeOfEachSector, const Config& config)
+        : hal::SynchronousFlashHomogeneous(numberOfSectors, sizeOfEachSector)
+        , file(path, FlashSize(numberOfSectors, sizeOfEachSector), config)
+    {}
+
+    void SynchronousFlashFileUnix::CutPowerAfter(uint32_t bytes)
+    {
+        file.CutPowerAfter(bytes);
+    }
+
+    bool SynchronousFlashFileUnix::PowerLost() const
+    {
+        return file.PowerLost();
+    }
+
+    void SynchronousFlashFileUnix::WriteBuffer(infra::ConstByteRange buffer, uint32_t address)
+    {
+        std::this_thread::sleep_for(file.Config().programLatency * NumberOfPages(buffer, address, file.Config().pageSize));
+        file.Program(buffer, address);
+    }
+
+    void SynchronousFlashFileUnix::ReadBuffer(infra::ByteRange buffer, uint32_t address)
+    {
+        file.Read(buffer, address);
+    }
+
+    void SynchronousFlashFileUnix::EraseSectors(uint32_t beginIndex, uint32_t endIndex)
+    {
+        std::this_thread::sleep_for(file.Config().eraseLatency * (endIndex - beginIndex));
+        file.Erase(AddressOfSector(beginIndex), endIndex == NumberOfSectors() ? TotalSize() : AddressOfSector(endIndex));
+    }
+}
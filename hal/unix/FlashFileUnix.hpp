@@ -0,0 +1,108 @@
+#ifndef HAL_FLASH_FILE_UNIX_HPP
+#define HAL_FLASH_FILE_UNIX_HPP
+
+#include "hal/interfaces/FlashHomogeneous.hpp"
+#include "hal/synchronous_interfaces/SynchronousFlashHomogeneous.hpp"
+#include "infra/timer/Timer.hpp"
+#include "infra/util/AutoResetFunction.hpp"
+#include "infra/util/ByteRange.hpp"
+#include <cstdint>
+#include <string>
+
+namespace hal
+{
+    struct FlashFileUnixConfig
+    {
+        // Programming can only clear bits; when strict, an attempt to set a bit is a programming error
+        bool strictProgramming = false;
+        // Latency per programmed page and per erased sector
+        infra::Duration programLatency = infra::Duration::zero();
+        infra::Duration eraseLatency = infra::Duration::zero();
+        uint32_t pageSize = 256;
+    };
+
+    // Flash contents in a memory mapped file, with NOR semantics: erasing sets all bytes of a sector to 0xff, and
+    // programming ANDs data into the existing contents. A file that does not yet exist, or that is too small, is extended
+    // with erased bytes. Since only touched pages are loaded, large images are opened instantly.
+    //
+    // CutPowerAfter simulates a power loss: the program or erase that crosses the given number of bytes is truncated,
+    // and subsequent programs and erases are ignored, so that recovery can be tested by opening the file again.
+    class MemoryMappedFlashFileUnix
+    {
+    public:
+        MemoryMappedFlashFileUnix(const std::string& path, uint32_t size, const FlashFileUnixConfig& config);
+        MemoryMappedFlashFileUnix(const MemoryMappedFlashFileUnix& other) = delete;
+        MemoryMappedFlashFileUnix& operator=(const MemoryMappedFlashFileUnix& other) = delete;
+        ~MemoryMappedFlashFileUnix();
+
+        void Program(infra::ConstByteRange buffer, uint32_t address);
+        void Read(infra::ByteRange buffer, uint32_t address) const;
+        void Erase(uint32_t begin, uint32_t end);
+
+        void CutPowerAfter(uint32_t bytes);
+        bool PowerLost() const;
+
+        const FlashFileUnixConfig& Config() const;
+
+    private:
+        uint32_t ConsumePower(uint32_t bytes);
+
+    private:
+        FlashFileUnixConfig config;
+        int fileDescriptor = -1;
+        infra::ByteRange memory;
+        bool powerCutArmed = false;
+        uint32_t powerBudget = 0;
+    };
+
+    class FlashFileUnix
+        : public hal::FlashHomogeneous
+    {
+    public:
+        using Config = FlashFileUnixConfig;
+
+        FlashFileUnix(const std::string& path, uint32_t numberOfSectors, uint32_t sizeOfEachSector, const Config& config = Config());
+
+        void CutPowerAfter(uint32_t bytes);
+        bool PowerLost() const;
+
+        // Implement Flash
+        virtual void WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        virtual void EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone) override;
+
+    private:
+        void CompleteAfter(infra::Duration latency, const infra::Function<void()>& action);
+        uint32_t EndAddressOfSectors(uint32_t endIndex) const;
+
+    private:
+        MemoryMappedFlashFileUnix file;
+        infra::TimerSingleShot latencyTimer;
+        infra::AutoResetFunction<void()> onDone;
+        infra::ConstByteRange writeBuffer;
+        uint32_t address = 0;
+        uint32_t eraseEnd = 0;
+    };
+
+    class SynchronousFlashFileUnix
+        : public hal::SynchronousFlashHomogeneous
+    {
+    public:
+        using Config = FlashFileUnixConfig;
+
+        SynchronousFlashFileUnix(const std::string& path, uint32_t numberOfSectors, uint32_t sizeOfEachSector, const Config& config = Config());
+
+        void CutPowerAfter(uint32_t bytes);
+        bool PowerLost() const;
+
+        // Implement SynchronousFlash
+        virtual void WriteBuffer(infra::ConstByteRange buffer, uint32_t address) override;
+        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address) override;
+        virtual void EraseSectors(uint32_t beginIndex, uint32_t endIndex) override;
+
+    private:
+        MemoryMappedFlashFileUnix file;
+    };
+}
+
+#endif
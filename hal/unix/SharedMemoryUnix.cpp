@@ -0,0 +1,69 @@
+#include "hal/unix/SharedMemoryUnix.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace hal
+{
+    SharedMemoryUnix::SharedMemoryUnix(std::size_t size)
+    {
+#ifdef EMIL_OS_DARWIN
+        std::string name = "/emil-" + std::to_string(getpid()) + "-" + std::to_string(reinterpret_cast<uintptr_t>(this));
+        fileDescriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (fileDescriptor != -1)
+            shm_unlink(name.c_str());
+#else
+        fileDescriptor = memfd_create("emil-shared-memory", 0);
+#endif
+
+        if (fileDescriptor == -1)
+            throw std::runtime_error(std::string("Could not create shared memory: ") + strerror(errno));
+
+        if (ftruncate(fileDescriptor, size) == -1)
+        {
+            close(fileDescriptor);
+            throw std::runtime_error(std::string("Could not size shared memory: ") + strerror(errno));
+        }
+
+        Map(size);
+    }
+
+    SharedMemoryUnix::SharedMemoryUnix(int fileDescriptor, std::size_t size)
+        : fileDescriptor(fileDescriptor)
+    {
+        Map(size);
+    }
+
+    SharedMemoryUnix::~SharedMemoryUnix()
+    {
+        munmap(memory.begin(), memory.size());
+        close(fileDescriptor);
+    }
+
+    infra::ByteRange SharedMemoryUnix::Memory() const
+    {
+        return memory;
+    }
+
+    int SharedMemoryUnix::FileDescriptor() const
+    {
+        return fileDescriptor;
+    }
+
+    void SharedMemoryUnix::Map(std::size_t size)
+    {
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+
+        if (address == MAP_FAILED)
+        {
+            close(fileDescriptor);
+            throw std::runtime_error(std::string("Could not map shared memory: ") + strerror(errno));
+        }
+
+        memory = infra::ByteRange(static_cast<uint8_t*>(address), static_cast<uint8_t*>(address) + size);
+    }
+}
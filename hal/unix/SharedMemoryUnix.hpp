@@ -0,0 +1,33 @@
+#ifndef HAL_SHARED_MEMORY_UNIX_HPP
+#define HAL_SHARED_MEMORY_UNIX_HPP
+
+#include "infra/util/ByteRange.hpp"
+#include <cstddef>
+
+namespace hal
+{
+    // Anonymous shared memory that can be mapped by other processes, for example by passing FileDescriptor() to a child process
+    class SharedMemoryUnix
+    {
+    public:
+        // Creates a zero-initialized shared memory object
+        explicit SharedMemoryUnix(std::size_t size);
+        // Maps a shared memory object created by another process
+        SharedMemoryUnix(int fileDescriptor, std::size_t size);
+        SharedMemoryUnix(const SharedMemoryUnix& other) = delete;
+        SharedMemoryUnix& operator=(const SharedMemoryUnix& other) = delete;
+        ~SharedMemoryUnix();
+
+        infra::ByteRange Memory() const;
+        int FileDescriptor() const;
+
+    private:
+        void Map(std::size_t size);
+
+    private:
+        int fileDescriptor{ -1 };
+        infra::ByteRange memory;
+    };
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "hal/unix/FlashFileUnix.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
+#include "infra/util/Optional.hpp"
+#include "gmock/gmock.h"
+#include <cstdio>
+
+class FlashFileUnixTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    FlashFileUnixTest()
+    {
+        std::remove(path.c_str());
+        flash.Emplace(path, 2, 16);
+    }
+
+    ~FlashFileUnixTest()
+    {
+        flash = infra::none;
+        std::remove(path.c_str());
+    }
+
+    std::vector<uint8_t> Read(uint32_t address, std::size_t size)
+    {
+        std::vector<uint8_t> result(size, 0);
+        flash->ReadBuffer(infra::MakeRange(result), address, infra::emptyFunction);
+        ExecuteAllActions();
+        return result;
+    }
+
+    void Write(const std::vector<uint8_t>& data, uint32_t address)
+    {
+        flash->WriteBuffer(infra::MakeRange(data), address, infra::emptyFunction);
+        ExecuteAllActions();
+    }
+
+    void Erase(uint32_t beginIndex, uint32_t endIndex)
+    {
+        flash->EraseSectors(beginIndex, endIndex, infra::emptyFunction);
+        ExecuteAllActions();
+    }
+
+    std::string path = testing::TempDir() + "FlashFileUnixTest_" + testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+    infra::Optional<hal::FlashFileUnix> flash;
+};
+
+TEST_F(FlashFileUnixTest, new_file_reads_as_erased)
+{
+    EXPECT_EQ(std::vector<uint8_t>(32, 0xff), Read(0, 32));
+}
+
+TEST_F(FlashFileUnixTest, programming_ands_into_existing_contents)
+{
+    Write({ 0xf0, 0x0f }, 4);
+    Write({ 0x3c, 0x3c }, 4);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0xff, 0x30, 0x0c, 0xff }), Read(3, 4));
+}
+
+TEST_F(FlashFileUnixTest, erase_sets_sectors_to_0xff)
+{
+    Write(std::vector<uint8_t>(32, 0), 0);
+    Erase(1, 2);
+
+    EXPECT_EQ(std::vector<uint8_t>(16, 0), Read(0, 16));
+    EXPECT_EQ(std::vector<uint8_t>(16, 0xff), Read(16, 16));
+}
+
+TEST_F(FlashFileUnixTest, contents_persist_after_reopening)
+{
+    Write({ 1, 2, 3 }, 20);
+
+    flash = infra::none;
+    flash.Emplace(path, 2, 16);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0xff, 1, 2, 3, 0xff }), Read(19, 5));
+}
+
+TEST_F(FlashFileUnixTest, CutPowerAfter_truncates_crossing_operation_and_ignores_later_operations)
+{
+    flash->CutPowerAfter(3);
+    EXPECT_FALSE(flash->PowerLost());
+
+    Write({ 0, 0, 0, 0, 0 }, 0);
+    EXPECT_TRUE(flash->PowerLost());
+
+    Write({ 0 }, 8);
+    Erase(0, 1);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0, 0, 0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }), Read(0, 9));
+}
+
+TEST_F(FlashFileUnixTest, strict_programming_asserts_when_setting_a_bit)
+{
+    flash = infra::none;
+    hal::FlashFileUnix::Config config;
+    config.strictProgramming = true;
+    flash.Emplace(path, 2, 16, config);
+
+    Write({ 0x0f }, 0);
+    Write({ 0x03 }, 0);
+
+    EXPECT_DEATH(Write({ 0xf0 }, 0), "");
+}
+
+TEST_F(FlashFileUnixTest, synchronous_flash_shares_the_file_format)
+{
+    Write({ 1, 2 }, 16);
+    flash = infra::none;
+
+    hal::SynchronousFlashFileUnix synchronousFlash(path, 2, 16);
+    std::array<uint8_t, 2> buffer;
+    synchronousFlash.ReadBuffer(buffer, 16);
+    EXPECT_EQ((std::array<uint8_t, 2>{ 1, 2 }), buffer);
+}
+
+TEST(FlashFileUnixSizeTest, images_of_4_GB_or_more_are_rejected)
+{
+    EXPECT_DEATH(hal::SynchronousFlashFileUnix(testing::TempDir() + "FlashFileUnixSizeTest.bin", 65536, 65536), "");
+}
@@ -0,0 +1,98 @@
+#include "hal/unix/SharedMemoryUnix.hpp"
+#include "infra/stream/ByteInputStream.hpp"
+#include "infra/stream/ByteOutputStream.hpp"
+#include "services/util/MessageCommunicationSharedMemory.hpp"
+#include "gmock/gmock.h"
+#include <algorithm>
+#include <unistd.h>
+
+namespace
+{
+    class MessageCommunicationObserverMock
+        : public services::MessageCommunicationObserver
+    {
+    public:
+        using services::MessageCommunicationObserver::MessageCommunicationObserver;
+
+        MOCK_METHOD1(SendMessageStreamAvailable, void(infra::SharedPtr<infra::StreamWriter>&& writer));
+        MOCK_METHOD1(ReceivedMessage, void(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader));
+    };
+}
+
+TEST(SharedMemoryUnixTest, created_memory_is_mapped_and_zero_initialized)
+{
+    hal::SharedMemoryUnix memory(4096);
+
+    EXPECT_NE(-1, memory.FileDescriptor());
+    ASSERT_EQ(4096, memory.Memory().size());
+    EXPECT_TRUE(std::all_of(memory.Memory().begin(), memory.Memory().end(), [](uint8_t byte)
+        {
+            return byte == 0;
+        }));
+}
+
+TEST(SharedMemoryUnixTest, mappings_of_the_same_object_see_each_others_writes)
+{
+    hal::SharedMemoryUnix memory(4096);
+    hal::SharedMemoryUnix otherMapping(dup(memory.FileDescriptor()), 4096);
+
+    EXPECT_NE(memory.Memory().begin(), otherMapping.Memory().begin());
+
+    memory.Memory()[10] = 5;
+    EXPECT_EQ(5, otherMapping.Memory()[10]);
+
+    otherMapping.Memory()[4095] = 7;
+    EXPECT_EQ(7, memory.Memory()[4095]);
+}
+
+class SharedMemoryUnixCommunicationTest
+    : public testing::Test
+{
+public:
+    void Send(const std::vector<uint8_t>& message)
+    {
+        EXPECT_CALL(observerA, SendMessageStreamAvailable(testing::_)).WillOnce(testing::Invoke([&message](infra::SharedPtr<infra::StreamWriter>&& writer)
+            {
+                infra::DataOutputStream::WithErrorPolicy stream(*writer);
+                stream << infra::MakeRange(message);
+            }));
+        communicationA.RequestSendMessage(static_cast<uint16_t>(message.size()));
+    }
+
+    void ExpectReceivedMessage(const std::vector<uint8_t>& expected)
+    {
+        EXPECT_CALL(observerB, ReceivedMessage(testing::_)).WillOnce(testing::Invoke([this, expected](infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader)
+            {
+                auto range = reader->ExtractContiguousRange(expected.size());
+                EXPECT_EQ(expected, std::vector<uint8_t>(range.begin(), range.end()));
+                EXPECT_GE(range.begin(), memoryB.Memory().begin());
+                EXPECT_LT(range.end(), memoryB.Memory().end());
+            }));
+        communicationB.Poll();
+    }
+
+    // Each ring consists of two cache lines for head and tail, followed by 32 bytes of data
+    static const std::size_t ringSize = 128 + 32;
+
+    hal::SharedMemoryUnix memoryA{ 4096 };
+    hal::SharedMemoryUnix memoryB{ dup(memoryA.FileDescriptor()), 4096 };
+    services::MessageCommunicationSharedMemory communicationA{ infra::Head(memoryA.Memory(), ringSize), infra::Head(infra::DiscardHead(memoryA.Memory(), 2048), ringSize) };
+    services::MessageCommunicationSharedMemory communicationB{ infra::Head(infra::DiscardHead(memoryB.Memory(), 2048), ringSize), infra::Head(memoryB.Memory(), ringSize) };
+    testing::StrictMock<MessageCommunicationObserverMock> observerA{ communicationA };
+    testing::StrictMock<MessageCommunicationObserverMock> observerB{ communicationB };
+};
+
+TEST_F(SharedMemoryUnixCommunicationTest, messages_wrap_around_the_ring_through_another_mapping)
+{
+    Send({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 });
+    ExpectReceivedMessage({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 });
+
+    Send({ 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24 });
+    ExpectReceivedMessage({ 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24 });
+
+    // Only four bytes are left at the end of the ring, so this message is written at its start
+    Send({ 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36 });
+    ExpectReceivedMessage({ 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36 });
+
+    EXPECT_EQ(25, memoryB.Memory()[128 + 2]);
+}
@@ -1,4 +1,5 @@
 #include "infra/syntax/Json.hpp"
+#include "infra/syntax/JsonScanner.hpp"
 #include "infra/stream/StringOutputStream.hpp"
 #include <cctype>
 
@@ -552,8 +553,7 @@ namespace infra
 
     void JsonTokenizer::SkipWhitespace()
     {
-        while (parseIndex != objectString.size() && std::isspace(static_cast<unsigned char>(objectString[parseIndex])))
-            ++parseIndex;
+        parseIndex = SkipJsonWhitespace(objectString.begin() + parseIndex, objectString.end()) - objectString.begin();
     }
 
     JsonToken::Token JsonTokenizer::TryCreateStringToken()
@@ -564,14 +564,21 @@ namespace infra
         if (parseIndex == objectString.size())
             return JsonToken::Error();
 
-        bool escape = false;
-        while (escape || objectString[parseIndex] != '"')
+        while (true)
         {
-            escape = !escape && objectString[parseIndex] == '\\';
-            ++parseIndex;
+            parseIndex = FindJsonStringDelimiter(objectString.begin() + parseIndex, objectString.end()) - objectString.begin();
 
             if (parseIndex == objectString.size())
                 return JsonToken::Error();
+
+            if (objectString[parseIndex] == '"')
+                break;
+
+            // Skip the backslash and the character it escapes
+            parseIndex += 2;
+
+            if (parseIndex >= objectString.size())
+                return JsonToken::Error();
         }
 
         ++parseIndex;
@@ -769,6 +776,211 @@ namespace infra
         return infra::none;
     }
 
+    namespace
+    {
+        bool AcceptsAnyValue(const JsonValue& value)
+        {
+            return true;
+        }
+
+        template<class T>
+        bool AcceptsValueOfType(const JsonValue& value)
+        {
+            return value.Is<T>();
+        }
+    }
+
+    JsonObjectIndex::JsonObjectIndex(infra::BoundedVector<Entry>& entries, infra::MemoryRange<Entry*> indexSlots, const JsonObject& object)
+        : entries(entries)
+        , index(indexSlots)
+        , object(object)
+    {
+        assert(indexSlots.size() > entries.max_size());
+
+        this->entries.clear();
+
+        for (auto& keyValue : this->object)
+        {
+            auto keyHash = Hash(keyValue.key);
+
+            auto existing = FindInIndex(keyHash, keyValue.key);
+            if (existing != nullptr)
+            {
+                existing->duplicated = true;
+                continue;
+            }
+
+            if (this->entries.full())
+            {
+                complete = false;
+                break;
+            }
+
+            this->entries.push_back(Entry{ keyHash, keyValue.key, keyValue.value });
+            index.insert(&this->entries.back());
+        }
+    }
+
+    bool JsonObjectIndex::HasKey(infra::BoundedConstString key)
+    {
+        return Find(key, &AcceptsAnyValue) != nullptr;
+    }
+
+    bool JsonObjectIndex::Complete() const
+    {
+        return complete;
+    }
+
+    JsonString JsonObjectIndex::GetString(infra::BoundedConstString key)
+    {
+        return GetValue<JsonString>(key);
+    }
+
+    JsonFloat JsonObjectIndex::GetFloat(infra::BoundedConstString key)
+    {
+        return GetValue<JsonFloat>(key);
+    }
+
+    bool JsonObjectIndex::GetBoolean(infra::BoundedConstString key)
+    {
+        return GetValue<bool>(key);
+    }
+
+    int32_t JsonObjectIndex::GetInteger(infra::BoundedConstString key)
+    {
+        return GetValue<int32_t>(key);
+    }
+
+    JsonObject JsonObjectIndex::GetObject(infra::BoundedConstString key)
+    {
+        return GetValue<JsonObject>(key);
+    }
+
+    JsonArray JsonObjectIndex::GetArray(infra::BoundedConstString key)
+    {
+        return GetValue<JsonArray>(key);
+    }
+
+    JsonValue JsonObjectIndex::GetValue(infra::BoundedConstString key)
+    {
+        auto value = Find(key, &AcceptsAnyValue);
+        if (value != nullptr)
+            return *value;
+
+        SetError();
+        return JsonValue();
+    }
+
+    infra::Optional<JsonString> JsonObjectIndex::GetOptionalString(infra::BoundedConstString key)
+    {
+        return GetOptionalValue<JsonString>(key);
+    }
+
+    infra::Optional<JsonFloat> JsonObjectIndex::GetOptionalFloat(infra::BoundedConstString key)
+    {
+        return GetOptionalValue<JsonFloat>(key);
+    }
+
+    infra::Optional<bool> JsonObjectIndex::GetOptionalBoolean(infra::BoundedConstString key)
+    {
+        return GetOptionalValue<bool>(key);
+    }
+
+    infra::Optional<int32_t> JsonObjectIndex::GetOptionalInteger(infra::BoundedConstString key)
+    {
+        return GetOptionalValue<int32_t>(key);
+    }
+
+    infra::Optional<JsonObject> JsonObjectIndex::GetOptionalObject(infra::BoundedConstString key)
+    {
+        return GetOptionalValue<JsonObject>(key);
+    }
+
+    infra::Optional<JsonArray> JsonObjectIndex::GetOptionalArray(infra::BoundedConstString key)
+    {
+        return GetOptionalValue<JsonArray>(key);
+    }
+
+    void JsonObjectIndex::SetError()
+    {
+        object.SetError();
+    }
+
+    bool JsonObjectIndex::Error() const
+    {
+        return object.Error();
+    }
+
+    template<class T>
+    T JsonObjectIndex::GetValue(infra::BoundedConstString key)
+    {
+        const JsonValue* value = Find(key, &AcceptsValueOfType<T>);
+        if (value != nullptr && value->Is<T>())
+            return value->Get<T>();
+
+        SetError();
+        return T();
+    }
+
+    template<class T>
+    infra::Optional<T> JsonObjectIndex::GetOptionalValue(infra::BoundedConstString key)
+    {
+        const JsonValue* value = Find(key, &AcceptsValueOfType<T>);
+        if (value != nullptr && value->Is<T>())
+            return infra::MakeOptional(value->Get<T>());
+
+        return infra::none;
+    }
+
+    const JsonValue* JsonObjectIndex::Find(infra::BoundedConstString key, bool (*accepts)(const JsonValue& value))
+    {
+        auto entry = FindInIndex(Hash(key), key);
+        if (entry != nullptr && (accepts(entry->value) || (!entry->duplicated && complete)))
+            return &entry->value;
+
+        if (entry == nullptr && complete)
+            return nullptr;
+
+        // Members beyond the capacity of the index, and later members with a duplicated key, are only reachable by
+        // iterating the object. Like JsonObject, the first member with the key and an accepted value is returned.
+        for (auto& keyValue : object)
+        {
+            if (keyValue.key == key && accepts(keyValue.value))
+            {
+                fallbackValue = keyValue.value;
+                return &*fallbackValue;
+            }
+        }
+
+        return entry != nullptr ? &entry->value : nullptr;
+    }
+
+    template<class Key>
+    JsonObjectIndex::Entry* JsonObjectIndex::FindInIndex(uint32_t keyHash, Key key)
+    {
+        auto slot = index.find(keyHash, [keyHash, &key](const Entry* entry)
+            { return entry->keyHash == keyHash && entry->key == key; });
+
+        return slot != nullptr ? *slot : nullptr;
+    }
+
+    template<class Key>
+    uint32_t JsonObjectIndex::Hash(Key key)
+    {
+        // FNV-1a over the unescaped key, so that a JsonString key hashes equal to the plain key used in lookups
+        uint32_t hash = 2166136261;
+
+        for (auto c : key)
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619;
+
+        return hash;
+    }
+
+    uint32_t JsonObjectIndex::EntryHash(const Entry& entry)
+    {
+        return entry.keyHash;
+    }
+
     JsonArray::JsonArray(infra::BoundedConstString objectString)
         : objectString(objectString)
     {}
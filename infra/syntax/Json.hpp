@@ -3,9 +3,12 @@
 
 #include "infra/stream/OutputStream.hpp"
 #include "infra/util/BoundedString.hpp"
+#include "infra/util/BoundedVector.hpp"
+#include "infra/util/OpenAddressingIndex.hpp"
 #include "infra/util/Optional.hpp"
 #include "infra/util/ReverseRange.hpp"
 #include "infra/util/Variant.hpp"
+#include "infra/util/WithStorage.hpp"
 
 #ifdef EMIL_HOST_BUILD
 #include <string>
@@ -497,6 +500,74 @@ namespace infra
         JsonArrayIterator arrayEndIterator;
     };
 
+    // JsonObjectIndex tokenizes an object once and stores its members in a hash table, so that subsequent
+    // lookups by key take constant time instead of re-tokenizing the object from the start.
+    // When the object holds more members than the index can store, lookups of unindexed keys fall back to
+    // iterating the object.
+    class JsonObjectIndex
+    {
+    public:
+        struct Entry
+        {
+            uint32_t keyHash;
+            JsonString key;
+            JsonValue value;
+            bool duplicated = false;
+        };
+
+        template<std::size_t MaxKeys>
+        using WithMaxKeys = infra::WithStorage<infra::WithStorage<JsonObjectIndex,
+                                                   infra::BoundedVector<Entry>::WithMaxSize<MaxKeys>>,
+            std::array<Entry*, 2 * MaxKeys>>;
+
+        JsonObjectIndex(infra::BoundedVector<Entry>& entries, infra::MemoryRange<Entry*> indexSlots, const JsonObject& object);
+        JsonObjectIndex(const JsonObjectIndex& other) = delete;
+        JsonObjectIndex& operator=(const JsonObjectIndex& other) = delete;
+
+        bool HasKey(infra::BoundedConstString key);
+        bool Complete() const;
+
+        JsonString GetString(infra::BoundedConstString key);
+        JsonFloat GetFloat(infra::BoundedConstString key);
+        bool GetBoolean(infra::BoundedConstString key);
+        int32_t GetInteger(infra::BoundedConstString key);
+        JsonObject GetObject(infra::BoundedConstString key);
+        JsonArray GetArray(infra::BoundedConstString key);
+        JsonValue GetValue(infra::BoundedConstString key);
+
+        infra::Optional<JsonString> GetOptionalString(infra::BoundedConstString key);
+        infra::Optional<JsonFloat> GetOptionalFloat(infra::BoundedConstString key);
+        infra::Optional<bool> GetOptionalBoolean(infra::BoundedConstString key);
+        infra::Optional<int32_t> GetOptionalInteger(infra::BoundedConstString key);
+        infra::Optional<JsonObject> GetOptionalObject(infra::BoundedConstString key);
+        infra::Optional<JsonArray> GetOptionalArray(infra::BoundedConstString key);
+
+    public:
+        void SetError();
+        bool Error() const;
+
+    private:
+        template<class T>
+        T GetValue(infra::BoundedConstString key);
+        template<class T>
+        infra::Optional<T> GetOptionalValue(infra::BoundedConstString key);
+
+        const JsonValue* Find(infra::BoundedConstString key, bool (*accepts)(const JsonValue& value));
+        template<class Key>
+        Entry* FindInIndex(uint32_t keyHash, Key key);
+
+        template<class Key>
+        static uint32_t Hash(Key key);
+        static uint32_t EntryHash(const Entry& entry);
+
+    private:
+        infra::BoundedVector<Entry>& entries;
+        infra::OpenAddressingIndex<Entry*, infra::OpenAddressingPointerTraits<Entry, &JsonObjectIndex::EntryHash>> index;
+        JsonObject object;
+        infra::Optional<JsonValue> fallbackValue;
+        bool complete = true;
+    };
+
     infra::detail::DoublePair<JsonValueArrayIterator<bool>> JsonBooleanArray(JsonArray& array);
     infra::detail::DoublePair<JsonValueArrayIterator<int32_t>> JsonIntegerArray(JsonArray& array);
     infra::detail::DoublePair<JsonValueArrayIterator<JsonString>> JsonStringArray(JsonArray& array);
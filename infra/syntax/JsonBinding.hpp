@@ -0,0 +1,493 @@
+#ifndef INFRA_JSON_BINDING_HPP
+#define INFRA_JSON_BINDING_HPP
+
+#include "infra/syntax/JsonFormatter.hpp"
+#include "infra/syntax/JsonStreamingParser.hpp"
+#include "infra/util/BoundedString.hpp"
+#include "infra/util/Optional.hpp"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// A JsonBinding maps members of a struct onto JSON keys. It is intended to be declared constexpr,
+// in which case a perfect hash over the keys is computed at compile time. When no perfect hash is found
+// within a bounded number of seeds, lookups fall back to comparing against every key:
+//
+//   struct Firmware
+//   {
+//       infra::BoundedString::WithStorage<64> url;
+//       uint32_t version;
+//   };
+//
+//   constexpr auto firmwareBinding = infra::MakeJsonBinding<Firmware>(
+//       infra::JsonField("url", &Firmware::url),
+//       infra::JsonField("version", &Firmware::version));
+//
+// A JsonBindingVisitor fills a struct from a JsonStreamingObjectParser, mapping each key in a single lookup,
+// and JsonBinding::Format writes the struct with a JsonObjectFormatter.
+// Supported member types are bool, integral types, BoundedStrings, and structs with their own binding.
+
+namespace infra
+{
+    template<class T, class M>
+    struct JsonScalarField
+    {
+        using Object = T;
+        using Member = M;
+
+        const char* key;
+        M T::*member;
+    };
+
+    template<class T, class M, class Binding>
+    struct JsonObjectField
+    {
+        using Object = T;
+        using Member = M;
+
+        const char* key;
+        M T::*member;
+        Binding binding;
+    };
+
+    template<class T, class M>
+    constexpr JsonScalarField<T, M> JsonField(const char* key, M T::*member);
+    template<class T, class M, class Binding>
+    constexpr JsonObjectField<T, M, Binding> JsonField(const char* key, M T::*member, const Binding& binding);
+
+    namespace detail
+    {
+        constexpr uint32_t JsonBindingHash(uint32_t seed, const char* key)
+        {
+            uint32_t hash = 2166136261 ^ seed;
+
+            for (; *key != 0; ++key)
+                hash = (hash ^ static_cast<uint8_t>(*key)) * 16777619;
+
+            return hash;
+        }
+
+        inline uint32_t JsonBindingHash(uint32_t seed, infra::BoundedConstString key)
+        {
+            uint32_t hash = 2166136261 ^ seed;
+
+            for (auto c : key)
+                hash = (hash ^ static_cast<uint8_t>(c)) * 16777619;
+
+            return hash;
+        }
+
+        constexpr std::size_t JsonBindingTableSize(std::size_t numberOfKeys)
+        {
+            std::size_t size = 4;
+
+            while (size < 4 * numberOfKeys)
+                size *= 2;
+
+            return size;
+        }
+    }
+
+    template<class T, class... Fields>
+    class JsonBinding
+    {
+    public:
+        using Object = T;
+
+        static constexpr std::size_t numberOfFields = sizeof...(Fields);
+        static constexpr std::size_t tableSize = detail::JsonBindingTableSize(numberOfFields);
+        static constexpr uint8_t noField = std::numeric_limits<uint8_t>::max();
+        static constexpr uint32_t maxSeedAttempts = 64;
+
+        static_assert(numberOfFields < noField, "Too many fields in binding");
+
+        constexpr explicit JsonBinding(Fields... fields);
+
+        // Returns the index of the field bound to key, or numberOfFields when there is none
+        std::size_t FindField(infra::BoundedConstString key) const;
+
+        template<class Function>
+        void ForField(std::size_t index, Function&& function) const;
+        template<class Function>
+        void ForEachField(Function&& function) const;
+
+        void Format(JsonObjectFormatter& formatter, const T& object) const;
+
+    private:
+        template<std::size_t... I>
+        constexpr std::array<const char*, numberOfFields> Keys(std::index_sequence<I...>) const;
+        constexpr bool TryBuildTable(uint32_t candidateSeed);
+
+        template<class Function, std::size_t... I>
+        void ForField(std::size_t index, Function&& function, std::index_sequence<I...>) const;
+
+    private:
+        std::tuple<Fields...> fields;
+        std::array<const char*, numberOfFields> keys{};
+        std::array<uint8_t, tableSize> table{};
+        uint32_t seed = 0;
+        bool perfectHash = false;
+    };
+
+    template<class T, class... Fields>
+    constexpr JsonBinding<T, Fields...> MakeJsonBinding(Fields... fields);
+
+    template<class Binding>
+    class JsonBindingVisitor
+        : public JsonObjectVisitor
+    {
+    public:
+        using Object = typename Binding::Object;
+
+        JsonBindingVisitor(const Binding& binding, Object& object);
+
+        // Done is true once the object has been closed; Error is true when the parser reported an error or when a value
+        // did not fit its member, in which case the object may be partially filled
+        bool Done() const;
+        bool Error() const;
+
+        // Implementation of JsonObjectVisitor
+        virtual void VisitString(infra::BoundedConstString tag, infra::BoundedConstString value) override;
+        virtual void VisitNumber(infra::BoundedConstString tag, int64_t value) override;
+        virtual void VisitBoolean(infra::BoundedConstString tag, bool value) override;
+        virtual JsonObjectVisitor* VisitObject(infra::BoundedConstString tag, JsonSubObjectParser& parser) override;
+        virtual void Close() override;
+        virtual void ParseError() override;
+        virtual void SemanticError() override;
+        virtual void StringOverflow() override;
+
+    private:
+        template<class Field>
+        struct NestedVisitor
+        {
+            using Type = std::tuple<>;
+        };
+
+        template<class T, class M, class NestedBinding>
+        struct NestedVisitor<JsonObjectField<T, M, NestedBinding>>
+        {
+            using Type = infra::Optional<JsonBindingVisitor<NestedBinding>>;
+        };
+
+        template<class Function>
+        void ForField(infra::BoundedConstString tag, Function&& function);
+
+        template<std::size_t... I>
+        bool NestedError(std::index_sequence<I...>) const;
+        template<class Nested>
+        static bool NestedError(const Nested& nested);
+
+        template<class M>
+        static bool AssignString(M& member, infra::BoundedConstString value);
+        template<class M>
+        static bool AssignNumber(M& member, int64_t value);
+        template<class M>
+        static bool AssignBoolean(M& member, bool value);
+
+    private:
+        template<class Binding_>
+        struct NestedVisitors;
+
+        template<class T, class... Fields>
+        struct NestedVisitors<JsonBinding<T, Fields...>>
+        {
+            using Type = std::tuple<typename NestedVisitor<Fields>::Type...>;
+        };
+
+        const Binding& binding;
+        Object& object;
+        typename NestedVisitors<std::remove_cv_t<Binding>>::Type nestedVisitors;
+        bool done = false;
+        bool error = false;
+    };
+
+    //// Implementation ////
+
+    template<class T, class M>
+    constexpr JsonScalarField<T, M> JsonField(const char* key, M T::*member)
+    {
+        return JsonScalarField<T, M>{ key, member };
+    }
+
+    template<class T, class M, class Binding>
+    constexpr JsonObjectField<T, M, Binding> JsonField(const char* key, M T::*member, const Binding& binding)
+    {
+        return JsonObjectField<T, M, Binding>{ key, member, binding };
+    }
+
+    template<class T, class... Fields>
+    constexpr JsonBinding<T, Fields...>::JsonBinding(Fields... fields)
+        : fields(fields...)
+        , keys(Keys(std::make_index_sequence<numberOfFields>()))
+    {
+        // Search for a seed that maps every key onto its own slot. With a table of at least four slots per key
+        // a seed is typically found within a few attempts
+        for (uint32_t candidateSeed = 0; candidateSeed != maxSeedAttempts && !perfectHash; ++candidateSeed)
+            perfectHash = TryBuildTable(candidateSeed);
+    }
+
+    template<class T, class... Fields>
+    std::size_t JsonBinding<T, Fields...>::FindField(infra::BoundedConstString key) const
+    {
+        if (!perfectHash)
+        {
+            for (std::size_t index = 0; index != numberOfFields; ++index)
+                if (key == keys[index])
+                    return index;
+
+            return numberOfFields;
+        }
+
+        auto index = table[detail::JsonBindingHash(seed, key) % tableSize];
+
+        if (index != noField && key == keys[index])
+            return index;
+        else
+            return numberOfFields;
+    }
+
+    template<class T, class... Fields>
+    template<class Function>
+    void JsonBinding<T, Fields...>::ForField(std::size_t index, Function&& function) const
+    {
+        ForField(index, std::forward<Function>(function), std::make_index_sequence<numberOfFields>());
+    }
+
+    template<class T, class... Fields>
+    template<class Function>
+    void JsonBinding<T, Fields...>::ForEachField(Function&& function) const
+    {
+        for (std::size_t index = 0; index != numberOfFields; ++index)
+            ForField(index, function);
+    }
+
+    template<class T, class... Fields>
+    void JsonBinding<T, Fields...>::Format(JsonObjectFormatter& formatter, const T& object) const
+    {
+        ForEachField([&formatter, &object](const auto& field, auto)
+            {
+                using Field = std::decay_t<decltype(field)>;
+                using Member = typename Field::Member;
+                const auto& member = object.*field.member;
+
+                if constexpr (std::is_base_of<infra::BoundedString, Member>::value)
+                    formatter.Add(field.key, infra::BoundedConstString(member));
+                else if constexpr (std::is_integral<Member>::value)
+                    formatter.Add(field.key, member);
+                else
+                {
+                    auto subObject = formatter.SubObject(field.key);
+                    field.binding.Format(subObject, member);
+                }
+            });
+    }
+
+    template<class T, class... Fields>
+    template<std::size_t... I>
+    constexpr std::array<const char*, JsonBinding<T, Fields...>::numberOfFields> JsonBinding<T, Fields...>::Keys(std::index_sequence<I...>) const
+    {
+        return std::array<const char*, numberOfFields>{ { std::get<I>(fields).key... } };
+    }
+
+    template<class T, class... Fields>
+    constexpr bool JsonBinding<T, Fields...>::TryBuildTable(uint32_t candidateSeed)
+    {
+        for (auto& slot : table)
+            slot = noField;
+
+        for (std::size_t index = 0; index != numberOfFields; ++index)
+        {
+            auto& slot = table[detail::JsonBindingHash(candidateSeed, keys[index]) % tableSize];
+            if (slot != noField)
+                return false;
+
+            slot = static_cast<uint8_t>(index);
+        }
+
+        seed = candidateSeed;
+        return true;
+    }
+
+    template<class T, class... Fields>
+    template<class Function, std::size_t... I>
+    void JsonBinding<T, Fields...>::ForField(std::size_t index, Function&& function, std::index_sequence<I...>) const
+    {
+        ((index == I ? function(std::get<I>(fields), std::integral_constant<std::size_t, I>()) : void()), ...);
+    }
+
+    template<class T, class... Fields>
+    constexpr JsonBinding<T, Fields...> MakeJsonBinding(Fields... fields)
+    {
+        static_assert((std::is_same<T, typename Fields::Object>::value && ...), "All fields must be members of T");
+        return JsonBinding<T, Fields...>(fields...);
+    }
+
+    template<class Binding>
+    JsonBindingVisitor<Binding>::JsonBindingVisitor(const Binding& binding, Object& object)
+        : binding(binding)
+        , object(object)
+    {}
+
+    template<class Binding>
+    bool JsonBindingVisitor<Binding>::Done() const
+    {
+        return done;
+    }
+
+    template<class Binding>
+    bool JsonBindingVisitor<Binding>::Error() const
+    {
+        return error || NestedError(std::make_index_sequence<Binding::numberOfFields>());
+    }
+
+    template<class Binding>
+    void JsonBindingVisitor<Binding>::VisitString(infra::BoundedConstString tag, infra::BoundedConstString value)
+    {
+        ForField(tag, [this, value](const auto& field, auto)
+            {
+                error |= !AssignString(object.*field.member, value);
+            });
+    }
+
+    template<class Binding>
+    void JsonBindingVisitor<Binding>::VisitNumber(infra::BoundedConstString tag, int64_t value)
+    {
+        ForField(tag, [this, value](const auto& field, auto)
+            {
+                error |= !AssignNumber(object.*field.member, value);
+            });
+    }
+
+    template<class Binding>
+    void JsonBindingVisitor<Binding>::VisitBoolean(infra::BoundedConstString tag, bool value)
+    {
+        ForField(tag, [this, value](const auto& field, auto)
+            {
+                error |= !AssignBoolean(object.*field.member, value);
+            });
+    }
+
+    template<class Binding>
+    JsonObjectVisitor* JsonBindingVisitor<Binding>::VisitObject(infra::BoundedConstString tag, JsonSubObjectParser& parser)
+    {
+        JsonObjectVisitor* result = nullptr;
+
+        ForField(tag, [this, &result](const auto& field, auto index)
+            {
+                auto& nested = std::get<decltype(index)::value>(nestedVisitors);
+
+                if constexpr (std::is_same<std::decay_t<decltype(nested)>, std::tuple<>>::value)
+                    error = true;
+                else
+                {
+                    nested.Emplace(field.binding, object.*field.member);
+                    result = &*nested;
+                }
+            });
+
+        return result;
+    }
+
+    template<class Binding>
+    void JsonBindingVisitor<Binding>::Close()
+    {
+        done = true;
+    }
+
+    template<class Binding>
+    void JsonBindingVisitor<Binding>::ParseError()
+    {
+        error = true;
+    }
+
+    template<class Binding>
+    void JsonBindingVisitor<Binding>::SemanticError()
+    {
+        error = true;
+    }
+
+    template<class Binding>
+    void JsonBindingVisitor<Binding>::StringOverflow()
+    {
+        error = true;
+    }
+
+    template<class Binding>
+    template<class Function>
+    void JsonBindingVisitor<Binding>::ForField(infra::BoundedConstString tag, Function&& function)
+    {
+        auto index = binding.FindField(tag);
+
+        if (index != Binding::numberOfFields)
+            binding.ForField(index, std::forward<Function>(function));
+    }
+
+    template<class Binding>
+    template<std::size_t... I>
+    bool JsonBindingVisitor<Binding>::NestedError(std::index_sequence<I...>) const
+    {
+        return (NestedError(std::get<I>(nestedVisitors)) || ...);
+    }
+
+    template<class Binding>
+    template<class Nested>
+    bool JsonBindingVisitor<Binding>::NestedError(const Nested& nested)
+    {
+        if constexpr (std::is_same<Nested, std::tuple<>>::value)
+            return false;
+        else
+            return nested != infra::none && nested->Error();
+    }
+
+    template<class Binding>
+    template<class M>
+    bool JsonBindingVisitor<Binding>::AssignString(M& member, infra::BoundedConstString value)
+    {
+        if constexpr (std::is_base_of<infra::BoundedString, M>::value)
+        {
+            member.assign(value.substr(0, member.max_size()));
+            return value.size() <= member.max_size();
+        }
+        else
+            return false;
+    }
+
+    template<class Binding>
+    template<class M>
+    bool JsonBindingVisitor<Binding>::AssignNumber(M& member, int64_t value)
+    {
+        if constexpr (std::is_integral<M>::value && !std::is_same<M, bool>::value)
+        {
+            if constexpr (std::is_signed<M>::value)
+            {
+                if (value < std::numeric_limits<M>::min() || value > std::numeric_limits<M>::max())
+                    return false;
+            }
+            else if (value < 0 || static_cast<uint64_t>(value) > std::numeric_limits<M>::max())
+                return false;
+
+            member = static_cast<M>(value);
+            return true;
+        }
+        else
+            return false;
+    }
+
+    template<class Binding>
+    template<class M>
+    bool JsonBindingVisitor<Binding>::AssignBoolean(M& member, bool value)
+    {
+        if constexpr (std::is_same<M, bool>::value)
+        {
+            member = value;
+            return true;
+        }
+        else
+            return false;
+    }
+}
+
+#endif
@@ -0,0 +1,328 @@
+#include "infra/syntax/JsonPointerExtractor.hpp"
+#include "infra/util/Optional.hpp"
+#include <cassert>
+
+namespace
+{
+    // Returns the reference token at depth in pointer, or none when the pointer has fewer tokens
+    infra::Optional<infra::BoundedConstString> ReferenceToken(infra::BoundedConstString pointer, std::size_t depth, bool& last)
+    {
+        std::size_t start = 0;
+
+        for (std::size_t level = 0; start != pointer.size() && pointer[start] == '/'; ++level)
+        {
+            auto end = pointer.find('/', start + 1);
+            if (end == infra::BoundedConstString::npos)
+                end = pointer.size();
+
+            if (level == depth)
+            {
+                last = end == pointer.size();
+                return infra::MakeOptional(pointer.substr(start + 1, end - start - 1));
+            }
+
+            start = end;
+        }
+
+        return infra::none;
+    }
+
+    // Compares a reference token to a key, decoding "~1" as '/' and "~0" as '~'
+    bool TokenEqualsKey(infra::BoundedConstString token, infra::BoundedConstString key)
+    {
+        auto k = key.begin();
+
+        for (auto t = token.begin(); t != token.end(); ++t, ++k)
+        {
+            if (k == key.end())
+                return false;
+
+            auto c = *t;
+            if (c == '~' && std::next(t) != token.end())
+            {
+                ++t;
+                c = *t == '1' ? '/' : '~';
+            }
+
+            if (c != *k)
+                return false;
+        }
+
+        return k == key.end();
+    }
+}
+
+namespace infra
+{
+    void JsonPointerVisitor::VisitString(std::size_t pointer, infra::BoundedConstString value)
+    {}
+
+    void JsonPointerVisitor::VisitNumber(std::size_t pointer, int64_t value)
+    {}
+
+    void JsonPointerVisitor::VisitBoolean(std::size_t pointer, bool value)
+    {}
+
+    void JsonPointerVisitor::VisitNull(std::size_t pointer)
+    {}
+
+    void JsonPointerVisitor::Close()
+    {}
+
+    void JsonPointerVisitor::ParseError()
+    {}
+
+    void JsonPointerVisitor::SemanticError()
+    {}
+
+    void JsonPointerVisitor::StringOverflow()
+    {}
+
+    JsonPointerExtractor::Level::Level(JsonPointerExtractor& extractor, uint32_t candidates, std::size_t depth)
+        : extractor(extractor)
+        , candidates(candidates)
+        , depth(depth)
+    {}
+
+    void JsonPointerExtractor::Level::VisitString(infra::BoundedConstString tag, infra::BoundedConstString value)
+    {
+        extractor.VisitScalar(candidates, depth, tag, [this, value](std::size_t pointer)
+            {
+                extractor.visitor.VisitString(pointer, value);
+            });
+    }
+
+    void JsonPointerExtractor::Level::VisitNumber(infra::BoundedConstString tag, int64_t value)
+    {
+        extractor.VisitScalar(candidates, depth, tag, [this, value](std::size_t pointer)
+            {
+                extractor.visitor.VisitNumber(pointer, value);
+            });
+    }
+
+    void JsonPointerExtractor::Level::VisitBoolean(infra::BoundedConstString tag, bool value)
+    {
+        extractor.VisitScalar(candidates, depth, tag, [this, value](std::size_t pointer)
+            {
+                extractor.visitor.VisitBoolean(pointer, value);
+            });
+    }
+
+    void JsonPointerExtractor::Level::VisitNull(infra::BoundedConstString tag)
+    {
+        extractor.VisitScalar(candidates, depth, tag, [this](std::size_t pointer)
+            {
+                extractor.visitor.VisitNull(pointer);
+            });
+    }
+
+    JsonObjectVisitor* JsonPointerExtractor::Level::VisitObject(infra::BoundedConstString tag, JsonSubObjectParser& parser)
+    {
+        return extractor.VisitContainer(candidates, depth, tag);
+    }
+
+    JsonArrayVisitor* JsonPointerExtractor::Level::VisitArray(infra::BoundedConstString tag, JsonSubArrayParser& parser)
+    {
+        return extractor.VisitContainer(candidates, depth, tag);
+    }
+
+    void JsonPointerExtractor::Level::VisitString(infra::BoundedConstString value)
+    {
+        VisitString(NextIndex(), value);
+    }
+
+    void JsonPointerExtractor::Level::VisitNumber(int64_t value)
+    {
+        VisitNumber(NextIndex(), value);
+    }
+
+    void JsonPointerExtractor::Level::VisitBoolean(bool value)
+    {
+        VisitBoolean(NextIndex(), value);
+    }
+
+    void JsonPointerExtractor::Level::VisitNull()
+    {
+        VisitNull(NextIndex());
+    }
+
+    JsonObjectVisitor* JsonPointerExtractor::Level::VisitObject(JsonSubObjectParser& parser)
+    {
+        return extractor.VisitContainer(candidates, depth, NextIndex());
+    }
+
+    JsonArrayVisitor* JsonPointerExtractor::Level::VisitArray(JsonSubArrayParser& parser)
+    {
+        return extractor.VisitContainer(candidates, depth, NextIndex());
+    }
+
+    void JsonPointerExtractor::Level::Close()
+    {
+        extractor.LevelClosed();
+    }
+
+    void JsonPointerExtractor::Level::ParseError()
+    {}
+
+    void JsonPointerExtractor::Level::SemanticError()
+    {}
+
+    void JsonPointerExtractor::Level::StringOverflow()
+    {
+        ++index;
+        extractor.StringOverflow(candidates, depth);
+    }
+
+    infra::BoundedConstString JsonPointerExtractor::Level::NextIndex()
+    {
+        indexString.clear();
+
+        auto value = index++;
+        do
+        {
+            indexString.insert(indexString.begin(), static_cast<char>('0' + value % 10));
+            value /= 10;
+        } while (value != 0);
+
+        return indexString;
+    }
+
+    JsonPointerExtractor::JsonPointerExtractor(infra::BoundedVector<Level>& levels, infra::MemoryRange<const infra::BoundedConstString> pointers, JsonPointerVisitor& visitor)
+        : levels(levels)
+        , pointers(pointers)
+        , visitor(visitor)
+        , candidates(pointers.size() == 32 ? 0xffffffff : (1u << pointers.size()) - 1)
+    {
+        assert(pointers.size() <= 32);
+    }
+
+    void JsonPointerExtractor::VisitString(infra::BoundedConstString tag, infra::BoundedConstString value)
+    {
+        VisitScalar(candidates, 0, tag, [this, value](std::size_t pointer)
+            {
+                visitor.VisitString(pointer, value);
+            });
+    }
+
+    void JsonPointerExtractor::VisitNumber(infra::BoundedConstString tag, int64_t value)
+    {
+        VisitScalar(candidates, 0, tag, [this, value](std::size_t pointer)
+            {
+                visitor.VisitNumber(pointer, value);
+            });
+    }
+
+    void JsonPointerExtractor::VisitBoolean(infra::BoundedConstString tag, bool value)
+    {
+        VisitScalar(candidates, 0, tag, [this, value](std::size_t pointer)
+            {
+                visitor.VisitBoolean(pointer, value);
+            });
+    }
+
+    void JsonPointerExtractor::VisitNull(infra::BoundedConstString tag)
+    {
+        VisitScalar(candidates, 0, tag, [this](std::size_t pointer)
+            {
+                visitor.VisitNull(pointer);
+            });
+    }
+
+    JsonObjectVisitor* JsonPointerExtractor::VisitObject(infra::BoundedConstString tag, JsonSubObjectParser& parser)
+    {
+        return VisitContainer(candidates, 0, tag);
+    }
+
+    JsonArrayVisitor* JsonPointerExtractor::VisitArray(infra::BoundedConstString tag, JsonSubArrayParser& parser)
+    {
+        return VisitContainer(candidates, 0, tag);
+    }
+
+    void JsonPointerExtractor::Close()
+    {
+        visitor.Close();
+    }
+
+    void JsonPointerExtractor::ParseError()
+    {
+        levels.clear();
+        visitor.ParseError();
+    }
+
+    void JsonPointerExtractor::SemanticError()
+    {
+        levels.clear();
+        visitor.SemanticError();
+    }
+
+    void JsonPointerExtractor::StringOverflow()
+    {
+        StringOverflow(candidates, 0);
+    }
+
+    template<class Visit>
+    void JsonPointerExtractor::VisitScalar(uint32_t candidates, std::size_t depth, infra::BoundedConstString key, Visit visit)
+    {
+        auto matches = Matches(candidates, depth, key, true);
+
+        for (std::size_t pointer = 0; matches != 0; ++pointer, matches >>= 1)
+            if ((matches & 1) != 0)
+                visit(pointer);
+    }
+
+    JsonPointerExtractor::Level* JsonPointerExtractor::VisitContainer(uint32_t candidates, std::size_t depth, infra::BoundedConstString key)
+    {
+        auto matches = Matches(candidates, depth, key, false);
+
+        if (matches == 0)
+            return nullptr;
+
+        if (levels.full())
+        {
+            visitor.SemanticError();
+            return nullptr;
+        }
+
+        levels.emplace_back(*this, matches, depth + 1);
+        return &levels.back();
+    }
+
+    void JsonPointerExtractor::StringOverflow(uint32_t candidates, std::size_t depth)
+    {
+        // The key of the overflowing value is not known, so report when any pointer could end at this level
+        for (std::size_t pointer = 0; pointer != pointers.size(); ++pointer)
+        {
+            bool last = false;
+            if ((candidates & (1u << pointer)) != 0 && ReferenceToken(pointers[pointer], depth, last) != infra::none && last)
+            {
+                visitor.StringOverflow();
+                return;
+            }
+        }
+    }
+
+    void JsonPointerExtractor::LevelClosed()
+    {
+        levels.pop_back();
+    }
+
+    uint32_t JsonPointerExtractor::Matches(uint32_t candidates, std::size_t depth, infra::BoundedConstString key, bool last) const
+    {
+        uint32_t result = 0;
+
+        for (std::size_t pointer = 0; pointer != pointers.size(); ++pointer)
+        {
+            bool tokenIsLast = false;
+
+            if ((candidates & (1u << pointer)) != 0)
+            {
+                auto token = ReferenceToken(pointers[pointer], depth, tokenIsLast);
+
+                if (token != infra::none && tokenIsLast == last && TokenEqualsKey(*token, key))
+                    result |= 1u << pointer;
+            }
+        }
+
+        return result;
+    }
+}
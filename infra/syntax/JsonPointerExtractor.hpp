@@ -0,0 +1,118 @@
+#ifndef INFRA_JSON_POINTER_EXTRACTOR_HPP
+#define INFRA_JSON_POINTER_EXTRACTOR_HPP
+
+#include "infra/syntax/JsonStreamingParser.hpp"
+#include "infra/util/BoundedString.hpp"
+#include "infra/util/BoundedVector.hpp"
+#include "infra/util/MemoryRange.hpp"
+#include "infra/util/WithStorage.hpp"
+
+namespace infra
+{
+    class JsonPointerVisitor
+    {
+    protected:
+        JsonPointerVisitor() = default;
+        JsonPointerVisitor(const JsonPointerVisitor& other) = delete;
+        JsonPointerVisitor& operator=(const JsonPointerVisitor& other) = delete;
+        ~JsonPointerVisitor() = default;
+
+    public:
+        // pointer is the index of the matching JSON Pointer in the list given to the JsonPointerExtractor
+        virtual void VisitString(std::size_t pointer, infra::BoundedConstString value);
+        virtual void VisitNumber(std::size_t pointer, int64_t value);
+        virtual void VisitBoolean(std::size_t pointer, bool value);
+        virtual void VisitNull(std::size_t pointer);
+
+        virtual void Close();
+        virtual void ParseError();
+        virtual void SemanticError();
+        virtual void StringOverflow();
+    };
+
+    // JsonPointerExtractor is the top object visitor of a JsonStreamingObjectParser (or of an HttpClientJson) that
+    // delivers the scalar values addressed by a set of JSON Pointers (RFC 6901), e.g. "/firmware/url" or "/items/0/id".
+    // Objects and arrays that cannot contain a match are skipped by the parser without being buffered.
+    // The parser's value buffer must hold the longest string in any object or array that is not skipped; a string
+    // overflow in an object or array that holds a match is reported through StringOverflow. An object or array that
+    // holds a match, but that is nested deeper than MaxNesting, is skipped and reported through SemanticError.
+    class JsonPointerExtractor
+        : public JsonObjectVisitor
+    {
+    private:
+        class Level
+            : public JsonObjectVisitor
+            , public JsonArrayVisitor
+        {
+        public:
+            Level(JsonPointerExtractor& extractor, uint32_t candidates, std::size_t depth);
+
+            // Implementation of JsonObjectVisitor
+            virtual void VisitString(infra::BoundedConstString tag, infra::BoundedConstString value) override;
+            virtual void VisitNumber(infra::BoundedConstString tag, int64_t value) override;
+            virtual void VisitBoolean(infra::BoundedConstString tag, bool value) override;
+            virtual void VisitNull(infra::BoundedConstString tag) override;
+            virtual JsonObjectVisitor* VisitObject(infra::BoundedConstString tag, JsonSubObjectParser& parser) override;
+            virtual JsonArrayVisitor* VisitArray(infra::BoundedConstString tag, JsonSubArrayParser& parser) override;
+
+            // Implementation of JsonArrayVisitor
+            virtual void VisitString(infra::BoundedConstString value) override;
+            virtual void VisitNumber(int64_t value) override;
+            virtual void VisitBoolean(bool value) override;
+            virtual void VisitNull() override;
+            virtual JsonObjectVisitor* VisitObject(JsonSubObjectParser& parser) override;
+            virtual JsonArrayVisitor* VisitArray(JsonSubArrayParser& parser) override;
+
+            // Implementation of JsonVisitor
+            virtual void Close() override;
+            virtual void ParseError() override;
+            virtual void SemanticError() override;
+            virtual void StringOverflow() override;
+
+        private:
+            infra::BoundedConstString NextIndex();
+
+        private:
+            JsonPointerExtractor& extractor;
+            uint32_t candidates;
+            std::size_t depth;
+            uint32_t index = 0;
+            infra::BoundedString::WithStorage<10> indexString;
+        };
+
+    public:
+        template<std::size_t MaxNesting>
+        using WithMaxNesting = infra::WithStorage<JsonPointerExtractor, infra::BoundedVector<Level>::WithMaxSize<MaxNesting>>;
+
+        JsonPointerExtractor(infra::BoundedVector<Level>& levels, infra::MemoryRange<const infra::BoundedConstString> pointers, JsonPointerVisitor& visitor);
+
+        // Implementation of JsonObjectVisitor
+        virtual void VisitString(infra::BoundedConstString tag, infra::BoundedConstString value) override;
+        virtual void VisitNumber(infra::BoundedConstString tag, int64_t value) override;
+        virtual void VisitBoolean(infra::BoundedConstString tag, bool value) override;
+        virtual void VisitNull(infra::BoundedConstString tag) override;
+        virtual JsonObjectVisitor* VisitObject(infra::BoundedConstString tag, JsonSubObjectParser& parser) override;
+        virtual JsonArrayVisitor* VisitArray(infra::BoundedConstString tag, JsonSubArrayParser& parser) override;
+        virtual void Close() override;
+        virtual void ParseError() override;
+        virtual void SemanticError() override;
+        virtual void StringOverflow() override;
+
+    private:
+        template<class Visit>
+        void VisitScalar(uint32_t candidates, std::size_t depth, infra::BoundedConstString key, Visit visit);
+        Level* VisitContainer(uint32_t candidates, std::size_t depth, infra::BoundedConstString key);
+        void StringOverflow(uint32_t candidates, std::size_t depth);
+        void LevelClosed();
+
+        uint32_t Matches(uint32_t candidates, std::size_t depth, infra::BoundedConstString key, bool last) const;
+
+    private:
+        infra::BoundedVector<Level>& levels;
+        infra::MemoryRange<const infra::BoundedConstString> pointers;
+        JsonPointerVisitor& visitor;
+        uint32_t candidates;
+    };
+}
+
+#endif
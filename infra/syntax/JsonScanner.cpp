@@ -0,0 +1,93 @@
+#include "infra/syntax/JsonScanner.hpp"
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#if defined(__SSE2__)
+    const std::size_t blockSize = sizeof(__m128i);
+
+    __m128i LoadBlock(const char* position)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+    }
+
+    __m128i EqualTo(__m128i block, char c)
+    {
+        return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+    }
+
+    bool ContainsStringDelimiter(const char* position)
+    {
+        auto block = LoadBlock(position);
+        return _mm_movemask_epi8(_mm_or_si128(EqualTo(block, '"'), EqualTo(block, '\\'))) != 0;
+    }
+
+    bool AllWhitespace(const char* position)
+    {
+        auto block = LoadBlock(position);
+        auto whitespace = _mm_or_si128(_mm_or_si128(EqualTo(block, ' '), EqualTo(block, '\n')), _mm_or_si128(EqualTo(block, '\r'), EqualTo(block, '\t')));
+        return _mm_movemask_epi8(whitespace) == 0xffff;
+    }
+#else
+    const std::size_t blockSize = sizeof(uint64_t);
+    const uint64_t lowBits = 0x7f7f7f7f7f7f7f7f;
+    const uint64_t highBits = 0x8080808080808080;
+
+    uint64_t LoadBlock(const char* position)
+    {
+        uint64_t block;
+        std::memcpy(&block, position, sizeof(block));
+        return block;
+    }
+
+    // Sets the high bit of each byte in block that equals c, without carries between bytes
+    uint64_t EqualTo(uint64_t block, char c)
+    {
+        uint64_t difference = block ^ (0x0101010101010101 * static_cast<uint8_t>(c));
+        return ~(((difference & lowBits) + lowBits) | difference | lowBits);
+    }
+
+    bool ContainsStringDelimiter(const char* position)
+    {
+        auto block = LoadBlock(position);
+        return (EqualTo(block, '"') | EqualTo(block, '\\')) != 0;
+    }
+
+    bool AllWhitespace(const char* position)
+    {
+        auto block = LoadBlock(position);
+        return (EqualTo(block, ' ') | EqualTo(block, '\n') | EqualTo(block, '\r') | EqualTo(block, '\t')) == highBits;
+    }
+#endif
+}
+
+namespace infra
+{
+    const char* FindJsonStringDelimiter(const char* begin, const char* end)
+    {
+        while (static_cast<std::size_t>(end - begin) >= blockSize && !ContainsStringDelimiter(begin))
+            begin += blockSize;
+
+        while (begin != end && *begin != '"' && *begin != '\\')
+            ++begin;
+
+        return begin;
+    }
+
+    const char* SkipJsonWhitespace(const char* begin, const char* end)
+    {
+        while (static_cast<std::size_t>(end - begin) >= blockSize && AllWhitespace(begin))
+            begin += blockSize;
+
+        while (begin != end && std::isspace(static_cast<unsigned char>(*begin)))
+            ++begin;
+
+        return begin;
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef INFRA_JSON_SCANNER_HPP
+#define INFRA_JSON_SCANNER_HPP
+
+namespace infra
+{
+    // These functions inspect multiple characters at a time: 16 when SSE2 is available, otherwise 8 using
+    // word-sized arithmetic. Their results are identical to a character-by-character scan.
+
+    // Returns the position of the first '"' or '\\' in [begin, end), or end when there is none
+    const char* FindJsonStringDelimiter(const char* begin, const char* end);
+
+    // Returns the position of the first character in [begin, end) that is not whitespace, or end when there is none
+    const char* SkipJsonWhitespace(const char* begin, const char* end);
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "infra/syntax/JsonStreamingParser.hpp"
+#include "infra/syntax/JsonScanner.hpp"
 #include "infra/util/Function.hpp"
+#include <algorithm>
 #include <cctype>
 
 namespace infra
@@ -149,10 +151,7 @@ namespace infra
                 {
                     case TokenState::open:
                         if (std::isspace(c))
-                        {
-                            while (!data.empty() && std::isspace(data.front()))
-                                data.pop_front();
-                        }
+                            data.pop_front(SkipJsonWhitespace(data.begin(), data.end()) - data.begin());
                         else
                             switch (c)
                             {
@@ -207,7 +206,10 @@ namespace infra
                             else if (c == '"')
                                 FoundToken(tokenState == TokenState::stringOpen ? Token::string : Token::stringOverflow);
                             else
+                            {
                                 AddToValueBuffer(c, saveValue, true);
+                                AddStringContentsToValueBuffer(data, saveValue);
+                            }
 
                             if ((tokenState != TokenState::stringOpen && tokenState != TokenState::stringOverflowOpen) || data.empty())
                                 break;
@@ -351,6 +353,26 @@ namespace infra
             valueBuffer += c;
     }
 
+    void JsonSubParser::AddStringContentsToValueBuffer(infra::MemoryRange<const char>& data, bool saveValue)
+    {
+        auto contents = infra::MakeRange(data.begin(), FindJsonStringDelimiter(data.begin(), data.end()));
+        if (contents.empty())
+            return;
+
+        data.pop_front(contents.size());
+
+        auto available = valueBuffer.max_size() - valueBuffer.size();
+        if (saveValue)
+        {
+            if (contents.size() > available)
+                tokenState = TokenState::stringOverflowOpen;
+
+            valueBuffer.append(contents.begin(), std::min(contents.size(), available));
+        }
+        else if (available == 0)
+            tokenState = TokenState::stringOverflowOpen;
+    }
+
     JsonSubObjectParser::JsonSubObjectParser(infra::BoundedString tagBuffer, infra::BoundedString valueBuffer,
         char& subObjects, JsonObjectVisitor& visitor)
         : JsonSubParser(tagBuffer, valueBuffer, subObjects)
@@ -125,6 +125,7 @@ namespace infra
         void FoundToken(Token found);
         void ProcessEscapedData(char c, bool saveValue);
         void AddToValueBuffer(char c, bool saveValue, bool inString);
+        void AddStringContentsToValueBuffer(infra::MemoryRange<const char>& data, bool saveValue);
 
     protected:
         infra::BoundedString tagBuffer;
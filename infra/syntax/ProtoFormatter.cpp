@@ -1,5 +1,16 @@
 #include "infra/syntax/ProtoFormatter.hpp"
 #include "infra/stream/SavedMarkerStream.hpp"
+#include <array>
+
+namespace
+{
+    uint64_t EncodeSignedVarInt(uint64_t value)
+    {
+        static const bool isArithmeticRightShift = (-1 >> 1) == -1;
+        static_assert(isArithmeticRightShift, "");
+        return (value << 1) ^ (static_cast<int64_t>(value) >> 63);
+    }
+}
 
 namespace infra
 {
@@ -34,22 +45,19 @@ namespace infra
 
     void ProtoFormatter::PutVarInt(uint64_t value)
     {
-        do
-        {
-            if (value > 127)
-                output << static_cast<uint8_t>((value & 0x7f) | 0x80);
-            else
-                output << static_cast<uint8_t>(value);
+        std::array<uint8_t, 10> buffer;
+        std::size_t size = 0;
 
-            value >>= 7;
-        } while (value != 0);
+        for (; value > 127; value >>= 7)
+            buffer[size++] = static_cast<uint8_t>((value & 0x7f) | 0x80);
+        buffer[size++] = static_cast<uint8_t>(value);
+
+        output << infra::ConstByteRange(buffer.data(), buffer.data() + size);
     }
 
     void ProtoFormatter::PutSignedVarInt(uint64_t value)
     {
-        static const bool isArithmeticRightShift = (-1 >> 1) == -1;
-        static_assert(isArithmeticRightShift, "");
-        PutVarInt((value << 1) ^ (static_cast<int64_t>(value) >> 63));
+        PutVarInt(EncodeSignedVarInt(value));
     }
 
     void ProtoFormatter::PutFixed32(uint32_t value)
@@ -121,4 +129,35 @@ namespace infra
     {
         return ProtoLengthDelimitedFormatter(*this, fieldNumber);
     }
+
+    void ProtoFormatter::PutLengthDelimitedSize(std::size_t size, uint32_t fieldNumber)
+    {
+        PutVarInt((fieldNumber << 3) | 2);
+        PutVarInt(size);
+    }
+
+    std::size_t ProtoFormatter::VarIntSize(uint64_t value)
+    {
+        std::size_t size = 1;
+
+        for (; value > 127; value >>= 7)
+            ++size;
+
+        return size;
+    }
+
+    std::size_t ProtoFormatter::SignedVarIntSize(uint64_t value)
+    {
+        return VarIntSize(EncodeSignedVarInt(value));
+    }
+
+    std::size_t ProtoFormatter::TagSize(uint32_t fieldNumber)
+    {
+        return VarIntSize(fieldNumber << 3);
+    }
+
+    std::size_t ProtoFormatter::LengthDelimitedFieldSize(std::size_t size, uint32_t fieldNumber)
+    {
+        return TagSize(fieldNumber) + VarIntSize(size) + size;
+    }
 }
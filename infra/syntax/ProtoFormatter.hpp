@@ -43,6 +43,15 @@ namespace infra
         void PutBytesField(infra::ConstByteRange bytes, uint32_t fieldNumber);
         ProtoLengthDelimitedFormatter LengthDelimitedFormatter(uint32_t fieldNumber);
 
+        // Writes the tag and length of a length-delimited field whose contents are written next; when the size of
+        // the contents is known up front, this avoids the insertion a ProtoLengthDelimitedFormatter does afterwards
+        void PutLengthDelimitedSize(std::size_t size, uint32_t fieldNumber);
+
+        static std::size_t VarIntSize(uint64_t value);
+        static std::size_t SignedVarIntSize(uint64_t value);
+        static std::size_t TagSize(uint32_t fieldNumber);
+        static std::size_t LengthDelimitedFieldSize(std::size_t size, uint32_t fieldNumber);
+
     private:
         friend class ProtoLengthDelimitedFormatter;
         infra::DataOutputStream output;
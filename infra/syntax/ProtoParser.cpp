@@ -1,4 +1,9 @@
 #include "infra/syntax/ProtoParser.hpp"
+#include <algorithm>
+#include <cstring>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace infra
 {
@@ -87,19 +92,46 @@ namespace infra
 
     uint64_t ProtoParser::GetVarInt()
     {
-        uint64_t result = 0;
-        uint8_t byte = 0;
-        uint8_t shift = 0;
+        // PeekContiguousRange is not bounded by the limited reader, so clip it to what is available
+        auto range = infra::Head(input.PeekContiguousRange(), input.Available());
 
-        do
+#if defined(__BMI2__)
+        if (range.size() >= sizeof(uint64_t))
         {
-            input >> byte;
+            uint64_t word;
+            std::memcpy(&word, range.begin(), sizeof(word));
+            uint64_t stops = ~word & 0x8080808080808080;
+
+            if (stops != 0)
+            {
+                std::size_t size = (__builtin_ctzll(stops) >> 3) + 1;
+                uint64_t mask = size == sizeof(uint64_t) ? ~uint64_t(0) : (uint64_t(1) << (size * 8)) - 1;
+
+                input.Consume(size);
+                return _pext_u64(word & mask, 0x7f7f7f7f7f7f7f7f);
+            }
+        }
+#endif
 
-            result += static_cast<uint64_t>(byte & 0x7f) << shift;
-            shift += 7;
-        } while (!input.Failed() && (byte & 0x80) != 0);
+        uint64_t result = 0;
+        std::size_t maxSize = std::min<std::size_t>(range.size(), maxVarIntSize);
+        for (std::size_t i = 0; i != maxSize; ++i)
+        {
+            result |= static_cast<uint64_t>(range[i] & 0x7f) << (7 * i);
 
-        return result;
+            if ((range[i] & 0x80) == 0)
+            {
+                input.Consume(i + 1);
+                return result;
+            }
+        }
+
+        return GetVarIntByteWise();
+    }
+
+    int64_t ProtoParser::GetSignedVarInt()
+    {
+        return DecodeSignedVarInt(GetVarInt());
     }
 
     uint32_t ProtoParser::GetFixed32()
@@ -147,4 +179,26 @@ namespace infra
     {
         return formatErrorPolicy.Failed();
     }
+
+    uint64_t ProtoParser::GetVarIntByteWise()
+    {
+        uint64_t result = 0;
+        uint8_t byte = 0;
+        uint8_t shift = 0;
+
+        do
+        {
+            input >> byte;
+
+            result += static_cast<uint64_t>(byte & 0x7f) << shift;
+            shift += 7;
+        } while (!input.Failed() && (byte & 0x80) != 0);
+
+        return result;
+    }
+
+    int64_t ProtoParser::DecodeSignedVarInt(uint64_t value)
+    {
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
 }
@@ -44,6 +44,7 @@ namespace infra
 
         bool Empty() const;
         uint64_t GetVarInt();
+        int64_t GetSignedVarInt();
         uint32_t GetFixed32();
         uint64_t GetFixed64();
 
@@ -52,7 +53,14 @@ namespace infra
         void ReportFormatResult(bool ok);
         bool FormatFailed() const;
 
+        static int64_t DecodeSignedVarInt(uint64_t value);
+
+    private:
+        uint64_t GetVarIntByteWise();
+
     private:
+        static constexpr std::size_t maxVarIntSize = 10;
+
         infra::LimitedStreamReader limitedReader;
         infra::DataInputStream input;
         infra::StreamErrorPolicy& formatErrorPolicy;
@@ -560,6 +560,97 @@ TEST(JsonObjectTest, get_nonexistent_string_sets_error_on_object)
     EXPECT_TRUE(object.Error());
 }
 
+TEST(JsonObjectIndexTest, get_values_by_key)
+{
+    infra::JsonObject object(R"({ "string": "value", "integer": 5, "boolean": true, "object": { "nested": 1 }, "array": [ 1 ] })");
+    infra::JsonObjectIndex::WithMaxKeys<8> index(object);
+
+    EXPECT_EQ("value", index.GetString("string"));
+    EXPECT_EQ(5, index.GetInteger("integer"));
+    EXPECT_TRUE(index.GetBoolean("boolean"));
+    EXPECT_EQ(1, index.GetObject("object").GetInteger("nested"));
+    EXPECT_EQ(infra::JsonArray("[ 1 ]"), index.GetArray("array"));
+    EXPECT_TRUE(index.HasKey("integer"));
+    EXPECT_FALSE(index.HasKey("absent"));
+    EXPECT_TRUE(index.Complete());
+    EXPECT_FALSE(index.Error());
+}
+
+TEST(JsonObjectIndexTest, get_optional_values_by_key)
+{
+    infra::JsonObject object(R"({ "integer": 5 })");
+    infra::JsonObjectIndex::WithMaxKeys<4> index(object);
+
+    EXPECT_EQ(infra::MakeOptional<int32_t>(5), index.GetOptionalInteger("integer"));
+    EXPECT_EQ(infra::none, index.GetOptionalString("integer"));
+    EXPECT_EQ(infra::none, index.GetOptionalInteger("absent"));
+    EXPECT_FALSE(index.Error());
+}
+
+TEST(JsonObjectIndexTest, get_nonexistent_or_mistyped_value_sets_error)
+{
+    infra::JsonObject object(R"({ "integer": 5 })");
+    infra::JsonObjectIndex::WithMaxKeys<4> index1(object);
+    infra::JsonObjectIndex::WithMaxKeys<4> index2(object);
+
+    index1.GetString("absent");
+    EXPECT_TRUE(index1.Error());
+
+    index2.GetString("integer");
+    EXPECT_TRUE(index2.Error());
+}
+
+TEST(JsonObjectIndexTest, incorrect_object_sets_error)
+{
+    infra::JsonObject object(R"({ "key" 5 })");
+    infra::JsonObjectIndex::WithMaxKeys<4> index(object);
+
+    EXPECT_TRUE(index.Error());
+}
+
+TEST(JsonObjectIndexTest, escaped_keys_are_found_by_their_unescaped_value)
+{
+    infra::JsonObject object(R"({ "a\tb": 1, "\u0041": 2 })");
+    infra::JsonObjectIndex::WithMaxKeys<4> index(object);
+
+    EXPECT_EQ(1, index.GetInteger("a\tb"));
+    EXPECT_EQ(2, index.GetInteger("A"));
+}
+
+TEST(JsonObjectIndexTest, first_of_duplicate_keys_is_found)
+{
+    infra::JsonObject object(R"({ "key": 1, "key": 2 })");
+    infra::JsonObjectIndex::WithMaxKeys<4> index(object);
+
+    EXPECT_EQ(1, index.GetInteger("key"));
+}
+
+TEST(JsonObjectIndexTest, duplicate_keys_with_different_types_are_found_like_in_object)
+{
+    infra::JsonObject object(R"({ "key": "a", "key": 2, "key": 3 })");
+    infra::JsonObjectIndex::WithMaxKeys<4> index(object);
+
+    EXPECT_EQ(object.GetInteger("key"), index.GetInteger("key"));
+    EXPECT_EQ(2, index.GetInteger("key"));
+    EXPECT_EQ(object.GetString("key"), index.GetString("key"));
+    EXPECT_EQ(object.GetOptionalInteger("key"), index.GetOptionalInteger("key"));
+    EXPECT_EQ(infra::none, index.GetOptionalBoolean("key"));
+    EXPECT_TRUE(index.GetValue("key").Is<infra::JsonString>());
+    EXPECT_FALSE(index.Error());
+}
+
+TEST(JsonObjectIndexTest, keys_beyond_capacity_are_found_by_iterating_the_object)
+{
+    infra::JsonObject object(R"({ "a": 1, "b": 2, "c": 3 })");
+    infra::JsonObjectIndex::WithMaxKeys<2> index(object);
+
+    EXPECT_FALSE(index.Complete());
+    EXPECT_EQ(1, index.GetInteger("a"));
+    EXPECT_EQ(3, index.GetInteger("c"));
+    EXPECT_FALSE(index.HasKey("d"));
+    EXPECT_FALSE(index.Error());
+}
+
 TEST(JsonObjectTest, nested_float_is_accepted)
 {
     infra::JsonObject object(R"({ "key": { "nestedKey", 1.5 } })");
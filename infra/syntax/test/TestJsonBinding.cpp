@@ -0,0 +1,151 @@
+#include "infra/syntax/JsonBinding.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    struct Firmware
+    {
+        infra::BoundedString::WithStorage<16> url;
+        uint32_t version = 0;
+    };
+
+    struct Configuration
+    {
+        infra::BoundedString::WithStorage<8> name;
+        int16_t offset = 0;
+        uint8_t level = 0;
+        bool enabled = false;
+        Firmware firmware;
+    };
+
+    constexpr auto firmwareBinding = infra::MakeJsonBinding<Firmware>(
+        infra::JsonField("url", &Firmware::url),
+        infra::JsonField("version", &Firmware::version));
+
+    constexpr auto configurationBinding = infra::MakeJsonBinding<Configuration>(
+        infra::JsonField("name", &Configuration::name),
+        infra::JsonField("offset", &Configuration::offset),
+        infra::JsonField("level", &Configuration::level),
+        infra::JsonField("enabled", &Configuration::enabled),
+        infra::JsonField("firmware", &Configuration::firmware, firmwareBinding));
+}
+
+class JsonBindingTest
+    : public testing::Test
+{
+public:
+    Configuration configuration;
+    infra::JsonBindingVisitor<decltype(configurationBinding)> visitor{ configurationBinding, configuration };
+    infra::JsonStreamingObjectParser::WithBuffers<16, 32, 4> parser{ visitor };
+};
+
+TEST_F(JsonBindingTest, every_key_is_found_and_unknown_keys_are_not)
+{
+    EXPECT_EQ(0, configurationBinding.FindField("name"));
+    EXPECT_EQ(1, configurationBinding.FindField("offset"));
+    EXPECT_EQ(2, configurationBinding.FindField("level"));
+    EXPECT_EQ(3, configurationBinding.FindField("enabled"));
+    EXPECT_EQ(4, configurationBinding.FindField("firmware"));
+    EXPECT_EQ(5, configurationBinding.FindField("nam"));
+    EXPECT_EQ(5, configurationBinding.FindField(""));
+}
+
+TEST(JsonBindingLookupTest, keys_without_perfect_hash_are_found_by_comparison)
+{
+    // Two fields with the same key never map onto separate slots, so no perfect hash exists
+    constexpr auto binding = infra::MakeJsonBinding<Firmware>(
+        infra::JsonField("url", &Firmware::url),
+        infra::JsonField("url", &Firmware::url),
+        infra::JsonField("version", &Firmware::version));
+
+    EXPECT_EQ(0, binding.FindField("url"));
+    EXPECT_EQ(2, binding.FindField("version"));
+    EXPECT_EQ(3, binding.FindField("versio"));
+}
+
+TEST_F(JsonBindingTest, parse_into_members)
+{
+    parser.Feed(R"({ "name": "device", "offset": -5, "level": 3, "enabled": true, "firmware": { "url": "http://x/fw", "version": 7 } })");
+
+    EXPECT_TRUE(visitor.Done());
+    EXPECT_FALSE(visitor.Error());
+    EXPECT_EQ("device", configuration.name);
+    EXPECT_EQ(-5, configuration.offset);
+    EXPECT_EQ(3, configuration.level);
+    EXPECT_TRUE(configuration.enabled);
+    EXPECT_EQ("http://x/fw", configuration.firmware.url);
+    EXPECT_EQ(7, configuration.firmware.version);
+}
+
+TEST_F(JsonBindingTest, parse_in_chunks)
+{
+    parser.Feed(R"({ "na)");
+    parser.Feed(R"(me": "dev)");
+    parser.Feed(R"(ice", "firmware": { "vers)");
+    parser.Feed(R"(ion": 12 } })");
+
+    EXPECT_TRUE(visitor.Done());
+    EXPECT_FALSE(visitor.Error());
+    EXPECT_EQ("device", configuration.name);
+    EXPECT_EQ(12, configuration.firmware.version);
+}
+
+TEST_F(JsonBindingTest, unknown_keys_are_ignored)
+{
+    parser.Feed(R"({ "unknown": "x", "other": { "level": 4 }, "level": 2 })");
+
+    EXPECT_TRUE(visitor.Done());
+    EXPECT_FALSE(visitor.Error());
+    EXPECT_EQ(2, configuration.level);
+}
+
+TEST_F(JsonBindingTest, value_out_of_range_results_in_error)
+{
+    parser.Feed(R"({ "level": 256 })");
+
+    EXPECT_TRUE(visitor.Error());
+    EXPECT_EQ(0, configuration.level);
+}
+
+TEST_F(JsonBindingTest, value_of_wrong_type_results_in_error)
+{
+    parser.Feed(R"({ "enabled": 1 })");
+
+    EXPECT_TRUE(visitor.Error());
+}
+
+TEST_F(JsonBindingTest, string_longer_than_member_is_truncated_and_results_in_error)
+{
+    parser.Feed(R"({ "name": "long device name" })");
+
+    EXPECT_TRUE(visitor.Error());
+    EXPECT_EQ("long dev", configuration.name);
+}
+
+TEST_F(JsonBindingTest, error_in_nested_object_results_in_error)
+{
+    parser.Feed(R"({ "firmware": { "version": -1 } })");
+
+    EXPECT_TRUE(visitor.Done());
+    EXPECT_TRUE(visitor.Error());
+}
+
+TEST(JsonBindingFormatTest, format_members)
+{
+    Configuration configuration;
+    configuration.name = "device";
+    configuration.offset = -5;
+    configuration.level = 3;
+    configuration.enabled = true;
+    configuration.firmware.url = "http://x/fw";
+    configuration.firmware.version = 7;
+
+    infra::BoundedString::WithStorage<160> string;
+
+    {
+        infra::JsonObjectFormatter::WithStringStream formatter(infra::inPlace, string);
+        configurationBinding.Format(formatter, configuration);
+    }
+
+    EXPECT_EQ(R"({ "name":"device", "offset":-5, "level":3, "enabled":true, "firmware":{ "url":"http://x/fw", "version":7 } })", string);
+}
@@ -0,0 +1,75 @@
+#include "infra/syntax/JsonPointerExtractor.hpp"
+#include "infra/syntax/test_doubles/JsonPointerVisitorMock.hpp"
+#include "gmock/gmock.h"
+#include <array>
+
+class JsonPointerExtractorTest
+    : public testing::Test
+{
+public:
+    std::array<infra::BoundedConstString, 5> pointers{ { "/firmware/url", "/firmware/size", "/items/1/id", "/a~1b/c~0d", "/enabled" } };
+    testing::StrictMock<infra::JsonPointerVisitorMock> visitor;
+    infra::JsonPointerExtractor::WithMaxNesting<3> extractor{ pointers, visitor };
+    infra::JsonStreamingObjectParser::WithBuffers<8, 12, 4> parser{ extractor };
+};
+
+TEST_F(JsonPointerExtractorTest, values_at_pointers_are_visited)
+{
+    EXPECT_CALL(visitor, VisitString(0, "http://x"));
+    EXPECT_CALL(visitor, VisitNumber(1, 1024));
+    EXPECT_CALL(visitor, VisitBoolean(4, true));
+    EXPECT_CALL(visitor, Close());
+    parser.Feed(R"({ "firmware": { "url": "http://x", "size": 1024, "other": "y" }, "url": "z", "enabled": true })");
+}
+
+TEST_F(JsonPointerExtractorTest, values_in_arrays_are_found_by_index)
+{
+    EXPECT_CALL(visitor, VisitNumber(2, 20));
+    EXPECT_CALL(visitor, Close());
+    parser.Feed(R"({ "items": [ { "id": 10 }, { "id": 20 }, { "id": 30 } ] })");
+}
+
+TEST_F(JsonPointerExtractorTest, escaped_reference_tokens_are_decoded)
+{
+    EXPECT_CALL(visitor, VisitNull(3));
+    EXPECT_CALL(visitor, Close());
+    parser.Feed(R"({ "a/b": { "c~d": null } })");
+}
+
+TEST_F(JsonPointerExtractorTest, unmatched_subtrees_are_skipped_without_buffering)
+{
+    EXPECT_CALL(visitor, VisitNumber(1, 5));
+    EXPECT_CALL(visitor, Close());
+    parser.Feed(R"({ "other": { "long": "this string does not fit the value buffer", "nested": [ { "x": "another long string" } ] }, )");
+    parser.Feed(R"("firmware": { "size": 5 } })");
+}
+
+TEST_F(JsonPointerExtractorTest, pointer_to_container_does_not_match_scalar)
+{
+    EXPECT_CALL(visitor, Close());
+    parser.Feed(R"({ "firmware": "url", "items": 1 })");
+}
+
+TEST_F(JsonPointerExtractorTest, overflow_where_pointer_can_end_is_reported)
+{
+    EXPECT_CALL(visitor, StringOverflow());
+    EXPECT_CALL(visitor, Close());
+    parser.Feed(R"({ "firmware": { "url": "http://very.long.url" } })");
+}
+
+TEST_F(JsonPointerExtractorTest, match_nested_deeper_than_max_nesting_is_reported)
+{
+    infra::JsonPointerExtractor::WithMaxNesting<1> shallowExtractor{ pointers, visitor };
+    infra::JsonStreamingObjectParser::WithBuffers<8, 12, 4> shallowParser{ shallowExtractor };
+
+    EXPECT_CALL(visitor, SemanticError());
+    EXPECT_CALL(visitor, VisitNumber(1, 5));
+    EXPECT_CALL(visitor, Close());
+    shallowParser.Feed(R"({ "items": [ { "id": 10 }, { "id": 20 } ], "firmware": { "size": 5 } })");
+}
+
+TEST_F(JsonPointerExtractorTest, ParseError_is_reported)
+{
+    EXPECT_CALL(visitor, ParseError());
+    parser.Feed(R"({ "firmware": { "url" ] )");
+}
@@ -0,0 +1,43 @@
+#include "infra/syntax/JsonScanner.hpp"
+#include "gtest/gtest.h"
+#include <string>
+
+TEST(JsonScannerTest, FindJsonStringDelimiter_returns_end_when_absent)
+{
+    std::string contents(40, 'a');
+
+    EXPECT_EQ(contents.data() + contents.size(), infra::FindJsonStringDelimiter(contents.data(), contents.data() + contents.size()));
+}
+
+TEST(JsonScannerTest, FindJsonStringDelimiter_finds_first_delimiter_at_every_position)
+{
+    for (std::size_t size = 1; size != 40; ++size)
+        for (std::size_t position = 0; position != size; ++position)
+            for (char delimiter : { '"', '\\' })
+            {
+                std::string contents(size, 'a');
+                contents[position] = delimiter;
+                contents.back() = '"';
+
+                EXPECT_EQ(contents.data() + position, infra::FindJsonStringDelimiter(contents.data(), contents.data() + contents.size()));
+            }
+}
+
+TEST(JsonScannerTest, SkipJsonWhitespace_returns_end_when_all_whitespace)
+{
+    std::string contents = " \t\r\n \t\r\n \t\r\n \t\r\n \t\r\n \t\r\n ";
+
+    EXPECT_EQ(contents.data() + contents.size(), infra::SkipJsonWhitespace(contents.data(), contents.data() + contents.size()));
+}
+
+TEST(JsonScannerTest, SkipJsonWhitespace_stops_at_first_non_whitespace_at_every_position)
+{
+    for (std::size_t size = 1; size != 40; ++size)
+        for (std::size_t position = 0; position != size; ++position)
+        {
+            std::string contents(size, ' ');
+            contents[position] = '{';
+
+            EXPECT_EQ(contents.data() + position, infra::SkipJsonWhitespace(contents.data(), contents.data() + contents.size()));
+        }
+}
@@ -272,6 +272,19 @@ TEST_F(JsonStreamingObjectParserTest, overflow_in_value_results_in_StringOverflo
     parser.Feed(R"({ "a" : "1234567890123" )");
 }
 
+TEST_F(JsonStreamingObjectParserTest, overflow_in_value_spanning_feeds_results_in_StringOverflow)
+{
+    parser.Feed(R"({ "a" : "123456)");
+    EXPECT_CALL(visitor, StringOverflow());
+    parser.Feed(R"(7890123" )");
+}
+
+TEST_F(JsonStreamingObjectParserTest, VisitString_after_long_whitespace_with_escape_in_value)
+{
+    EXPECT_CALL(visitor, VisitString("a", "b\"c"));
+    parser.Feed("{                                   \"a\"\t\r\n                           : \"b\\\"c\" ");
+}
+
 TEST_F(JsonStreamingObjectParserTest, overflow_in_tag_is_truncated)
 {
     EXPECT_CALL(visitor, VisitString("12345678", "a"));
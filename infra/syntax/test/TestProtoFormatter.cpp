@@ -88,3 +88,39 @@ TEST(ProtoFormatterTest, PutSubObject)
 
     EXPECT_EQ((std::array<uint8_t, 4>{ 4 << 3 | 2, 2, 4 << 3, 2 }), stream.Writer().Processed());
 }
+
+TEST(ProtoFormatterTest, PutLengthDelimitedSize)
+{
+    infra::ByteOutputStream::WithStorage<20> stream;
+    infra::ProtoFormatter formatter(stream);
+
+    formatter.PutLengthDelimitedSize(200, 4);
+    EXPECT_EQ((std::array<uint8_t, 3>{ 4 << 3 | 2, 0xc8, 1 }), stream.Writer().Processed());
+}
+
+TEST(ProtoFormatterTest, VarIntSize)
+{
+    EXPECT_EQ(1, infra::ProtoFormatter::VarIntSize(0));
+    EXPECT_EQ(1, infra::ProtoFormatter::VarIntSize(127));
+    EXPECT_EQ(2, infra::ProtoFormatter::VarIntSize(128));
+    EXPECT_EQ(3, infra::ProtoFormatter::VarIntSize(16384));
+    EXPECT_EQ(10, infra::ProtoFormatter::VarIntSize(static_cast<uint64_t>(-1)));
+}
+
+TEST(ProtoFormatterTest, SignedVarIntSize)
+{
+    EXPECT_EQ(1, infra::ProtoFormatter::SignedVarIntSize(static_cast<uint64_t>(-1)));
+    EXPECT_EQ(1, infra::ProtoFormatter::SignedVarIntSize(63));
+    EXPECT_EQ(2, infra::ProtoFormatter::SignedVarIntSize(64));
+    EXPECT_EQ(10, infra::ProtoFormatter::SignedVarIntSize(static_cast<uint64_t>(std::numeric_limits<int64_t>::min())));
+}
+
+TEST(ProtoFormatterTest, LengthDelimitedFieldSize_matches_PutStringField)
+{
+    infra::ByteOutputStream::WithStorage<200> stream;
+    infra::ProtoFormatter formatter(stream);
+
+    std::string string(130, 'a');
+    formatter.PutStringField(string, 16);
+    EXPECT_EQ(stream.Writer().Processed().size(), infra::ProtoFormatter::LengthDelimitedFieldSize(string.size(), 16));
+}
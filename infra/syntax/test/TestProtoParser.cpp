@@ -1,3 +1,4 @@
+#include "infra/stream/BoundedDequeInputStream.hpp"
 #include "infra/stream/StdVectorInputStream.hpp"
 #include "infra/syntax/ProtoParser.hpp"
 #include "gmock/gmock.h"
@@ -26,6 +27,42 @@ TEST(ProtoParserTest, GetVarInt_largest)
     EXPECT_EQ(std::numeric_limits<uint64_t>::max(), parser.GetVarInt());
 }
 
+TEST(ProtoParserTest, GetVarInt_across_contiguous_ranges)
+{
+    infra::BoundedDeque<uint8_t>::WithMaxSize<4> data{ std::initializer_list<uint8_t>{ 0, 0, 0x85, 0x83 } };
+    data.pop_front();
+    data.pop_front();
+    data.push_back(1);
+    data.push_back(7);
+    infra::BoundedDequeInputStream stream(data);
+    infra::ProtoParser parser(stream);
+
+    EXPECT_EQ(0x4185, parser.GetVarInt());
+    EXPECT_EQ(7, parser.GetVarInt());
+    EXPECT_TRUE(parser.Empty());
+}
+
+TEST(ProtoParserTest, GetVarInt_does_not_read_beyond_length_delimited)
+{
+    infra::StdVectorInputStream::WithStorage stream(infra::inPlace, std::vector<uint8_t>{ (1 << 3) | 2, 1, 0x85, 3 }, infra::softFail);
+    infra::ProtoParser parser(stream);
+
+    infra::ProtoParser::Field field = parser.GetField();
+    infra::ProtoParser nestedParser = field.first.Get<infra::ProtoLengthDelimited>().Parser();
+    nestedParser.GetVarInt();
+    EXPECT_TRUE(stream.Failed());
+}
+
+TEST(ProtoParserTest, GetSignedVarInt)
+{
+    infra::StdVectorInputStream::WithStorage stream(infra::inPlace, std::vector<uint8_t>{ 3, 4, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 1 });
+    infra::ProtoParser parser(stream);
+
+    EXPECT_EQ(-2, parser.GetSignedVarInt());
+    EXPECT_EQ(2, parser.GetSignedVarInt());
+    EXPECT_EQ(std::numeric_limits<int64_t>::min(), parser.GetSignedVarInt());
+}
+
 TEST(ProtoParserTest, GetFixed32)
 {
     infra::StdVectorInputStream::WithStorage stream(infra::inPlace, std::vector<uint8_t>{ 1, 0, 0, 0 });
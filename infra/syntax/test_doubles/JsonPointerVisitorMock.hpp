@@ -0,0 +1,25 @@
+#ifndef INFRA_JSON_POINTER_VISITOR_MOCK_HPP
+#define INFRA_JSON_POINTER_VISITOR_MOCK_HPP
+
+#include "infra/syntax/JsonPointerExtractor.hpp"
+#include "infra/util/test_helper/BoundedStringMatcher.hpp"
+#include "gmock/gmock.h"
+
+namespace infra
+{
+    class JsonPointerVisitorMock
+        : public JsonPointerVisitor
+    {
+    public:
+        MOCK_METHOD2(VisitString, void(std::size_t pointer, BoundedConstString value));
+        MOCK_METHOD2(VisitNumber, void(std::size_t pointer, int64_t value));
+        MOCK_METHOD2(VisitBoolean, void(std::size_t pointer, bool value));
+        MOCK_METHOD1(VisitNull, void(std::size_t pointer));
+        MOCK_METHOD0(Close, void());
+        MOCK_METHOD0(ParseError, void());
+        MOCK_METHOD0(SemanticError, void());
+        MOCK_METHOD0(StringOverflow, void());
+    };
+}
+
+#endif
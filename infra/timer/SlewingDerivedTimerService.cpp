@@ -0,0 +1,112 @@
+#include "infra/timer/SlewingDerivedTimerService.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    const int64_t ppm = 1000000;
+}
+
+namespace infra
+{
+    SlewingDerivedTimerService::SlewingDerivedTimerService(uint32_t id, TimerService& baseTimerService, uint32_t maxSlewRatePpm)
+        : TimerService(id)
+        , baseTimerService(baseTimerService)
+        , timer(baseTimerService.Id())
+        , maxSlewRatePpm(maxSlewRatePpm)
+    {
+        assert(maxSlewRatePpm > 0 && maxSlewRatePpm < ppm);
+    }
+
+    void SlewingDerivedTimerService::NextTriggerChanged()
+    {
+        if (NextTrigger() != TimePoint::max())
+        {
+            nextTrigger = BaseTime(NextTrigger());
+
+            // Compensate for rounding in BaseTime, so that the derived time has certainly reached the trigger when the timer fires
+            while (DerivedTime(nextTrigger) < NextTrigger())
+                nextTrigger += Duration(1);
+
+            timer.Start(nextTrigger, [this]()
+                { Progressed(DerivedTime(nextTrigger)); });
+        }
+        else
+            timer.Cancel();
+    }
+
+    TimePoint SlewingDerivedTimerService::Now() const
+    {
+        return DerivedTime(baseTimerService.Now());
+    }
+
+    Duration SlewingDerivedTimerService::Resolution() const
+    {
+        return baseTimerService.Resolution();
+    }
+
+    void SlewingDerivedTimerService::Shift(Duration shift)
+    {
+        auto oldTime = Now();
+        this->shift = shift;
+        slew = Duration();
+        slewDuration = Duration();
+        Jumped(oldTime, Now());
+        NextTriggerChanged();
+    }
+
+    void SlewingDerivedTimerService::Slew(Duration adjustment)
+    {
+        auto baseNow = baseTimerService.Now();
+
+        shift = ShiftAt(baseNow);
+        slew = adjustment;
+        slewStart = baseNow;
+        slewDuration = std::chrono::abs(adjustment) * ppm / maxSlewRatePpm;
+
+        NextTriggerChanged();
+    }
+
+    Duration SlewingDerivedTimerService::GetCurrentShift() const
+    {
+        return ShiftAt(baseTimerService.Now());
+    }
+
+    Duration SlewingDerivedTimerService::GetPendingSlew() const
+    {
+        return shift + slew - GetCurrentShift();
+    }
+
+    Duration SlewingDerivedTimerService::ShiftAt(TimePoint baseTime) const
+    {
+        auto elapsed = std::min(std::max(baseTime - slewStart, Duration()), slewDuration);
+
+        if (elapsed == slewDuration)
+            return shift + slew;
+
+        auto progress = elapsed * maxSlewRatePpm / ppm;
+        return slew > Duration() ? shift + progress : shift - progress;
+    }
+
+    TimePoint SlewingDerivedTimerService::DerivedTime(TimePoint baseTime) const
+    {
+        return baseTime + ShiftAt(baseTime);
+    }
+
+    TimePoint SlewingDerivedTimerService::BaseTime(TimePoint derivedTime) const
+    {
+        auto beforeSlew = derivedTime - shift;
+        if (beforeSlew <= slewStart)
+            return beforeSlew;
+
+        auto afterSlew = derivedTime - shift - slew;
+        if (afterSlew >= slewStart + slewDuration)
+            return afterSlew;
+
+        // During the slew, derived time progresses (1 +/- rate) times as fast as base time
+        // Split the division to avoid overflowing on long slews
+        auto rate = slew > Duration() ? ppm + maxSlewRatePpm : ppm - maxSlewRatePpm;
+        auto progress = (derivedTime - shift - slewStart).count();
+        return slewStart + Duration(progress / rate * ppm + progress % rate * ppm / rate);
+    }
+}
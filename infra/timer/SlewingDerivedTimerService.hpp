@@ -0,0 +1,44 @@
+#ifndef INFRA_SLEWING_DERIVED_TIMER_SERVICE_HPP
+#define INFRA_SLEWING_DERIVED_TIMER_SERVICE_HPP
+
+#include "infra/timer/TimerService.hpp"
+
+namespace infra
+{
+    // A derived timer service which can be corrected without jumping: a slew is spread out over time,
+    // with the derived clock running at most maxSlewRatePpm parts per million faster or slower than its base.
+    class SlewingDerivedTimerService
+        : public TimerService
+    {
+    public:
+        SlewingDerivedTimerService(uint32_t id, TimerService& baseTimerService, uint32_t maxSlewRatePpm = 500);
+
+        // Implementation of TimerService
+        virtual void NextTriggerChanged() override;
+        virtual TimePoint Now() const override;
+        virtual Duration Resolution() const override;
+
+        void Shift(Duration shift);
+        void Slew(Duration adjustment);
+        Duration GetCurrentShift() const;
+        Duration GetPendingSlew() const;
+
+    private:
+        Duration ShiftAt(TimePoint baseTime) const;
+        TimePoint DerivedTime(TimePoint baseTime) const;
+        TimePoint BaseTime(TimePoint derivedTime) const;
+
+    private:
+        TimerService& baseTimerService;
+        TimerSingleShot timer;
+        TimePoint nextTrigger;
+        uint32_t maxSlewRatePpm;
+
+        Duration shift = Duration();
+        Duration slew = Duration();
+        TimePoint slewStart;
+        Duration slewDuration = Duration();
+    };
+}
+
+#endif
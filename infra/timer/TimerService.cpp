@@ -97,9 +97,9 @@ namespace infra
         for (timerIterator = scheduledTimers.begin(); timerIterator != scheduledTimers.end();)
             timerIterator++->Jumped(from, to);
 
+        // Timers may have moved their trigger times without notifying
         holdUpdate = false;
-        if (updateNeeded)
-            ComputeNextTrigger();
+        ComputeNextTrigger();
     }
 
     TimePoint TimerService::NextTrigger() const
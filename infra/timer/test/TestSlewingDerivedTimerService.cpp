@@ -0,0 +1,103 @@
+#include "infra/event/EventDispatcher.hpp"
+#include "infra/timer/SlewingDerivedTimerService.hpp"
+#include "infra/timer/Timer.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
+#include "infra/util/test_helper/MockCallback.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+class SlewingDerivedTimerServiceTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    SlewingDerivedTimerServiceTest()
+        : slewId(reinterpret_cast<std::ptrdiff_t>(&slewId))
+        , slewingTimerService(slewId, systemTimerService)
+    {}
+
+    std::ptrdiff_t slewId;
+    infra::SlewingDerivedTimerService slewingTimerService;
+};
+
+TEST_F(SlewingDerivedTimerServiceTest, ShiftDoesNotAffectRunningTimers)
+{
+    infra::MockCallback<void()> callback;
+    EXPECT_CALL(callback, callback()).With(After(std::chrono::seconds(3)));
+
+    infra::TimerSingleShot timer(
+        std::chrono::seconds(3), [&callback]()
+        { callback.callback(); },
+        slewId);
+    slewingTimerService.Shift(std::chrono::seconds(1));
+    EXPECT_EQ(systemTimerService.Now() + std::chrono::seconds(1), slewingTimerService.Now());
+
+    ForwardTime(std::chrono::seconds(5));
+}
+
+TEST_F(SlewingDerivedTimerServiceTest, SlewIsAppliedGradually)
+{
+    slewingTimerService.Slew(std::chrono::milliseconds(1));
+    EXPECT_EQ(infra::Duration(), slewingTimerService.GetCurrentShift());
+    EXPECT_EQ(std::chrono::milliseconds(1), slewingTimerService.GetPendingSlew());
+
+    ForwardTime(std::chrono::seconds(1));
+    EXPECT_EQ(std::chrono::microseconds(500), slewingTimerService.GetCurrentShift());
+    EXPECT_EQ(std::chrono::microseconds(500), slewingTimerService.GetPendingSlew());
+
+    ForwardTime(std::chrono::seconds(2));
+    EXPECT_EQ(std::chrono::milliseconds(1), slewingTimerService.GetCurrentShift());
+    EXPECT_EQ(infra::Duration(), slewingTimerService.GetPendingSlew());
+    EXPECT_EQ(systemTimerService.Now() + std::chrono::milliseconds(1), slewingTimerService.Now());
+}
+
+TEST_F(SlewingDerivedTimerServiceTest, NegativeSlewIsAppliedGradually)
+{
+    slewingTimerService.Slew(-std::chrono::milliseconds(1));
+
+    ForwardTime(std::chrono::seconds(1));
+    EXPECT_EQ(-std::chrono::microseconds(500), slewingTimerService.GetCurrentShift());
+
+    ForwardTime(std::chrono::seconds(1));
+    EXPECT_EQ(-std::chrono::milliseconds(1), slewingTimerService.GetCurrentShift());
+}
+
+TEST_F(SlewingDerivedTimerServiceTest, NewSlewContinuesFromCurrentShift)
+{
+    slewingTimerService.Slew(std::chrono::milliseconds(1));
+    ForwardTime(std::chrono::seconds(1));
+
+    slewingTimerService.Slew(-std::chrono::milliseconds(1));
+    EXPECT_EQ(std::chrono::microseconds(500), slewingTimerService.GetCurrentShift());
+
+    ForwardTime(std::chrono::seconds(2));
+    EXPECT_EQ(-std::chrono::microseconds(500), slewingTimerService.GetCurrentShift());
+}
+
+TEST_F(SlewingDerivedTimerServiceTest, ShiftCancelsSlew)
+{
+    slewingTimerService.Slew(std::chrono::milliseconds(1));
+    ForwardTime(std::chrono::seconds(1));
+
+    slewingTimerService.Shift(std::chrono::seconds(1));
+    EXPECT_EQ(infra::Duration(), slewingTimerService.GetPendingSlew());
+
+    ForwardTime(std::chrono::seconds(2));
+    EXPECT_EQ(std::chrono::seconds(1), slewingTimerService.GetCurrentShift());
+}
+
+TEST_F(SlewingDerivedTimerServiceTest, TimerFiresAtSlewedTime)
+{
+    infra::SlewingDerivedTimerService fastSlewingTimerService(slewId + 1, systemTimerService, 500000);
+
+    infra::MockCallback<void()> callback;
+    EXPECT_CALL(callback, callback()).With(After(std::chrono::seconds(2)));
+
+    fastSlewingTimerService.Slew(std::chrono::seconds(2));
+    infra::TimerSingleShot timer(
+        std::chrono::seconds(3), [&callback]()
+        { callback.callback(); },
+        slewId + 1);
+
+    ForwardTime(std::chrono::seconds(5));
+}
@@ -0,0 +1,189 @@
+#ifndef INFRA_OPEN_ADDRESSING_INDEX_HPP
+#define INFRA_OPEN_ADDRESSING_INDEX_HPP
+
+#include "infra/util/MemoryRange.hpp"
+#include "infra/util/ReallyAssert.hpp"
+#include "infra/util/WithStorage.hpp"
+#include <array>
+#include <cstdint>
+
+namespace infra
+{
+    // OpenAddressingIndex is a hash table with linear probing over a fixed number of slots. Elements are stored in the
+    // slots themselves; typically they are pointers to, or small descriptors of, objects that are stored elsewhere.
+    // At least one slot is always kept empty, so that probing for an absent element ends on an empty slot. Erasing an
+    // element shifts back later elements of its probe sequence instead of leaving a tombstone.
+    //
+    // Traits provides:
+    //   static uint32_t Hash(const T& element);
+    //   static bool IsEmpty(const T& element);
+    //   static T Empty();
+    template<class T, class Traits>
+    class OpenAddressingIndex
+    {
+    public:
+        template<std::size_t Slots>
+        using WithSlots = infra::WithStorage<OpenAddressingIndex<T, Traits>, std::array<T, Slots>>;
+
+        explicit OpenAddressingIndex(infra::MemoryRange<T> slots);
+        OpenAddressingIndex(const OpenAddressingIndex& other) = delete;
+        OpenAddressingIndex& operator=(const OpenAddressingIndex& other) = delete;
+
+        std::size_t size() const;
+        bool empty() const;
+        bool full() const;
+
+        // Returns the first element of the probe sequence of hash for which matches returns true
+        template<class Matches>
+        T* find(uint32_t hash, const Matches& matches);
+        template<class Matches>
+        const T* find(uint32_t hash, const Matches& matches) const;
+
+        T& insert(const T& element);
+        // element must refer to a slot, as returned by find or insert
+        void erase(T& element);
+        void clear();
+
+    private:
+        std::size_t HomeSlot(uint32_t hash) const;
+        std::size_t NextSlot(std::size_t slot) const;
+
+    private:
+        infra::MemoryRange<T> slots;
+        std::size_t numberOfElements = 0;
+    };
+
+    // Traits for an index of pointers, in which nullptr marks an empty slot
+    template<class U, uint32_t (*ElementHash)(const U& element)>
+    struct OpenAddressingPointerTraits
+    {
+        static uint32_t Hash(U* element)
+        {
+            return ElementHash(*element);
+        }
+
+        static bool IsEmpty(U* element)
+        {
+            return element == nullptr;
+        }
+
+        static U* Empty()
+        {
+            return nullptr;
+        }
+    };
+
+    ////    Implementation    ////
+
+    template<class T, class Traits>
+    OpenAddressingIndex<T, Traits>::OpenAddressingIndex(infra::MemoryRange<T> slots)
+        : slots(slots)
+    {
+        really_assert(slots.size() > 1);
+        clear();
+    }
+
+    template<class T, class Traits>
+    std::size_t OpenAddressingIndex<T, Traits>::size() const
+    {
+        return numberOfElements;
+    }
+
+    template<class T, class Traits>
+    bool OpenAddressingIndex<T, Traits>::empty() const
+    {
+        return numberOfElements == 0;
+    }
+
+    template<class T, class Traits>
+    bool OpenAddressingIndex<T, Traits>::full() const
+    {
+        return numberOfElements == slots.size() - 1;
+    }
+
+    template<class T, class Traits>
+    template<class Matches>
+    T* OpenAddressingIndex<T, Traits>::find(uint32_t hash, const Matches& matches)
+    {
+        for (auto slot = HomeSlot(hash); !Traits::IsEmpty(slots[slot]); slot = NextSlot(slot))
+            if (matches(slots[slot]))
+                return &slots[slot];
+
+        return nullptr;
+    }
+
+    template<class T, class Traits>
+    template<class Matches>
+    const T* OpenAddressingIndex<T, Traits>::find(uint32_t hash, const Matches& matches) const
+    {
+        for (auto slot = HomeSlot(hash); !Traits::IsEmpty(slots[slot]); slot = NextSlot(slot))
+            if (matches(slots[slot]))
+                return &slots[slot];
+
+        return nullptr;
+    }
+
+    template<class T, class Traits>
+    T& OpenAddressingIndex<T, Traits>::insert(const T& element)
+    {
+        really_assert(!full());
+
+        auto slot = HomeSlot(Traits::Hash(element));
+        while (!Traits::IsEmpty(slots[slot]))
+            slot = NextSlot(slot);
+
+        slots[slot] = element;
+        ++numberOfElements;
+        return slots[slot];
+    }
+
+    template<class T, class Traits>
+    void OpenAddressingIndex<T, Traits>::erase(T& element)
+    {
+        really_assert(&element >= slots.begin() && &element < slots.end() && !Traits::IsEmpty(element));
+
+        std::size_t slot = &element - slots.begin();
+        slots[slot] = Traits::Empty();
+        --numberOfElements;
+
+        for (auto next = NextSlot(slot); !Traits::IsEmpty(slots[next]); next = NextSlot(next))
+        {
+            auto home = HomeSlot(Traits::Hash(slots[next]));
+            bool homeBetweenFreeAndNext = slot <= next ? (home > slot && home <= next) : (home > slot || home <= next);
+
+            if (!homeBetweenFreeAndNext)
+            {
+                slots[slot] = slots[next];
+                slots[next] = Traits::Empty();
+                slot = next;
+            }
+        }
+    }
+
+    template<class T, class Traits>
+    void OpenAddressingIndex<T, Traits>::clear()
+    {
+        for (auto& slot : slots)
+            slot = Traits::Empty();
+
+        numberOfElements = 0;
+    }
+
+    template<class T, class Traits>
+    std::size_t OpenAddressingIndex<T, Traits>::HomeSlot(uint32_t hash) const
+    {
+        return hash % slots.size();
+    }
+
+    template<class T, class Traits>
+    std::size_t OpenAddressingIndex<T, Traits>::NextSlot(std::size_t slot) const
+    {
+        ++slot;
+        if (slot == slots.size())
+            slot = 0;
+
+        return slot;
+    }
+}
+
+#endif
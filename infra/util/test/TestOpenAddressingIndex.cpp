@@ -0,0 +1,180 @@
+#include "infra/util/OpenAddressingIndex.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    struct Element
+    {
+        uint32_t hash;
+        int value;
+    };
+
+    uint32_t HashOf(const Element& element)
+    {
+        return element.hash;
+    }
+
+    using Index = infra::OpenAddressingIndex<Element*, infra::OpenAddressingPointerTraits<Element, &HashOf>>;
+
+    struct SlotTraits
+    {
+        static uint32_t Hash(const Element& element)
+        {
+            return element.hash;
+        }
+
+        static bool IsEmpty(const Element& element)
+        {
+            return element.value == 0;
+        }
+
+        static Element Empty()
+        {
+            return Element{ 0, 0 };
+        }
+    };
+
+    using InlineIndex = infra::OpenAddressingIndex<Element, SlotTraits>;
+}
+
+class OpenAddressingIndexTest
+    : public testing::Test
+{
+public:
+    Element* Find(uint32_t hash, int value)
+    {
+        auto slot = index.find(hash, [value](Element* element)
+            { return element->value == value; });
+
+        return slot != nullptr ? *slot : nullptr;
+    }
+
+    Index::WithSlots<4> index;
+};
+
+TEST_F(OpenAddressingIndexTest, constructed_empty)
+{
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(0, index.size());
+    EXPECT_EQ(nullptr, Find(1, 1));
+}
+
+TEST_F(OpenAddressingIndexTest, find_inserted_elements)
+{
+    Element a{ 1, 10 };
+    Element b{ 2, 20 };
+
+    index.insert(&a);
+    index.insert(&b);
+
+    EXPECT_EQ(2, index.size());
+    EXPECT_EQ(&a, Find(1, 10));
+    EXPECT_EQ(&b, Find(2, 20));
+    EXPECT_EQ(nullptr, Find(1, 30));
+}
+
+TEST_F(OpenAddressingIndexTest, colliding_elements_are_probed)
+{
+    Element a{ 1, 10 };
+    Element b{ 5, 20 };
+    Element c{ 1, 30 };
+
+    index.insert(&a);
+    index.insert(&b);
+    index.insert(&c);
+
+    EXPECT_TRUE(index.full());
+    EXPECT_EQ(&a, Find(1, 10));
+    EXPECT_EQ(&b, Find(5, 20));
+    EXPECT_EQ(&c, Find(1, 30));
+}
+
+TEST_F(OpenAddressingIndexTest, probing_wraps_around_the_end)
+{
+    Element a{ 3, 10 };
+    Element b{ 3, 20 };
+
+    index.insert(&a);
+    index.insert(&b);
+
+    EXPECT_EQ(&b, Find(3, 20));
+}
+
+TEST_F(OpenAddressingIndexTest, erase_shifts_back_later_elements_of_probe_sequence)
+{
+    Element a{ 1, 10 };
+    Element b{ 1, 20 };
+    Element c{ 1, 30 };
+
+    index.insert(&a);
+    index.insert(&b);
+    index.insert(&c);
+
+    index.erase(*index.find(1, [](Element* element)
+        { return element->value == 10; }));
+
+    EXPECT_EQ(2, index.size());
+    EXPECT_EQ(nullptr, Find(1, 10));
+    EXPECT_EQ(&b, Find(1, 20));
+    EXPECT_EQ(&c, Find(1, 30));
+}
+
+TEST_F(OpenAddressingIndexTest, erase_keeps_element_that_is_in_its_home_slot)
+{
+    Element a{ 1, 10 };
+    Element b{ 1, 20 };
+    Element c{ 2, 30 };
+
+    index.insert(&a);
+    index.insert(&b);
+    index.insert(&c);
+
+    index.erase(*index.find(1, [](Element* element)
+        { return element->value == 20; }));
+
+    EXPECT_EQ(&a, Find(1, 10));
+    EXPECT_EQ(&c, Find(2, 30));
+}
+
+TEST_F(OpenAddressingIndexTest, erase_across_the_end)
+{
+    Element a{ 3, 10 };
+    Element b{ 3, 20 };
+    Element c{ 0, 30 };
+
+    index.insert(&a);
+    index.insert(&b);
+    index.insert(&c);
+
+    index.erase(*index.find(3, [](Element* element)
+        { return element->value == 10; }));
+
+    EXPECT_EQ(&b, Find(3, 20));
+    EXPECT_EQ(&c, Find(0, 30));
+}
+
+TEST_F(OpenAddressingIndexTest, clear_removes_all_elements)
+{
+    Element a{ 1, 10 };
+    index.insert(&a);
+
+    index.clear();
+
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(nullptr, Find(1, 10));
+}
+
+TEST(OpenAddressingIndexInlineTest, elements_are_stored_in_slots)
+{
+    InlineIndex::WithSlots<4> index;
+
+    index.insert(Element{ 2, 10 });
+    auto element = index.find(2, [](const Element& element)
+        { return element.value == 10; });
+
+    ASSERT_NE(nullptr, element);
+    element->value = 11;
+
+    EXPECT_NE(nullptr, index.find(2, [](const Element& element)
+        { return element.value == 11; }));
+}
@@ -1,25 +1,40 @@
 #include "protobuf/echo/Echo.hpp"
 #include "infra/event/EventDispatcherWithWeakPtr.hpp"
+#include <cassert>
 
 namespace services
 {
     EchoErrorPolicyAbortOnMessageFormatError echoErrorPolicyAbortOnMessageFormatError;
     EchoErrorPolicyAbort echoErrorPolicyAbort;
 
+    Service::Service(Echo& echo, uint32_t window)
+        : infra::Observer<Service, Echo>(echo)
+        , window(window)
+    {
+        assert(window != 0);
+    }
+
     void Service::MethodDone()
     {
-        inProgress = false;
+        assert(inProgress != 0);
+        --inProgress;
         Rpc().ServiceDone(*this);
     }
 
     bool Service::InProgress() const
     {
-        return inProgress;
+        return inProgress != 0;
     }
 
-    void Service::HandleMethod(uint32_t serviceId, uint32_t methodId, infra::ProtoLengthDelimited& contents, EchoErrorPolicy& errorPolicy)
+    bool Service::WindowFull() const
     {
-        inProgress = true;
+        return inProgress == window;
+    }
+
+    void Service::HandleMethod(uint32_t serviceId, uint32_t methodId, infra::ProtoLengthDelimited& contents, EchoErrorPolicy& errorPolicy, uint32_t requestId)
+    {
+        ++inProgress;
+        this->requestId = requestId;
         Handle(serviceId, methodId, contents, errorPolicy);
     }
 
@@ -28,6 +43,11 @@ namespace services
         return Subject();
     }
 
+    uint32_t Service::RequestId() const
+    {
+        return requestId;
+    }
+
     ServiceProxy::ServiceProxy(Echo& echo, uint32_t maxMessageSize)
         : echo(echo)
         , maxMessageSize(maxMessageSize)
@@ -41,6 +61,14 @@ namespace services
     void ServiceProxy::RequestSend(infra::Function<void()> onGranted)
     {
         this->onGranted = onGranted;
+        requestId = infra::none;
+        echo.RequestSend(*this);
+    }
+
+    void ServiceProxy::RequestSend(infra::Function<void()> onGranted, uint32_t requestId)
+    {
+        this->onGranted = onGranted;
+        this->requestId = requestId;
         echo.RequestSend(*this);
     }
 
@@ -49,11 +77,22 @@ namespace services
         onGranted();
     }
 
+    void ServiceProxy::GrantSend(uint32_t requestId)
+    {
+        this->requestId = requestId;
+        onGranted();
+    }
+
     uint32_t ServiceProxy::MaxMessageSize() const
     {
         return maxMessageSize;
     }
 
+    const infra::Optional<uint32_t>& ServiceProxy::RequestId() const
+    {
+        return requestId;
+    }
+
     void EchoErrorPolicyAbortOnMessageFormatError::MessageFormatError()
     {
         std::abort();
@@ -75,8 +114,9 @@ namespace services
         std::abort();
     }
 
-    EchoOnStreams::EchoOnStreams(EchoErrorPolicy& errorPolicy)
+    EchoOnStreams::EchoOnStreams(EchoErrorPolicy& errorPolicy, EchoFraming framing)
         : errorPolicy(errorPolicy)
+        , framing(framing)
     {}
 
     void EchoOnStreams::RequestSend(ServiceProxy& serviceProxy)
@@ -84,7 +124,7 @@ namespace services
         if (sendRequesters.empty() && streamWriter == nullptr)
         {
             sendRequesters.push_back(serviceProxy);
-            RequestSendStream(serviceProxy.MaxMessageSize());
+            RequestSendStream(serviceProxy.MaxMessageSize() + (framing == EchoFraming::pipelined ? maxRequestIdSize : 0));
         }
         else
             sendRequesters.push_back(serviceProxy);
@@ -100,7 +140,7 @@ namespace services
         streamWriter = nullptr;
 
         if (!sendRequesters.empty())
-            RequestSendStream(sendRequesters.front().MaxMessageSize());
+            RequestSendStream(sendRequesters.front().MaxMessageSize() + (framing == EchoFraming::pipelined ? maxRequestIdSize : 0));
     }
 
     void EchoOnStreams::ServiceDone(Service& service)
@@ -120,10 +160,10 @@ namespace services
                 {
                 if (service.AcceptsService(serviceId))
                 {
-                    if (service.InProgress())
+                    if (service.WindowFull())
                         serviceBusy = serviceId;
                     else
-                        service.HandleMethod(serviceId, methodId, contents, errorPolicy);
+                        service.HandleMethod(serviceId, methodId, contents, errorPolicy, receivedRequestId);
 
                     return true;
                 }
@@ -141,7 +181,19 @@ namespace services
 
         ServiceProxy& proxy = sendRequesters.front();
         sendRequesters.pop_front();
-        proxy.GrantSend();
+
+        if (framing == EchoFraming::pipelined)
+        {
+            auto requestId = proxy.RequestId() != infra::none ? *proxy.RequestId() : nextRequestId++;
+
+            infra::DataOutputStream::WithErrorPolicy stream(*streamWriter);
+            infra::ProtoFormatter formatter(stream);
+            formatter.PutVarInt(requestId);
+
+            proxy.GrantSend(requestId);
+        }
+        else
+            proxy.GrantSend();
     }
 
     bool EchoOnStreams::ServiceBusy() const
@@ -154,6 +206,8 @@ namespace services
         infra::DataInputStream::WithErrorPolicy stream(reader, infra::softFail);
         infra::StreamErrorPolicy formatErrorPolicy(infra::softFail);
         infra::ProtoParser parser(stream, formatErrorPolicy);
+        if (framing == EchoFraming::pipelined)
+            receivedRequestId = static_cast<uint32_t>(parser.GetVarInt());
         uint32_t serviceId = static_cast<uint32_t>(parser.GetVarInt());
         infra::ProtoParser::Field message = parser.GetField();
         if (stream.Failed())
@@ -172,6 +226,11 @@ namespace services
         return true;
     }
 
+    EchoFraming EchoOnStreams::Framing() const
+    {
+        return framing;
+    }
+
     void EchoOnConnection::SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer)
     {
         SetStreamWriter(std::move(writer));
@@ -201,8 +260,8 @@ namespace services
         DataReceived();
     }
 
-    EchoOnMessageCommunication::EchoOnMessageCommunication(MessageCommunication& subject, EchoErrorPolicy& errorPolicy)
-        : EchoOnStreams(errorPolicy)
+    EchoOnMessageCommunication::EchoOnMessageCommunication(MessageCommunication& subject, EchoErrorPolicy& errorPolicy, EchoFraming framing)
+        : EchoOnStreams(errorPolicy, framing)
         , MessageCommunicationObserver(subject)
     {}
 
@@ -214,12 +273,15 @@ namespace services
     void EchoOnMessageCommunication::ReceivedMessage(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader)
     {
         this->reader = std::move(reader);
+        messageStart = this->reader->ConstructSaveMarker();
         ProcessMessage();
     }
 
     void EchoOnMessageCommunication::ServiceDone(Service& service)
     {
-        reader = nullptr;
+        if (Framing() == EchoFraming::sequential)
+            reader = nullptr;
+
         EchoOnStreams::ServiceDone(service);
     }
 
@@ -230,13 +292,17 @@ namespace services
 
     void EchoOnMessageCommunication::BusyServiceDone()
     {
-        // In this class, services are never busy, so BusyServiceDone() is never invoked
-        std::abort();
+        // Only in pipelined framing is a message received while a service is busy; it was not executed, so process it again
+        reader->Rewind(messageStart);
+        ProcessMessage();
     }
 
     void EchoOnMessageCommunication::ProcessMessage()
     {
         if (!EchoOnStreams::ProcessMessage(*reader))
             errorPolicy.MessageFormatError();
+
+        if (Framing() == EchoFraming::pipelined && !ServiceBusy())
+            reader = nullptr;
     }
 }
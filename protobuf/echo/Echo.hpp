@@ -1,6 +1,7 @@
 #ifndef PROTOBUF_ECHO_HPP
 #define PROTOBUF_ECHO_HPP
 
+#include "infra/stream/ByteInputStream.hpp"
 #include "infra/syntax/ProtoFormatter.hpp"
 #include "infra/syntax/ProtoParser.hpp"
 #include "infra/util/Compatibility.hpp"
@@ -30,6 +31,12 @@ namespace services
     struct ProtoInt64
     {};
 
+    struct ProtoSInt32
+    {};
+
+    struct ProtoSInt64
+    {};
+
     struct ProtoFixed32
     {};
 
@@ -72,11 +79,80 @@ namespace services
     struct ProtoUnboundedRepeated
     {};
 
+    // Repeated fields of scalar types are serialized packed into a single length-delimited field;
+    // on deserialization both the packed and the unpacked encoding are accepted
+    template<class T>
+    struct ProtoPacked
+        : std::false_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoBool>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoUInt32>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoInt32>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoUInt64>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoInt64>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoSInt32>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoSInt64>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoFixed32>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoFixed64>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoSFixed32>
+        : std::true_type
+    {};
+
+    template<>
+    struct ProtoPacked<ProtoSFixed64>
+        : std::true_type
+    {};
+
+    template<class T>
+    struct ProtoPacked<ProtoEnum<T>>
+        : std::true_type
+    {};
+
     void SerializeField(ProtoBool, infra::ProtoFormatter& formatter, bool value, uint32_t fieldNumber);
     void SerializeField(ProtoUInt32, infra::ProtoFormatter& formatter, uint32_t value, uint32_t fieldNumber);
     void SerializeField(ProtoInt32, infra::ProtoFormatter& formatter, int32_t value, uint32_t fieldNumber);
     void SerializeField(ProtoUInt64, infra::ProtoFormatter& formatter, uint64_t value, uint32_t fieldNumber);
     void SerializeField(ProtoInt64, infra::ProtoFormatter& formatter, int64_t value, uint32_t fieldNumber);
+    void SerializeField(ProtoSInt32, infra::ProtoFormatter& formatter, int32_t value, uint32_t fieldNumber);
+    void SerializeField(ProtoSInt64, infra::ProtoFormatter& formatter, int64_t value, uint32_t fieldNumber);
     void SerializeField(ProtoFixed32, infra::ProtoFormatter& formatter, uint32_t value, uint32_t fieldNumber);
     void SerializeField(ProtoFixed64, infra::ProtoFormatter& formatter, uint64_t value, uint32_t fieldNumber);
     void SerializeField(ProtoSFixed32, infra::ProtoFormatter& formatter, int32_t value, uint32_t fieldNumber);
@@ -99,11 +175,46 @@ namespace services
     template<std::size_t Max>
     void SerializeField(ProtoString<Max>, infra::ProtoFormatter& formatter, infra::BoundedConstString value, uint32_t fieldNumber);
 
+    // Serializes message as a length-delimited field, computing its size first so that the length is written up front
+    template<class T>
+    void SerializeMessageField(infra::ProtoFormatter& formatter, const T& message, uint32_t fieldNumber);
+
+    std::size_t SerializedFieldSize(ProtoBool, bool value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoUInt32, uint32_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoInt32, int32_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoUInt64, uint64_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoInt64, int64_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoSInt32, int32_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoSInt64, int64_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoFixed32, uint32_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoFixed64, uint64_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoSFixed32, int32_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoSFixed64, int64_t value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoUnboundedString, const std::string& value, uint32_t fieldNumber);
+    std::size_t SerializedFieldSize(ProtoUnboundedBytes, const std::vector<uint8_t>& value, uint32_t fieldNumber);
+
+    template<std::size_t Max, class T, class U>
+    std::size_t SerializedFieldSize(ProtoRepeated<Max, T>, const infra::BoundedVector<U>& value, uint32_t fieldNumber);
+    template<class T, class U>
+    std::size_t SerializedFieldSize(ProtoUnboundedRepeated<T>, const std::vector<U>& value, uint32_t fieldNumber);
+    template<class T>
+    std::size_t SerializedFieldSize(ProtoUnboundedRepeated<T>, const std::vector<bool>& value, uint32_t fieldNumber);
+    template<class T, class U>
+    std::size_t SerializedFieldSize(ProtoMessage<T>, const U& value, uint32_t fieldNumber);
+    template<class T>
+    std::size_t SerializedFieldSize(ProtoEnum<T>, T value, uint32_t fieldNumber);
+    template<std::size_t Max>
+    std::size_t SerializedFieldSize(ProtoBytes<Max>, const infra::BoundedVector<uint8_t>& value, uint32_t fieldNumber);
+    template<std::size_t Max>
+    std::size_t SerializedFieldSize(ProtoString<Max>, infra::BoundedConstString value, uint32_t fieldNumber);
+
     void DeserializeField(ProtoBool, infra::ProtoParser& parser, infra::ProtoParser::Field& field, bool& value);
     void DeserializeField(ProtoUInt32, infra::ProtoParser& parser, infra::ProtoParser::Field& field, uint32_t& value);
     void DeserializeField(ProtoInt32, infra::ProtoParser& parser, infra::ProtoParser::Field& field, int32_t& value);
     void DeserializeField(ProtoUInt64, infra::ProtoParser& parser, infra::ProtoParser::Field& field, uint64_t& value);
     void DeserializeField(ProtoInt64, infra::ProtoParser& parser, infra::ProtoParser::Field& field, int64_t& value);
+    void DeserializeField(ProtoSInt32, infra::ProtoParser& parser, infra::ProtoParser::Field& field, int32_t& value);
+    void DeserializeField(ProtoSInt64, infra::ProtoParser& parser, infra::ProtoParser::Field& field, int64_t& value);
     void DeserializeField(ProtoFixed32, infra::ProtoParser& parser, infra::ProtoParser::Field& field, uint32_t& value);
     void DeserializeField(ProtoFixed64, infra::ProtoParser& parser, infra::ProtoParser::Field& field, uint64_t& value);
     void DeserializeField(ProtoSFixed32, infra::ProtoParser& parser, infra::ProtoParser::Field& field, int32_t& value);
@@ -130,6 +241,54 @@ namespace services
     template<std::size_t Max>
     void DeserializeField(ProtoString<Max>, infra::ProtoParser& parser, infra::ProtoParser::Field& field, infra::BoundedConstString& value);
 
+    void SerializePackedValue(ProtoBool, infra::ProtoFormatter& formatter, bool value);
+    void SerializePackedValue(ProtoUInt32, infra::ProtoFormatter& formatter, uint32_t value);
+    void SerializePackedValue(ProtoInt32, infra::ProtoFormatter& formatter, int32_t value);
+    void SerializePackedValue(ProtoUInt64, infra::ProtoFormatter& formatter, uint64_t value);
+    void SerializePackedValue(ProtoInt64, infra::ProtoFormatter& formatter, int64_t value);
+    void SerializePackedValue(ProtoSInt32, infra::ProtoFormatter& formatter, int32_t value);
+    void SerializePackedValue(ProtoSInt64, infra::ProtoFormatter& formatter, int64_t value);
+    void SerializePackedValue(ProtoFixed32, infra::ProtoFormatter& formatter, uint32_t value);
+    void SerializePackedValue(ProtoFixed64, infra::ProtoFormatter& formatter, uint64_t value);
+    void SerializePackedValue(ProtoSFixed32, infra::ProtoFormatter& formatter, int32_t value);
+    void SerializePackedValue(ProtoSFixed64, infra::ProtoFormatter& formatter, int64_t value);
+    template<class T>
+    void SerializePackedValue(ProtoEnum<T>, infra::ProtoFormatter& formatter, T value);
+
+    std::size_t SerializedPackedValueSize(ProtoBool, bool value);
+    std::size_t SerializedPackedValueSize(ProtoUInt32, uint32_t value);
+    std::size_t SerializedPackedValueSize(ProtoInt32, int32_t value);
+    std::size_t SerializedPackedValueSize(ProtoUInt64, uint64_t value);
+    std::size_t SerializedPackedValueSize(ProtoInt64, int64_t value);
+    std::size_t SerializedPackedValueSize(ProtoSInt32, int32_t value);
+    std::size_t SerializedPackedValueSize(ProtoSInt64, int64_t value);
+    std::size_t SerializedPackedValueSize(ProtoFixed32, uint32_t value);
+    std::size_t SerializedPackedValueSize(ProtoFixed64, uint64_t value);
+    std::size_t SerializedPackedValueSize(ProtoSFixed32, int32_t value);
+    std::size_t SerializedPackedValueSize(ProtoSFixed64, int64_t value);
+    template<class T>
+    std::size_t SerializedPackedValueSize(ProtoEnum<T>, T value);
+
+    void DeserializePackedValue(ProtoBool, infra::ProtoParser& parser, bool& value);
+    void DeserializePackedValue(ProtoUInt32, infra::ProtoParser& parser, uint32_t& value);
+    void DeserializePackedValue(ProtoInt32, infra::ProtoParser& parser, int32_t& value);
+    void DeserializePackedValue(ProtoUInt64, infra::ProtoParser& parser, uint64_t& value);
+    void DeserializePackedValue(ProtoInt64, infra::ProtoParser& parser, int64_t& value);
+    void DeserializePackedValue(ProtoSInt32, infra::ProtoParser& parser, int32_t& value);
+    void DeserializePackedValue(ProtoSInt64, infra::ProtoParser& parser, int64_t& value);
+    void DeserializePackedValue(ProtoFixed32, infra::ProtoParser& parser, uint32_t& value);
+    void DeserializePackedValue(ProtoFixed64, infra::ProtoParser& parser, uint64_t& value);
+    void DeserializePackedValue(ProtoSFixed32, infra::ProtoParser& parser, int32_t& value);
+    void DeserializePackedValue(ProtoSFixed64, infra::ProtoParser& parser, int64_t& value);
+    template<class T>
+    void DeserializePackedValue(ProtoEnum<T>, infra::ProtoParser& parser, T& value);
+
+    // Deserializes the argument of a method with reference parameters, and invokes onArgument with it. The string and bytes
+    // fields of the argument refer into the received contents; when those are not contiguous, e.g. because they wrap around
+    // the end of a ring buffer, they are first copied into Storage.
+    template<class T, class Storage, class F>
+    void DeserializeReferenceArgument(infra::ProtoParser& parser, infra::ProtoLengthDelimited& contents, const F& onArgument);
+
     class EchoErrorPolicy
     {
     protected:
@@ -161,24 +320,40 @@ namespace services
     extern EchoErrorPolicyAbortOnMessageFormatError echoErrorPolicyAbortOnMessageFormatError;
     extern EchoErrorPolicyAbort echoErrorPolicyAbort;
 
+    // In pipelined framing, each message is preceded by a request id. Calls received by a service are then correlated
+    // with the messages it sends back by passing RequestId() to ServiceProxy::RequestSend.
+    enum class EchoFraming
+    {
+        sequential,
+        pipelined
+    };
+
     class Service
         : public infra::Observer<Service, Echo>
     {
     public:
         using infra::Observer<Service, Echo>::Observer;
+        // A service with a window larger than one accepts new calls while earlier calls are not yet done,
+        // and may complete its outstanding calls in any order
+        Service(Echo& echo, uint32_t window);
 
         virtual bool AcceptsService(uint32_t id) const = 0;
 
         void MethodDone();
         bool InProgress() const;
-        void HandleMethod(uint32_t serviceId, uint32_t methodId, infra::ProtoLengthDelimited& contents, EchoErrorPolicy& errorPolicy);
+        bool WindowFull() const;
+        void HandleMethod(uint32_t serviceId, uint32_t methodId, infra::ProtoLengthDelimited& contents, EchoErrorPolicy& errorPolicy, uint32_t requestId = 0);
 
     protected:
         Echo& Rpc();
+        // Request id of the call being handled; valid during Handle
+        uint32_t RequestId() const;
         virtual void Handle(uint32_t serviceId, uint32_t methodId, infra::ProtoLengthDelimited& contents, EchoErrorPolicy& errorPolicy) = 0;
 
     private:
-        bool inProgress = false;
+        uint32_t window = 1;
+        uint32_t inProgress = 0;
+        uint32_t requestId = 0;
     };
 
     class Echo
@@ -199,13 +374,19 @@ namespace services
 
         Echo& Rpc();
         void RequestSend(infra::Function<void()> onGranted);
+        void RequestSend(infra::Function<void()> onGranted, uint32_t requestId);
         void GrantSend();
+        void GrantSend(uint32_t requestId);
         uint32_t MaxMessageSize() const;
 
+        // In pipelined framing, the request id that is sent with the message; valid from the moment the send is granted
+        const infra::Optional<uint32_t>& RequestId() const;
+
     private:
         Echo& echo;
         uint32_t maxMessageSize;
         infra::Function<void()> onGranted;
+        infra::Optional<uint32_t> requestId;
     };
 
     class EchoOnStreams
@@ -213,7 +394,7 @@ namespace services
         , public infra::EnableSharedFromThis<EchoOnStreams>
     {
     public:
-        explicit EchoOnStreams(EchoErrorPolicy& errorPolicy = echoErrorPolicyAbortOnMessageFormatError);
+        explicit EchoOnStreams(EchoErrorPolicy& errorPolicy = echoErrorPolicyAbortOnMessageFormatError, EchoFraming framing = EchoFraming::sequential);
 
         // Implementation of Echo
         virtual void RequestSend(ServiceProxy& serviceProxy) override;
@@ -229,14 +410,20 @@ namespace services
         virtual void SetStreamWriter(infra::SharedPtr<infra::StreamWriter>&& writer);
         bool ServiceBusy() const;
         bool ProcessMessage(infra::StreamReaderWithRewinding& reader);
+        EchoFraming Framing() const;
 
     protected:
         EchoErrorPolicy& errorPolicy;
 
     private:
+        static const uint32_t maxRequestIdSize = 5;
+
+        EchoFraming framing;
         infra::SharedPtr<infra::StreamWriter> streamWriter;
         infra::IntrusiveList<ServiceProxy> sendRequesters;
         infra::Optional<uint32_t> serviceBusy;
+        uint32_t receivedRequestId = 0;
+        uint32_t nextRequestId = 0;
     };
 
     class EchoOnConnection
@@ -260,7 +447,10 @@ namespace services
         , public MessageCommunicationObserver
     {
     public:
-        EchoOnMessageCommunication(MessageCommunication& subject, EchoErrorPolicy& errorPolicy = echoErrorPolicyAbortOnMessageFormatError);
+        // In pipelined framing, a received message is released as soon as it is handled, so that the next message is
+        // received while earlier calls are outstanding. A message for a service with a full window is held until the
+        // service completes a call.
+        EchoOnMessageCommunication(MessageCommunication& subject, EchoErrorPolicy& errorPolicy = echoErrorPolicyAbortOnMessageFormatError, EchoFraming framing = EchoFraming::sequential);
 
         // Implementation of MessageCommunicationObserver
         virtual void SendMessageStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer) override;
@@ -277,6 +467,7 @@ namespace services
 
     private:
         infra::SharedPtr<infra::StreamReaderWithRewinding> reader;
+        std::size_t messageStart = 0;
     };
 
     ////    Implementation    ////
@@ -306,6 +497,16 @@ namespace services
         formatter.PutVarIntField(value, fieldNumber);
     }
 
+    inline void SerializeField(ProtoSInt32, infra::ProtoFormatter& formatter, int32_t value, uint32_t fieldNumber)
+    {
+        formatter.PutSignedVarIntField(value, fieldNumber);
+    }
+
+    inline void SerializeField(ProtoSInt64, infra::ProtoFormatter& formatter, int64_t value, uint32_t fieldNumber)
+    {
+        formatter.PutSignedVarIntField(value, fieldNumber);
+    }
+
     inline void SerializeField(ProtoFixed32, infra::ProtoFormatter& formatter, uint32_t value, uint32_t fieldNumber)
     {
         formatter.PutFixed32Field(value, fieldNumber);
@@ -336,32 +537,163 @@ namespace services
         formatter.PutBytesField(value, fieldNumber);
     }
 
+    namespace detail
+    {
+        template<class T, class Container>
+        std::size_t PackedSize(T, const Container& value)
+        {
+            std::size_t size = 0;
+
+            for (const auto& v : value)
+                size += SerializedPackedValueSize(T(), v);
+
+            return size;
+        }
+
+        template<class T, class Container>
+        void SerializeRepeatedField(std::true_type packed, T, infra::ProtoFormatter& formatter, const Container& value, uint32_t fieldNumber)
+        {
+            if (!value.empty())
+            {
+                formatter.PutLengthDelimitedSize(PackedSize(T(), value), fieldNumber);
+
+                for (const auto& v : value)
+                    SerializePackedValue(T(), formatter, v);
+            }
+        }
+
+        template<class T, class Container>
+        void SerializeRepeatedField(std::false_type packed, T, infra::ProtoFormatter& formatter, const Container& value, uint32_t fieldNumber)
+        {
+            for (const auto& v : value)
+                SerializeField(T(), formatter, v, fieldNumber);
+        }
+
+        template<class T, class Container>
+        std::size_t SerializedRepeatedFieldSize(std::true_type packed, T, const Container& value, uint32_t fieldNumber)
+        {
+            if (value.empty())
+                return 0;
+            else
+                return infra::ProtoFormatter::LengthDelimitedFieldSize(PackedSize(T(), value), fieldNumber);
+        }
+
+        template<class T, class Container>
+        std::size_t SerializedRepeatedFieldSize(std::false_type packed, T, const Container& value, uint32_t fieldNumber)
+        {
+            std::size_t size = 0;
+
+            for (const auto& v : value)
+                size += SerializedFieldSize(T(), v, fieldNumber);
+
+            return size;
+        }
+
+        template<class T, class U>
+        void DeserializeRepeatedValue(T, infra::ProtoParser& parser, infra::ProtoParser::Field& field, infra::BoundedVector<U>& value)
+        {
+            parser.ReportFormatResult(!value.full());
+            if (!value.full())
+            {
+                value.emplace_back();
+                DeserializeField(T(), parser, field, value.back());
+            }
+        }
+
+        template<class T, class U>
+        void DeserializeRepeatedValue(T, infra::ProtoParser& parser, infra::ProtoParser::Field& field, std::vector<U>& value)
+        {
+            value.emplace_back();
+            DeserializeField(T(), parser, field, value.back());
+        }
+
+        template<class T>
+        void DeserializeRepeatedValue(T, infra::ProtoParser& parser, infra::ProtoParser::Field& field, std::vector<bool>& value)
+        {
+            bool result{};
+            DeserializeField(T(), parser, field, result);
+            value.push_back(result);
+        }
+
+        template<class T, class U>
+        bool DeserializePackedElement(T, infra::ProtoParser& parser, infra::BoundedVector<U>& value)
+        {
+            if (value.full())
+                return false;
+
+            value.emplace_back();
+            DeserializePackedValue(T(), parser, value.back());
+            return true;
+        }
+
+        template<class T, class U>
+        bool DeserializePackedElement(T, infra::ProtoParser& parser, std::vector<U>& value)
+        {
+            value.emplace_back();
+            DeserializePackedValue(T(), parser, value.back());
+            return true;
+        }
+
+        template<class T>
+        bool DeserializePackedElement(T, infra::ProtoParser& parser, std::vector<bool>& value)
+        {
+            bool result{};
+            DeserializePackedValue(T(), parser, result);
+            value.push_back(result);
+            return true;
+        }
+
+        template<class T, class Container>
+        void DeserializeRepeatedField(std::true_type packed, T, infra::ProtoParser& parser, infra::ProtoParser::Field& field, Container& value)
+        {
+            if (field.first.Is<infra::ProtoLengthDelimited>())
+            {
+                auto& contents = field.first.Get<infra::ProtoLengthDelimited>();
+                infra::ProtoParser packedParser = contents.Parser();
+
+                while (!packedParser.Empty())
+                    if (!DeserializePackedElement(T(), packedParser, value))
+                    {
+                        parser.ReportFormatResult(false);
+                        contents.SkipEverything();
+                        break;
+                    }
+            }
+            else
+                DeserializeRepeatedValue(T(), parser, field, value);
+        }
+
+        template<class T, class Container>
+        void DeserializeRepeatedField(std::false_type packed, T, infra::ProtoParser& parser, infra::ProtoParser::Field& field, Container& value)
+        {
+            DeserializeRepeatedValue(T(), parser, field, value);
+        }
+    }
+
     template<std::size_t Max, class T, class U>
     void SerializeField(ProtoRepeated<Max, T>, infra::ProtoFormatter& formatter, const infra::BoundedVector<U>& value, uint32_t fieldNumber)
     {
-        for (auto& v : value)
-            SerializeField(T(), formatter, v, fieldNumber);
+        detail::SerializeRepeatedField(ProtoPacked<T>(), T(), formatter, value, fieldNumber);
     }
 
     template<class T, class U>
     void SerializeField(ProtoUnboundedRepeated<T>, infra::ProtoFormatter& formatter, const std::vector<U>& value, uint32_t fieldNumber)
     {
-        for (auto& v : value)
-            SerializeField(T(), formatter, v, fieldNumber);
+        detail::SerializeRepeatedField(ProtoPacked<T>(), T(), formatter, value, fieldNumber);
     }
 
     template<class T>
     void SerializeField(ProtoUnboundedRepeated<T>, infra::ProtoFormatter& formatter, const std::vector<bool>& value, uint32_t fieldNumber)
     {
-        for (auto v : value)
-            SerializeField(T(), formatter, v, fieldNumber);
+        detail::SerializeRepeatedField(ProtoPacked<T>(), T(), formatter, value, fieldNumber);
     }
 
     template<class T, class U>
     void SerializeField(ProtoMessage<T>, infra::ProtoFormatter& formatter, const U& value, uint32_t fieldNumber)
     {
-        infra::ProtoLengthDelimitedFormatter nestedMessage(formatter, fieldNumber);
-        value.Serialize(formatter);
+        // The size of value is cached by the SerializedSize() of the enclosing message
+        formatter.PutLengthDelimitedSize(value.CachedSerializedSize(), fieldNumber);
+        value.SerializeWithCachedSizes(formatter);
     }
 
     template<class T>
@@ -382,6 +714,120 @@ namespace services
         formatter.PutStringField(value, fieldNumber);
     }
 
+    template<class T>
+    void SerializeMessageField(infra::ProtoFormatter& formatter, const T& message, uint32_t fieldNumber)
+    {
+        formatter.PutLengthDelimitedSize(message.SerializedSize(), fieldNumber);
+        message.SerializeWithCachedSizes(formatter);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoBool, bool value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoUInt32, uint32_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoInt32, int32_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoUInt64, uint64_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoInt64, int64_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoSInt32, int32_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::SignedVarIntSize(value);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoSInt64, int64_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::SignedVarIntSize(value);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoFixed32, uint32_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + sizeof(uint32_t);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoFixed64, uint64_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + sizeof(uint64_t);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoSFixed32, int32_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + sizeof(uint32_t);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoSFixed64, int64_t value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + sizeof(uint64_t);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoUnboundedString, const std::string& value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::LengthDelimitedFieldSize(value.size(), fieldNumber);
+    }
+
+    inline std::size_t SerializedFieldSize(ProtoUnboundedBytes, const std::vector<uint8_t>& value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::LengthDelimitedFieldSize(value.size(), fieldNumber);
+    }
+
+    template<std::size_t Max, class T, class U>
+    std::size_t SerializedFieldSize(ProtoRepeated<Max, T>, const infra::BoundedVector<U>& value, uint32_t fieldNumber)
+    {
+        return detail::SerializedRepeatedFieldSize(ProtoPacked<T>(), T(), value, fieldNumber);
+    }
+
+    template<class T, class U>
+    std::size_t SerializedFieldSize(ProtoUnboundedRepeated<T>, const std::vector<U>& value, uint32_t fieldNumber)
+    {
+        return detail::SerializedRepeatedFieldSize(ProtoPacked<T>(), T(), value, fieldNumber);
+    }
+
+    template<class T>
+    std::size_t SerializedFieldSize(ProtoUnboundedRepeated<T>, const std::vector<bool>& value, uint32_t fieldNumber)
+    {
+        return detail::SerializedRepeatedFieldSize(ProtoPacked<T>(), T(), value, fieldNumber);
+    }
+
+    template<class T, class U>
+    std::size_t SerializedFieldSize(ProtoMessage<T>, const U& value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::LengthDelimitedFieldSize(value.SerializedSize(), fieldNumber);
+    }
+
+    template<class T>
+    std::size_t SerializedFieldSize(ProtoEnum<T>, T value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::TagSize(fieldNumber) + infra::ProtoFormatter::VarIntSize(static_cast<uint64_t>(value));
+    }
+
+    template<std::size_t Max>
+    std::size_t SerializedFieldSize(ProtoBytes<Max>, const infra::BoundedVector<uint8_t>& value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::LengthDelimitedFieldSize(value.size(), fieldNumber);
+    }
+
+    template<std::size_t Max>
+    std::size_t SerializedFieldSize(ProtoString<Max>, infra::BoundedConstString value, uint32_t fieldNumber)
+    {
+        return infra::ProtoFormatter::LengthDelimitedFieldSize(value.size(), fieldNumber);
+    }
+
     inline void DeserializeField(ProtoBool, infra::ProtoParser& parser, infra::ProtoParser::Field& field, bool& value)
     {
         parser.ReportFormatResult(field.first.Is<uint64_t>());
@@ -417,6 +863,20 @@ namespace services
             value = static_cast<int64_t>(field.first.Get<uint64_t>());
     }
 
+    inline void DeserializeField(ProtoSInt32, infra::ProtoParser& parser, infra::ProtoParser::Field& field, int32_t& value)
+    {
+        parser.ReportFormatResult(field.first.Is<uint64_t>());
+        if (field.first.Is<uint64_t>())
+            value = static_cast<int32_t>(infra::ProtoParser::DecodeSignedVarInt(field.first.Get<uint64_t>()));
+    }
+
+    inline void DeserializeField(ProtoSInt64, infra::ProtoParser& parser, infra::ProtoParser::Field& field, int64_t& value)
+    {
+        parser.ReportFormatResult(field.first.Is<uint64_t>());
+        if (field.first.Is<uint64_t>())
+            value = infra::ProtoParser::DecodeSignedVarInt(field.first.Get<uint64_t>());
+    }
+
     inline void DeserializeField(ProtoFixed32, infra::ProtoParser& parser, infra::ProtoParser::Field& field, uint32_t& value)
     {
         parser.ReportFormatResult(field.first.Is<uint32_t>());
@@ -462,27 +922,19 @@ namespace services
     template<std::size_t Max, class T, class U>
     void DeserializeField(ProtoRepeated<Max, T>, infra::ProtoParser& parser, infra::ProtoParser::Field& field, infra::BoundedVector<U>& value)
     {
-        parser.ReportFormatResult(!value.full());
-        if (!value.full())
-        {
-            value.emplace_back();
-            DeserializeField(T(), parser, field, value.back());
-        }
+        detail::DeserializeRepeatedField(ProtoPacked<T>(), T(), parser, field, value);
     }
 
     template<class T, class U>
     void DeserializeField(ProtoUnboundedRepeated<T>, infra::ProtoParser& parser, infra::ProtoParser::Field& field, std::vector<U>& value)
     {
-        value.emplace_back();
-        DeserializeField(T(), parser, field, value.back());
+        detail::DeserializeRepeatedField(ProtoPacked<T>(), T(), parser, field, value);
     }
 
     template<class T>
     void DeserializeField(ProtoUnboundedRepeated<T>, infra::ProtoParser& parser, infra::ProtoParser::Field& field, std::vector<bool>& value)
     {
-        bool result{};
-        DeserializeField(T(), parser, field, result);
-        value.push_back(result);
+        detail::DeserializeRepeatedField(ProtoPacked<T>(), T(), parser, field, value);
     }
 
     template<class T, class U>
@@ -517,7 +969,15 @@ namespace services
     {
         parser.ReportFormatResult(field.first.Is<infra::ProtoLengthDelimited>());
         if (field.first.Is<infra::ProtoLengthDelimited>())
-            field.first.Get<infra::ProtoLengthDelimited>().GetBytesReference(value);
+        {
+            auto& contents = field.first.Get<infra::ProtoLengthDelimited>();
+            auto size = contents.Available();
+            contents.GetBytesReference(value);
+
+            // A reference can only be made when the field is contiguous in the received data
+            parser.ReportFormatResult(value.size() == size);
+            contents.SkipEverything();
+        }
     }
 
     template<std::size_t Max>
@@ -533,7 +993,256 @@ namespace services
     {
         parser.ReportFormatResult(field.first.Is<infra::ProtoLengthDelimited>());
         if (field.first.Is<infra::ProtoLengthDelimited>())
-            field.first.Get<infra::ProtoLengthDelimited>().GetStringReference(value);
+        {
+            auto& contents = field.first.Get<infra::ProtoLengthDelimited>();
+            auto size = contents.Available();
+            contents.GetStringReference(value);
+
+            // A reference can only be made when the field is contiguous in the received data
+            parser.ReportFormatResult(value.size() == size);
+            contents.SkipEverything();
+        }
+    }
+
+    namespace detail
+    {
+        template<class T, class F>
+        void InvokeWithReferenceArgument(infra::ProtoParser& parser, infra::ConstByteRange contents, const F& onArgument)
+        {
+            infra::ByteInputStream stream(contents, infra::softFail);
+            infra::StreamErrorPolicy formatErrorPolicy(infra::softFail);
+            infra::ProtoParser argumentParser(stream, formatErrorPolicy);
+            T argument(argumentParser);
+
+            parser.ReportFormatResult(!stream.Failed() && !formatErrorPolicy.Failed());
+            if (!parser.FormatFailed())
+                onArgument(argument);
+        }
+
+        template<class T, class Storage, class F>
+        void InvokeWithCopiedReferenceArgument(infra::ProtoParser& parser, infra::ConstByteRange head, infra::ProtoLengthDelimited& contents, const F& onArgument)
+        {
+            Storage storage;
+
+            if (head.size() + contents.Available() > storage.max_size())
+            {
+                parser.ReportFormatResult(false);
+                contents.SkipEverything();
+                return;
+            }
+
+            storage.insert(storage.end(), head.begin(), head.end());
+            while (contents.Available() != 0)
+            {
+                infra::ConstByteRange part;
+                contents.GetBytesReference(part);
+                if (part.empty())
+                {
+                    parser.ReportFormatResult(false);
+                    return;
+                }
+
+                storage.insert(storage.end(), part.begin(), part.end());
+            }
+
+            InvokeWithReferenceArgument<T>(parser, infra::ConstByteRange(storage.data(), storage.data() + storage.size()), onArgument);
+        }
+    }
+
+    template<class T, class Storage, class F>
+    void DeserializeReferenceArgument(infra::ProtoParser& parser, infra::ProtoLengthDelimited& contents, const F& onArgument)
+    {
+        auto size = contents.Available();
+        infra::ConstByteRange head;
+        contents.GetBytesReference(head);
+
+        if (head.size() == size)
+            detail::InvokeWithReferenceArgument<T>(parser, head, onArgument);
+        else
+            detail::InvokeWithCopiedReferenceArgument<T, Storage>(parser, head, contents, onArgument);
+    }
+
+    inline void SerializePackedValue(ProtoBool, infra::ProtoFormatter& formatter, bool value)
+    {
+        formatter.PutVarInt(value);
+    }
+
+    inline void SerializePackedValue(ProtoUInt32, infra::ProtoFormatter& formatter, uint32_t value)
+    {
+        formatter.PutVarInt(value);
+    }
+
+    inline void SerializePackedValue(ProtoInt32, infra::ProtoFormatter& formatter, int32_t value)
+    {
+        formatter.PutVarInt(value);
+    }
+
+    inline void SerializePackedValue(ProtoUInt64, infra::ProtoFormatter& formatter, uint64_t value)
+    {
+        formatter.PutVarInt(value);
+    }
+
+    inline void SerializePackedValue(ProtoInt64, infra::ProtoFormatter& formatter, int64_t value)
+    {
+        formatter.PutVarInt(value);
+    }
+
+    inline void SerializePackedValue(ProtoSInt32, infra::ProtoFormatter& formatter, int32_t value)
+    {
+        formatter.PutSignedVarInt(value);
+    }
+
+    inline void SerializePackedValue(ProtoSInt64, infra::ProtoFormatter& formatter, int64_t value)
+    {
+        formatter.PutSignedVarInt(value);
+    }
+
+    inline void SerializePackedValue(ProtoFixed32, infra::ProtoFormatter& formatter, uint32_t value)
+    {
+        formatter.PutFixed32(value);
+    }
+
+    inline void SerializePackedValue(ProtoFixed64, infra::ProtoFormatter& formatter, uint64_t value)
+    {
+        formatter.PutFixed64(value);
+    }
+
+    inline void SerializePackedValue(ProtoSFixed32, infra::ProtoFormatter& formatter, int32_t value)
+    {
+        formatter.PutFixed32(static_cast<uint32_t>(value));
+    }
+
+    inline void SerializePackedValue(ProtoSFixed64, infra::ProtoFormatter& formatter, int64_t value)
+    {
+        formatter.PutFixed64(static_cast<uint64_t>(value));
+    }
+
+    template<class T>
+    void SerializePackedValue(ProtoEnum<T>, infra::ProtoFormatter& formatter, T value)
+    {
+        formatter.PutVarInt(static_cast<uint64_t>(value));
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoBool, bool value)
+    {
+        return infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoUInt32, uint32_t value)
+    {
+        return infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoInt32, int32_t value)
+    {
+        return infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoUInt64, uint64_t value)
+    {
+        return infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoInt64, int64_t value)
+    {
+        return infra::ProtoFormatter::VarIntSize(value);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoSInt32, int32_t value)
+    {
+        return infra::ProtoFormatter::SignedVarIntSize(value);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoSInt64, int64_t value)
+    {
+        return infra::ProtoFormatter::SignedVarIntSize(value);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoFixed32, uint32_t value)
+    {
+        return sizeof(uint32_t);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoFixed64, uint64_t value)
+    {
+        return sizeof(uint64_t);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoSFixed32, int32_t value)
+    {
+        return sizeof(uint32_t);
+    }
+
+    inline std::size_t SerializedPackedValueSize(ProtoSFixed64, int64_t value)
+    {
+        return sizeof(uint64_t);
+    }
+
+    template<class T>
+    std::size_t SerializedPackedValueSize(ProtoEnum<T>, T value)
+    {
+        return infra::ProtoFormatter::VarIntSize(static_cast<uint64_t>(value));
+    }
+
+    inline void DeserializePackedValue(ProtoBool, infra::ProtoParser& parser, bool& value)
+    {
+        value = parser.GetVarInt() != 0;
+    }
+
+    inline void DeserializePackedValue(ProtoUInt32, infra::ProtoParser& parser, uint32_t& value)
+    {
+        value = static_cast<uint32_t>(parser.GetVarInt());
+    }
+
+    inline void DeserializePackedValue(ProtoInt32, infra::ProtoParser& parser, int32_t& value)
+    {
+        value = static_cast<int32_t>(parser.GetVarInt());
+    }
+
+    inline void DeserializePackedValue(ProtoUInt64, infra::ProtoParser& parser, uint64_t& value)
+    {
+        value = parser.GetVarInt();
+    }
+
+    inline void DeserializePackedValue(ProtoInt64, infra::ProtoParser& parser, int64_t& value)
+    {
+        value = static_cast<int64_t>(parser.GetVarInt());
+    }
+
+    inline void DeserializePackedValue(ProtoSInt32, infra::ProtoParser& parser, int32_t& value)
+    {
+        value = static_cast<int32_t>(parser.GetSignedVarInt());
+    }
+
+    inline void DeserializePackedValue(ProtoSInt64, infra::ProtoParser& parser, int64_t& value)
+    {
+        value = parser.GetSignedVarInt();
+    }
+
+    inline void DeserializePackedValue(ProtoFixed32, infra::ProtoParser& parser, uint32_t& value)
+    {
+        value = parser.GetFixed32();
+    }
+
+    inline void DeserializePackedValue(ProtoFixed64, infra::ProtoParser& parser, uint64_t& value)
+    {
+        value = parser.GetFixed64();
+    }
+
+    inline void DeserializePackedValue(ProtoSFixed32, infra::ProtoParser& parser, int32_t& value)
+    {
+        value = static_cast<int32_t>(parser.GetFixed32());
+    }
+
+    inline void DeserializePackedValue(ProtoSFixed64, infra::ProtoParser& parser, int64_t& value)
+    {
+        value = static_cast<int64_t>(parser.GetFixed64());
+    }
+
+    template<class T>
+    void DeserializePackedValue(ProtoEnum<T>, infra::ProtoParser& parser, T& value)
+    {
+        value = static_cast<T>(parser.GetVarInt());
     }
 }
 
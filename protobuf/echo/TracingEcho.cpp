@@ -12,8 +12,8 @@ namespace services
         return serviceId;
     }
 
-    TracingEchoOnConnection::TracingEchoOnConnection(services::Tracer& tracer, EchoErrorPolicy& errorPolicy)
-        : EchoOnConnection(errorPolicy)
+    TracingEchoOnConnection::TracingEchoOnConnection(services::Tracer& tracer, EchoErrorPolicy& errorPolicy, EchoFraming framing)
+        : EchoOnConnection(errorPolicy, framing)
         , tracer(tracer)
     {}
 
@@ -59,6 +59,8 @@ namespace services
         infra::ByteInputStream stream(range, infra::noFail);
         infra::StreamErrorPolicy formatErrorPolicy(infra::softFail);
         infra::ProtoParser parser(stream, formatErrorPolicy);
+        if (Framing() == EchoFraming::pipelined)
+            parser.GetVarInt();
         auto serviceId = static_cast<uint32_t>(parser.GetVarInt());
         auto message = parser.GetField();
         if (stream.Failed() || formatErrorPolicy.Failed() || !message.first.Is<infra::ProtoLengthDelimited>())
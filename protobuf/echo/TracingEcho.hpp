@@ -27,7 +27,7 @@ namespace services
         : public EchoOnConnection
     {
     public:
-        TracingEchoOnConnection(services::Tracer& tracer, EchoErrorPolicy& errorPolicy = echoErrorPolicyAbortOnMessageFormatError);
+        TracingEchoOnConnection(services::Tracer& tracer, EchoErrorPolicy& errorPolicy = echoErrorPolicyAbortOnMessageFormatError, EchoFraming framing = EchoFraming::sequential);
 
         void AddServiceTracer(ServiceTracer& service);
         void RemoveServiceTracer(ServiceTracer& service);
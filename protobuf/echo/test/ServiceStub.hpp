@@ -11,6 +11,7 @@ namespace services
     {
     public:
         using services::Service::Service;
+        using services::Service::RequestId;
 
         MOCK_CONST_METHOD1(AcceptsService, bool(uint32_t id));
         MOCK_METHOD1(Method, void(uint32_t value));
@@ -154,3 +154,94 @@ TEST_F(EchoOnConnectionTest, MethodNotFound_is_reported)
     EXPECT_CALL(connection, AckReceived());
     connection.Observer().DataReceived();
 }
+
+class EchoOnConnectionPipelinedTest
+    : public testing::Test
+    , public infra::EventDispatcherWithWeakPtrFixture
+{
+public:
+    EchoOnConnectionPipelinedTest()
+    {
+        connection.Attach(infra::UnOwnedSharedPtr(echo));
+        EXPECT_CALL(service, AcceptsService(1)).WillRepeatedly(testing::Return(true));
+    }
+
+    void ExpectMethodWithRequestId(uint32_t requestId)
+    {
+        EXPECT_CALL(service, Method(5)).WillOnce(testing::Invoke([this, requestId](uint32_t value)
+            {
+                EXPECT_EQ(requestId, service.RequestId());
+            }));
+    }
+
+    testing::StrictMock<services::EchoErrorPolicyMock> errorPolicy;
+    services::ConnectionMock connection;
+    services::EchoOnConnection echo{ errorPolicy, services::EchoFraming::pipelined };
+    testing::StrictMock<services::ServiceStub> service{ echo, 2 };
+};
+
+TEST_F(EchoOnConnectionPipelinedTest, proxy_messages_are_prefixed_with_increasing_request_ids)
+{
+    services::ServiceStubProxy serviceProxy{ echo };
+
+    for (uint8_t requestId = 0; requestId != 2; ++requestId)
+    {
+        EXPECT_CALL(connection, RequestSendStream(23));
+        serviceProxy.RequestSend([&serviceProxy]()
+            {
+                serviceProxy.Method(5);
+            });
+
+        infra::ByteOutputStreamWriter::WithStorage<128> writer;
+        connection.Observer().SendStreamAvailable(infra::UnOwnedSharedPtr(writer));
+
+        EXPECT_EQ((std::vector<uint8_t>{ requestId, 1, 10, 2, 8, 5 }), (std::vector<uint8_t>(writer.Processed().begin(), writer.Processed().end())));
+        EXPECT_EQ(requestId, *serviceProxy.RequestId());
+    }
+}
+
+TEST_F(EchoOnConnectionPipelinedTest, reply_carries_request_id_of_call)
+{
+    services::ServiceStubProxy serviceProxy{ echo };
+
+    EXPECT_CALL(connection, RequestSendStream(23));
+    serviceProxy.RequestSend([&serviceProxy]()
+        {
+            serviceProxy.Method(5);
+        },
+        7);
+
+    infra::ByteOutputStreamWriter::WithStorage<128> writer;
+    connection.Observer().SendStreamAvailable(infra::UnOwnedSharedPtr(writer));
+
+    EXPECT_EQ((std::vector<uint8_t>{ 7, 1, 10, 2, 8, 5 }), (std::vector<uint8_t>(writer.Processed().begin(), writer.Processed().end())));
+}
+
+TEST_F(EchoOnConnectionPipelinedTest, calls_are_handled_until_window_is_full)
+{
+    infra::ByteInputStreamReader::WithStorage<128> reader;
+    infra::Copy(infra::MakeRange(std::array<uint8_t, 18>{ 0, 1, 10, 2, 8, 5, 1, 1, 10, 2, 8, 5, 2, 1, 10, 2, 8, 5 }), infra::Head(infra::MakeRange(reader.Storage()), 18));
+    auto readerPtr = infra::UnOwnedSharedPtr(reader);
+    EXPECT_CALL(connection, ReceiveStream()).WillRepeatedly(testing::Return(readerPtr));
+    {
+        testing::InSequence sequence;
+        ExpectMethodWithRequestId(0);
+        ExpectMethodWithRequestId(1);
+    }
+    EXPECT_CALL(connection, AckReceived()).Times(2);
+    connection.Observer().DataReceived();
+    testing::Mock::VerifyAndClearExpectations(&connection);
+    testing::Mock::VerifyAndClearExpectations(&service);
+
+    infra::ByteInputStreamReader::WithStorage<128> reader2;
+    infra::Copy(infra::MakeRange(std::array<uint8_t, 6>{ 2, 1, 10, 2, 8, 5 }), infra::Head(infra::MakeRange(reader2.Storage()), 6));
+    auto reader2Ptr = infra::UnOwnedSharedPtr(reader2);
+    infra::ByteInputStreamReader::WithStorage<0> emptyReader;
+    auto emptyReaderPtr = infra::UnOwnedSharedPtr(emptyReader);
+    EXPECT_CALL(connection, ReceiveStream()).WillOnce(testing::Return(reader2Ptr)).WillOnce(testing::Return(emptyReaderPtr));
+    EXPECT_CALL(service, AcceptsService(1)).WillRepeatedly(testing::Return(true));
+    ExpectMethodWithRequestId(2);
+    EXPECT_CALL(connection, AckReceived());
+    service.MethodDone();
+    ExecuteAllActions();
+}
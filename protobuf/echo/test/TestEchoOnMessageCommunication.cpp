@@ -2,6 +2,7 @@
 #include "infra/stream/ByteInputStream.hpp"
 #include "infra/stream/ByteOutputStream.hpp"
 #include "infra/util/ConstructBin.hpp"
+#include "infra/util/SharedOptional.hpp"
 #include "infra/util/test_helper/MockCallback.hpp"
 #include "protobuf/echo/Echo.hpp"
 #include "protobuf/echo/test/ServiceStub.hpp"
@@ -89,3 +90,61 @@ TEST_F(EchoOnMessageCommunicationTest, MethodNotFound_is_reported)
     EXPECT_CALL(errorPolicy, MethodNotFound(1, 2));
     ReceiveMessage(infra::ConstructBin()({ 1, 18, 2, 8, 5 }).Range());
 }
+
+class EchoOnMessageCommunicationPipelinedTest
+    : public testing::Test
+    , public infra::EventDispatcherWithWeakPtrFixture
+{
+public:
+    EchoOnMessageCommunicationPipelinedTest()
+    {
+        EXPECT_CALL(service, AcceptsService(1)).WillRepeatedly(testing::Return(true));
+    }
+
+    void ReceiveMessage(infra::SharedOptional<infra::ByteInputStreamReader>& reader, infra::ConstByteRange data)
+    {
+        messageCommunication.GetObserver().ReceivedMessage(reader.Emplace(data));
+    }
+
+    void ExpectMethodWithRequestId(uint32_t value, uint32_t requestId)
+    {
+        EXPECT_CALL(service, Method(value)).WillOnce(testing::Invoke([this, requestId](uint32_t value)
+            {
+                EXPECT_EQ(requestId, service.RequestId());
+            }));
+    }
+
+    testing::StrictMock<services::EchoErrorPolicyMock> errorPolicy;
+    testing::StrictMock<services::MessageCommunicationMock> messageCommunication;
+    services::EchoOnMessageCommunication echo{ messageCommunication, errorPolicy, services::EchoFraming::pipelined };
+    infra::SharedPtr<services::EchoOnMessageCommunication> echoPtr{ infra::UnOwnedSharedPtr(echo) };
+    testing::StrictMock<services::ServiceStub> service{ echo, 2 };
+};
+
+TEST_F(EchoOnMessageCommunicationPipelinedTest, handled_message_is_released_while_call_is_outstanding)
+{
+    infra::SharedOptional<infra::ByteInputStreamReader> reader;
+    ExpectMethodWithRequestId(5, 3);
+    ReceiveMessage(reader, infra::ConstructBin()({ 3, 1, 10, 2, 8, 5 }).Range());
+
+    EXPECT_TRUE(reader.Allocatable());
+    EXPECT_TRUE(service.InProgress());
+}
+
+TEST_F(EchoOnMessageCommunicationPipelinedTest, message_for_service_with_full_window_is_handled_when_a_call_is_done)
+{
+    infra::SharedOptional<infra::ByteInputStreamReader> reader;
+    ExpectMethodWithRequestId(5, 0);
+    ReceiveMessage(reader, infra::ConstructBin()({ 0, 1, 10, 2, 8, 5 }).Range());
+    ExpectMethodWithRequestId(6, 1);
+    ReceiveMessage(reader, infra::ConstructBin()({ 1, 1, 10, 2, 8, 6 }).Range());
+
+    std::array<uint8_t, 6> heldMessage{ 2, 1, 10, 2, 8, 7 };
+    ReceiveMessage(reader, heldMessage);
+    EXPECT_FALSE(reader.Allocatable());
+
+    ExpectMethodWithRequestId(7, 2);
+    service.MethodDone();
+    ExecuteAllActions();
+    EXPECT_TRUE(reader.Allocatable());
+}
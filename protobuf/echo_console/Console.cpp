@@ -1,5 +1,6 @@
 #include "protobuf/echo_console/Console.hpp"
 #include "infra/stream/ByteOutputStream.hpp"
+#include "infra/util/Optional.hpp"
 #include "services/tracer/GlobalTracer.hpp"
 #include <cctype>
 #include <iomanip>
@@ -12,6 +13,100 @@ namespace application
     {
         struct Quit
         {};
+
+        // Determines the wire type of the elements of a packed repeated field; types that are never packed leave wireType empty
+        class PackedWireTypeVisitor
+            : public EchoFieldVisitor
+        {
+        public:
+            explicit PackedWireTypeVisitor(infra::Optional<uint8_t>& wireType)
+                : wireType(wireType)
+            {}
+
+            void VisitInt64(const EchoFieldInt64& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitUint64(const EchoFieldUint64& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitInt32(const EchoFieldInt32& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitSInt64(const EchoFieldSInt64& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitSInt32(const EchoFieldSInt32& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitFixed64(const EchoFieldFixed64& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(1);
+            }
+
+            void VisitFixed32(const EchoFieldFixed32& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(5);
+            }
+
+            void VisitBool(const EchoFieldBool& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitString(const EchoFieldString& field) override
+            {}
+
+            void VisitUnboundedString(const EchoFieldUnboundedString& field) override
+            {}
+
+            void VisitMessage(const EchoFieldMessage& field) override
+            {}
+
+            void VisitBytes(const EchoFieldBytes& field) override
+            {}
+
+            void VisitUnboundedBytes(const EchoFieldUnboundedBytes& field) override
+            {}
+
+            void VisitUint32(const EchoFieldUint32& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitEnum(const EchoFieldEnum& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(0);
+            }
+
+            void VisitSFixed64(const EchoFieldSFixed64& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(1);
+            }
+
+            void VisitSFixed32(const EchoFieldSFixed32& field) override
+            {
+                wireType = infra::MakeOptional<uint8_t>(5);
+            }
+
+            void VisitRepeated(const EchoFieldRepeated& field) override
+            {}
+
+            void VisitUnboundedRepeated(const EchoFieldUnboundedRepeated& field) override
+            {}
+
+        private:
+            infra::Optional<uint8_t>& wireType;
+        };
     }
 
     namespace ConsoleToken
@@ -447,6 +542,16 @@ namespace application
                 std::cout << static_cast<int32_t>(fieldData.Get<uint64_t>());
             }
 
+            void VisitSInt64(const EchoFieldSInt64& field) override
+            {
+                std::cout << infra::ProtoParser::DecodeSignedVarInt(fieldData.Get<uint64_t>());
+            }
+
+            void VisitSInt32(const EchoFieldSInt32& field) override
+            {
+                std::cout << static_cast<int32_t>(infra::ProtoParser::DecodeSignedVarInt(fieldData.Get<uint64_t>()));
+            }
+
             void VisitFixed64(const EchoFieldFixed64& field) override
             {
                 std::cout << fieldData.Get<uint64_t>();
@@ -522,14 +627,52 @@ namespace application
 
             void VisitRepeated(const EchoFieldRepeated& field) override
             {
-                PrintFieldVisitor visitor(fieldData, parser, console);
-                field.type->Accept(visitor);
+                PrintRepeated(*field.type);
             }
 
             void VisitUnboundedRepeated(const EchoFieldUnboundedRepeated& field) override
             {
-                PrintFieldVisitor visitor(fieldData, parser, console);
-                field.type->Accept(visitor);
+                PrintRepeated(*field.type);
+            }
+
+        private:
+            void PrintRepeated(const EchoField& type)
+            {
+                infra::Optional<uint8_t> wireType;
+                PackedWireTypeVisitor wireTypeVisitor(wireType);
+                type.Accept(wireTypeVisitor);
+
+                if (wireType != infra::none && fieldData.Is<infra::ProtoLengthDelimited>())
+                    PrintPacked(type, *wireType);
+                else
+                {
+                    PrintFieldVisitor visitor(fieldData, parser, console);
+                    type.Accept(visitor);
+                }
+            }
+
+            void PrintPacked(const EchoField& type, uint8_t wireType)
+            {
+                infra::ProtoParser packedParser = fieldData.Get<infra::ProtoLengthDelimited>().Parser();
+
+                std::cout << "[";
+                for (bool first = true; !packedParser.Empty(); first = false)
+                {
+                    if (!first)
+                        std::cout << ", ";
+
+                    infra::Variant<uint32_t, uint64_t, infra::ProtoLengthDelimited> element;
+                    if (wireType == 5)
+                        element = packedParser.GetFixed32();
+                    else if (wireType == 1)
+                        element = packedParser.GetFixed64();
+                    else
+                        element = packedParser.GetVarInt();
+
+                    PrintFieldVisitor visitor(element, parser, console);
+                    type.Accept(visitor);
+                }
+                std::cout << "]";
             }
 
         private:
@@ -604,6 +747,16 @@ namespace application
                 services::GlobalTracer().Continue() << "int32";
             }
 
+            void VisitSInt64(const EchoFieldSInt64& field) override
+            {
+                services::GlobalTracer().Continue() << "sint64";
+            }
+
+            void VisitSInt32(const EchoFieldSInt32& field) override
+            {
+                services::GlobalTracer().Continue() << "sint32";
+            }
+
             void VisitFixed64(const EchoFieldFixed64& field) override
             {
                 services::GlobalTracer().Continue() << "fixed64";
@@ -965,6 +1118,22 @@ namespace application
                 formatter.PutVarIntField(value.Get<int64_t>(), field.number);
             }
 
+            void VisitSInt64(const EchoFieldSInt64& field) override
+            {
+                if (!value.Is<int64_t>())
+                    throw ConsoleExceptions::IncorrectType{ valueIndex };
+
+                formatter.PutSignedVarIntField(value.Get<int64_t>(), field.number);
+            }
+
+            void VisitSInt32(const EchoFieldSInt32& field) override
+            {
+                if (!value.Is<int64_t>())
+                    throw ConsoleExceptions::IncorrectType{ valueIndex };
+
+                formatter.PutSignedVarIntField(value.Get<int64_t>(), field.number);
+            }
+
             void VisitFixed32(const EchoFieldFixed32& field) override
             {
                 if (!value.Is<int64_t>())
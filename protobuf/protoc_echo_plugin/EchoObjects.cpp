@@ -128,6 +128,10 @@ namespace application
                     return std::make_shared<EchoFieldUint64>(fieldDescriptor);
                 case google::protobuf::FieldDescriptor::TYPE_INT32:
                     return std::make_shared<EchoFieldInt32>(fieldDescriptor);
+                case google::protobuf::FieldDescriptor::TYPE_SINT64:
+                    return std::make_shared<EchoFieldSInt64>(fieldDescriptor);
+                case google::protobuf::FieldDescriptor::TYPE_SINT32:
+                    return std::make_shared<EchoFieldSInt32>(fieldDescriptor);
                 case google::protobuf::FieldDescriptor::TYPE_FIXED64:
                     return std::make_shared<EchoFieldFixed64>(fieldDescriptor);
                 case google::protobuf::FieldDescriptor::TYPE_FIXED32:
@@ -166,6 +170,10 @@ namespace application
                     return std::make_shared<EchoFieldRepeated>(fieldDescriptor, std::make_shared<EchoFieldUint64>(fieldDescriptor));
                 case google::protobuf::FieldDescriptor::TYPE_INT32:
                     return std::make_shared<EchoFieldRepeated>(fieldDescriptor, std::make_shared<EchoFieldInt32>(fieldDescriptor));
+                case google::protobuf::FieldDescriptor::TYPE_SINT64:
+                    return std::make_shared<EchoFieldRepeated>(fieldDescriptor, std::make_shared<EchoFieldSInt64>(fieldDescriptor));
+                case google::protobuf::FieldDescriptor::TYPE_SINT32:
+                    return std::make_shared<EchoFieldRepeated>(fieldDescriptor, std::make_shared<EchoFieldSInt32>(fieldDescriptor));
                 case google::protobuf::FieldDescriptor::TYPE_FIXED64:
                     return std::make_shared<EchoFieldRepeated>(fieldDescriptor, std::make_shared<EchoFieldFixed64>(fieldDescriptor));
                 case google::protobuf::FieldDescriptor::TYPE_FIXED32:
@@ -204,6 +212,10 @@ namespace application
                     return std::make_shared<EchoFieldUnboundedRepeated>(fieldDescriptor, std::make_shared<EchoFieldUint64>(fieldDescriptor));
                 case google::protobuf::FieldDescriptor::TYPE_INT32:
                     return std::make_shared<EchoFieldUnboundedRepeated>(fieldDescriptor, std::make_shared<EchoFieldInt32>(fieldDescriptor));
+                case google::protobuf::FieldDescriptor::TYPE_SINT64:
+                    return std::make_shared<EchoFieldUnboundedRepeated>(fieldDescriptor, std::make_shared<EchoFieldSInt64>(fieldDescriptor));
+                case google::protobuf::FieldDescriptor::TYPE_SINT32:
+                    return std::make_shared<EchoFieldUnboundedRepeated>(fieldDescriptor, std::make_shared<EchoFieldSInt32>(fieldDescriptor));
                 case google::protobuf::FieldDescriptor::TYPE_FIXED64:
                     return std::make_shared<EchoFieldUnboundedRepeated>(fieldDescriptor, std::make_shared<EchoFieldFixed64>(fieldDescriptor));
                 case google::protobuf::FieldDescriptor::TYPE_FIXED32:
@@ -301,6 +313,16 @@ namespace application
                 maxMessageSize += MaxVarIntSize(std::numeric_limits<uint32_t>::max()) + MaxVarIntSize((field.number << 3) | 2);
             }
 
+            virtual void VisitSInt64(const EchoFieldSInt64& field) override
+            {
+                maxMessageSize += MaxVarIntSize(std::numeric_limits<uint64_t>::max()) + MaxVarIntSize((field.number << 3) | 2);
+            }
+
+            virtual void VisitSInt32(const EchoFieldSInt32& field) override
+            {
+                maxMessageSize += MaxVarIntSize(std::numeric_limits<uint32_t>::max()) + MaxVarIntSize((field.number << 3) | 2);
+            }
+
             virtual void VisitFixed64(const EchoFieldFixed64& field) override
             {
                 maxMessageSize += 8 + MaxVarIntSize((field.number << 3) | 2);
@@ -371,7 +393,9 @@ namespace application
                 uint32_t max = 0;
                 GenerateMaxMessageSizeVisitor visitor(max);
                 field.type->Accept(visitor);
-                maxMessageSize = field.maxArraySize * max;
+
+                // Scalar elements are packed behind a single tag and length, which is not accounted for in max
+                maxMessageSize += field.maxArraySize * max + MaxVarIntSize(field.maxArraySize * max) + MaxVarIntSize((field.number << 3) | 2);
             }
 
             virtual void VisitUnboundedRepeated(const EchoFieldUnboundedRepeated& field) override
@@ -414,6 +438,24 @@ namespace application
         visitor.VisitInt64(*this);
     }
 
+    EchoFieldSInt32::EchoFieldSInt32(const google::protobuf::FieldDescriptor& descriptor)
+        : EchoField("services::ProtoSInt32", descriptor)
+    {}
+
+    void EchoFieldSInt32::Accept(EchoFieldVisitor& visitor) const
+    {
+        visitor.VisitSInt32(*this);
+    }
+
+    EchoFieldSInt64::EchoFieldSInt64(const google::protobuf::FieldDescriptor& descriptor)
+        : EchoField("services::ProtoSInt64", descriptor)
+    {}
+
+    void EchoFieldSInt64::Accept(EchoFieldVisitor& visitor) const
+    {
+        visitor.VisitSInt64(*this);
+    }
+
     EchoFieldFixed32::EchoFieldFixed32(const google::protobuf::FieldDescriptor& descriptor)
         : EchoField("services::ProtoFixed32", descriptor)
     {}
@@ -584,6 +626,7 @@ namespace application
     EchoMethod::EchoMethod(const google::protobuf::MethodDescriptor& descriptor, EchoRoot& root)
         : name(descriptor.name())
         , methodId(descriptor.options().GetExtension(method_id))
+        , referenceParameter(descriptor.options().GetExtension(reference_parameter))
     {
         if (methodId == 0)
             throw UnspecifiedMethodId{ "", name };
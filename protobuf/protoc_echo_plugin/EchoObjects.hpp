@@ -89,6 +89,24 @@ namespace application
         virtual void Accept(EchoFieldVisitor& visitor) const override;
     };
 
+    class EchoFieldSInt32
+        : public EchoField
+    {
+    public:
+        explicit EchoFieldSInt32(const google::protobuf::FieldDescriptor& descriptor);
+
+        virtual void Accept(EchoFieldVisitor& visitor) const override;
+    };
+
+    class EchoFieldSInt64
+        : public EchoField
+    {
+    public:
+        explicit EchoFieldSInt64(const google::protobuf::FieldDescriptor& descriptor);
+
+        virtual void Accept(EchoFieldVisitor& visitor) const override;
+    };
+
     class EchoFieldFixed32
         : public EchoField
     {
@@ -246,6 +264,7 @@ namespace application
         std::string name;
         uint32_t methodId;
         std::shared_ptr<EchoMessage> parameter;
+        bool referenceParameter;
     };
 
     class EchoService
@@ -306,6 +325,8 @@ namespace application
         virtual void VisitInt64(const EchoFieldInt64& field) = 0;
         virtual void VisitUint64(const EchoFieldUint64& field) = 0;
         virtual void VisitInt32(const EchoFieldInt32& field) = 0;
+        virtual void VisitSInt64(const EchoFieldSInt64& field) = 0;
+        virtual void VisitSInt32(const EchoFieldSInt32& field) = 0;
         virtual void VisitFixed64(const EchoFieldFixed64& field) = 0;
         virtual void VisitFixed32(const EchoFieldFixed32& field) = 0;
         virtual void VisitBool(const EchoFieldBool& field) = 0;
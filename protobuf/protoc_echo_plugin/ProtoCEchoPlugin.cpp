@@ -33,6 +33,16 @@ namespace application
                 result = "int32_t";
             }
 
+            virtual void VisitSInt64(const EchoFieldSInt64& field) override
+            {
+                result = "int64_t";
+            }
+
+            virtual void VisitSInt32(const EchoFieldSInt32& field) override
+            {
+                result = "int32_t";
+            }
+
             virtual void VisitFixed64(const EchoFieldFixed64& field) override
             {
                 result = "uint64_t";
@@ -408,6 +418,7 @@ namespace application
         GenerateFieldDeclarations();
         GenerateFieldConstants();
         GenerateMaxMessageSize();
+        GenerateSerializedSizeCache();
     }
 
     void MessageGenerator::GenerateTypeMap(Entities& formatter)
@@ -452,10 +463,17 @@ namespace application
     {
         auto functions = std::make_shared<Access>("public");
 
-        auto serialize = std::make_shared<Function>("Serialize", SerializerBody(), "void", Function::fConst);
+        auto serialize = std::make_shared<Function>("Serialize", "SerializedSize();\nSerializeWithCachedSizes(formatter);\n", "void", Function::fConst);
         serialize->Parameter("infra::ProtoFormatter& formatter");
         functions->Add(serialize);
 
+        functions->Add(std::make_shared<Function>("SerializedSize", SerializedSizeBody(), "std::size_t", Function::fConst));
+        functions->Add(std::make_shared<Function>("CachedSerializedSize", "return cachedSerializedSize;\n", "std::size_t", Function::fConst));
+
+        auto serializeWithCachedSizes = std::make_shared<Function>("SerializeWithCachedSizes", SerializerBody(), "void", Function::fConst);
+        serializeWithCachedSizes->Parameter("infra::ProtoFormatter& formatter");
+        functions->Add(serializeWithCachedSizes);
+
         auto deserialize = std::make_shared<Function>("Deserialize", DeserializerBody(), "void", 0);
         deserialize->Parameter("infra::ProtoParser& parser");
         functions->Add(deserialize);
@@ -580,6 +598,13 @@ namespace application
         }
     }
 
+    void MessageGenerator::GenerateSerializedSizeCache()
+    {
+        auto fields = std::make_shared<Access>("private");
+        fields->Add(std::make_shared<DataMember>("cachedSerializedSize", "mutable std::size_t", "0"));
+        classFormatter->Add(fields);
+    }
+
     std::string MessageGenerator::SerializerBody()
     {
         std::ostringstream result;
@@ -594,6 +619,24 @@ namespace application
         return result.str();
     }
 
+    std::string MessageGenerator::SerializedSizeBody()
+    {
+        std::ostringstream result;
+        {
+            google::protobuf::io::OstreamOutputStream stream(&result);
+            google::protobuf::io::Printer printer(&stream, '$', nullptr);
+
+            printer.Print("std::size_t size = 0;\n");
+
+            for (auto& field : message->fields)
+                printer.Print("size += SerializedFieldSize($type$(), $name$, $constant$);\n", "type", field->protoType, "name", field->name, "constant", field->constantName);
+
+            printer.Print("cachedSerializedSize = size;\nreturn size;\n");
+        }
+
+        return result.str();
+    }
+
     std::string MessageGenerator::DeserializerBody()
     {
         std::ostringstream result;
@@ -786,6 +829,11 @@ namespace application
         return "std::abort();\n";
     }
 
+    std::string MessageReferenceGenerator::SerializedSizeBody()
+    {
+        return "std::abort();\n";
+    }
+
     std::string MessageReferenceGenerator::ClassName() const
     {
         return MessageGenerator::ClassName() + "Reference";
@@ -828,7 +876,13 @@ namespace application
         constructor->Parameter("services::Echo& echo");
         constructor->Initializer("services::Service(echo)");
 
+        auto windowConstructor = std::make_shared<Constructor>(service->name, "", 0);
+        windowConstructor->Parameter("services::Echo& echo");
+        windowConstructor->Parameter("uint32_t window");
+        windowConstructor->Initializer("services::Service(echo, window)");
+
         constructors->Add(constructor);
+        constructors->Add(windowConstructor);
         serviceFormatter->Add(constructors);
     }
 
@@ -855,8 +909,16 @@ namespace application
                 for (auto field : method.parameter->fields)
                 {
                     std::string typeName;
-                    ParameterTypeVisitor visitor(typeName);
-                    field->Accept(visitor);
+                    if (method.referenceParameter)
+                    {
+                        ParameterReferenceTypeVisitor visitor(typeName);
+                        field->Accept(visitor);
+                    }
+                    else
+                    {
+                        ParameterTypeVisitor visitor(typeName);
+                        field->Accept(visitor);
+                    }
                     serviceMethod->Parameter(typeName + " " + field->name);
                 }
             }
@@ -961,7 +1023,29 @@ switch (methodId)
 
             for (auto& method : service->methods)
             {
-                if (method.parameter)
+                if (method.parameter && method.referenceParameter)
+                {
+                    auto maxMessageSize = method.parameter->MaxMessageSize();
+                    auto storage = maxMessageSize != std::nullopt ? "infra::BoundedVector<uint8_t>::WithMaxSize<" + google::protobuf::SimpleItoa(*maxMessageSize) + ">" : "std::vector<uint8_t>";
+
+                    printer.Print(R"(    case id$name$:
+        services::DeserializeReferenceArgument<$argument$, $storage$>(parser, contents, [this](const $argument$& argument)
+            {
+            $name$()",
+                        "name", method.name, "argument", method.parameter->qualifiedDetailReferenceName, "storage", storage);
+
+                    for (auto& field : method.parameter->fields)
+                    {
+                        printer.Print("argument.$field$", "field", field->name);
+                        if (&field != &method.parameter->fields.back())
+                            printer.Print(", ");
+                    }
+
+                    printer.Print(R"(); });
+        break;
+)");
+                }
+                else if (method.parameter)
                 {
                     printer.Print(R"(    case id$name$:
     {
@@ -1011,14 +1095,11 @@ switch (methodId)
             printer.Print(R"(infra::DataOutputStream::WithErrorPolicy stream(Rpc().SendStreamWriter());
 infra::ProtoFormatter formatter(stream);
 formatter.PutVarInt(serviceId);
-{
-    infra::ProtoLengthDelimitedFormatter argumentFormatter = formatter.LengthDelimitedFormatter(id$name$);
-)",
-                "name", method.name);
+)");
 
             if (method.parameter)
             {
-                printer.Print("    $type$(", "type", method.parameter->qualifiedName);
+                printer.Print("services::SerializeMessageField(formatter, $type$(", "type", method.parameter->qualifiedName);
 
                 for (auto& field : method.parameter->fields)
                 {
@@ -1030,13 +1111,12 @@ formatter.PutVarInt(serviceId);
                         printer.Print(", ");
                 }
 
-                printer.Print(R"().Serialize(formatter);
-)");
+                printer.Print("), id$name$);\n", "name", method.name);
             }
+            else
+                printer.Print("formatter.PutLengthDelimitedSize(0, id$name$);\n", "name", method.name);
 
-            printer.Print(R"(}
-Rpc().Send();
-)");
+            printer.Print("Rpc().Send();\n");
         }
 
         return result.str();
@@ -103,7 +103,9 @@ namespace application
         virtual void GenerateFieldDeclarations();
         void GenerateFieldConstants();
         virtual void GenerateMaxMessageSize();
+        void GenerateSerializedSizeCache();
         virtual std::string SerializerBody();
+        virtual std::string SerializedSizeBody();
         virtual std::string DeserializerBody();
         virtual std::string CompareEqualBody() const;
         virtual std::string CompareUnEqualBody() const;
@@ -136,6 +138,7 @@ namespace application
         virtual void GenerateFieldDeclarations() override;
         virtual void GenerateMaxMessageSize() override;
         virtual std::string SerializerBody() override;
+        virtual std::string SerializedSizeBody() override;
 
         virtual std::string ClassName() const override;
         virtual std::string ReferencedName() const override;
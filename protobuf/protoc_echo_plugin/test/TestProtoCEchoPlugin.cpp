@@ -1,8 +1,12 @@
 #include "generated/echo/TestMessages.pb.hpp"
+#include "infra/event/test_helper/EventDispatcherWithWeakPtrFixture.hpp"
+#include "infra/stream/BoundedDequeInputStream.hpp"
 #include "infra/stream/ByteInputStream.hpp"
 #include "infra/stream/ByteOutputStream.hpp"
 #include "infra/syntax/ProtoFormatter.hpp"
 #include "infra/syntax/ProtoParser.hpp"
+#include "infra/util/test_helper/MockHelpers.hpp"
+#include "protobuf/echo/test_doubles/EchoMock.hpp"
 #include "gmock/gmock.h"
 
 TEST(ProtoCEchoPluginTest, serialize_int32)
@@ -265,6 +269,151 @@ TEST(ProtoCEchoPluginTest, deserialize_bytes)
     EXPECT_EQ(value, message.value);
 }
 
+TEST(ProtoCEchoPluginTest, deserialize_bytes_reference)
+{
+    std::array<uint8_t, 4> data{ 10, 2, 5, 6 };
+    infra::ByteInputStream stream(data);
+    infra::ProtoParser parser(stream);
+
+    test_messages::TestBytesReference message(parser);
+    EXPECT_EQ(data.data() + 2, message.value.begin());
+    EXPECT_EQ(2, message.value.size());
+}
+
+TEST(ProtoCEchoPluginTest, deserialize_bytes_reference_that_is_not_contiguous_reports_error)
+{
+    // Wrap the contents of the bytes field around the end of the deque's storage
+    infra::BoundedDeque<uint8_t>::WithMaxSize<6> data;
+    for (int i = 0; i != 3; ++i)
+    {
+        data.push_back(0);
+        data.pop_front();
+    }
+    data.insert(data.end(), { 10, 4, 1, 2, 3, 4 });
+    infra::BoundedDequeInputStream stream(data, infra::softFail);
+    infra::ProtoParser parser(stream);
+
+    test_messages::TestBytesReference message(parser);
+    EXPECT_TRUE(stream.Failed());
+}
+
+namespace
+{
+    class TestService3Mock
+        : public test_messages::TestService3
+    {
+    public:
+        using test_messages::TestService3::TestService3;
+
+        MOCK_METHOD1(Upload, void(infra::ConstByteRange value));
+    };
+}
+
+TEST(ProtoCEchoPluginTest, service_with_reference_parameter_receives_reference_into_received_data)
+{
+    testing::StrictMock<services::EchoMock> echo;
+    TestService3Mock service(echo);
+
+    std::array<uint8_t, 4> data{ 10, 2, 5, 6 };
+    infra::ByteInputStream stream(data);
+    infra::ProtoLengthDelimited contents(stream, stream.ErrorPolicy(), data.size());
+
+    EXPECT_CALL(service, Upload(testing::_)).WillOnce(testing::Invoke([&data](infra::ConstByteRange value)
+        {
+            EXPECT_EQ(data.data() + 2, value.begin());
+            EXPECT_EQ(2, value.size());
+        }));
+    service.HandleMethod(test_messages::TestService3::serviceId, test_messages::TestService3::idUpload, contents, services::echoErrorPolicyAbort);
+}
+
+TEST(ProtoCEchoPluginTest, service_with_reference_parameter_receives_copy_of_data_that_wraps_around_ring_buffer)
+{
+    testing::StrictMock<services::EchoMock> echo;
+    TestService3Mock service(echo);
+
+    // Wrap the contents of the bytes field around the end of the deque's storage
+    infra::BoundedDeque<uint8_t>::WithMaxSize<6> data;
+    for (int i = 0; i != 3; ++i)
+    {
+        data.push_back(0);
+        data.pop_front();
+    }
+    data.insert(data.end(), { 10, 4, 1, 2, 3, 4 });
+    infra::BoundedDequeInputStream stream(data, infra::softFail);
+    infra::ProtoLengthDelimited contents(stream, stream.ErrorPolicy(), data.size());
+
+    EXPECT_CALL(service, Upload(infra::CheckByteRangeContents(std::vector<uint8_t>{ 1, 2, 3, 4 })));
+    service.HandleMethod(test_messages::TestService3::serviceId, test_messages::TestService3::idUpload, contents, services::echoErrorPolicyAbort);
+    EXPECT_FALSE(stream.Failed());
+    EXPECT_TRUE(stream.Empty());
+}
+
+namespace
+{
+    class TestService1Mock
+        : public test_messages::TestService1
+    {
+    public:
+        using test_messages::TestService1::RequestId;
+        using test_messages::TestService1::TestService1;
+
+        MOCK_METHOD1(Method, void(uint32_t value));
+    };
+
+    class ProtoCEchoPluginPipelinedTest
+        : public testing::Test
+        , public infra::EventDispatcherWithWeakPtrFixture
+    {
+    public:
+        void ReceiveMessage(infra::ConstByteRange data)
+        {
+            infra::ByteInputStreamReader reader{ data };
+            messageCommunication.GetObserver().ReceivedMessage(infra::UnOwnedSharedPtr(reader));
+        }
+
+        std::vector<uint8_t> Reply(uint32_t value, uint32_t requestId)
+        {
+            infra::ByteOutputStreamWriter::WithStorage<128> writer;
+
+            EXPECT_CALL(messageCommunication, RequestSendMessage(testing::_));
+            proxy.RequestSend([this, value]()
+                { proxy.Method(value); },
+                requestId);
+            messageCommunication.GetObserver().SendMessageStreamAvailable(infra::UnOwnedSharedPtr(writer));
+
+            return std::vector<uint8_t>(writer.Processed().begin(), writer.Processed().end());
+        }
+
+        testing::StrictMock<services::MessageCommunicationMock> messageCommunication;
+        services::EchoOnMessageCommunication echo{ messageCommunication, services::echoErrorPolicyAbort, services::EchoFraming::pipelined };
+        infra::SharedPtr<services::EchoOnMessageCommunication> echoPtr{ infra::UnOwnedSharedPtr(echo) };
+        testing::StrictMock<TestService1Mock> service{ echo, 2 };
+        test_messages::TestService1Proxy proxy{ echo };
+    };
+}
+
+TEST_F(ProtoCEchoPluginPipelinedTest, service_with_window_completes_calls_out_of_order)
+{
+    std::vector<uint32_t> requestIds;
+    EXPECT_CALL(service, Method(5)).WillOnce(testing::Invoke([this, &requestIds](uint32_t value)
+        { requestIds.push_back(service.RequestId()); }));
+    EXPECT_CALL(service, Method(6)).WillOnce(testing::Invoke([this, &requestIds](uint32_t value)
+        { requestIds.push_back(service.RequestId()); }));
+    ReceiveMessage(infra::MakeRange(std::array<uint8_t, 6>{ 3, 1, 10, 2, 8, 5 }));
+    ReceiveMessage(infra::MakeRange(std::array<uint8_t, 6>{ 4, 1, 10, 2, 8, 6 }));
+    EXPECT_EQ((std::vector<uint32_t>{ 3, 4 }), requestIds);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 4, 1, 10, 2, 8, 60 }), Reply(60, requestIds[1]));
+    service.MethodDone();
+    EXPECT_TRUE(service.InProgress());
+
+    EXPECT_EQ((std::vector<uint8_t>{ 3, 1, 10, 2, 8, 50 }), Reply(50, requestIds[0]));
+    service.MethodDone();
+    EXPECT_FALSE(service.InProgress());
+
+    ExecuteAllActions();
+}
+
 TEST(ProtoCEchoPluginTest, serialize_uint32)
 {
     test_messages::TestUInt32 message;
@@ -319,7 +468,18 @@ TEST(ProtoCEchoPluginTest, serialize_repeated_uint32)
     infra::ProtoFormatter formatter(stream);
     message.Serialize(formatter);
 
-    EXPECT_EQ((std::array<uint8_t, 4>{ 1 << 3, 5, 1 << 3, 6 }), stream.Writer().Processed());
+    EXPECT_EQ((std::array<uint8_t, 4>{ (1 << 3) | 2, 2, 5, 6 }), stream.Writer().Processed());
+}
+
+TEST(ProtoCEchoPluginTest, serialize_empty_repeated_uint32)
+{
+    test_messages::TestRepeatedUInt32 message;
+
+    infra::ByteOutputStream::WithStorage<100> stream;
+    infra::ProtoFormatter formatter(stream);
+    message.Serialize(formatter);
+
+    EXPECT_TRUE(stream.Writer().Processed().empty());
 }
 
 TEST(ProtoCEchoPluginTest, deserialize_repeated_uint32)
@@ -334,6 +494,99 @@ TEST(ProtoCEchoPluginTest, deserialize_repeated_uint32)
     EXPECT_EQ(6, message.value[1]);
 }
 
+TEST(ProtoCEchoPluginTest, deserialize_packed_repeated_uint32)
+{
+    std::array<uint8_t, 7> data{ (1 << 3) | 2, 2, 5, 6, (1 << 3) | 2, 1, 7 };
+    infra::ByteInputStream stream(data);
+    infra::ProtoParser parser(stream);
+
+    test_messages::TestRepeatedUInt32 message(parser);
+    EXPECT_EQ(3, message.value.size());
+    EXPECT_EQ(5, message.value[0]);
+    EXPECT_EQ(6, message.value[1]);
+    EXPECT_EQ(7, message.value[2]);
+}
+
+TEST(ProtoCEchoPluginTest, deserialize_packed_repeated_uint32_beyond_array_size_reports_error)
+{
+    std::array<uint8_t, 13> data{ (1 << 3) | 2, 11, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    infra::ByteInputStream stream(data, infra::softFail);
+    infra::ProtoParser parser(stream);
+
+    test_messages::TestRepeatedUInt32 message(parser);
+    EXPECT_TRUE(stream.Failed());
+    EXPECT_EQ(10, message.value.size());
+}
+
+TEST(ProtoCEchoPluginTest, serialize_sint32)
+{
+    test_messages::TestSInt32 message;
+    message.value = -2;
+
+    infra::ByteOutputStream::WithStorage<100> stream;
+    infra::ProtoFormatter formatter(stream);
+    message.Serialize(formatter);
+
+    EXPECT_EQ((std::array<uint8_t, 2>{ 1 << 3, 3 }), stream.Writer().Processed());
+    EXPECT_EQ(2, message.SerializedSize());
+}
+
+TEST(ProtoCEchoPluginTest, deserialize_sint32)
+{
+    std::array<uint8_t, 2> data{ 1 << 3, 3 };
+    infra::ByteInputStream stream(data);
+    infra::ProtoParser parser(stream);
+
+    test_messages::TestSInt32 message(parser);
+    EXPECT_EQ(-2, message.value);
+}
+
+TEST(ProtoCEchoPluginTest, serialize_sint64)
+{
+    test_messages::TestSInt64 message;
+    message.value = std::numeric_limits<int64_t>::min();
+
+    infra::ByteOutputStream::WithStorage<100> stream;
+    infra::ProtoFormatter formatter(stream);
+    message.Serialize(formatter);
+
+    EXPECT_EQ((std::array<uint8_t, 11>{ 1 << 3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 1 }), stream.Writer().Processed());
+}
+
+TEST(ProtoCEchoPluginTest, deserialize_sint64)
+{
+    std::array<uint8_t, 2> data{ 1 << 3, 4 };
+    infra::ByteInputStream stream(data);
+    infra::ProtoParser parser(stream);
+
+    test_messages::TestSInt64 message(parser);
+    EXPECT_EQ(2, message.value);
+}
+
+TEST(ProtoCEchoPluginTest, serialize_packed_repeated_sint32)
+{
+    test_messages::TestRepeatedSInt32 message;
+    message.value.push_back(-1);
+    message.value.push_back(1);
+    message.value.push_back(-65);
+
+    infra::ByteOutputStream::WithStorage<100> stream;
+    infra::ProtoFormatter formatter(stream);
+    message.Serialize(formatter);
+
+    EXPECT_EQ((std::array<uint8_t, 6>{ (1 << 3) | 2, 4, 1, 2, 0x81, 1 }), stream.Writer().Processed());
+}
+
+TEST(ProtoCEchoPluginTest, deserialize_packed_repeated_sint32)
+{
+    std::array<uint8_t, 6> data{ (1 << 3) | 2, 4, 1, 2, 0x81, 1 };
+    infra::ByteInputStream stream(data);
+    infra::ProtoParser parser(stream);
+
+    test_messages::TestRepeatedSInt32 message(parser);
+    EXPECT_EQ((std::vector<int32_t>{ -1, 1, -65 }), message.value);
+}
+
 TEST(ProtoCEchoPluginTest, serialize_message)
 {
     test_messages::TestMessageWithMessageField message;
@@ -427,3 +680,36 @@ TEST(ProtoCEchoPluginTest, deserialize_nested_repeated_message)
     EXPECT_EQ(5, message.message[0].value);
     EXPECT_EQ(6, message.message[1].value);
 }
+
+TEST(ProtoCEchoPluginTest, SerializedSize_equals_serialized_bytes)
+{
+    test_messages::TestUnboundedRepeatedEverything message;
+    message.v1.push_back(test_messages::Enumeration::val1);
+    message.v2.push_back(-1);
+    message.v4.push_back(300);
+    message.v6.push_back(5);
+    message.v10.push_back(true);
+    message.v12.push_back("abc");
+    message.v13.push_back(test_messages::TestUInt32(1000));
+    message.v15.push_back(std::vector<uint8_t>(200, 1));
+
+    infra::ByteOutputStream::WithStorage<400> stream;
+    infra::ProtoFormatter formatter(stream);
+    message.Serialize(formatter);
+
+    EXPECT_EQ(stream.Writer().Processed().size(), message.SerializedSize());
+}
+
+TEST(ProtoCEchoPluginTest, serialize_message_with_multi_byte_length)
+{
+    test_messages::TestMessageWithLargeMessageField message;
+    message.message.value = std::vector<uint8_t>(200, 1);
+
+    infra::ByteOutputStream::WithStorage<300> stream;
+    infra::ProtoFormatter formatter(stream);
+    message.Serialize(formatter);
+
+    auto processed = stream.Writer().Processed();
+    ASSERT_EQ(206, processed.size());
+    EXPECT_EQ((std::array<uint8_t, 6>{ (1 << 3) | 2, 0xcb, 1, (1 << 3) | 2, 0xc8, 1 }), infra::Head(processed, 6));
+}
@@ -0,0 +1,56 @@
+#include "protobuf/services/FlashStatisticsEcho.hpp"
+#include "infra/util/ReallyAssert.hpp"
+
+namespace services
+{
+    template<class T>
+    FlashStatisticsEchoBase<T>::FlashStatisticsEchoBase(services::Echo& echo, FlashStatisticsBase<T>& statistics)
+        : flash_statistics::FlashStatistics(echo)
+        , statistics(statistics)
+        , response(echo)
+    {
+        really_assert(statistics.Statistics().eraseCounts.size() <= flash_statistics::Snapshot().eraseCounts.max_size());
+    }
+
+    template<class T>
+    void FlashStatisticsEchoBase<T>::RequestStatistics()
+    {
+        response.RequestSend([this]()
+            {
+                response.Statistics(Convert(statistics.Statistics()));
+                MethodDone(); });
+    }
+
+    template<class T>
+    void FlashStatisticsEchoBase<T>::Reset()
+    {
+        statistics.Reset();
+        MethodDone();
+    }
+
+    template<class T>
+    flash_statistics::Snapshot FlashStatisticsEchoBase<T>::Convert(const FlashStatisticsSnapshot& snapshot) const
+    {
+        flash_statistics::Snapshot result;
+        result.read = Convert(snapshot.read);
+        result.write = Convert(snapshot.write);
+        result.erase = Convert(snapshot.erase);
+        result.sectorsPerEraseCounter = snapshot.sectorsPerEraseCounter;
+        result.eraseCounts.assign(snapshot.eraseCounts.begin(), snapshot.eraseCounts.end());
+        return result;
+    }
+
+    template<class T>
+    flash_statistics::OperationStatistics FlashStatisticsEchoBase<T>::Convert(const FlashOperationStatistics& statistics) const
+    {
+        flash_statistics::OperationStatistics result;
+        result.count = statistics.count;
+        result.bytes = statistics.bytes;
+        result.maxLatencyMicroseconds = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(statistics.maxLatency).count());
+        result.latencyHistogram.assign(statistics.latencyHistogram.begin(), statistics.latencyHistogram.end());
+        return result;
+    }
+
+    template class FlashStatisticsEchoBase<uint32_t>;
+    template class FlashStatisticsEchoBase<uint64_t>;
+}
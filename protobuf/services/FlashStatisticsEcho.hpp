@@ -0,0 +1,37 @@
+#ifndef PROTOBUF_FLASH_STATISTICS_ECHO_HPP
+#define PROTOBUF_FLASH_STATISTICS_ECHO_HPP
+
+#include "generated/echo/FlashStatistics.pb.hpp"
+#include "services/util/FlashStatistics.hpp"
+
+namespace services
+{
+    template<class T>
+    class FlashStatisticsEchoBase;
+
+    using FlashStatisticsEcho = FlashStatisticsEchoBase<uint32_t>;
+    using FlashStatisticsEcho64 = FlashStatisticsEchoBase<uint64_t>;
+
+    // Serves the statistics of a FlashStatistics decorator: RequestStatistics is answered with a snapshot sent through
+    // FlashStatisticsResponse, Reset clears the statistics
+    template<class T>
+    class FlashStatisticsEchoBase
+        : public flash_statistics::FlashStatistics
+    {
+    public:
+        FlashStatisticsEchoBase(services::Echo& echo, FlashStatisticsBase<T>& statistics);
+
+        virtual void RequestStatistics() override;
+        virtual void Reset() override;
+
+    private:
+        flash_statistics::Snapshot Convert(const FlashStatisticsSnapshot& snapshot) const;
+        flash_statistics::OperationStatistics Convert(const FlashOperationStatistics& statistics) const;
+
+    private:
+        FlashStatisticsBase<T>& statistics;
+        flash_statistics::FlashStatisticsResponseProxy response;
+    };
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "hal/interfaces/test_doubles/FlashMock.hpp"
+#include "infra/stream/ByteInputStream.hpp"
+#include "infra/stream/ByteOutputStream.hpp"
+#include "infra/syntax/ProtoParser.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
+#include "protobuf/echo/test_doubles/EchoMock.hpp"
+#include "protobuf/services/FlashStatisticsEcho.hpp"
+#include "gmock/gmock.h"
+
+class FlashStatisticsEchoTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    void Invoke(uint32_t methodId)
+    {
+        infra::StreamErrorPolicy formatErrorPolicy;
+        infra::ByteInputStream stream(infra::ConstByteRange(), infra::noFail);
+        infra::ProtoLengthDelimited contents(stream, formatErrorPolicy, 0);
+        service.HandleMethod(flash_statistics::FlashStatistics::serviceId, methodId, contents, errorPolicy);
+    }
+
+    void EraseSector(uint32_t sectorIndex, infra::Duration latency)
+    {
+        EXPECT_CALL(flash, eraseSectorsMock(sectorIndex, sectorIndex + 1));
+        statistics.EraseSectors(sectorIndex, sectorIndex + 1, infra::emptyFunction);
+        ForwardTime(latency);
+        flash.done();
+    }
+
+    flash_statistics::SnapshotResult SentSnapshot()
+    {
+        infra::ByteInputStream stream(writer.Processed());
+        infra::ProtoParser parser(stream);
+        EXPECT_TRUE(parser.GetVarInt() == flash_statistics::FlashStatisticsResponse::serviceId);
+
+        auto field = parser.GetField();
+        EXPECT_TRUE(field.second == flash_statistics::FlashStatisticsResponse::idStatistics);
+
+        infra::ProtoParser snapshotParser = field.first.Get<infra::ProtoLengthDelimited>().Parser();
+        return flash_statistics::SnapshotResult(snapshotParser);
+    }
+
+    testing::StrictMock<services::EchoMock> echo;
+    testing::StrictMock<services::EchoErrorPolicyMock> errorPolicy;
+    testing::StrictMock<hal::FlashMock> flash{ 4, 16 };
+    services::FlashStatistics::WithEraseCounters<4> statistics{ flash };
+    services::FlashStatisticsEcho service{ echo, statistics };
+    infra::ByteOutputStreamWriter::WithStorage<flash_statistics::FlashStatisticsResponseProxy::maxMessageSize> writer;
+};
+
+TEST_F(FlashStatisticsEchoTest, RequestStatistics_sends_Statistics)
+{
+    EraseSector(1, std::chrono::milliseconds(5));
+    EraseSector(1, std::chrono::milliseconds(2));
+
+    EXPECT_CALL(echo, RequestSend(testing::_)).WillOnce(testing::Invoke([](services::ServiceProxy& proxy)
+        { proxy.GrantSend(); }));
+    EXPECT_CALL(echo, SendStreamWriter()).WillOnce(testing::ReturnRef(writer));
+    EXPECT_CALL(echo, Send());
+    EXPECT_CALL(echo, ServiceDone(testing::Ref(service)));
+    Invoke(flash_statistics::FlashStatistics::idRequestStatistics);
+
+    auto snapshot = SentSnapshot().snapshot;
+    EXPECT_EQ(0, snapshot.read.count);
+    EXPECT_EQ(0, snapshot.write.count);
+    EXPECT_EQ(2, snapshot.erase.count);
+    EXPECT_EQ(32, snapshot.erase.bytes);
+    EXPECT_EQ(5000, snapshot.erase.maxLatencyMicroseconds);
+    EXPECT_EQ((std::vector<uint32_t>{ 0, 0, 2, 0, 0, 0 }), (std::vector<uint32_t>(snapshot.erase.latencyHistogram.begin(), snapshot.erase.latencyHistogram.end())));
+    EXPECT_EQ(1, snapshot.sectorsPerEraseCounter);
+    EXPECT_EQ((std::vector<uint32_t>{ 0, 2, 0, 0 }), (std::vector<uint32_t>(snapshot.eraseCounts.begin(), snapshot.eraseCounts.end())));
+}
+
+TEST_F(FlashStatisticsEchoTest, RequestStatistics_is_done_after_send_is_granted)
+{
+    services::ServiceProxy* proxy = nullptr;
+    EXPECT_CALL(echo, RequestSend(testing::_)).WillOnce(testing::Invoke([&proxy](services::ServiceProxy& serviceProxy)
+        { proxy = &serviceProxy; }));
+    Invoke(flash_statistics::FlashStatistics::idRequestStatistics);
+    EXPECT_TRUE(service.InProgress());
+
+    EXPECT_CALL(echo, SendStreamWriter()).WillOnce(testing::ReturnRef(writer));
+    EXPECT_CALL(echo, Send());
+    EXPECT_CALL(echo, ServiceDone(testing::Ref(service)));
+    proxy->GrantSend();
+    EXPECT_FALSE(service.InProgress());
+}
+
+TEST_F(FlashStatisticsEchoTest, Reset_clears_statistics)
+{
+    EraseSector(2, std::chrono::milliseconds(1));
+
+    EXPECT_CALL(echo, ServiceDone(testing::Ref(service)));
+    Invoke(flash_statistics::FlashStatistics::idReset);
+
+    auto snapshot = statistics.Statistics();
+    EXPECT_EQ(0, snapshot.erase.count);
+    EXPECT_EQ((std::vector<uint32_t>{ 0, 0, 0, 0 }), (std::vector<uint32_t>(snapshot.eraseCounts.begin(), snapshot.eraseCounts.end())));
+}
+
+TEST(FlashStatisticsEchoConstructionTest, at_most_128_erase_counters_are_served)
+{
+    testing::StrictMock<services::EchoMock> echo;
+
+    testing::StrictMock<hal::FlashMock> flash128{ 128, 16 };
+    services::FlashStatistics::WithEraseCounters<128> statistics128{ flash128 };
+    services::FlashStatisticsEcho service128{ echo, statistics128 };
+
+    testing::StrictMock<hal::FlashMock> flash129{ 129, 16 };
+    services::FlashStatistics::WithEraseCounters<129> statistics129{ flash129 };
+    EXPECT_DEATH(services::FlashStatisticsEcho(echo, statistics129), "");
+}
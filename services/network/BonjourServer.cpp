@@ -1,6 +1,8 @@
 #include "services/network/BonjourServer.hpp"
 #include "infra/util/BitLogic.hpp"
 #include "infra/util/EnumCast.hpp"
+#include <algorithm>
+#include <limits>
 
 namespace services
 {
@@ -9,6 +11,7 @@ namespace services
         const uint16_t mdnsPort = 5353;
         const IPv4Address mdnsMulticastAddressIpv4{ 224, 0, 0, 251 };
         const IPv6Address mdnsMulticastAddressIpv6{ 0xff02, 0, 0, 0, 0, 0, 0, 0xfb };
+        const infra::Duration recordTtl = std::chrono::seconds(5);
 
         class DnsBitmap
         {
@@ -48,6 +51,40 @@ namespace services
         private:
             uint32_t bitmap;
         };
+
+        // Compares the data written to it against the data read from a stream
+        class ComparingStreamWriter
+            : public infra::StreamWriter
+        {
+        public:
+            explicit ComparingStreamWriter(infra::StreamReader& reader)
+                : reader(reader)
+            {}
+
+            bool Equal() const
+            {
+                return equal;
+            }
+
+            virtual void Insert(infra::ConstByteRange range, infra::StreamErrorPolicy& errorPolicy) override
+            {
+                while (equal && !range.empty())
+                {
+                    auto data = reader.ExtractContiguousRange(range.size());
+                    equal = !data.empty() && std::equal(data.begin(), data.end(), range.begin());
+                    range.pop_front(data.size());
+                }
+            }
+
+            virtual std::size_t Available() const override
+            {
+                return std::numeric_limits<std::size_t>::max();
+            }
+
+        private:
+            infra::StreamReader& reader;
+            bool equal = true;
+        };
     }
 
     BonjourServer::BonjourServer(DatagramFactory& factory, Multicast& multicast, infra::BoundedConstString instance, infra::BoundedConstString serviceName, infra::BoundedConstString type,
@@ -92,6 +129,39 @@ namespace services
         state->SendStreamAvailable(std::move(writer));
     }
 
+    void BonjourServer::WriteResponse(infra::StreamWriter& writer, const Response& response)
+    {
+        auto count = [](uint8_t records)
+        {
+            uint16_t result = 0;
+            for (; records != 0; records &= records - 1)
+                ++result;
+            return result;
+        };
+
+        Answer answer(*this, response.queryId, writer, count(response.answers), count(response.additionalRecords));
+
+        if ((response.answers & recordPtr) != 0)
+            answer.AddPtrAnswer();
+        if ((response.answers & recordSrv) != 0)
+            answer.AddSrvAnswer();
+        if ((response.answers & recordTxt) != 0)
+            answer.AddTxtAnswer();
+        if ((response.answers & recordA) != 0)
+            answer.AddAAnswer();
+        if ((response.answers & recordAaaa) != 0)
+            answer.AddAaaaAnswer();
+
+        if ((response.additionalRecords & recordTxt) != 0)
+            answer.AddTxtAdditional();
+        if ((response.additionalRecords & recordSrv) != 0)
+            answer.AddSrvAdditional();
+        if ((response.additionalRecords & recordA) != 0)
+            answer.AddAAdditional();
+        if ((response.additionalRecords & recordAaaa) != 0)
+            answer.AddAaaaAdditional();
+    }
+
     BonjourServer::Answer::Answer(BonjourServer& server, uint16_t queryId, infra::StreamWriter& writer, uint16_t answersCount, uint16_t additionalRecordsCount)
         : server(server)
         , writer(writer)
@@ -180,7 +250,7 @@ namespace services
 
     void BonjourServer::Answer::AddA(const DnsHostnameParts& dnsHostname)
     {
-        DnsRecordPayload payload{ DnsType::dnsTypeA, DnsClass::dnsClassIn, std::chrono::seconds(5), sizeof(IPv4Address) };
+        DnsRecordPayload payload{ DnsType::dnsTypeA, DnsClass::dnsClassIn, recordTtl, sizeof(IPv4Address) };
 
         stream << infra::text << dnsHostname;
         stream << payload;
@@ -189,7 +259,7 @@ namespace services
 
     void BonjourServer::Answer::AddNoA(const DnsHostnameParts& dnsHostname)
     {
-        DnsRecordPayload payload{ DnsType::dnsTypeNsec, DnsClass::dnsClassIn, std::chrono::seconds(5), static_cast<uint16_t>(6 + dnsHostname.StreamedSize()) };
+        DnsRecordPayload payload{ DnsType::dnsTypeNsec, DnsClass::dnsClassIn, recordTtl, static_cast<uint16_t>(6 + dnsHostname.StreamedSize()) };
 
         stream << infra::text << dnsHostname;
         stream << payload;
@@ -199,7 +269,7 @@ namespace services
 
     void BonjourServer::Answer::AddAaaa(const DnsHostnameParts& dnsHostname)
     {
-        DnsRecordPayload payload{ DnsType::dnsTypeAAAA, DnsClass::dnsClassIn, std::chrono::seconds(5), sizeof(IPv6Address) };
+        DnsRecordPayload payload{ DnsType::dnsTypeAAAA, DnsClass::dnsClassIn, recordTtl, sizeof(IPv6Address) };
 
         stream << infra::text << dnsHostname;
         stream << payload;
@@ -208,7 +278,7 @@ namespace services
 
     void BonjourServer::Answer::AddNoAaaa(const DnsHostnameParts& dnsHostname)
     {
-        DnsRecordPayload payload{ DnsType::dnsTypeNsec, DnsClass::dnsClassIn, std::chrono::seconds(5), static_cast<uint16_t>(6 + dnsHostname.StreamedSize()) };
+        DnsRecordPayload payload{ DnsType::dnsTypeNsec, DnsClass::dnsClassIn, recordTtl, static_cast<uint16_t>(6 + dnsHostname.StreamedSize()) };
 
         stream << infra::text << dnsHostname;
         stream << payload;
@@ -219,7 +289,7 @@ namespace services
     void BonjourServer::Answer::AddPtr(const DnsHostnameParts& dnsHostname)
     {
         auto instance = services::DnsHostnameInParts(server.instance)(server.serviceName)(server.type)("local");
-        DnsRecordPayload payload{ DnsType::dnsTypePtr, DnsClass::dnsClassIn, std::chrono::seconds(5), static_cast<uint16_t>(instance.StreamedSize()) };
+        DnsRecordPayload payload{ DnsType::dnsTypePtr, DnsClass::dnsClassIn, recordTtl, static_cast<uint16_t>(instance.StreamedSize()) };
 
         stream << infra::text << dnsHostname;
         stream << payload;
@@ -229,7 +299,7 @@ namespace services
     void BonjourServer::Answer::AddSrv(const DnsHostnameParts& dnsHostname)
     {
         auto instance = services::DnsHostnameInParts(server.instance)("local");
-        DnsRecordPayload payload{ DnsType::dnsTypeSrv, DnsClass::dnsClassIn, std::chrono::seconds(5), static_cast<uint16_t>(instance.StreamedSize() + 6) };
+        DnsRecordPayload payload{ DnsType::dnsTypeSrv, DnsClass::dnsClassIn, recordTtl, static_cast<uint16_t>(instance.StreamedSize() + 6) };
 
         infra::BigEndian<uint16_t> priority(0);
         infra::BigEndian<uint16_t> weight(0);
@@ -242,65 +312,79 @@ namespace services
 
     void BonjourServer::Answer::AddTxt(const DnsHostnameParts& dnsHostname)
     {
-        DnsRecordPayload payload{ DnsType::dnsTypeTxt, DnsClass::dnsClassIn, std::chrono::seconds(5), static_cast<uint16_t>(server.text.StreamedSize() - 1) };
+        DnsRecordPayload payload{ DnsType::dnsTypeTxt, DnsClass::dnsClassIn, recordTtl, static_cast<uint16_t>(server.text.StreamedSize() - 1) };
 
         stream << infra::text << dnsHostname;
         stream << payload;
         stream << infra::text << DnsPartsWithoutTermination(server.text);
     }
 
-    BonjourServer::QuestionParser::QuestionParser(BonjourServer& server, infra::StreamReaderWithRewinding& reader)
-        : server(server)
-        , reader(reader)
+    bool BonjourServer::Response::Empty() const
     {
-        CreateAnswer(countingWriter);
-        reader.Rewind(startMarker);
+        return answers == 0;
     }
 
-    BonjourServer::QuestionParser::QuestionParser(BonjourServer& server, infra::StreamReaderWithRewinding& reader, infra::StreamWriter& writer)
+    void BonjourServer::Response::Add(const Response& other)
+    {
+        answers |= other.answers;
+        additionalRecords = (additionalRecords | other.additionalRecords) & ~answers;
+    }
+
+    void BonjourServer::Response::Remove(uint8_t records)
+    {
+        answers &= ~records;
+        additionalRecords &= ~records;
+
+        if (answers == 0)
+            additionalRecords = 0;
+    }
+
+    BonjourServer::QuestionParser::QuestionParser(BonjourServer& server, infra::StreamReaderWithRewinding& reader, IPVersions version)
         : server(server)
         , reader(reader)
+        , response{ version, 0, 0, 0 }
     {
-        CreateAnswer(countingWriter); // First fill the answersCount and additionalRecordsCount fields
-        reader.Rewind(startMarker);
-        CreateAnswer(writer);
+        Parse();
         reader.Rewind(startMarker);
     }
 
     bool BonjourServer::QuestionParser::HasAnswer() const
     {
-        return answer != infra::none && answer->Answers() != 0;
+        return valid && !response.Empty();
     }
 
-    void BonjourServer::QuestionParser::RequestSendStream(DatagramExchange& datagramExchange, UdpSocket from, UdpSocket to)
+    const BonjourServer::Response& BonjourServer::QuestionParser::GetResponse() const
     {
-        datagramExchange.RequestSendStream(countingWriter.Processed(), to);
+        return response;
     }
 
-    void BonjourServer::QuestionParser::CreateAnswer(infra::StreamWriter& writer)
+    void BonjourServer::QuestionParser::Parse()
     {
         stream >> header;
 
         if (!IsValidQuestion())
+        {
+            valid = false;
             return;
+        }
 
-        answer.Emplace(server, header.id, writer, answersCount, additionalRecordsCount);
+        response.queryId = header.id;
 
+        // The known answers follow the questions, but must be known before answering the questions
         auto startOfQuestions = reader.ConstructSaveMarker();
 
-        for (auto i = 0; valid && i != header.questionsCount; ++i)
-            ReadQuestion();
+        for (auto i = 0; i != header.questionsCount; ++i)
+            SkipQuestion();
+
+        if (!stream.Failed())
+            ReadKnownAnswers();
 
         reader.Rewind(startOfQuestions);
 
         for (auto i = 0; valid && i != header.questionsCount; ++i)
-            ReadQuestionForAdditionalRecords();
-
-        answersCount = answer->Answers();
-        additionalRecordsCount = answer->AdditionalRecords();
+            ReadQuestion();
 
-        if (!valid)
-            answer = infra::none;
+        response.additionalRecords &= ~(response.answers | knownAnswers);
     }
 
     bool BonjourServer::QuestionParser::IsValidQuestion() const
@@ -317,6 +401,103 @@ namespace services
         return true;
     }
 
+    void BonjourServer::QuestionParser::SkipQuestion()
+    {
+        ReadHostname();
+        stream >> footer;
+    }
+
+    void BonjourServer::QuestionParser::ReadKnownAnswers()
+    {
+        // A separate stream is used, so that a malformed known answer section does not invalidate the questions
+        infra::DataInputStream::WithErrorPolicy knownAnswerStream(reader, infra::noFail);
+
+        for (auto i = 0; i != header.answersCount; ++i)
+        {
+            ReadHostname();
+
+            DnsRecordPayload payload;
+            knownAnswerStream >> payload;
+
+            if (knownAnswerStream.Failed())
+                break;
+
+            knownAnswers |= KnownRecord(payload);
+            knownAnswerStream.Consume(payload.resourceDataLength);
+        }
+    }
+
+    uint8_t BonjourServer::QuestionParser::KnownRecord(const DnsRecordPayload& payload)
+    {
+        // Known answers with less than half of the original TTL remaining must be answered anyway
+        if (payload.Ttl() * 2 < recordTtl)
+            return 0;
+
+        if ((payload.class_ & 0x7fff) != infra::enum_cast(DnsClass::dnsClassIn))
+            return 0;
+
+        // A known answer only suppresses a record when its data is equal to the data that would be sent
+        if (payload.type == infra::enum_cast(DnsType::dnsTypeA) && MyShortInstanceName() && server.ipv4Address != infra::none)
+            if (RecordDataIs(payload, sizeof(IPv4Address), [this](infra::DataOutputStream& stream)
+                    { stream << *server.ipv4Address; }))
+                return recordA;
+
+        if (payload.type == infra::enum_cast(DnsType::dnsTypeAAAA) && MyShortInstanceName() && server.ipv6Address != infra::none)
+            if (RecordDataIs(payload, sizeof(IPv6Address), [this](infra::DataOutputStream& stream)
+                    { stream << services::ToNetworkOrder(*server.ipv6Address); }))
+                return recordAaaa;
+
+        if (payload.type == infra::enum_cast(DnsType::dnsTypeSrv) && MyFullInstanceName() && KnownSrvData())
+            return recordSrv;
+
+        if (payload.type == infra::enum_cast(DnsType::dnsTypeTxt) && MyFullInstanceName())
+            if (RecordDataIs(payload, static_cast<uint16_t>(server.text.StreamedSize() - 1), [this](infra::DataOutputStream& stream)
+                    { stream << infra::text << DnsPartsWithoutTermination(server.text); }))
+                return recordTxt;
+
+        if (payload.type == infra::enum_cast(DnsType::dnsTypePtr) && MyServiceName())
+        {
+            // Other instances of the same service share the PTR name, so the PTR data must point to this instance
+            auto startOfData = reader.ConstructSaveMarker();
+            ReadHostname();
+            reader.Rewind(startOfData);
+
+            if (MyFullInstanceName())
+                return recordPtr;
+        }
+
+        return 0;
+    }
+
+    bool BonjourServer::QuestionParser::RecordDataIs(const DnsRecordPayload& payload, uint16_t size, const infra::Function<void(infra::DataOutputStream& stream)>& data)
+    {
+        if (payload.resourceDataLength != size)
+            return false;
+
+        auto startOfData = reader.ConstructSaveMarker();
+        ComparingStreamWriter comparator(reader);
+        infra::DataOutputStream::WithErrorPolicy comparatorStream(comparator, infra::noFail);
+        data(comparatorStream);
+        reader.Rewind(startOfData);
+
+        return comparator.Equal();
+    }
+
+    bool BonjourServer::QuestionParser::KnownSrvData()
+    {
+        // The target of an SRV record may be compressed, so it is compared as a hostname instead of byte by byte
+        auto startOfData = reader.ConstructSaveMarker();
+        infra::DataInputStream::WithErrorPolicy dataStream(reader, infra::noFail);
+        infra::BigEndian<uint16_t> priority;
+        infra::BigEndian<uint16_t> weight;
+        infra::BigEndian<uint16_t> port;
+        dataStream >> priority >> weight >> port;
+        ReadHostname();
+        reader.Rewind(startOfData);
+
+        return !dataStream.Failed() && priority == 0 && weight == 0 && port == server.port && MyShortInstanceName();
+    }
+
     void BonjourServer::QuestionParser::ReadQuestion()
     {
         ReadHostname();
@@ -326,50 +507,36 @@ namespace services
             valid = false;
         else if (IsQueryForMe())
         {
+            uint8_t record = 0;
+            uint8_t additionalRecords = 0;
+
             switch (static_cast<DnsType>(static_cast<uint16_t>(footer.type)))
             {
                 case DnsType::dnsTypeA:
-                    answer->AddAAnswer();
+                    record = recordA;
                     break;
                 case DnsType::dnsTypeAAAA:
-                    answer->AddAaaaAnswer();
+                    record = recordAaaa;
                     break;
                 case DnsType::dnsTypePtr:
-                    answer->AddPtrAnswer();
+                    record = recordPtr;
+                    additionalRecords = recordTxt | recordSrv | recordA | recordAaaa;
                     break;
                 case DnsType::dnsTypeSrv:
-                    answer->AddSrvAnswer();
+                    record = recordSrv;
+                    additionalRecords = recordA | recordAaaa;
                     break;
                 case DnsType::dnsTypeTxt:
-                    answer->AddTxtAnswer();
+                    record = recordTxt;
                     break;
                 default:
                     std::abort();
             }
-        }
-    }
-
-    void BonjourServer::QuestionParser::ReadQuestionForAdditionalRecords()
-    {
-        ReadHostname();
-        stream >> footer;
 
-        if (IsQueryForMe())
-        {
-            switch (static_cast<DnsType>(static_cast<uint16_t>(footer.type)))
+            if ((knownAnswers & record) == 0)
             {
-                case DnsType::dnsTypePtr:
-                    answer->AddTxtAdditional();
-                    answer->AddSrvAdditional();
-                    answer->AddAAdditional();
-                    answer->AddAaaaAdditional();
-                    break;
-                case DnsType::dnsTypeSrv:
-                    answer->AddAAdditional();
-                    answer->AddAaaaAdditional();
-                    break;
-                default:
-                    break;
+                response.answers |= record;
+                response.additionalRecords |= additionalRecords;
             }
         }
     }
@@ -476,29 +643,64 @@ namespace services
         if (GetPort(from) != mdnsPort)
             return;
 
-        if (waitingReader != nullptr)
+        QuestionParser question(server, *reader, GetVersion(from));
+        if (!question.HasAnswer())
             return;
 
-        waitingReader = std::move(reader);
-        QuestionParser question(server, *waitingReader);
-        if (question.HasAnswer())
+        auto response = question.GetResponse();
+
+        if (sending == infra::none)
         {
-            if (GetAddress(from).Is<services::IPv4Address>())
-                question.RequestSendStream(*server.datagramExchangeIpv4, from, MakeUdpSocket(mdnsMulticastAddressIpv4, mdnsPort));
-            else
-                question.RequestSendStream(*server.datagramExchangeIpv6, from, MakeUdpSocket(mdnsMulticastAddressIpv6, mdnsPort));
+            sending = response;
+            RequestSendStream();
+            return;
         }
+
+        // Records which are about to be sent are not repeated, other records are aggregated into one next response
+        if (sending->version == response.version)
+            response.Remove(sending->answers | sending->additionalRecords);
+
+        if (response.Empty())
+            return;
+
+        auto& queued = Queued(response.version);
+        if (queued == infra::none)
+            queued = response;
         else
-            waitingReader = nullptr;
+            queued->Add(response);
     }
 
     void BonjourServer::StateIdle::SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer)
     {
-        assert(waitingReader != nullptr);
+        assert(sending != infra::none);
+
+        server.WriteResponse(*writer, *sending);
+        writer = nullptr;
+
+        // Responses for the other IP version go first, so that neither version starves the other
+        auto& other = Queued(sending->version == IPVersions::ipv4 ? IPVersions::ipv6 : IPVersions::ipv4);
+        auto& next = other != infra::none ? other : Queued(sending->version);
+        sending = next;
+        next = infra::none;
+
+        if (sending != infra::none)
+            RequestSendStream();
+    }
+
+    infra::Optional<BonjourServer::Response>& BonjourServer::StateIdle::Queued(IPVersions version)
+    {
+        return version == IPVersions::ipv4 ? queuedIpv4 : queuedIpv6;
+    }
 
-        QuestionParser question(server, *waitingReader, *writer);
+    void BonjourServer::StateIdle::RequestSendStream()
+    {
+        infra::CountingStreamWriter countingWriter;
+        server.WriteResponse(countingWriter, *sending);
 
-        waitingReader = nullptr;
+        if (sending->version == IPVersions::ipv4)
+            server.datagramExchangeIpv4->RequestSendStream(countingWriter.Processed(), MakeUdpSocket(mdnsMulticastAddressIpv4, mdnsPort));
+        else
+            server.datagramExchangeIpv6->RequestSendStream(countingWriter.Processed(), MakeUdpSocket(mdnsMulticastAddressIpv6, mdnsPort));
     }
 
     BonjourServer::StateAnnounce::StateAnnounce(BonjourServer& server)
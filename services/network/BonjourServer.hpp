@@ -58,20 +58,44 @@ namespace services
             uint16_t additionalRecordsCount = 0;
         };
 
+        enum Record : uint8_t
+        {
+            recordPtr = 1,
+            recordSrv = 2,
+            recordTxt = 4,
+            recordA = 8,
+            recordAaaa = 16
+        };
+
+        struct Response
+        {
+            IPVersions version;
+            uint16_t queryId;
+            uint8_t answers;
+            uint8_t additionalRecords;
+
+            bool Empty() const;
+            void Add(const Response& other);
+            void Remove(uint8_t records);
+        };
+
         class QuestionParser
         {
         public:
-            QuestionParser(BonjourServer& server, infra::StreamReaderWithRewinding& reader);
-            QuestionParser(BonjourServer& server, infra::StreamReaderWithRewinding& reader, infra::StreamWriter& writer);
+            QuestionParser(BonjourServer& server, infra::StreamReaderWithRewinding& reader, IPVersions version);
 
             bool HasAnswer() const;
-            void RequestSendStream(DatagramExchange& datagramExchange, UdpSocket from, UdpSocket to);
+            const Response& GetResponse() const;
 
         private:
-            void CreateAnswer(infra::StreamWriter& writer);
+            void Parse();
             bool IsValidQuestion() const;
+            void SkipQuestion();
+            void ReadKnownAnswers();
+            uint8_t KnownRecord(const DnsRecordPayload& payload);
+            bool RecordDataIs(const DnsRecordPayload& payload, uint16_t size, const infra::Function<void(infra::DataOutputStream& stream)>& data);
+            bool KnownSrvData();
             void ReadQuestion();
-            void ReadQuestionForAdditionalRecords();
             bool IsFooterValid() const;
             bool IsQueryForMe() const;
             bool MyFullInstanceName() const;
@@ -86,15 +110,12 @@ namespace services
             infra::StreamReaderWithRewinding& reader;
             infra::DataInputStream::WithErrorPolicy stream{ reader, infra::noFail };
             std::size_t startMarker{ reader.ConstructSaveMarker() };
-            infra::CountingStreamWriter countingWriter;
             DnsRecordHeader header{};
             infra::BoundedString::WithStorage<253> reconstructedHostname;
             DnsQuestionFooter footer{};
             bool valid = true;
-
-            infra::Optional<Answer> answer;
-            uint16_t answersCount = 0;
-            uint16_t additionalRecordsCount = 0;
+            uint8_t knownAnswers = 0;
+            Response response;
         };
 
         class State
@@ -115,9 +136,15 @@ namespace services
             virtual void DataReceived(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader, UdpSocket from) override;
             virtual void SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer) override;
 
+        private:
+            void RequestSendStream();
+            infra::Optional<Response>& Queued(IPVersions version);
+
         private:
             BonjourServer& server;
-            infra::SharedPtr<infra::StreamReaderWithRewinding> waitingReader;
+            infra::Optional<Response> sending;
+            infra::Optional<Response> queuedIpv4;
+            infra::Optional<Response> queuedIpv6;
         };
 
         class StateAnnounce
@@ -153,6 +180,9 @@ namespace services
             virtual void SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer) override;
         };
 
+    private:
+        void WriteResponse(infra::StreamWriter& writer, const Response& response);
+
     private:
         infra::SharedPtr<DatagramExchange> datagramExchangeIpv4;
         infra::SharedPtr<DatagramExchange> datagramExchangeIpv6;
@@ -16,6 +16,11 @@ namespace services
         return class_ == infra::enum_cast(DnsClass::dnsClassIn) && type == infra::enum_cast(DnsType::dnsTypeA) && resourceDataLength == static_cast<uint16_t>(sizeof(IPv4Address));
     }
 
+    bool DnsRecordPayload::IsIPv6Answer() const
+    {
+        return class_ == infra::enum_cast(DnsClass::dnsClassIn) && type == infra::enum_cast(DnsType::dnsTypeAAAA) && resourceDataLength == static_cast<uint16_t>(sizeof(IPv6AddressNetworkOrder));
+    }
+
     bool DnsRecordPayload::IsNameServer() const
     {
         return class_ == infra::enum_cast(DnsClass::dnsClassIn) && type == infra::enum_cast(DnsType::dnsTypeNameServer);
@@ -23,7 +28,7 @@ namespace services
 
     infra::Duration DnsRecordPayload::Ttl() const
     {
-        return std::chrono::seconds((ttl[0] << 16) + ttl[1]);
+        return std::chrono::seconds((static_cast<uint32_t>(ttl[0]) << 16) + ttl[1]);
     }
 
     void DnsHostnameParts::Stream(infra::TextOutputStream& stream) const
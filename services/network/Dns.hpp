@@ -81,6 +81,7 @@ namespace services
 
         bool IsCName() const;
         bool IsIPv4Answer() const;
+        bool IsIPv6Answer() const;
         bool IsNameServer() const;
 
         infra::Duration Ttl() const;
@@ -8,12 +8,14 @@ namespace services
 {
     const infra::Duration DnsResolver::responseTimeout = std::chrono::seconds(5);
 
-    DnsResolver::DnsResolver(DatagramFactory& datagramFactory, const DnsServers& nameServers, hal::SynchronousRandomDataGenerator& randomDataGenerator)
-        : datagramFactory(datagramFactory)
+    DnsResolver::DnsResolver(infra::BoundedList<ActiveLookup>& lookups, DatagramFactory& datagramFactory, const DnsServers& nameServers, hal::SynchronousRandomDataGenerator& randomDataGenerator)
+        : lookups(lookups)
+        , datagramFactory(datagramFactory)
         , randomDataGenerator(randomDataGenerator)
         , nameServers(nameServers.nameServers)
     {
         assert(!this->nameServers.empty());
+        assert(lookups.max_size() != 0);
     }
 
     void DnsResolver::Lookup(NameResolverResult& result)
@@ -25,59 +27,165 @@ namespace services
 
     void DnsResolver::CancelLookup(NameResolverResult& result)
     {
-        if (!activeLookup->IsResolving(result))
+        for (auto& lookup : lookups)
+            if (lookup.IsResolving(result))
+            {
+                NameLookupCancelled(lookup);
+                return;
+            }
+
+        assert(waiting.has_element(result));
+        waiting.erase(result);
+    }
+
+    void DnsResolver::DataReceived(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader, UdpSocket from)
+    {
+        this->reader = std::move(reader);
+
+        auto query = FindQuery(PeekQueryId(*this->reader));
+        if (query != nullptr)
+            query->DataReceived(*this->reader, from);
+    }
+
+    void DnsResolver::SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer)
+    {
+        assert(sendingQuery != nullptr);
+        auto& query = *sendingQuery;
+        sendingQuery = nullptr;
+
+        query.SendStreamAvailable(*writer);
+        writer = nullptr;
+
+        if (query.Lookup().IsCancelled())
         {
-            assert(waiting.has_element(result));
-            waiting.erase(result);
+            lookups.remove(query.Lookup());
+            TryResolveNext();
         }
-        else
-            NameLookupCancelled();
+
+        TrySendNextQuery();
     }
 
     void DnsResolver::TryResolveNext()
     {
-        if (activeLookup == infra::none && !waiting.empty())
+        while (!lookups.full() && !waiting.empty())
         {
-            Resolve(waiting.front());
+            auto& nameLookup = waiting.front();
             waiting.pop_front();
+            Resolve(nameLookup);
         }
     }
 
     void DnsResolver::Resolve(NameResolverResult& nameLookup)
     {
-        activeLookup.Emplace(*this, nameLookup);
+        if (datagramExchange == nullptr)
+            datagramExchange = datagramFactory.Listen(*this);
+
+        lookups.emplace_back(*this, nameLookup, currentNameServer);
         ++currentNameServer;
         if (currentNameServer == nameServers.size())
             currentNameServer = 0;
+
+        lookups.back().Start();
     }
 
-    void DnsResolver::NameLookupSuccess(NameResolverResult& nameLookup, IPAddress address, infra::TimePoint validUntil)
+    void DnsResolver::NameLookupSuccess(ActiveLookup& lookup, NameResolverResult& nameLookup, IPAddress address, infra::TimePoint validUntil)
     {
-        NameLookupDone([&nameLookup, &address, &validUntil]()
+        NameLookupDone(lookup, [&nameLookup, &address, &validUntil]()
             { nameLookup.NameLookupDone(address, validUntil); });
     }
 
-    void DnsResolver::NameLookupFailed(NameResolverResult& nameLookup)
+    void DnsResolver::NameLookupFailed(ActiveLookup& lookup, NameResolverResult& nameLookup)
     {
-        NameLookupDone([&nameLookup]()
+        NameLookupDone(lookup, [&nameLookup]()
             { nameLookup.NameLookupFailed(); });
     }
 
-    void DnsResolver::NameLookupCancelled()
+    void DnsResolver::NameLookupCancelled(ActiveLookup& lookup)
     {
-        NameLookupDone([]() {});
+        NameLookupDone(lookup, []() {});
     }
 
-    void DnsResolver::NameLookupDone(const infra::Function<void(), 3 * sizeof(void*)>& observerCallback)
+    void DnsResolver::NameLookupDone(ActiveLookup& lookup, const infra::Function<void(), 3 * sizeof(void*)>& observerCallback)
     {
-        activeLookup = infra::none;
+        RemoveLookup(lookup);
+        ReleaseDatagramExchangeWhenIdle();
         observerCallback();
         TryResolveNext();
     }
 
-    DnsResolver::ReplyParser::ReplyParser(infra::StreamReaderWithRewinding& reader, infra::BoundedString& hostname)
+    void DnsResolver::RemoveLookup(ActiveLookup& lookup)
+    {
+        lookup.Cancel();
+
+        // A lookup with an outstanding send stream request is kept until the stream arrives, since the request cannot be withdrawn
+        if (sendingQuery == nullptr || &sendingQuery->Lookup() != &lookup)
+            lookups.remove(lookup);
+    }
+
+    void DnsResolver::ReleaseDatagramExchangeWhenIdle()
+    {
+        for (auto& lookup : lookups)
+            if (!lookup.IsCancelled())
+                return;
+
+        sendingQuery = nullptr;
+        lookups.clear();
+        reader = nullptr;
+        datagramExchange = nullptr;
+    }
+
+    uint16_t DnsResolver::GenerateQueryId()
+    {
+        auto queryId = randomDataGenerator.GenerateRandomData<uint16_t>();
+
+        while (FindQuery(queryId) != nullptr)
+            ++queryId;
+
+        return queryId;
+    }
+
+    DnsResolver::Query* DnsResolver::FindQuery(uint16_t queryId)
+    {
+        for (auto& lookup : lookups)
+        {
+            auto query = lookup.FindQuery(queryId);
+            if (query != nullptr)
+                return query;
+        }
+
+        return nullptr;
+    }
+
+    void DnsResolver::TrySendNextQuery()
+    {
+        if (sendingQuery != nullptr)
+            return;
+
+        for (auto& lookup : lookups)
+        {
+            sendingQuery = lookup.FindQueryWaitingForSendStream();
+            if (sendingQuery != nullptr)
+            {
+                sendingQuery->RequestSendStream(*datagramExchange);
+                return;
+            }
+        }
+    }
+
+    uint16_t DnsResolver::PeekQueryId(infra::StreamReaderWithRewinding& reader)
+    {
+        infra::DataInputStream::WithErrorPolicy stream(reader, infra::noFail);
+        auto start = reader.ConstructSaveMarker();
+        auto header = stream.Extract<DnsRecordHeader>();
+        reader.Rewind(start);
+
+        return header.id;
+    }
+
+    DnsResolver::ReplyParser::ReplyParser(infra::StreamReaderWithRewinding& reader, infra::BoundedString& hostname, DnsType type)
         : reader(reader)
         , hostname(hostname)
+        , type(type)
     {
         stream >> header;
         hostnameMatches = ReadAndMatchHostname();
@@ -97,7 +205,7 @@ namespace services
             return false;
         if (!hostnameMatches)
             return false;
-        if (footer.type != infra::enum_cast(DnsType::dnsTypeA))
+        if (footer.type != infra::enum_cast(type))
             return false;
         if (footer.class_ != infra::enum_cast(DnsClass::dnsClassIn))
             return false;
@@ -174,7 +282,7 @@ namespace services
                 else
                     return NoAnswer{};
             }
-            else if (payload.IsIPv4Answer())
+            else if (type == DnsType::dnsTypeA && payload.IsIPv4Answer())
             {
                 auto address = stream.Extract<IPv4Address>();
 
@@ -182,6 +290,14 @@ namespace services
                     return Answer{ address, infra::Now() + payload.Ttl() };
                 return NoAnswer{};
             }
+            else if (type == DnsType::dnsTypeAAAA && payload.IsIPv6Answer())
+            {
+                auto address = stream.Extract<IPv6AddressNetworkOrder>();
+
+                if (!stream.Failed())
+                    return Answer{ FromNetworkOrder(address), infra::Now() + payload.Ttl() };
+                return NoAnswer{};
+            }
         }
 
         stream.Consume(payload.resourceDataLength);
@@ -375,27 +491,52 @@ namespace services
         return false;
     }
 
-    DnsResolver::ActiveLookup::ActiveLookup(DnsResolver& resolver, NameResolverResult& resolving)
+    DnsResolver::Query::Query(DnsResolver& resolver, ActiveLookup& lookup, DnsType type, NameResolverResult& resolving, std::size_t nameServerIndex)
         : resolver(resolver)
-        , datagramExchange(resolver.datagramFactory.Listen(*this))
-        , queryId(resolver.randomDataGenerator.GenerateRandomData<uint16_t>())
-        , resolving(resolving)
+        , lookup(lookup)
+        , type(type)
         , hostname(resolving.Hostname())
         , nameServers(resolver.nameServers.begin(), resolver.nameServers.end())
-        , currentNameServer(nameServers.begin() + resolver.currentNameServer)
+        , currentNameServer(nameServers.begin() + nameServerIndex)
+    {}
+
+    void DnsResolver::Query::Start()
     {
+        queryId = resolver.GenerateQueryId();
+        active = true;
         ResolveNextAttempt();
     }
 
-    bool DnsResolver::ActiveLookup::IsResolving(NameResolverResult& resolving) const
+    void DnsResolver::Query::Cancel()
+    {
+        active = false;
+        waitingForSendStream = false;
+        timeoutTimer.Cancel();
+    }
+
+    bool DnsResolver::Query::IsActive() const
+    {
+        return active;
+    }
+
+    uint16_t DnsResolver::Query::Id() const
+    {
+        return queryId;
+    }
+
+    bool DnsResolver::Query::IsWaitingForSendStream() const
+    {
+        return waitingForSendStream;
+    }
+
+    DnsResolver::ActiveLookup& DnsResolver::Query::Lookup() const
     {
-        return &resolving == &this->resolving;
+        return lookup;
     }
 
-    void DnsResolver::ActiveLookup::DataReceived(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader, UdpSocket from)
+    void DnsResolver::Query::DataReceived(infra::StreamReaderWithRewinding& reader, UdpSocket from)
     {
-        this->reader = std::move(reader); // The SharedPtr towards the reader is saved in the ActiveLookup object, so that it is destroyed before datagramExchange is destroyed
-        ReplyParser replyParser(*this->reader, hostname);
+        ReplyParser replyParser(reader, hostname, type);
 
         if (replyParser.AnswerIsForCurrentQuery(from, GetAddress(DnsUdpSocket()), queryId))
         {
@@ -406,26 +547,34 @@ namespace services
         }
     }
 
-    void DnsResolver::ActiveLookup::SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer)
+    void DnsResolver::Query::RequestSendStream(DatagramExchange& datagramExchange)
+    {
+        datagramExchange.RequestSendStream(QuerySize(), DnsUdpSocket());
+    }
+
+    void DnsResolver::Query::SendStreamAvailable(infra::StreamWriter& writer)
     {
-        infra::DataOutputStream::WithErrorPolicy stream(*writer);
+        infra::DataOutputStream::WithErrorPolicy stream(writer);
 
         DnsRecordHeader header{ queryId, DnsRecordHeader::flagsRecursionDesired, 1, 0, 0, 0 };
         DnsHostnamePartsString hostnameParts(hostname);
-        DnsQuestionFooter footer{ DnsType::dnsTypeA, DnsClass::dnsClassIn };
+        DnsQuestionFooter footer{ type, DnsClass::dnsClassIn };
 
         stream << header;
         stream << infra::text << hostnameParts;
         stream << footer;
 
-        timeoutTimer.Start(responseTimeout, [this]()
-            { ResolveNextAttempt(); });
+        waitingForSendStream = false;
+
+        if (active)
+            timeoutTimer.Start(responseTimeout, [this]()
+                { ResolveNextAttempt(); });
     }
 
-    void DnsResolver::ActiveLookup::ResolveNextAttempt()
+    void DnsResolver::Query::ResolveNextAttempt()
     {
         if (resolveAttempts == maxAttempts)
-            resolver.NameLookupFailed(resolving);
+            lookup.QueryFailed(*this);
         else
         {
             ++resolveAttempts;
@@ -435,38 +584,40 @@ namespace services
         }
     }
 
-    void DnsResolver::ActiveLookup::ResolveRecursion()
+    void DnsResolver::Query::ResolveRecursion()
     {
         ++recursions;
 
         if (recursions == maxRecursions)
-            resolver.NameLookupFailed(resolving);
+            lookup.QueryFailed(*this);
         else
             ResolveAttempt();
     }
 
-    void DnsResolver::ActiveLookup::ResolveAttempt()
+    void DnsResolver::Query::ResolveAttempt()
     {
-        datagramExchange->RequestSendStream(QuerySize(), DnsUdpSocket());
+        timeoutTimer.Cancel();
+        waitingForSendStream = true;
+        resolver.TrySendNextQuery();
     }
 
-    void DnsResolver::ActiveLookup::SelectNextNameServer()
+    void DnsResolver::Query::SelectNextNameServer()
     {
         ++currentNameServer;
         if (currentNameServer == nameServers.end())
             currentNameServer = nameServers.begin();
     }
 
-    void DnsResolver::ActiveLookup::TryFindAnswer(ReplyParser& replyParser)
+    void DnsResolver::Query::TryFindAnswer(ReplyParser& replyParser)
     {
         auto answer = replyParser.ReadAnswerRecords();
         if (answer != infra::none)
-            resolver.NameLookupSuccess(resolving, answer->first, answer->second);
+            lookup.QuerySucceeded(answer->first, answer->second);
         else
             TryFindRecursiveNameServer(replyParser);
     }
 
-    void DnsResolver::ActiveLookup::TryFindRecursiveNameServer(ReplyParser& replyParser)
+    void DnsResolver::Query::TryFindRecursiveNameServer(ReplyParser& replyParser)
     {
         TryNewNameServers(replyParser);
 
@@ -476,7 +627,7 @@ namespace services
             ResolveNextAttempt();
     }
 
-    void DnsResolver::ActiveLookup::TryNewNameServers(ReplyParser& replyParser)
+    void DnsResolver::Query::TryNewNameServers(ReplyParser& replyParser)
     {
         decltype(nameServers) newRecursiveDnsServers;
         replyParser.ReadNameServers(newRecursiveDnsServers);
@@ -488,12 +639,12 @@ namespace services
         }
     }
 
-    UdpSocket DnsResolver::ActiveLookup::DnsUdpSocket() const
+    UdpSocket DnsResolver::Query::DnsUdpSocket() const
     {
         return MakeUdpSocket(*currentNameServer, 53);
     }
 
-    std::size_t DnsResolver::ActiveLookup::QuerySize() const
+    std::size_t DnsResolver::Query::QuerySize() const
     {
         infra::BoundedConstString hostnameCopy = hostname;
         std::size_t hostnameSize = 1;
@@ -510,4 +661,78 @@ namespace services
 
         return sizeof(DnsRecordHeader) + hostnameSize + hostnameCopy.size() + 1 + sizeof(DnsQuestionFooter);
     }
+
+    DnsResolver::ActiveLookup::ActiveLookup(DnsResolver& resolver, NameResolverResult& resolving, std::size_t nameServerIndex)
+        : resolver(resolver)
+        , resolving(&resolving)
+    {
+        auto versions = resolving.Versions();
+
+        if (versions != IPVersions::ipv6)
+            ipv4Query.Emplace(resolver, *this, DnsType::dnsTypeA, resolving, nameServerIndex);
+        if (versions != IPVersions::ipv4)
+            ipv6Query.Emplace(resolver, *this, DnsType::dnsTypeAAAA, resolving, nameServerIndex);
+    }
+
+    void DnsResolver::ActiveLookup::Start()
+    {
+        if (ipv4Query != infra::none)
+            ipv4Query->Start();
+        if (ipv6Query != infra::none)
+            ipv6Query->Start();
+    }
+
+    void DnsResolver::ActiveLookup::Cancel()
+    {
+        resolving = nullptr;
+
+        if (ipv4Query != infra::none)
+            ipv4Query->Cancel();
+        if (ipv6Query != infra::none)
+            ipv6Query->Cancel();
+    }
+
+    bool DnsResolver::ActiveLookup::IsResolving(NameResolverResult& resolving) const
+    {
+        return &resolving == this->resolving;
+    }
+
+    bool DnsResolver::ActiveLookup::IsCancelled() const
+    {
+        return resolving == nullptr;
+    }
+
+    DnsResolver::Query* DnsResolver::ActiveLookup::FindQuery(uint16_t queryId)
+    {
+        if (ipv4Query != infra::none && ipv4Query->IsActive() && ipv4Query->Id() == queryId)
+            return &*ipv4Query;
+        if (ipv6Query != infra::none && ipv6Query->IsActive() && ipv6Query->Id() == queryId)
+            return &*ipv6Query;
+
+        return nullptr;
+    }
+
+    DnsResolver::Query* DnsResolver::ActiveLookup::FindQueryWaitingForSendStream()
+    {
+        if (ipv4Query != infra::none && ipv4Query->IsWaitingForSendStream())
+            return &*ipv4Query;
+        if (ipv6Query != infra::none && ipv6Query->IsWaitingForSendStream())
+            return &*ipv6Query;
+
+        return nullptr;
+    }
+
+    void DnsResolver::ActiveLookup::QuerySucceeded(IPAddress address, infra::TimePoint validUntil)
+    {
+        resolver.NameLookupSuccess(*this, *resolving, address, validUntil);
+    }
+
+    void DnsResolver::ActiveLookup::QueryFailed(Query& query)
+    {
+        query.Cancel();
+
+        // When both A and AAAA records are queried, the lookup only fails once neither query can produce an answer anymore
+        if ((ipv4Query == infra::none || !ipv4Query->IsActive()) && (ipv6Query == infra::none || !ipv6Query->IsActive()))
+            resolver.NameLookupFailed(*this, *resolving);
+    }
 }
@@ -3,9 +3,11 @@
 
 #include "hal/synchronous_interfaces/SynchronousRandomDataGenerator.hpp"
 #include "infra/timer/Timer.hpp"
+#include "infra/util/BoundedList.hpp"
 #include "infra/util/BoundedVector.hpp"
 #include "infra/util/Optional.hpp"
 #include "infra/util/Variant.hpp"
+#include "infra/util/WithStorage.hpp"
 #include "services/network/Datagram.hpp"
 #include "services/network/Dns.hpp"
 #include "services/network/NameResolver.hpp"
@@ -14,14 +16,23 @@ namespace services
 {
     class DnsResolver
         : public NameResolver
+        , private DatagramExchangeObserver
     {
+    private:
+        class ActiveLookup;
+
     public:
         struct DnsServers
         {
             infra::MemoryRange<const IPAddress> nameServers;
         };
 
-        DnsResolver(DatagramFactory& datagramFactory, const DnsServers& nameServers, hal::SynchronousRandomDataGenerator& randomDataGenerator);
+        template<std::size_t MaxLookups>
+        using WithMaxConcurrentLookups = infra::WithStorage<DnsResolver, infra::BoundedList<ActiveLookup>::WithMaxSize<MaxLookups>>;
+
+        // Up to lookups.max_size() lookups are resolved concurrently; all queries share a single datagram exchange
+        // and their replies are matched on transaction id
+        DnsResolver(infra::BoundedList<ActiveLookup>& lookups, DatagramFactory& datagramFactory, const DnsServers& nameServers, hal::SynchronousRandomDataGenerator& randomDataGenerator);
 
         // Implementation of NameResolver
         virtual void Lookup(NameResolverResult& result) override;
@@ -48,7 +59,7 @@ namespace services
         class ReplyParser
         {
         public:
-            ReplyParser(infra::StreamReaderWithRewinding& reader, infra::BoundedString& hostname);
+            ReplyParser(infra::StreamReaderWithRewinding& reader, infra::BoundedString& hostname, DnsType type);
 
             bool AnswerIsForCurrentQuery(UdpSocket from, const IPAddress& currentNameServer, uint16_t queryId) const;
             bool Error() const;
@@ -76,25 +87,32 @@ namespace services
             infra::StreamReaderWithRewinding& reader;
             infra::DataInputStream::WithErrorPolicy stream{ reader, infra::noFail };
             infra::BoundedString& hostname;
+            DnsType type;
             bool recurse = false;
             DnsRecordHeader header{};
             DnsQuestionFooter footer{};
             bool hostnameMatches;
         };
 
-        class ActiveLookup
-            : private DatagramExchangeObserver
+        class Query
         {
         public:
-            ActiveLookup(DnsResolver& resolver, NameResolverResult& resolving);
+            Query(DnsResolver& resolver, ActiveLookup& lookup, DnsType type, NameResolverResult& resolving, std::size_t nameServerIndex);
+            Query(const Query& other) = delete;
+            Query& operator=(const Query& other) = delete;
 
-            bool IsResolving(NameResolverResult& resolving) const;
+            void Start();
+            void Cancel();
+            bool IsActive() const;
+            uint16_t Id() const;
+            bool IsWaitingForSendStream() const;
+            ActiveLookup& Lookup() const;
 
-        private:
-            // Implementation of DatagramExchangeObserver
-            virtual void DataReceived(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader, UdpSocket from) override;
-            virtual void SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer) override;
+            void DataReceived(infra::StreamReaderWithRewinding& reader, UdpSocket from);
+            void RequestSendStream(DatagramExchange& datagramExchange);
+            void SendStreamAvailable(infra::StreamWriter& writer);
 
+        private:
             void ResolveNextAttempt();
             void ResolveRecursion();
             void ResolveAttempt();
@@ -107,35 +125,72 @@ namespace services
 
         private:
             DnsResolver& resolver;
-            infra::SharedPtr<DatagramExchange> datagramExchange;
-            uint16_t queryId;
-            NameResolverResult& resolving;
+            ActiveLookup& lookup;
+            DnsType type;
+            uint16_t queryId = 0;
             infra::TimerSingleShot timeoutTimer;
             uint8_t resolveAttempts = 0;
             uint8_t recursions = 0;
+            bool active = false;
+            bool waitingForSendStream = false;
 
             infra::BoundedString::WithStorage<253> hostname;
             infra::BoundedVector<IPAddress>::WithMaxSize<maxAttempts> nameServers;
             const IPAddress* currentNameServer;
+        };
+
+        class ActiveLookup
+        {
+        public:
+            ActiveLookup(DnsResolver& resolver, NameResolverResult& resolving, std::size_t nameServerIndex);
+            ActiveLookup(const ActiveLookup& other) = delete;
+            ActiveLookup& operator=(const ActiveLookup& other) = delete;
+
+            void Start();
+            void Cancel();
+            bool IsResolving(NameResolverResult& resolving) const;
+            bool IsCancelled() const;
+            Query* FindQuery(uint16_t queryId);
+            Query* FindQueryWaitingForSendStream();
 
-            infra::SharedPtr<infra::StreamReaderWithRewinding> reader;
+            void QuerySucceeded(IPAddress address, infra::TimePoint validUntil);
+            void QueryFailed(Query& query);
+
+        private:
+            DnsResolver& resolver;
+            NameResolverResult* resolving;
+            infra::Optional<Query> ipv4Query;
+            infra::Optional<Query> ipv6Query;
         };
 
     private:
+        // Implementation of DatagramExchangeObserver
+        virtual void DataReceived(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader, UdpSocket from) override;
+        virtual void SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer) override;
+
         void TryResolveNext();
         void Resolve(NameResolverResult& nameLookup);
-        void NameLookupSuccess(NameResolverResult& nameLookup, IPAddress address, infra::TimePoint validUntil);
-        void NameLookupFailed(NameResolverResult& nameLookup);
-        void NameLookupCancelled();
-        void NameLookupDone(const infra::Function<void(), 3 * sizeof(void*)>& observerCallback);
+        void NameLookupSuccess(ActiveLookup& lookup, NameResolverResult& nameLookup, IPAddress address, infra::TimePoint validUntil);
+        void NameLookupFailed(ActiveLookup& lookup, NameResolverResult& nameLookup);
+        void NameLookupCancelled(ActiveLookup& lookup);
+        void NameLookupDone(ActiveLookup& lookup, const infra::Function<void(), 3 * sizeof(void*)>& observerCallback);
+        void RemoveLookup(ActiveLookup& lookup);
+        void ReleaseDatagramExchangeWhenIdle();
+        uint16_t GenerateQueryId();
+        Query* FindQuery(uint16_t queryId);
+        void TrySendNextQuery();
+        static uint16_t PeekQueryId(infra::StreamReaderWithRewinding& reader);
 
     private:
+        infra::BoundedList<ActiveLookup>& lookups;
         DatagramFactory& datagramFactory;
         hal::SynchronousRandomDataGenerator& randomDataGenerator;
         infra::MemoryRange<const IPAddress> nameServers;
         std::size_t currentNameServer = 0;
         infra::IntrusiveList<NameResolverResult> waiting;
-        infra::Optional<ActiveLookup> activeLookup;
+        infra::SharedPtr<DatagramExchange> datagramExchange;
+        infra::SharedPtr<infra::StreamReaderWithRewinding> reader; // Held here so that it is released before datagramExchange is released
+        Query* sendingQuery = nullptr;
     };
 }
 
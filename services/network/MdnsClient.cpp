@@ -1,6 +1,8 @@
 #include "services/network/MdnsClient.hpp"
 #include "infra/event/EventDispatcherWithWeakPtr.hpp"
 #include "infra/stream/StringOutputStream.hpp"
+#include "infra/util/EnumCast.hpp"
+#include <algorithm>
 
 namespace services
 {
@@ -9,6 +11,34 @@ namespace services
         const uint16_t mdnsPort = 5353;
         const IPv4Address mdnsMulticastAddressIpv4{ 224, 0, 0, 251 };
         const IPv6Address mdnsMulticastAddressIpv6{ 0xff02, 0, 0, 0, 0, 0, 0, 0xfb };
+        const uint16_t classMask = 0x7fff;
+        const std::array<uint8_t, 2> pointerToQuestionName{ 0xc0, sizeof(DnsRecordHeader) };
+
+        bool ContainsCompressedName(DnsType type, infra::ConstByteRange data)
+        {
+            std::size_t offset;
+
+            if (type == DnsType::dnsTypePtr)
+                offset = 0;
+            else if (type == DnsType::dnsTypeSrv)
+                offset = 6;
+            else
+                return false;
+
+            while (offset < data.size())
+            {
+                auto length = data[offset];
+
+                if (length == 0)
+                    return false;
+                if ((length & 0xc0) != 0)
+                    return true;
+
+                offset += length + 1;
+            }
+
+            return true;
+        }
     }
 
     void CreateMdnsHostname(infra::BoundedConstString instance, infra::BoundedConstString serviceName, infra::BoundedConstString type, infra::BoundedString& out)
@@ -32,6 +62,99 @@ namespace services
         AddPartToStream("local");
     }
 
+    infra::ConstByteRange MdnsRecordCache::Record::Data() const
+    {
+        return infra::ConstByteRange(data.data(), data.data() + dataSize);
+    }
+
+    infra::ConstByteRange MdnsRecordCache::KnownAnswer::Data() const
+    {
+        return infra::ConstByteRange(data.data(), data.data() + dataSize);
+    }
+
+    MdnsRecordCache::MdnsRecordCache(infra::BoundedVector<Record>& records, infra::BoundedVector<KnownAnswer>& knownAnswers)
+        : records(records)
+        , knownAnswers(knownAnswers)
+    {}
+
+    void MdnsRecordCache::Add(infra::BoundedConstString name, DnsType type, DnsClass class_, IPVersions ipVersion, infra::Duration ttl, infra::ConstByteRange data)
+    {
+        if (data.size() > maxRecordDataSize)
+            return;
+
+        auto record = Find(name, type, class_, ipVersion, data);
+
+        // A TTL of zero announces that the record is no longer valid
+        if (ttl == infra::Duration())
+        {
+            if (record != nullptr)
+                records.erase(records.begin() + (record - records.begin()));
+            return;
+        }
+
+        if (record == nullptr)
+        {
+            RemoveExpired();
+
+            if (records.full())
+                records.erase(std::min_element(records.begin(), records.end(), [](const Record& x, const Record& y)
+                    { return x.validUntil < y.validUntil; }));
+
+            records.emplace_back();
+            record = &records.back();
+            record->name = name;
+            record->type = type;
+            record->class_ = class_;
+            record->ipVersion = ipVersion;
+            record->dataSize = data.size();
+            std::copy(data.begin(), data.end(), record->data.begin());
+        }
+
+        record->validUntil = infra::Now() + ttl;
+        record->ttl = ttl;
+    }
+
+    infra::MemoryRange<const MdnsRecordCache::KnownAnswer> MdnsRecordCache::SnapshotKnownAnswers(const MdnsQuery& query, IPVersions ipVersion)
+    {
+        RemoveExpired();
+        knownAnswers.clear();
+
+        auto now = infra::Now();
+        for (auto& record : records)
+            if (IsRecordFor(record, query, ipVersion) && (record.validUntil - now) * 2 > record.ttl)
+            {
+                knownAnswers.emplace_back();
+                auto& knownAnswer = knownAnswers.back();
+                knownAnswer.remainingTtl = record.validUntil - now;
+                knownAnswer.data = record.data;
+                knownAnswer.dataSize = record.dataSize;
+            }
+
+        return knownAnswers.range();
+    }
+
+    void MdnsRecordCache::RemoveExpired()
+    {
+        auto now = infra::Now();
+        records.erase(std::remove_if(records.begin(), records.end(), [now](const Record& record)
+                          { return record.validUntil <= now; }),
+            records.end());
+    }
+
+    MdnsRecordCache::Record* MdnsRecordCache::Find(infra::BoundedConstString name, DnsType type, DnsClass class_, IPVersions ipVersion, infra::ConstByteRange data)
+    {
+        for (auto& record : records)
+            if (record.name == name && record.type == type && record.class_ == class_ && record.ipVersion == ipVersion && infra::ContentsEqual(record.Data(), data))
+                return &record;
+
+        return nullptr;
+    }
+
+    bool MdnsRecordCache::IsRecordFor(const Record& record, const MdnsQuery& query, IPVersions ipVersion)
+    {
+        return record.name == query.DnsHostname() && record.type == query.DnsType() && record.class_ == DnsClass::dnsClassIn && record.ipVersion == ipVersion;
+    }
+
     MdnsQueryImpl::MdnsQueryImpl(MdnsClient& mdnsClient, services::DnsType dnsType, infra::BoundedConstString instance, infra::BoundedConstString serviceName, infra::BoundedConstString type, infra::Function<void(infra::ConstByteRange data)> queryHit,
         infra::Function<void(infra::BoundedString hostname, DnsRecordPayload payload, infra::ConstByteRange data)> queryAdditionalRecordHit)
         : mdnsClient(mdnsClient)
@@ -150,6 +273,12 @@ namespace services
             multicast.JoinMulticastGroup(datagramExchange, mdnsMulticastAddressIpv6);
     }
 
+    MdnsClient::MdnsClient(DatagramFactory& datagramFactory, Multicast& multicast, MdnsRecordCache& cache, IPVersions versions)
+        : MdnsClient(datagramFactory, multicast, versions)
+    {
+        this->cache = &cache;
+    }
+
     MdnsClient::~MdnsClient()
     {
         if (versions != IPVersions::ipv6)
@@ -234,10 +363,49 @@ namespace services
         activeMdnsQuery.Emplace(*this, datagramFactory, multicast, query);
     }
 
-    void MdnsClient::ActiveQueryDone()
+    void MdnsClient::ActiveQueryDone(MdnsQuery& query)
     {
         activeMdnsQuery = infra::none;
         TrySendNextQuery();
+        AnswerFromCache(query);
+    }
+
+    void MdnsClient::AnswerFromCache(MdnsQuery& query)
+    {
+        if (cache == nullptr)
+            return;
+
+        // Known answers are not repeated by responders, so deliver them from the cache
+        infra::BoundedString::WithStorage<253> hostname = query.DnsHostname();
+        bool answered = false;
+
+        cache->ForEachRecord(query, query.IpVersion(), [this, &query, &hostname, &answered](infra::Duration remainingTtl, infra::ConstByteRange data)
+            {
+                DnsRecordPayload payload{ query.DnsType(), DnsClass::dnsClassIn, remainingTtl, static_cast<uint16_t>(data.size()) };
+                query.CheckAnswer(query.IpVersion(), hostname, payload, data);
+                answered = true;
+            });
+
+        if (answered)
+            query.EndOfAnswerNotification();
+    }
+
+    void MdnsClient::AddToCache(services::IPVersions ipVersion, infra::BoundedString& hostname, DnsRecordPayload& payload, infra::ConstByteRange data)
+    {
+        if (cache == nullptr || (payload.class_ & classMask) != infra::enum_cast(DnsClass::dnsClassIn))
+            return;
+
+        DnsType type = static_cast<DnsType>(static_cast<uint16_t>(payload.type));
+        if (ContainsCompressedName(type, data))
+            return;
+
+        // Only records that are asked for by a query are cached
+        for (auto& query : queries)
+            if (query.IpVersion() == ipVersion && query.DnsType() == type && query.DnsHostname() == hostname)
+            {
+                cache->Add(hostname, type, DnsClass::dnsClassIn, ipVersion, payload.Ttl(), data);
+                return;
+            }
     }
 
     bool MdnsClient::IsActivelyQuerying()
@@ -274,7 +442,7 @@ namespace services
     {
         infra::DataOutputStream::WithErrorPolicy stream(*writer);
 
-        DnsRecordHeader header{ 0, 0, 1, 0, 0, 0 };
+        DnsRecordHeader header{ 0, 0, 1, static_cast<uint16_t>(knownAnswers.size()), 0, 0 };
         DnsHostnamePartsString dnsHostname(query.DnsHostname());
         DnsQuestionFooter footer{ query.DnsType(), DnsClass::dnsClassIn };
 
@@ -282,10 +450,16 @@ namespace services
         stream << infra::text << dnsHostname;
         stream << footer;
 
+        for (auto& knownAnswer : knownAnswers)
+        {
+            DnsRecordPayload payload{ query.DnsType(), DnsClass::dnsClassIn, knownAnswer.remainingTtl, static_cast<uint16_t>(knownAnswer.dataSize) };
+            stream << pointerToQuestionName << payload << knownAnswer.Data();
+        }
+
         query.SetWaiting(false);
 
         writer = nullptr;
-        mdnsClient.ActiveQueryDone();
+        mdnsClient.ActiveQueryDone(query);
     }
 
     void MdnsClient::ActiveMdnsQuery::SendQuery()
@@ -305,6 +479,12 @@ namespace services
 
         std::size_t querySize = sizeof(DnsRecordHeader) + hostnameSize + hostnameCopy.size() + 1 + sizeof(DnsQuestionFooter);
 
+        if (mdnsClient.cache != nullptr)
+            knownAnswers = mdnsClient.cache->SnapshotKnownAnswers(query, query.IpVersion());
+
+        for (auto& knownAnswer : knownAnswers)
+            querySize += pointerToQuestionName.size() + sizeof(DnsRecordPayload) + knownAnswer.dataSize;
+
         switch (query.IpVersion())
         {
             case services::IPVersions::ipv4:
@@ -379,11 +559,15 @@ namespace services
         if (stream.Failed())
             valid = false;
         else
+        {
+            client.AddToCache(ipVersion, reconstructedHostname, payload, data);
+
             for (auto& query : client.queries)
                 if (isAnswer)
                     query.CheckAnswer(ipVersion, reconstructedHostname, payload, data);
                 else
                     query.CheckAdditionalRecord(reconstructedHostname, payload, data);
+        }
     }
 
     void MdnsClient::AnswerParser::ReadHostname()
@@ -1,8 +1,11 @@
 #ifndef SERVICES_MDNS_CLIENT_HPP
 #define SERVICES_MDNS_CLIENT_HPP
 
+#include "infra/timer/Timer.hpp"
+#include "infra/util/BoundedVector.hpp"
 #include "infra/util/IntrusiveList.hpp"
 #include "infra/util/Optional.hpp"
+#include "infra/util/WithStorage.hpp"
 #include "services/network/Datagram.hpp"
 #include "services/network/Dns.hpp"
 #include "services/network/Multicast.hpp"
@@ -31,6 +34,68 @@ namespace services
         virtual void EndOfAnswerNotification() = 0;
     };
 
+    // Caches the answers to the queries of an MdnsClient. Records are keyed by name, type and class, so that they are
+    // shared by all queries for the same record, and outlive the query that caused them to be cached. Cached records
+    // are delivered to a query when it is asked, and are sent along as known answers so that responders do not repeat
+    // them (RFC 6762, section 7.1).
+    // Only records without compressed names in their data are cached, since those can be replayed outside
+    // of the message in which they were received.
+    class MdnsRecordCache
+    {
+    public:
+        static constexpr std::size_t maxRecordDataSize = 128;
+
+        struct Record
+        {
+            infra::BoundedString::WithStorage<253> name;
+            DnsType type;
+            DnsClass class_;
+            IPVersions ipVersion;
+            infra::TimePoint validUntil;
+            infra::Duration ttl;
+            std::array<uint8_t, maxRecordDataSize> data;
+            std::size_t dataSize;
+
+            infra::ConstByteRange Data() const;
+        };
+
+        struct KnownAnswer
+        {
+            infra::Duration remainingTtl;
+            std::array<uint8_t, maxRecordDataSize> data;
+            std::size_t dataSize;
+
+            infra::ConstByteRange Data() const;
+        };
+
+        template<std::size_t Max>
+        using WithMaxRecords = infra::WithStorage<infra::WithStorage<MdnsRecordCache,
+                                                      infra::BoundedVector<Record>::WithMaxSize<Max>>,
+            infra::BoundedVector<KnownAnswer>::WithMaxSize<Max>>;
+
+        MdnsRecordCache(infra::BoundedVector<Record>& records, infra::BoundedVector<KnownAnswer>& knownAnswers);
+
+        void Add(infra::BoundedConstString name, DnsType type, DnsClass class_, IPVersions ipVersion, infra::Duration ttl, infra::ConstByteRange data);
+
+        // Records are looked up by the name and type of the query, in class IN
+        template<class F>
+        void ForEachRecord(const MdnsQuery& query, IPVersions ipVersion, F action);
+
+        // Known answers are the records of which more than half of the TTL remains. They are copied together with
+        // their remaining TTL, so that a query that is sent later contains exactly the answers for which it was sized,
+        // even when the cache changes in the meantime. The copies remain valid until the next snapshot.
+        infra::MemoryRange<const KnownAnswer> SnapshotKnownAnswers(const MdnsQuery& query, IPVersions ipVersion);
+
+    private:
+        void RemoveExpired();
+        Record* Find(infra::BoundedConstString name, DnsType type, DnsClass class_, IPVersions ipVersion, infra::ConstByteRange data);
+        static bool IsRecordFor(const Record& record, const MdnsQuery& query, IPVersions ipVersion);
+
+    private:
+        infra::BoundedVector<Record>& records;
+        infra::BoundedVector<KnownAnswer>& knownAnswers;
+    };
+
     class MdnsClient;
 
     class MdnsQueryImpl
@@ -79,6 +144,7 @@ namespace services
     {
     public:
         MdnsClient(DatagramFactory& datagramFactory, Multicast& multicast, IPVersions versions = IPVersions::both);
+        MdnsClient(DatagramFactory& datagramFactory, Multicast& multicast, MdnsRecordCache& cache, IPVersions versions = IPVersions::both);
         ~MdnsClient();
 
         virtual void RegisterQuery(MdnsQuery& query);
@@ -93,7 +159,9 @@ namespace services
         infra::detail::IntrusiveListIterator<MdnsQuery> FindNextWaitingQuery();
         void TrySendNextQuery();
         void SendQuery(MdnsQuery& query);
-        void ActiveQueryDone();
+        void ActiveQueryDone(MdnsQuery& query);
+        void AnswerFromCache(MdnsQuery& query);
+        void AddToCache(services::IPVersions ipVersion, infra::BoundedString& hostname, DnsRecordPayload& payload, infra::ConstByteRange data);
         bool IsActivelyQuerying();
         void CancelActiveQueryIfEqual(MdnsQuery& query);
 
@@ -113,6 +181,7 @@ namespace services
         private:
             MdnsClient& mdnsClient;
             MdnsQuery& query;
+            infra::MemoryRange<const MdnsRecordCache::KnownAnswer> knownAnswers;
         };
 
         class AnswerParser
@@ -142,11 +211,29 @@ namespace services
         DatagramFactory& datagramFactory;
         Multicast& multicast;
         IPVersions versions;
+        MdnsRecordCache* cache = nullptr;
         infra::SharedPtr<DatagramExchange> datagramExchange;
         infra::Optional<ActiveMdnsQuery> activeMdnsQuery;
         infra::IntrusiveList<MdnsQuery> queries;
         size_t lastWaitingQueryPosition = 0;
     };
+
+    ////    Implementation    ////
+
+    template<class F>
+    void MdnsRecordCache::ForEachRecord(const MdnsQuery& query, IPVersions ipVersion, F action)
+    {
+        RemoveExpired();
+
+        // The action may alter the cache, so iterate over copies of the records
+        auto now = infra::Now();
+        for (std::size_t i = 0; i < records.size(); ++i)
+            if (IsRecordFor(records[i], query, ipVersion))
+            {
+                auto record = records[i];
+                action(record.validUntil - now, record.Data());
+            }
+    }
 }
 
 #endif
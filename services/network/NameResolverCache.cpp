@@ -3,17 +3,41 @@
 
 namespace services
 {
-    NameResolverCache::NameResolverCache(infra::BoundedVector<CacheEntry>& cache, NameResolver& resolver, infra::Duration minimumTtl)
+    NameResolverCache::NameResolverCache(infra::BoundedVector<CacheEntry>& cache, infra::MemoryRange<CacheEntry*> indexSlots, NameResolver& resolver,
+        infra::Duration minimumTtl, infra::Duration negativeTtl, infra::Duration prefetchMargin)
         : cache(cache)
+        , index(indexSlots)
         , resolver(resolver)
         , minimumTtl(minimumTtl)
-    {}
+        , negativeTtl(negativeTtl)
+        , prefetchMargin(prefetchMargin)
+    {
+        assert(indexSlots.size() > cache.max_size());
+
+        cache.resize(cache.max_size());
+
+        for (auto& entry : cache)
+            freeEntries.push_back(entry);
+    }
 
     void NameResolverCache::Lookup(NameResolverResult& result)
     {
-        auto cacheEntry = SearchCache(result);
-        if (cacheEntry != infra::none)
-            result.NameLookupDone(cacheEntry->address, cacheEntry->validUntil);
+        auto cacheEntry = SearchCache(result.Hostname());
+        if (cacheEntry != nullptr)
+        {
+            MarkAsMostRecentlyUsed(*cacheEntry);
+
+            if (cacheEntry->failed)
+                result.NameLookupFailed();
+            else
+            {
+                auto address = cacheEntry->address;
+                auto validUntil = cacheEntry->validUntil;
+
+                TryPrefetch(*cacheEntry, result);
+                result.NameLookupDone(address, validUntil);
+            }
+        }
         else
         {
             waiting.push_back(result);
@@ -23,7 +47,7 @@ namespace services
 
     void NameResolverCache::CancelLookup(NameResolverResult& result)
     {
-        if (!activeLookup->IsResolving(result))
+        if (activeLookup == infra::none || !activeLookup->IsResolving(result))
         {
             assert(waiting.has_element(result));
             waiting.erase(result);
@@ -32,30 +56,22 @@ namespace services
             activeLookup->CancelLookup();
     }
 
-    void NameResolverCache::RemoveOneCacheEntry(infra::BoundedVector<CacheEntry>& cache)
+    void NameResolverCache::RemoveOneCacheEntry()
     {
-        infra::TimePoint firstToExpire = cache.front().validUntil;
-
-        for (auto& entry : cache)
-            firstToExpire = std::min(firstToExpire, entry.validUntil);
-
-        for (auto& entry : cache)
-            if (entry.validUntil == firstToExpire)
-            {
-                cache.erase(&entry);
-                break;
-            }
+        RemoveEntry(recentlyUsed.back());
     }
 
-    infra::Optional<NameResolverCache::CacheEntry> NameResolverCache::SearchCache(NameResolverResult& result) const
+    NameResolverCache::CacheEntry* NameResolverCache::SearchCache(infra::BoundedConstString name)
     {
-        auto nameHash = Hash(result.Hostname());
+        auto entry = FindInIndex(Hash(name));
 
-        for (auto& entry : cache)
-            if (entry.nameHash == nameHash)
-                return infra::MakeOptional(entry);
+        if (entry != nullptr && entry->validUntil <= infra::Now())
+        {
+            RemoveEntry(*entry);
+            return nullptr;
+        }
 
-        return infra::none;
+        return entry;
     }
 
     std::array<uint8_t, 16> NameResolverCache::Hash(infra::BoundedConstString name) const
@@ -77,6 +93,12 @@ namespace services
         return result.hash_parts.first;
     }
 
+    void NameResolverCache::TryPrefetch(const CacheEntry& entry, NameResolverResult& result)
+    {
+        if (!prefetch.IsPrefetching() && infra::Now() + prefetchMargin >= entry.validUntil)
+            prefetch.Start(result.Hostname(), result.Versions());
+    }
+
     void NameResolverCache::TryResolveNext()
     {
         if (activeLookup == infra::none && !waiting.empty())
@@ -89,13 +111,14 @@ namespace services
     void NameResolverCache::NameLookupSuccess(NameResolverResult& result, IPAddress address, infra::TimePoint validUntil)
     {
         validUntil = std::max(infra::Now() + minimumTtl, validUntil);
-        TryAddToCache(result.Hostname(), address, validUntil);
+        AddToCache(result.Hostname(), address, validUntil);
         NameLookupDone([&result, &address, &validUntil]()
             { result.NameLookupDone(address, validUntil); });
     }
 
     void NameResolverCache::NameLookupFailed(NameResolverResult& result)
     {
+        AddFailureToCache(result.Hostname());
         NameLookupDone([&result]()
             { result.NameLookupFailed(); });
     }
@@ -112,38 +135,84 @@ namespace services
         TryResolveNext();
     }
 
-    void NameResolverCache::TryAddToCache(infra::BoundedConstString name, IPAddress address, infra::TimePoint validUntil)
+    void NameResolverCache::AddToCache(infra::BoundedConstString name, IPAddress address, infra::TimePoint validUntil)
     {
-        if (cache.full())
-            RemoveOneCacheEntry(cache);
-
-        AddToCache(name, address, validUntil);
+        auto& entry = FindOrAllocateEntry(Hash(name));
+        entry.address = address;
+        entry.validUntil = validUntil;
+        entry.failed = false;
     }
 
-    void NameResolverCache::AddToCache(infra::BoundedConstString name, IPAddress address, infra::TimePoint validUntil)
+    void NameResolverCache::AddFailureToCache(infra::BoundedConstString name)
     {
-        cache.emplace_back(CacheEntry{ address, validUntil, Hash(name) });
-        Cleanup();
+        auto nameHash = Hash(name);
+        auto existing = FindInIndex(nameHash);
+
+        // A failed refresh does not replace an answer that is still valid
+        if (existing != nullptr && !existing->failed && existing->validUntil > infra::Now())
+            return;
+
+        auto& entry = FindOrAllocateEntry(nameHash);
+        entry.validUntil = infra::Now() + negativeTtl;
+        entry.failed = true;
     }
 
-    void NameResolverCache::Cleanup()
+    NameResolverCache::CacheEntry& NameResolverCache::FindOrAllocateEntry(const std::array<uint8_t, 16>& nameHash)
     {
-        infra::TimePoint now = infra::Now();
-        infra::TimePoint cleanupTime = infra::TimePoint::max();
+        auto entry = FindInIndex(nameHash);
 
-        for (auto entry = cache.begin(); entry != cache.end();)
+        if (entry == nullptr)
         {
-            if (entry->validUntil <= now)
-                entry = cache.erase(entry);
-            else
-            {
-                cleanupTime = std::min(cleanupTime, entry->validUntil);
-                ++entry;
-            }
+            if (freeEntries.empty())
+                RemoveOneCacheEntry();
+
+            entry = &freeEntries.front();
+            freeEntries.pop_front();
+            entry->nameHash = nameHash;
+            index.insert(entry);
+            recentlyUsed.push_front(*entry);
         }
+        else
+            MarkAsMostRecentlyUsed(*entry);
+
+        return *entry;
+    }
+
+    void NameResolverCache::RemoveEntry(CacheEntry& entry)
+    {
+        RemoveFromIndex(entry);
+        recentlyUsed.erase(entry);
+        freeEntries.push_front(entry);
+    }
+
+    void NameResolverCache::MarkAsMostRecentlyUsed(CacheEntry& entry)
+    {
+        recentlyUsed.erase(entry);
+        recentlyUsed.push_front(entry);
+    }
 
-        cleanupTimer.Start(cleanupTime, [this]()
-            { Cleanup(); });
+    NameResolverCache::CacheEntry* NameResolverCache::FindInIndex(const std::array<uint8_t, 16>& nameHash)
+    {
+        auto slot = index.find(IndexHash(nameHash), [&nameHash](const CacheEntry* entry)
+            { return entry->nameHash == nameHash; });
+
+        return slot != nullptr ? *slot : nullptr;
+    }
+
+    void NameResolverCache::RemoveFromIndex(CacheEntry& entry)
+    {
+        index.erase(*index.find(IndexHash(entry), [&entry](const CacheEntry* indexed)
+            { return indexed == &entry; }));
+    }
+
+    uint32_t NameResolverCache::IndexHash(const std::array<uint8_t, 16>& nameHash)
+    {
+        return nameHash[0] | (nameHash[1] << 8) | (nameHash[2] << 16) | (static_cast<uint32_t>(nameHash[3]) << 24);
+    }
+
+    uint32_t NameResolverCache::IndexHash(const CacheEntry& entry)
+    {
+        return IndexHash(entry.nameHash);
     }
 
     NameResolverCache::ActiveLookup::ActiveLookup(NameResolverCache& nameResolverCache, NameResolverResult& resolving)
@@ -183,4 +252,43 @@ namespace services
     {
         nameResolverCache.NameLookupFailed(resolving);
     }
+
+    NameResolverCache::Prefetch::Prefetch(NameResolverCache& nameResolverCache)
+        : nameResolverCache(nameResolverCache)
+    {}
+
+    bool NameResolverCache::Prefetch::IsPrefetching() const
+    {
+        return prefetching;
+    }
+
+    void NameResolverCache::Prefetch::Start(infra::BoundedConstString hostname, IPVersions versions)
+    {
+        this->hostname = hostname.substr(0, this->hostname.max_size());
+        this->versions = versions;
+        prefetching = true;
+
+        nameResolverCache.waiting.push_back(*this);
+        nameResolverCache.TryResolveNext();
+    }
+
+    infra::BoundedConstString NameResolverCache::Prefetch::Hostname() const
+    {
+        return hostname;
+    }
+
+    IPVersions NameResolverCache::Prefetch::Versions() const
+    {
+        return versions;
+    }
+
+    void NameResolverCache::Prefetch::NameLookupDone(IPAddress address, infra::TimePoint validUntil)
+    {
+        prefetching = false;
+    }
+
+    void NameResolverCache::Prefetch::NameLookupFailed()
+    {
+        prefetching = false;
+    }
 }
@@ -2,7 +2,10 @@
 #define SERVICES_NAME_RESOLVER_CACHE_HPP
 
 #include "infra/timer/Timer.hpp"
+#include "infra/util/BoundedString.hpp"
 #include "infra/util/BoundedVector.hpp"
+#include "infra/util/IntrusiveList.hpp"
+#include "infra/util/OpenAddressingIndex.hpp"
 #include "infra/util/WithStorage.hpp"
 #include "services/network/NameResolver.hpp"
 
@@ -13,23 +16,31 @@ namespace services
     {
     public:
         struct CacheEntry
+            : infra::IntrusiveList<CacheEntry>::NodeType
         {
             IPAddress address;
             infra::TimePoint validUntil;
             std::array<uint8_t, 16> nameHash;
+            bool failed = false;
         };
 
+        // Entries are found through an open addressing index with twice as many slots as there are entries
         template<std::size_t Size>
-        using WithCacheSize = infra::WithStorage<NameResolverCache, infra::BoundedVector<CacheEntry>::WithMaxSize<Size>>;
+        using WithCacheSize = infra::WithStorage<infra::WithStorage<NameResolverCache,
+                                                     infra::BoundedVector<CacheEntry>::WithMaxSize<Size>>,
+            std::array<CacheEntry*, 2 * Size>>;
 
-        NameResolverCache(infra::BoundedVector<CacheEntry>& cache, NameResolver& resolver, infra::Duration minimumTtl = std::chrono::minutes(10));
+        // Failed lookups are cached for negativeTtl. A cache hit within prefetchMargin of validUntil refreshes the entry in the background.
+        NameResolverCache(infra::BoundedVector<CacheEntry>& cache, infra::MemoryRange<CacheEntry*> indexSlots, NameResolver& resolver,
+            infra::Duration minimumTtl = std::chrono::minutes(10), infra::Duration negativeTtl = std::chrono::seconds(30), infra::Duration prefetchMargin = std::chrono::minutes(1));
 
         // Implementation of NameResolver
         virtual void Lookup(NameResolverResult& result) override;
         virtual void CancelLookup(NameResolverResult& result) override;
 
     protected:
-        virtual void RemoveOneCacheEntry(infra::BoundedVector<CacheEntry>& cache);
+        // Removes one entry to make room for a new entry; by default the least recently used entry
+        virtual void RemoveOneCacheEntry();
 
     private:
         class ActiveLookup
@@ -52,27 +63,62 @@ namespace services
             NameResolverResult& resolving;
         };
 
+        class Prefetch
+            : public NameResolverResult
+        {
+        public:
+            explicit Prefetch(NameResolverCache& nameResolverCache);
+
+            bool IsPrefetching() const;
+            void Start(infra::BoundedConstString hostname, IPVersions versions);
+
+            virtual infra::BoundedConstString Hostname() const override;
+            virtual IPVersions Versions() const override;
+            virtual void NameLookupDone(IPAddress address, infra::TimePoint validUntil) override;
+            virtual void NameLookupFailed() override;
+
+        private:
+            NameResolverCache& nameResolverCache;
+            infra::BoundedString::WithStorage<253> hostname;
+            IPVersions versions = IPVersions::ipv4;
+            bool prefetching = false;
+        };
+
     private:
-        infra::Optional<CacheEntry> SearchCache(NameResolverResult& result) const;
+        CacheEntry* SearchCache(infra::BoundedConstString name);
         std::array<uint8_t, 16> Hash(infra::BoundedConstString name) const;
+        void TryPrefetch(const CacheEntry& entry, NameResolverResult& result);
         void TryResolveNext();
         void NameLookupSuccess(NameResolverResult& result, IPAddress address, infra::TimePoint validUntil);
         void NameLookupFailed(NameResolverResult& result);
         void NameLookupCancelled();
         void NameLookupDone(const infra::Function<void(), 3 * sizeof(void*)>& observerCallback);
-        void TryAddToCache(infra::BoundedConstString name, IPAddress address, infra::TimePoint validUntil);
         void AddToCache(infra::BoundedConstString name, IPAddress address, infra::TimePoint validUntil);
-        void Cleanup();
+        void AddFailureToCache(infra::BoundedConstString name);
+        CacheEntry& FindOrAllocateEntry(const std::array<uint8_t, 16>& nameHash);
+        void RemoveEntry(CacheEntry& entry);
+        void MarkAsMostRecentlyUsed(CacheEntry& entry);
+
+        CacheEntry* FindInIndex(const std::array<uint8_t, 16>& nameHash);
+        void RemoveFromIndex(CacheEntry& entry);
+
+        static uint32_t IndexHash(const std::array<uint8_t, 16>& nameHash);
+        static uint32_t IndexHash(const CacheEntry& entry);
 
     private:
         infra::BoundedVector<CacheEntry>& cache;
+        infra::OpenAddressingIndex<CacheEntry*, infra::OpenAddressingPointerTraits<CacheEntry, &NameResolverCache::IndexHash>> index;
         NameResolver& resolver;
         infra::Duration minimumTtl;
+        infra::Duration negativeTtl;
+        infra::Duration prefetchMargin;
+
+        infra::IntrusiveList<CacheEntry> recentlyUsed; // Most recently used entry first
+        infra::IntrusiveList<CacheEntry> freeEntries;
 
         infra::IntrusiveList<NameResolverResult> waiting;
         infra::Optional<ActiveLookup> activeLookup;
-
-        infra::TimerSingleShot cleanupTimer;
+        Prefetch prefetch{ *this };
     };
 }
 
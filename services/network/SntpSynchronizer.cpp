@@ -0,0 +1,271 @@
+#include "services/network/SntpSynchronizer.hpp"
+#include "infra/event/EventDispatcher.hpp"
+#include "infra/util/Optional.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace services
+{
+    SntpSynchronizer::Server::Server(IPv4Address address)
+        : address(address)
+    {}
+
+    IPv4Address SntpSynchronizer::Server::Address() const
+    {
+        return address;
+    }
+
+    bool SntpSynchronizer::Server::Disabled() const
+    {
+        return disabled;
+    }
+
+    void SntpSynchronizer::Server::Disable()
+    {
+        disabled = true;
+        ClearSamples();
+    }
+
+    void SntpSynchronizer::Server::AddSample(infra::Duration offset, infra::Duration delay)
+    {
+        samples[next] = Sample{ offset, delay };
+        next = (next + 1) % windowSize;
+        count = std::min(count + 1, windowSize);
+    }
+
+    void SntpSynchronizer::Server::CorrectSamples(infra::Duration correction)
+    {
+        for (std::size_t i = 0; i != count; ++i)
+            samples[i].offset -= correction;
+    }
+
+    void SntpSynchronizer::Server::ClearSamples()
+    {
+        count = 0;
+        next = 0;
+    }
+
+    bool SntpSynchronizer::Server::HasSamples() const
+    {
+        return count != 0;
+    }
+
+    infra::Duration SntpSynchronizer::Server::Offset() const
+    {
+        return BestSample().offset;
+    }
+
+    infra::Duration SntpSynchronizer::Server::RootDistance() const
+    {
+        return BestSample().delay / 2 + Jitter();
+    }
+
+    const SntpSynchronizer::Server::Sample& SntpSynchronizer::Server::BestSample() const
+    {
+        assert(count != 0);
+        return *std::min_element(samples.begin(), samples.begin() + count, [](const Sample& x, const Sample& y)
+            { return x.delay < y.delay; });
+    }
+
+    infra::Duration SntpSynchronizer::Server::Jitter() const
+    {
+        auto best = Offset();
+        infra::Duration deviation{};
+
+        for (std::size_t i = 0; i != count; ++i)
+            deviation += std::chrono::abs(samples[i].offset - best);
+
+        return deviation / count;
+    }
+
+    SntpSynchronizer::SntpSynchronizer(infra::BoundedVector<Server>& servers, infra::MemoryRange<const IPv4Address> addresses, SntpClient& client,
+        infra::SlewingDerivedTimerService& clock, const Config& config)
+        : SntpResultObserver(client)
+        , servers(servers)
+        , client(client)
+        , clock(clock)
+        , config(config)
+    {
+        really_assert(addresses.size() <= servers.max_size());
+
+        for (auto& address : addresses)
+            servers.emplace_back(address);
+    }
+
+    void SntpSynchronizer::Start()
+    {
+        pollTimer.Start(
+            config.pollInterval, [this]()
+            { Poll(); },
+            infra::triggerImmediately);
+    }
+
+    void SntpSynchronizer::Stop()
+    {
+        pollTimer.Cancel();
+        responseTimer.Cancel();
+        pollInProgress = false;
+    }
+
+    void SntpSynchronizer::TimeAvailable(infra::Duration roundTripDelay, infra::Duration localClockOffset)
+    {
+        if (!pollInProgress)
+            return;
+
+        // Measured offsets are relative to the clock including the part of the slew that is still pending
+        servers[polling].AddSample(localClockOffset - clock.GetPendingSlew(), roundTripDelay);
+        PollDone();
+    }
+
+    void SntpSynchronizer::TimeUnavailable()
+    {
+        if (pollInProgress)
+            PollDone();
+    }
+
+    void SntpSynchronizer::KissOfDeath(KissCode reason)
+    {
+        if (!pollInProgress)
+            return;
+
+        if (reason != KissCode::rateExceeded)
+            servers[polling].Disable();
+
+        PollDone();
+    }
+
+    void SntpSynchronizer::Poll()
+    {
+        if (pollInProgress)
+            return;
+
+        pollInProgress = true;
+        polling = 0;
+        PollNext();
+    }
+
+    void SntpSynchronizer::PollNext()
+    {
+        if (!pollInProgress)
+            return;
+
+        while (polling != servers.size() && servers[polling].Disabled())
+            ++polling;
+
+        if (polling == servers.size())
+        {
+            pollInProgress = false;
+            Synchronize();
+        }
+        else
+        {
+            client.RequestTime(servers[polling].Address());
+            responseTimer.Start(config.responseTimeout, [this]()
+                {
+                    ++polling;
+                    PollNext();
+                });
+        }
+    }
+
+    void SntpSynchronizer::PollDone()
+    {
+        responseTimer.Cancel();
+        ++polling;
+
+        // The SntpClient is still handling the response, so do not request the next time from within its callback
+        infra::EventDispatcher::Instance().Schedule([this]()
+            { PollNext(); });
+    }
+
+    void SntpSynchronizer::Synchronize()
+    {
+        infra::Duration low;
+        infra::Duration high;
+
+        if (SelectInterval(low, high))
+            Apply(CombinedOffset(low, high));
+    }
+
+    bool SntpSynchronizer::SelectInterval(infra::Duration& low, infra::Duration& high) const
+    {
+        auto candidates = std::count_if(servers.begin(), servers.end(), [](const Server& server)
+            { return server.HasSamples(); });
+
+        // Intersection algorithm: find the smallest interval containing points from the correctness intervals of
+        // at least candidates - falsetickers servers, allowing fewer than half of the servers to be falsetickers
+        for (std::size_t falsetickers = 0; falsetickers * 2 < static_cast<std::size_t>(candidates); ++falsetickers)
+        {
+            auto required = candidates - falsetickers;
+            low = infra::Duration::max();
+            high = infra::Duration::min();
+
+            for (auto& server : servers)
+                if (server.HasSamples())
+                {
+                    auto lower = server.Offset() - server.RootDistance();
+                    auto upper = server.Offset() + server.RootDistance();
+
+                    if (Survivors(lower) >= required)
+                        low = std::min(low, lower);
+                    if (Survivors(upper) >= required)
+                        high = std::max(high, upper);
+                }
+
+            if (low <= high)
+                return true;
+        }
+
+        return false;
+    }
+
+    std::size_t SntpSynchronizer::Survivors(infra::Duration point) const
+    {
+        return std::count_if(servers.begin(), servers.end(), [point](const Server& server)
+            { return server.HasSamples() && server.Offset() - server.RootDistance() <= point && server.Offset() + server.RootDistance() >= point; });
+    }
+
+    infra::Duration SntpSynchronizer::CombinedOffset(infra::Duration low, infra::Duration high) const
+    {
+        // Average the truechimers weighted by the inverse of their root distance. Offsets are taken relative
+        // to the first truechimer, so that the weighted sum stays small
+        infra::Optional<infra::Duration> reference;
+        int64_t weightedSum = 0;
+        int64_t totalWeight = 0;
+
+        for (auto& server : servers)
+            if (server.HasSamples() && server.Offset() >= low && server.Offset() <= high)
+            {
+                if (reference == infra::none)
+                    reference.Emplace(server.Offset());
+
+                auto distance = std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(server.RootDistance()).count(), 1);
+                auto weight = 1000000 / distance + 1;
+                weightedSum += weight * std::chrono::duration_cast<std::chrono::microseconds>(server.Offset() - *reference).count();
+                totalWeight += weight;
+            }
+
+        if (reference == infra::none)
+            return (low + high) / 2;
+
+        return *reference + std::chrono::microseconds(weightedSum / totalWeight);
+    }
+
+    void SntpSynchronizer::Apply(infra::Duration offset)
+    {
+        if (std::chrono::abs(offset) > config.stepThreshold)
+        {
+            clock.Shift(clock.GetCurrentShift() + clock.GetPendingSlew() + offset);
+
+            for (auto& server : servers)
+                server.ClearSamples();
+        }
+        else
+        {
+            clock.Slew(clock.GetPendingSlew() + offset);
+
+            for (auto& server : servers)
+                server.CorrectSamples(offset);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef SERVICES_SNTP_SYNCHRONIZER_HPP
+#define SERVICES_SNTP_SYNCHRONIZER_HPP
+
+#include "infra/timer/SlewingDerivedTimerService.hpp"
+#include "infra/timer/Timer.hpp"
+#include "infra/util/BoundedVector.hpp"
+#include "infra/util/MemoryRange.hpp"
+#include "infra/util/WithStorage.hpp"
+#include "services/network/SntpClient.hpp"
+#include <array>
+
+namespace services
+{
+    // Periodically polls several NTP servers and keeps a window of samples per server. Each poll round, the
+    // clock filter picks the minimum-delay sample of every server, the intersection algorithm discards falsetickers,
+    // and the combined offset of the remaining servers is slewed into the clock; only large offsets are stepped.
+    // Build the TimeWithLocalization used by the SntpClient on top of the slewing timer service, so that
+    // offsets are measured against the corrected clock.
+    class SntpSynchronizer
+        : public SntpResultObserver
+    {
+    public:
+        class Server;
+
+        template<std::size_t Max>
+        using WithMaxServers = infra::WithStorage<SntpSynchronizer, infra::BoundedVector<Server>::WithMaxSize<Max>>;
+
+        struct Config
+        {
+            Config()
+            {}
+
+            infra::Duration pollInterval = std::chrono::seconds(64);
+            infra::Duration responseTimeout = std::chrono::seconds(2);
+            infra::Duration stepThreshold = std::chrono::milliseconds(128);
+        };
+
+        SntpSynchronizer(infra::BoundedVector<Server>& servers, infra::MemoryRange<const IPv4Address> addresses, SntpClient& client,
+            infra::SlewingDerivedTimerService& clock, const Config& config = Config());
+
+        void Start();
+        void Stop();
+
+        // Implementation of SntpResultObserver
+        virtual void TimeAvailable(infra::Duration roundTripDelay, infra::Duration localClockOffset) override;
+        virtual void TimeUnavailable() override;
+        virtual void KissOfDeath(KissCode reason) override;
+
+    public:
+        class Server
+        {
+        public:
+            static constexpr std::size_t windowSize = 8;
+
+            explicit Server(IPv4Address address);
+
+            IPv4Address Address() const;
+            bool Disabled() const;
+            void Disable();
+
+            void AddSample(infra::Duration offset, infra::Duration delay);
+            void CorrectSamples(infra::Duration correction);
+            void ClearSamples();
+            bool HasSamples() const;
+
+            // Clock filter: offset of the sample with the smallest round trip delay
+            infra::Duration Offset() const;
+            // Half the round trip delay of the selected sample plus the jitter of the window
+            infra::Duration RootDistance() const;
+
+        private:
+            struct Sample
+            {
+                infra::Duration offset;
+                infra::Duration delay;
+            };
+
+            const Sample& BestSample() const;
+            infra::Duration Jitter() const;
+
+        private:
+            IPv4Address address;
+            bool disabled = false;
+            std::array<Sample, windowSize> samples;
+            std::size_t count = 0;
+            std::size_t next = 0;
+        };
+
+    private:
+        void Poll();
+        void PollNext();
+        void PollDone();
+        void Synchronize();
+        bool SelectInterval(infra::Duration& low, infra::Duration& high) const;
+        std::size_t Survivors(infra::Duration point) const;
+        infra::Duration CombinedOffset(infra::Duration low, infra::Duration high) const;
+        void Apply(infra::Duration offset);
+
+    private:
+        infra::BoundedVector<Server>& servers;
+        SntpClient& client;
+        infra::SlewingDerivedTimerService& clock;
+        Config config;
+
+        infra::TimerRepeating pollTimer;
+        infra::TimerSingleShot responseTimer;
+        std::size_t polling = 0;
+        bool pollInProgress = false;
+    };
+}
+
+#endif
@@ -2,6 +2,8 @@
 #include "infra/util/BoundedVector.hpp"
 #include "infra/util/Endian.hpp"
 #include "infra/util/EnumCast.hpp"
+#include <cassert>
+#include <limits>
 
 namespace
 {
@@ -82,6 +84,73 @@ namespace services
         headers.push_back(services::HttpHeader("Sec-Websocket-Version", "13"));
     }
 
+    std::size_t WebSocket::FrameHeaderSize(uint64_t payloadLength, bool masked)
+    {
+        std::size_t size = 2;
+
+        if (payloadLength > std::numeric_limits<uint16_t>::max())
+            size += sizeof(uint64_t);
+        else if (payloadLength >= extendedPayloadLength16)
+            size += sizeof(uint16_t);
+
+        if (masked)
+            size += std::tuple_size<WebSocketMaskingKey>::value;
+
+        return size;
+    }
+
+    void WebSocket::WriteFrameHeader(infra::DataOutputStream& stream, WebSocketOpCode opCode, bool finalFrame, uint64_t payloadLength, const infra::Optional<WebSocketMaskingKey>& maskingKey)
+    {
+        uint8_t fin = finalFrame ? infra::enum_cast(WebSocketMask::finMask) : 0;
+        uint8_t mask = maskingKey != infra::none ? infra::enum_cast(WebSocketMask::payloadMask) : 0;
+
+        stream << static_cast<uint8_t>(fin | (infra::enum_cast(opCode) & infra::enum_cast(WebSocketMask::opCodeMask)));
+
+        if (payloadLength < extendedPayloadLength16)
+            stream << static_cast<uint8_t>(payloadLength | mask);
+        else if (payloadLength <= std::numeric_limits<uint16_t>::max())
+            stream << static_cast<uint8_t>(extendedPayloadLength16 | mask) << infra::ToBigEndian(static_cast<uint16_t>(payloadLength));
+        else
+            stream << static_cast<uint8_t>(extendedPayloadLength64 | mask) << infra::ToBigEndian(payloadLength);
+
+        if (maskingKey != infra::none)
+            stream << *maskingKey;
+    }
+
+    void WebSocketOutgoingMessage::Start(uint64_t messageSize)
+    {
+        assert(!fragmenting);
+        remaining = messageSize;
+    }
+
+    std::pair<WebSocketOpCode, bool> WebSocketOutgoingMessage::NextFrame(uint64_t payloadLength)
+    {
+        auto opCode = fragmenting ? WebSocketOpCode::opCodeContinue : WebSocketOpCode::opCodeBin;
+
+        if (payloadLength >= remaining)
+        {
+            remaining = 0;
+            fragmenting = false;
+            return std::make_pair(opCode, true);
+        }
+
+        remaining -= payloadLength;
+        fragmenting = true;
+        return std::make_pair(opCode, false);
+    }
+
+    bool WebSocketIncomingMessage::IsBinaryData(WebSocketOpCode opCode)
+    {
+        if (opCode == WebSocketOpCode::opCodeBin)
+            binary = true;
+        else if (opCode == WebSocketOpCode::opCodeText)
+            binary = false;
+        else if (opCode != WebSocketOpCode::opCodeContinue)
+            return false;
+
+        return binary;
+    }
+
     WebSocketObserverFactoryImpl::WebSocketObserverFactoryImpl(const Creators& creators)
         : connectionCreator(creators.connectionCreator)
     {}
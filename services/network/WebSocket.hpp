@@ -4,6 +4,7 @@
 #include "infra/stream/InputStream.hpp"
 #include "infra/stream/OutputStream.hpp"
 #include "infra/util/BoundedVector.hpp"
+#include "infra/util/Optional.hpp"
 #include "infra/util/ProxyCreator.hpp"
 #include "infra/util/SharedOptional.hpp"
 #include "services/network/Connection.hpp"
@@ -59,6 +60,42 @@ namespace services
     {
     public:
         static void UpgradeHeaders(infra::BoundedVector<const services::HttpHeader>& headers, infra::BoundedConstString protocol);
+
+        static std::size_t FrameHeaderSize(uint64_t payloadLength, bool masked);
+        static void WriteFrameHeader(infra::DataOutputStream& stream, WebSocketOpCode opCode, bool finalFrame, uint64_t payloadLength, const infra::Optional<WebSocketMaskingKey>& maskingKey);
+    };
+
+    class WebSocketConnection
+        : public Connection
+    {
+    public:
+        // Announces an outgoing message of messageSize bytes which may span several send streams. The data of each
+        // following send stream is sent as a fragment of that message, until messageSize bytes have been sent.
+        // Without announcement, the data of each send stream is sent as a complete message.
+        virtual void StartMessage(uint64_t messageSize) = 0;
+    };
+
+    class WebSocketOutgoingMessage
+    {
+    public:
+        void Start(uint64_t messageSize);
+
+        // Returns the opcode of the frame holding the next payloadLength bytes, and whether that frame completes the message
+        std::pair<WebSocketOpCode, bool> NextFrame(uint64_t payloadLength);
+
+    private:
+        uint64_t remaining = 0;
+        bool fragmenting = false;
+    };
+
+    class WebSocketIncomingMessage
+    {
+    public:
+        // Returns whether the payload of a frame with opCode belongs to a binary message
+        bool IsBinaryData(WebSocketOpCode opCode);
+
+    private:
+        bool binary = false;
     };
 
     class WebSocketObserverFactory
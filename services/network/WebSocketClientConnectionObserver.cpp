@@ -26,7 +26,7 @@ namespace services
             assert(observerStreamRequested);
             assert(requestedSendSize != infra::none);
             assert(!streamWriter);
-            Connection::Observer().SendStreamAvailable(streamWriter.Emplace(std::move(writer), *infra::PostAssign(requestedSendSize, infra::none)));
+            Connection::Observer().SendStreamAvailable(streamWriter.Emplace(std::move(writer), *infra::PostAssign(requestedSendSize, infra::none), sendingMessage));
         }
     }
 
@@ -53,7 +53,8 @@ namespace services
 
     std::size_t WebSocketClientConnectionObserver::MaxSendStreamSize() const
     {
-        return ConnectionObserver::Subject().MaxSendStreamSize() - 8;
+        auto maxSize = ConnectionObserver::Subject().MaxSendStreamSize();
+        return maxSize - WebSocket::FrameHeaderSize(maxSize, true);
     }
 
     infra::SharedPtr<infra::StreamReaderWithRewinding> WebSocketClientConnectionObserver::ReceiveStream()
@@ -72,6 +73,7 @@ namespace services
         saveAtEndOfDiscovery = 0;
         unackedReadAvailable = availableInCurrentFrame;
         skipDiscoveryPayload = availableInCurrentFrame;
+        discoveredMessage = receivedMessage;
         DiscoverData();
     }
 
@@ -85,6 +87,11 @@ namespace services
         Abort();
     }
 
+    void WebSocketClientConnectionObserver::StartMessage(uint64_t messageSize)
+    {
+        sendingMessage.Start(messageSize);
+    }
+
     void WebSocketClientConnectionObserver::StreamWriterAllocatable()
     {
         observerStreamRequested = false;
@@ -99,12 +106,12 @@ namespace services
             {
                 pongRequested = false;
                 pongStreamRequested = true;
-                ConnectionObserver::Subject().RequestSendStream(8 + pongBuffer.max_size());
+                ConnectionObserver::Subject().RequestSendStream(WebSocket::FrameHeaderSize(pongBuffer.max_size(), true) + pongBuffer.max_size());
             }
             else if (requestedSendSize != infra::none)
             {
                 observerStreamRequested = true;
-                ConnectionObserver::Subject().RequestSendStream(*requestedSendSize + 8);
+                ConnectionObserver::Subject().RequestSendStream(*requestedSendSize + WebSocket::FrameHeaderSize(*requestedSendSize, true));
             }
         }
     }
@@ -128,26 +135,26 @@ namespace services
         while (skipDiscoveryPayload == 0 && !stream.Failed())
         {
             uint8_t opcode;
-            uint32_t payloadLength;
+            uint64_t payloadLength;
             std::tie(opcode, payloadLength) = ReadOpcodeAndPayloadLength(stream);
 
             if (!stream.Failed())
             {
-                if (static_cast<WebSocketOpCode>(opcode) == WebSocketOpCode::opCodeBin)
-                    unackedReadAvailable += payloadLength;
+                if (discoveredMessage.IsBinaryData(static_cast<WebSocketOpCode>(opcode)))
+                    unackedReadAvailable += static_cast<std::size_t>(payloadLength);
 
                 if (static_cast<WebSocketOpCode>(opcode) == WebSocketOpCode::opCodePing && unackedReadAvailable == 0)
                 {
                     if (stream.Available() < payloadLength)
                         break;
 
-                    pongBuffer.resize(std::min<std::size_t>(payloadLength, pongBuffer.max_size()));
+                    pongBuffer.resize(static_cast<std::size_t>(std::min<uint64_t>(payloadLength, pongBuffer.max_size())));
                     stream >> infra::MakeRange(pongBuffer);
                     pongRequested = true;
                     payloadLength -= pongBuffer.size();
                 }
 
-                skipDiscoveryPayload = payloadLength;
+                skipDiscoveryPayload = static_cast<std::size_t>(payloadLength);
                 SkipPayloadInDiscovery(stream);
                 saveAtEndOfDiscovery = reader->ConstructSaveMarker();
             }
@@ -179,20 +186,20 @@ namespace services
         {
             reader->Rewind(reader->ConstructSaveMarker() + availableInCurrentFrame);
             uint8_t opcode;
-            uint32_t payloadLength;
+            uint64_t payloadLength;
             std::tie(opcode, payloadLength) = ReadOpcodeAndPayloadLength(stream);
 
             if (!stream.Failed() && stream.Available() >= payloadLength)
             {
                 if (static_cast<WebSocketOpCode>(opcode) == WebSocketOpCode::opCodePing)
                 {
-                    pongBuffer.resize(std::min<std::size_t>(payloadLength, pongBuffer.max_size()));
+                    pongBuffer.resize(static_cast<std::size_t>(std::min<uint64_t>(payloadLength, pongBuffer.max_size())));
                     stream >> infra::MakeRange(pongBuffer);
                     pongRequested = true;
                     payloadLength -= pongBuffer.size();
                 }
 
-                Skip(*reader, payloadLength);
+                Skip(*reader, static_cast<std::size_t>(payloadLength));
             }
         }
 
@@ -204,24 +211,24 @@ namespace services
         pongStreamRequested = false;
 
         infra::DataOutputStream::WithErrorPolicy stream(*writer);
-        stream << static_cast<uint8_t>(static_cast<uint8_t>(WebSocketOpCode::opCodePong) | static_cast<uint8_t>(WebSocketMask::finMask));
-        stream << static_cast<uint8_t>(static_cast<uint8_t>(pongBuffer.size()) | static_cast<uint8_t>(WebSocketMask::payloadMask));
-        stream << WebSocketMaskingKey();
+        WebSocket::WriteFrameHeader(stream, WebSocketOpCode::opCodePong, true, pongBuffer.size(), infra::MakeOptional(WebSocketMaskingKey()));
         stream << infra::MakeRange(pongBuffer);
 
         writer = nullptr;
     }
 
-    std::pair<uint8_t, uint32_t> WebSocketClientConnectionObserver::ReadOpcodeAndPayloadLength(infra::DataInputStream& stream)
+    std::pair<uint8_t, uint64_t> WebSocketClientConnectionObserver::ReadOpcodeAndPayloadLength(infra::DataInputStream& stream)
     {
         uint8_t opcode;
-        uint32_t payloadLength;
+        uint64_t payloadLength;
 
         uint8_t payloadLength8;
         stream >> opcode >> payloadLength8;
 
         if (payloadLength8 == 126)
             payloadLength = infra::FromBigEndian(stream.Extract<uint16_t>());
+        else if (payloadLength8 == 127)
+            payloadLength = infra::FromBigEndian(stream.Extract<uint64_t>());
         else
             payloadLength = payloadLength8;
 
@@ -239,9 +246,10 @@ namespace services
         }
     }
 
-    WebSocketClientConnectionObserver::FrameWriter::FrameWriter(infra::SharedPtr<infra::StreamWriter>&& writer, std::size_t sendSize)
+    WebSocketClientConnectionObserver::FrameWriter::FrameWriter(infra::SharedPtr<infra::StreamWriter>&& writer, std::size_t sendSize, WebSocketOutgoingMessage& message)
         : infra::LimitedStreamWriter(*writer, sendSize)
         , writer(std::move(writer))
+        , message(message)
         , positionAtStart(this->writer->ConstructSaveMarker())
     {}
 
@@ -251,20 +259,15 @@ namespace services
         infra::DataOutputStream::WithErrorPolicy stream(*writer);
         infra::SavedMarkerDataStream savedStream(stream, positionAtStart);
 
-        savedStream << static_cast<uint8_t>(static_cast<uint8_t>(WebSocketOpCode::opCodeBin) | static_cast<uint8_t>(WebSocketMask::finMask));
-
-        if (dataLength <= 125)
-            savedStream << static_cast<uint8_t>(static_cast<uint8_t>(dataLength) | static_cast<uint8_t>(WebSocketMask::payloadMask));
-        else
-            savedStream << static_cast<uint8_t>(static_cast<uint8_t>(126) | static_cast<uint8_t>(WebSocketMask::payloadMask)) << infra::ToBigEndian(static_cast<uint16_t>(dataLength));
-
-        savedStream << WebSocketMaskingKey();
+        auto frame = message.NextFrame(dataLength);
+        WebSocket::WriteFrameHeader(savedStream, frame.first, frame.second, dataLength, infra::MakeOptional(WebSocketMaskingKey()));
     }
 
     WebSocketClientConnectionObserver::FrameReader::FrameReader(WebSocketClientConnectionObserver& client)
         : client(client)
         , reader(client.ConnectionObserver::Subject().ReceiveStream())
         , availableInCurrentFrame(client.availableInCurrentFrame)
+        , message(client.receivedMessage)
     {}
 
     void WebSocketClientConnectionObserver::FrameReader::Extract(infra::ByteRange range, infra::StreamErrorPolicy& errorPolicy)
@@ -334,6 +337,7 @@ namespace services
     {
         reader->Rewind(0);
         availableInCurrentFrame = client.availableInCurrentFrame;
+        message = client.receivedMessage;
         offset = 0;
 
         Forward(marker);
@@ -345,6 +349,7 @@ namespace services
         offset = 0;
 
         client.availableInCurrentFrame = availableInCurrentFrame;
+        client.receivedMessage = message;
     }
 
     infra::SharedPtr<infra::StreamReaderWithRewinding> WebSocketClientConnectionObserver::FrameReader::Reader()
@@ -370,13 +375,13 @@ namespace services
         {
             infra::DataInputStream::WithErrorPolicy stream(*reader);
             uint8_t opcode;
-            uint32_t payloadLength;
+            uint64_t payloadLength;
             std::tie(opcode, payloadLength) = ReadOpcodeAndPayloadLength(stream);
 
-            if (static_cast<WebSocketOpCode>(opcode) == WebSocketOpCode::opCodeBin)
-                availableInCurrentFrame = payloadLength;
+            if (message.IsBinaryData(static_cast<WebSocketOpCode>(opcode)))
+                availableInCurrentFrame = static_cast<std::size_t>(payloadLength);
             else
-                Skip(*reader, payloadLength);
+                Skip(*reader, static_cast<std::size_t>(payloadLength));
         }
     }
 
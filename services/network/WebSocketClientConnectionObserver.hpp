@@ -53,7 +53,7 @@ namespace services
 
     class WebSocketClientConnectionObserver
         : public services::ConnectionObserver
-        , public services::Connection
+        , public services::WebSocketConnection
     {
     public:
         explicit WebSocketClientConnectionObserver(infra::BoundedConstString path);
@@ -71,6 +71,9 @@ namespace services
         virtual void CloseAndDestroy() override;
         virtual void AbortAndDestroy() override;
 
+        // Implementation of WebSocketConnection
+        virtual void StartMessage(uint64_t messageSize) override;
+
     private:
         void StreamWriterAllocatable();
         void TryAllocateSendStream();
@@ -79,7 +82,7 @@ namespace services
         void SkipPayloadInDiscovery(infra::DataInputStream& stream);
         void SearchForPingRequests();
         void SendPong(infra::SharedPtr<infra::StreamWriter>&& writer);
-        static std::pair<uint8_t, uint32_t> ReadOpcodeAndPayloadLength(infra::DataInputStream& stream);
+        static std::pair<uint8_t, uint64_t> ReadOpcodeAndPayloadLength(infra::DataInputStream& stream);
         static void Skip(infra::StreamReader& reader, std::size_t size);
 
     private:
@@ -87,13 +90,14 @@ namespace services
             : public infra::LimitedStreamWriter
         {
         public:
-            FrameWriter(infra::SharedPtr<infra::StreamWriter>&& writer, std::size_t sendSize);
+            FrameWriter(infra::SharedPtr<infra::StreamWriter>&& writer, std::size_t sendSize, WebSocketOutgoingMessage& message);
             FrameWriter(const FrameWriter& other) = delete;
             FrameWriter& operator=(const FrameWriter& other) = delete;
             ~FrameWriter();
 
         private:
             infra::SharedPtr<infra::StreamWriter> writer;
+            WebSocketOutgoingMessage& message;
             std::size_t positionAtStart;
         };
 
@@ -125,6 +129,7 @@ namespace services
             infra::SharedPtr<infra::StreamReaderWithRewinding> reader;
             std::size_t offset = 0;
             std::size_t availableInCurrentFrame;
+            WebSocketIncomingMessage message;
         };
 
     private:
@@ -135,6 +140,9 @@ namespace services
         std::size_t availableInCurrentFrame = 0;
         std::size_t saveAtEndOfDiscovery = 0;
         std::size_t skipDiscoveryPayload = 0;
+        WebSocketIncomingMessage receivedMessage;
+        WebSocketIncomingMessage discoveredMessage;
+        WebSocketOutgoingMessage sendingMessage;
         infra::BoundedVector<uint8_t>::WithMaxSize<8> pongBuffer;
         bool pongRequested = false;
         bool pongStreamRequested = false;
@@ -55,8 +55,8 @@ namespace services
 
     std::size_t WebSocketServerConnectionObserver::MaxSendStreamSize() const
     {
-        static constexpr uint8_t frameDataSize = 4;
-        return std::min(sendBuffer.max_size(), Subject().MaxSendStreamSize() - frameDataSize);
+        auto maxSize = Subject().MaxSendStreamSize();
+        return std::min(sendBuffer.max_size(), maxSize - WebSocket::FrameHeaderSize(maxSize, false));
     }
 
     infra::SharedPtr<infra::StreamReaderWithRewinding> WebSocketServerConnectionObserver::ReceiveStream()
@@ -82,6 +82,11 @@ namespace services
         Abort();
     }
 
+    void WebSocketServerConnectionObserver::StartMessage(uint64_t messageSize)
+    {
+        sendingMessage.Start(messageSize);
+    }
+
     void WebSocketServerConnectionObserver::ReceiveStreamAllocatable()
     {
         receivingState->DataReceived();
@@ -121,17 +126,10 @@ namespace services
         sendingState->CheckForSomethingToDo();
     }
 
-    void WebSocketServerConnectionObserver::SendFrame(services::WebSocketOpCode operationCode, infra::ConstByteRange data, infra::StreamWriter& writer) const
+    void WebSocketServerConnectionObserver::SendFrame(services::WebSocketOpCode operationCode, bool finalFrame, infra::ConstByteRange data, infra::StreamWriter& writer) const
     {
         infra::DataOutputStream::WithErrorPolicy stream(writer);
-        stream << operationCode;
-
-        uint32_t dataLength = data.size();
-        if (dataLength <= 125)
-            stream << static_cast<uint8_t>(dataLength);
-        else
-            stream << static_cast<uint8_t>(126) << static_cast<uint8_t>(dataLength >> 8) << static_cast<uint8_t>(dataLength);
-
+        WebSocket::WriteFrameHeader(stream, operationCode, finalFrame, data.size(), infra::none);
         stream << data;
     }
 
@@ -173,7 +171,7 @@ namespace services
     WebSocketServerConnectionObserver::ReceivingStateReceiveData::ReceivingStateReceiveData(WebSocketServerConnectionObserver& connection, const services::WebSocketFrameHeader& header)
         : connection(connection)
         , header(header)
-        , sizeToReceive(static_cast<uint32_t>(header.PayloadLength()))
+        , sizeToReceive(header.PayloadLength())
     {}
 
     void WebSocketServerConnectionObserver::ReceivingStateReceiveData::DataReceived()
@@ -203,7 +201,7 @@ namespace services
         {
             auto startSize = connection.pongBuffer.size();
 
-            auto growSize = std::min(connection.pongBuffer.size() + std::min<std::size_t>(stream.Available(), sizeToReceive), connection.pongBuffer.max_size()) - connection.pongBuffer.size();
+            auto growSize = std::min(connection.pongBuffer.size() + AvailableInFrame(stream), connection.pongBuffer.max_size()) - connection.pongBuffer.size();
             connection.pongBuffer.resize(connection.pongBuffer.size() + growSize);
             sizeToReceive -= growSize;
             stream >> infra::Tail(infra::MakeRange(connection.pongBuffer), growSize);
@@ -217,7 +215,7 @@ namespace services
         {
             auto startSize = connection.receiveBuffer.size();
 
-            auto growSize = std::min(connection.receiveBuffer.size() + std::min<std::size_t>(stream.Available(), sizeToReceive), connection.receiveBuffer.max_size()) - connection.receiveBuffer.size();
+            auto growSize = std::min(connection.receiveBuffer.size() + AvailableInFrame(stream), connection.receiveBuffer.max_size()) - connection.receiveBuffer.size();
             connection.receiveBuffer.resize(connection.receiveBuffer.size() + growSize);
             sizeToReceive -= growSize;
 
@@ -236,7 +234,7 @@ namespace services
     {
         while (true)
         {
-            auto discardSize = std::min<std::size_t>(stream.Available(), sizeToReceive);
+            auto discardSize = AvailableInFrame(stream);
 
             if (discardSize == 0)
                 break;
@@ -246,6 +244,11 @@ namespace services
         }
     }
 
+    std::size_t WebSocketServerConnectionObserver::ReceivingStateReceiveData::AvailableInFrame(infra::DataInputStream& stream) const
+    {
+        return static_cast<std::size_t>(std::min<uint64_t>(stream.Available(), sizeToReceive));
+    }
+
     void WebSocketServerConnectionObserver::ReceivingStateReceiveData::ProcessFrameData(uint32_t alreadyReceived)
     {
         for (std::size_t i = alreadyReceived; i != connection.receiveBuffer.size(); ++i, ++receiveOffset)
@@ -277,7 +280,7 @@ namespace services
 
     void WebSocketServerConnectionObserver::ReceivingStateClose::Send(infra::SharedPtr<infra::StreamWriter>&& writer)
     {
-        connection.SendFrame(services::WebSocketOpCode::opCodeClose, infra::ConstByteRange(), *writer);
+        connection.SendFrame(services::WebSocketOpCode::opCodeClose, true, infra::ConstByteRange(), *writer);
         writer = nullptr;
         connection.Close();
     }
@@ -289,7 +292,7 @@ namespace services
 
     void WebSocketServerConnectionObserver::ReceivingStatePong::Send(infra::SharedPtr<infra::StreamWriter>&& writer)
     {
-        connection.SendFrame(services::WebSocketOpCode::opCodePong, infra::MakeRange(connection.pongBuffer), *writer);
+        connection.SendFrame(services::WebSocketOpCode::opCodePong, true, infra::MakeRange(connection.pongBuffer), *writer);
         connection.pongBuffer.clear();
         connection.SetReceivingStateReceiveHeader();
     }
@@ -345,7 +348,8 @@ namespace services
 
     void WebSocketServerConnectionObserver::SendingStateExternalData::SendStreamAvailable(infra::SharedPtr<infra::StreamWriter>&& writer)
     {
-        connection.SendFrame(services::WebSocketOpCode::opCodeBin, infra::MakeRange(connection.sendBuffer), *writer);
+        auto frame = connection.sendingMessage.NextFrame(connection.sendBuffer.size());
+        connection.SendFrame(frame.first, frame.second, infra::MakeRange(connection.sendBuffer), *writer);
         connection.sendBuffer.clear();
         writer = nullptr;
 
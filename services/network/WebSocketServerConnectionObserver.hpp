@@ -18,7 +18,7 @@ namespace services
 {
     class WebSocketServerConnectionObserver
         : public services::ConnectionObserver
-        , public services::Connection
+        , public services::WebSocketConnection
     {
     public:
         template<std::size_t SendBufferSize, std::size_t ReceiveBufferSize>
@@ -42,6 +42,9 @@ namespace services
         virtual void CloseAndDestroy() override;
         virtual void AbortAndDestroy() override;
 
+        // Implementation of WebSocketConnection
+        virtual void StartMessage(uint64_t messageSize) override;
+
     private:
         void ReceiveStreamAllocatable();
         void SendStreamAllocatable();
@@ -50,7 +53,7 @@ namespace services
         void SetReceivingStateClose();
         void SetReceivingStatePong();
         void SetStateSendingIdle();
-        void SendFrame(services::WebSocketOpCode operationCode, infra::ConstByteRange data, infra::StreamWriter& writer) const;
+        void SendFrame(services::WebSocketOpCode operationCode, bool finalFrame, infra::ConstByteRange data, infra::StreamWriter& writer) const;
         void TryAllocateSendStream();
 
     private:
@@ -99,6 +102,7 @@ namespace services
             void ReceiveData();
             void ConsumeData(infra::DataInputStream& stream);
             void DiscardRest(infra::DataInputStream& stream);
+            std::size_t AvailableInFrame(infra::DataInputStream& stream) const;
             void ProcessFrameData(uint32_t alreadyReceived);
             void ProcessPongData(uint32_t alreadyReceived);
             void SetNextState();
@@ -106,8 +110,8 @@ namespace services
         private:
             WebSocketServerConnectionObserver& connection;
             services::WebSocketFrameHeader header;
-            uint32_t sizeToReceive;
-            uint32_t receiveOffset = 0;
+            uint64_t sizeToReceive;
+            uint64_t receiveOffset = 0;
         };
 
         class ReceivingStateClose
@@ -196,6 +200,7 @@ namespace services
         infra::NotifyingSharedOptional<infra::LimitedStreamReaderWithRewinding::WithInput<infra::BoundedDequeInputStreamReader>> streamReader;
         infra::NotifyingSharedOptional<infra::LimitedStreamWriter::WithOutput<infra::BoundedVectorStreamWriter>> streamWriter;
         bool sendBufferReadyForSending = false;
+        WebSocketOutgoingMessage sendingMessage;
         infra::BoundedVector<uint8_t>::WithMaxSize<8> pongBuffer;
     };
 }
@@ -99,6 +99,28 @@ public:
             ipv4Source);
     }
 
+    void QueryWithKnownAnswerReceived(const std::vector<uint8_t>& question, const std::vector<uint8_t>& knownAnswer)
+    {
+        DataReceived(infra::ConstructBin()
+                         .Value<services::DnsRecordHeader>({ 0x0200, 0, 1, 1, 0, 0 })(question)(knownAnswer)
+                         .Vector(),
+            ipv4Source);
+    }
+
+    std::vector<uint8_t> PtrQuestion()
+    {
+        return infra::ConstructBin()(7)("service")(4)("type")(5)("local")(0)
+            .Value<services::DnsQuestionFooter>({ services::DnsType::dnsTypePtr, services::DnsClass::dnsClassIn })
+            .Vector();
+    }
+
+    std::vector<uint8_t> SrvQuestion()
+    {
+        return infra::ConstructBin()(8)("instance")(7)("service")(4)("type")(5)("local")(0)
+            .Value<services::DnsQuestionFooter>({ services::DnsType::dnsTypeSrv, services::DnsClass::dnsClassIn })
+            .Vector();
+    }
+
     void QueryWithNameServerReceived()
     {
         DataReceived(infra::ConstructBin()
@@ -228,6 +250,11 @@ public:
     }
 
     void ExpectResponse(const std::vector<uint8_t>& data)
+    {
+        ExpectResponse(datagramExchange, data);
+    }
+
+    void ExpectResponse(infra::SharedOptional<testing::StrictMock<services::DatagramExchangeMock>>& exchange, const std::vector<uint8_t>& data)
     {
         struct Ptr
         {
@@ -237,7 +264,7 @@ public:
 
         auto ptr = std::make_shared<Ptr>(Ptr{ *this, data });
 
-        EXPECT_CALL(*datagramExchange, RequestSendStream(data.size(), testing::_)).WillOnce(testing::Invoke([ptr](std::size_t sendSize, services::UdpSocket to)
+        EXPECT_CALL(*exchange, RequestSendStream(data.size(), testing::_)).WillOnce(testing::Invoke([ptr](std::size_t sendSize, services::UdpSocket to)
             { infra::EventDispatcher::Instance().Schedule([ptr]()
                   {
                 infra::StdVectorOutputStreamWriter::WithStorage response;
@@ -252,6 +279,20 @@ public:
             .Vector();
     }
 
+    std::vector<uint8_t> PtrAnswerWithTtl(infra::Duration ttl)
+    {
+        return infra::ConstructBin()(7)("service")(4)("type")(5)("local")(0)
+            .Value<services::DnsRecordPayload>({ services::DnsType::dnsTypePtr, services::DnsClass::dnsClassIn, ttl, 0x1d })(8)("instance")(7)("service")(4)("type")(5)("local")(0)
+            .Vector();
+    }
+
+    std::vector<uint8_t> PtrAnswerForOtherInstance()
+    {
+        return infra::ConstructBin()(7)("service")(4)("type")(5)("local")(0)
+            .Value<services::DnsRecordPayload>({ services::DnsType::dnsTypePtr, services::DnsClass::dnsClassIn, std::chrono::seconds(5), 0x1d })(8)("otherins")(7)("service")(4)("type")(5)("local")(0)
+            .Vector();
+    }
+
     std::vector<uint8_t> TxtAnswer()
     {
         return infra::ConstructBin()(8)("instance")(7)("service")(4)("type")(5)("local")(0)
@@ -362,9 +403,43 @@ public:
         };
     }
 
+    void ReConstructDualStack()
+    {
+        ExpectLeaveMulticastIpv4();
+        EXPECT_CALL(factory, Listen(testing::Ref(server), 5353, services::IPVersions::ipv4)).WillOnce(testing::Invoke([this](services::DatagramExchangeObserver& observer, uint16_t port, services::IPVersions versions)
+            {
+            auto ptr = datagramExchange.Emplace();
+            observer.Attach(*ptr);
+            ExpectResponse(datagramExchange, DualStackAnnouncement());
+            return ptr; }));
+        EXPECT_CALL(factory, Listen(testing::Ref(server), 5353, services::IPVersions::ipv6)).WillOnce(testing::Invoke([this](services::DatagramExchangeObserver& observer, uint16_t port, services::IPVersions versions)
+            {
+            // The server observes one datagram exchange, which receives all questions and send streams in this test
+            auto ptr = datagramExchangeIpv6.Emplace();
+            ExpectResponse(datagramExchangeIpv6, DualStackAnnouncement());
+            return ptr; }));
+        ExpectJoinMulticastIpv4();
+        ExpectJoinMulticastIpv6();
+        infra::ReConstruct(server, factory, multicast, "instance", "service", "type", infra::MakeOptional(services::IPv4Address{ 1, 2, 3, 4 }), infra::MakeOptional(services::IPv6Address{ 1, 2, 3, 4, 5, 6, 7, 8 }), 1234, text);
+        ExecuteAllActions();
+        expectLeave = [this]()
+        {
+            ExpectLeaveMulticastIpv4();
+            ExpectLeaveMulticastIpv6();
+        };
+    }
+
+    std::vector<uint8_t> DualStackAnnouncement()
+    {
+        return infra::ConstructBin()
+            .Value<services::DnsRecordHeader>({ 0x0000, 0x8000, 0, 5, 0, 0 })(PtrAnswer())(SrvAnswer())(TxtAnswer())(AAnswer())(AaaaAnswer())
+            .Vector();
+    }
+
     testing::StrictMock<services::MulticastMock> multicast;
     testing::StrictMock<services::DatagramFactoryMock> factory;
     infra::SharedOptional<testing::StrictMock<services::DatagramExchangeMock>> datagramExchange;
+    infra::SharedOptional<testing::StrictMock<services::DatagramExchangeMock>> datagramExchangeIpv6;
     infra::Execute execute{ [this]
         {
             ExpectListenIpv4();
@@ -414,10 +489,10 @@ TEST_F(BonjourServerTest, ptr_question_with_two_questions_has_answers_and_additi
     ExecuteAllActions();
 }
 
-TEST_F(BonjourServerTest, ptr_question_with_two_equal_questions_has_answers_and_additional_data)
+TEST_F(BonjourServerTest, ptr_question_with_two_equal_questions_has_answers_and_additional_data_once)
 {
     ExpectResponse(infra::ConstructBin()
-                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 2, 0, 8 })(PtrAnswer())(PtrAnswer())(TxtAnswer())(SrvAnswer())(AAnswer())(NoAaaaAnswer())(TxtAnswer())(SrvAnswer())(AAnswer())(NoAaaaAnswer())
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 4 })(PtrAnswer())(TxtAnswer())(SrvAnswer())(AAnswer())(NoAaaaAnswer())
                        .Vector());
 
     PtrQueryWithTwoEqualQuestionsReceived();
@@ -454,7 +529,7 @@ TEST_F(BonjourServerTest, a_question_has_answers)
     ExecuteAllActions();
 }
 
-TEST_F(BonjourServerTest, second_question_while_first_is_busy_is_ignored)
+TEST_F(BonjourServerTest, second_question_while_first_is_busy_is_answered_by_first_response)
 {
     ExpectResponse(infra::ConstructBin()
                        .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 4 })(PtrAnswer())(TxtAnswer())(SrvAnswer())(AAnswer())(NoAaaaAnswer())
@@ -465,6 +540,131 @@ TEST_F(BonjourServerTest, second_question_while_first_is_busy_is_ignored)
     ExecuteAllActions();
 }
 
+TEST_F(BonjourServerTest, questions_while_first_is_busy_are_aggregated_into_one_response)
+{
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 2 })(SrvAnswer())(AAnswer())(NoAaaaAnswer())
+                       .Vector());
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 2, 0, 0 })(PtrAnswer())(TxtAnswer())
+                       .Vector());
+
+    SrvQueryReceived();
+    TxtQueryReceived();
+    PtrQueryReceived();
+    AQueryReceived();
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, questions_for_both_ip_versions_while_first_is_busy_are_both_answered)
+{
+    ReConstructDualStack();
+
+    ExpectResponse(datagramExchange, infra::ConstructBin()
+                                         .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 0 })(AAnswer())
+                                         .Vector());
+    ExpectResponse(datagramExchangeIpv6, infra::ConstructBin()
+                                             .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 0 })(AaaaAnswer())
+                                             .Vector());
+    ExpectResponse(datagramExchange, infra::ConstructBin()
+                                         .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 0 })(TxtAnswer())
+                                         .Vector());
+
+    AQueryReceived();
+    AaaaQueryReceived(ipv6Source);
+    TxtQueryReceived();
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_answer_suppresses_answer)
+{
+    QueryWithKnownAnswerReceived(PtrQuestion(), PtrAnswer());
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_answer_with_less_than_half_ttl_remaining_does_not_suppress_answer)
+{
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 4 })(PtrAnswer())(TxtAnswer())(SrvAnswer())(AAnswer())(NoAaaaAnswer())
+                       .Vector());
+
+    QueryWithKnownAnswerReceived(PtrQuestion(), PtrAnswerWithTtl(std::chrono::seconds(2)));
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_answer_for_other_instance_does_not_suppress_answer)
+{
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 4 })(PtrAnswer())(TxtAnswer())(SrvAnswer())(AAnswer())(NoAaaaAnswer())
+                       .Vector());
+
+    QueryWithKnownAnswerReceived(PtrQuestion(), PtrAnswerForOtherInstance());
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_answer_suppresses_additional_record)
+{
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 1 })(SrvAnswer())(NoAaaaAnswer())
+                       .Vector());
+
+    QueryWithKnownAnswerReceived(SrvQuestion(), AAnswer());
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_answer_with_other_address_does_not_suppress_additional_record)
+{
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 2 })(SrvAnswer())(AAnswer())(NoAaaaAnswer())
+                       .Vector());
+
+    QueryWithKnownAnswerReceived(SrvQuestion(), infra::ConstructBin()(8)("instance")(5)("local")(0)
+                                                    .Value<services::DnsRecordPayload>({ services::DnsType::dnsTypeA, services::DnsClass::dnsClassIn, std::chrono::seconds(5), 4 })
+                                                    .Value<services::IPv4Address>({ 1, 2, 3, 5 })
+                                                    .Vector());
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_srv_and_txt_answers_suppress_answers)
+{
+    QueryWithKnownAnswerReceived(SrvQuestion(), SrvAnswer());
+    QueryWithKnownAnswerReceived(infra::ConstructBin()(8)("instance")(7)("service")(4)("type")(5)("local")(0)
+                                     .Value<services::DnsQuestionFooter>({ services::DnsType::dnsTypeTxt, services::DnsClass::dnsClassIn })
+                                     .Vector(),
+        TxtAnswer());
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_srv_answer_with_other_port_does_not_suppress_answer)
+{
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 2 })(SrvAnswer())(AAnswer())(NoAaaaAnswer())
+                       .Vector());
+
+    QueryWithKnownAnswerReceived(SrvQuestion(), infra::ConstructBin()(8)("instance")(7)("service")(4)("type")(5)("local")(0)
+                                                    .Value<services::DnsRecordPayload>({ services::DnsType::dnsTypeSrv, services::DnsClass::dnsClassIn, std::chrono::seconds(5), 0x16 })
+                                                    .Value<infra::BigEndian<uint16_t>>(0)
+                                                    .Value<infra::BigEndian<uint16_t>>(0)
+                                                    .Value<infra::BigEndian<uint16_t>>(1235)(8)("instance")(5)("local")(0)
+                                                    .Vector());
+    ExecuteAllActions();
+}
+
+TEST_F(BonjourServerTest, known_txt_answer_with_other_text_does_not_suppress_answer)
+{
+    ExpectResponse(infra::ConstructBin()
+                       .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 0 })(TxtAnswer())
+                       .Vector());
+
+    QueryWithKnownAnswerReceived(infra::ConstructBin()(8)("instance")(7)("service")(4)("type")(5)("local")(0)
+                                     .Value<services::DnsQuestionFooter>({ services::DnsType::dnsTypeTxt, services::DnsClass::dnsClassIn })
+                                     .Vector(),
+        infra::ConstructBin()(8)("instance")(7)("service")(4)("type")(5)("local")(0)
+            .Value<services::DnsRecordPayload>({ services::DnsType::dnsTypeTxt, services::DnsClass::dnsClassIn, std::chrono::seconds(5), 0x15 })(7)("aa=text")(12)("bb=otherteXt")
+            .Vector());
+    ExecuteAllActions();
+}
+
 TEST_F(BonjourServerTest, aaaa_query_is_declined_when_no_ipv6_address_is_available)
 {
     ExpectResponse(infra::ConstructBin()
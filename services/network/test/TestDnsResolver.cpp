@@ -21,17 +21,19 @@ public:
             { std::fill(result.begin(), result.end(), 9); }));
     }
 
-    auto&& ExpectRequestSendStream(services::NameResolverResultMock& result, infra::BoundedConstString hostname, services::IPAddress dnsServer)
+    auto&& ExpectRequestSendStream(services::NameResolverResultMock& result, infra::BoundedConstString hostname, services::IPAddress dnsServer, services::IPVersions versions = services::IPVersions::ipv4)
     {
         EXPECT_CALL(result, Hostname()).Times(testing::AnyNumber()).WillRepeatedly(testing::Return(hostname));
+        EXPECT_CALL(result, Versions()).Times(testing::AnyNumber()).WillRepeatedly(testing::Return(versions));
         return EXPECT_CALL(datagram, RequestSendStream(18 + hostname.size(), services::MakeUdpSocket(dnsServer, 53)));
     }
 
-    void ExpectAndRespondToRequestSendStream(services::NameResolverResultMock& result, infra::BoundedConstString hostname, services::IPAddress dnsServer)
+    void ExpectAndRespondToRequestSendStream(services::NameResolverResultMock& result, infra::BoundedConstString hostname, services::IPAddress dnsServer,
+        services::IPVersions versions = services::IPVersions::ipv4, uint8_t idLow = 9, uint8_t type = 1)
     {
-        ExpectRequestSendStream(result, hostname, dnsServer).WillOnce(testing::Invoke([this, &result, hostname](std::size_t sendSize, services::UdpSocket remote)
+        ExpectRequestSendStream(result, hostname, dnsServer, versions).WillOnce(testing::Invoke([this, &result, hostname, idLow, type](std::size_t sendSize, services::UdpSocket remote)
             {
-            EXPECT_CALL(writer, Insert(infra::CheckByteRangeContents(std::vector<uint8_t>{ { 9, 9, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0 } }), testing::_));
+            EXPECT_CALL(writer, Insert(infra::CheckByteRangeContents(std::vector<uint8_t>{ { 9, idLow, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0 } }), testing::_));
 
             infra::Tokenizer tokenizer(hostname, '.');
             for (uint32_t i = 0; i != tokenizer.Size(); ++i)
@@ -41,8 +43,9 @@ public:
             }
 
             EXPECT_CALL(writer, Insert(infra::CheckByteRangeContents(std::vector<uint8_t>{ { 0 } }), testing::_));
-            EXPECT_CALL(writer, Insert(infra::CheckByteRangeContents(std::vector<uint8_t>{ { 0, 1, 0, 1 } }), testing::_));
-            datagramExchangeObserver->SendStreamAvailable(infra::UnOwnedSharedPtr(writer)); }));
+            EXPECT_CALL(writer, Insert(infra::CheckByteRangeContents(std::vector<uint8_t>{ { 0, type, 0, 1 } }), testing::_));
+            datagramExchangeObserver->SendStreamAvailable(infra::UnOwnedSharedPtr(writer)); }))
+            .RetiresOnSaturation();
     }
 
     void Lookup(services::NameResolverResultMock& result)
@@ -50,13 +53,18 @@ public:
         resolver.Lookup(result);
     }
 
-    void GiveSendStream(services::NameResolverResultMock& result, infra::BoundedConstString hostname, services::IPAddress dnsServer)
+    void ExpectListen()
     {
-        currentHostname = hostname;
         EXPECT_CALL(datagramFactory, Listen(testing::_, services::IPVersions::both)).WillOnce(testing::Invoke([this](services::DatagramExchangeObserver& observer, services::IPVersions versions)
             {
             datagramExchangeObserver = &observer;
             return infra::UnOwnedSharedPtr(datagram); }));
+    }
+
+    void GiveSendStream(services::NameResolverResultMock& result, infra::BoundedConstString hostname, services::IPAddress dnsServer)
+    {
+        currentHostname = hostname;
+        ExpectListen();
         ExpectAndRespondToRequestSendStream(result, hostname, dnsServer);
     }
 
@@ -99,6 +107,19 @@ public:
         return std::vector<uint8_t>(address.begin(), address.end());
     }
 
+    std::vector<uint8_t> ConvertDns(services::IPv6Address address)
+    {
+        std::vector<uint8_t> result;
+
+        for (auto part : address)
+        {
+            result.push_back(static_cast<uint8_t>(part >> 8));
+            result.push_back(static_cast<uint8_t>(part));
+        }
+
+        return result;
+    }
+
     std::vector<uint8_t> MakeHeader(uint8_t answers, uint8_t authorativeNameServers = 0, uint8_t additionRecords = 0)
     {
         return std::vector<uint8_t>{ { 9, 9, 0x80, 0, 0, 1, 0, answers, 0, authorativeNameServers, 0, additionRecords } };
@@ -116,6 +137,12 @@ public:
         return Concatenate({ name, resourceInner, ConvertDns(answer) });
     }
 
+    std::vector<uint8_t> MakeAnswerAAAA(const std::vector<uint8_t>& name, services::IPv6Address answer)
+    {
+        std::vector<uint8_t> resourceInner{ { 0, 28, 0, 1, 0, 1, 0, 30, 0, 16 } };
+        return Concatenate({ name, resourceInner, ConvertDns(answer) });
+    }
+
     std::vector<uint8_t> MakeAnswerCName(const std::vector<uint8_t>& name, infra::BoundedConstString answer)
     {
         std::vector<uint8_t> resourceInner{ { 0, 5, 0, 1, 0, 1, 0, 30, 0, static_cast<uint8_t>(answer.size() + 2) } };
@@ -151,6 +178,22 @@ public:
         return Concatenate({ MakeHeader(1), MakeQuestion(hostname), MakeReferenceAnswerA(address) });
     }
 
+    std::vector<uint8_t> MakeDnsResponse(infra::BoundedConstString hostname, services::IPv4Address address, uint8_t idLow)
+    {
+        auto result = MakeDnsResponse(hostname, address);
+        result[1] = idLow;
+        return result;
+    }
+
+    std::vector<uint8_t> MakeDnsResponseAAAA(infra::BoundedConstString hostname, services::IPv6Address address, uint8_t idLow)
+    {
+        std::vector<uint8_t> nameReference{ { 0xc0, 0x0c } };
+        auto result = Concatenate({ MakeHeader(1), MakeQuestion(hostname), MakeAnswerAAAA(nameReference, address) });
+        result[1] = idLow;
+        result[static_cast<std::size_t>(12 + hostname.size() + 3)] = 28;
+        return result;
+    }
+
     std::vector<uint8_t> MakeDnsResponseWithUncompressedHost(infra::BoundedConstString hostname, services::IPv4Address address)
     {
         return Concatenate({ MakeHeader(1), MakeQuestion(hostname), MakeAnswerA(ConvertDns(hostname), address) });
@@ -316,11 +359,12 @@ public:
     const services::IPv4Address dnsServer2{ { 2, 3, 4, 5 } };
     const services::IPv4Address hostAddress1{ { 3, 4, 5, 6 } };
     const services::IPv4Address nsServer1{ { 4, 5, 6, 7 } };
+    const services::IPv6Address hostAddress6{ { 0x2001, 0xdb8, 0, 0, 0, 0, 0, 1 } };
 
     testing::StrictMock<services::DatagramFactoryMock> datagramFactory;
     const std::array<services::IPAddress, 2> dnsServers{ { dnsServer1, dnsServer2 } };
     testing::StrictMock<hal::SynchronousRandomDataGeneratorMock> randomDataGenerator;
-    services::DnsResolver resolver{ datagramFactory, { dnsServers }, randomDataGenerator };
+    services::DnsResolver::WithMaxConcurrentLookups<1> resolver{ datagramFactory, services::DnsResolver::DnsServers{ dnsServers }, randomDataGenerator };
     testing::StrictMock<services::NameResolverResultMock> result1;
     testing::StrictMock<services::NameResolverResultMock> result2;
     testing::StrictMock<services::DatagramExchangeMock> datagram;
@@ -588,6 +632,149 @@ TEST_F(DnsResolverTest, too_short_ns_results_in_retry)
     DataReceived(MakeDnsResponseWithNSTooShort("hostname.com", "ns.com", nsServer1), services::Udpv4Socket{ dnsServer2, 53 });
 }
 
+TEST_F(DnsResolverTest, ipv6_lookup_queries_aaaa_record)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2, services::IPVersions::ipv6, 9, 28);
+    Lookup(result1);
+
+    EXPECT_CALL(result1, NameLookupDone(services::IPAddress(hostAddress6), expiration));
+    DataReceived(MakeDnsResponseAAAA("hostname.com", hostAddress6, 9), services::Udpv4Socket{ dnsServer2, 53 });
+}
+
+TEST_F(DnsResolverTest, lookup_for_both_versions_queries_a_and_aaaa_in_parallel)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2, services::IPVersions::both, 10, 28);
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2, services::IPVersions::both, 9, 1);
+    Lookup(result1);
+
+    EXPECT_CALL(result1, NameLookupDone(services::IPAddress(hostAddress6), expiration));
+    DataReceived(MakeDnsResponseAAAA("hostname.com", hostAddress6, 10), services::Udpv4Socket{ dnsServer2, 53 });
+
+    DataReceived(MakeDnsResponse("hostname.com", hostAddress1), services::Udpv4Socket{ dnsServer2, 53 });
+}
+
+TEST_F(DnsResolverTest, lookup_for_both_versions_fails_when_both_queries_fail)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2, services::IPVersions::both, 10, 28);
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2, services::IPVersions::both, 9, 1);
+    Lookup(result1);
+
+    auto giveSendStream = [this](std::size_t sendSize, services::UdpSocket remote)
+    {
+        datagramExchangeObserver->SendStreamAvailable(infra::UnOwnedSharedPtr(writer));
+    };
+
+    EXPECT_CALL(writer, Insert(testing::_, testing::_)).Times(testing::AnyNumber());
+    EXPECT_CALL(datagram, RequestSendStream(30, services::MakeUdpSocket(dnsServer1, 53))).Times(2).WillRepeatedly(testing::Invoke(giveSendStream));
+    ForwardTime(std::chrono::seconds(5));
+
+    EXPECT_CALL(datagram, RequestSendStream(30, services::MakeUdpSocket(dnsServer2, 53))).Times(2).WillRepeatedly(testing::Invoke(giveSendStream));
+    ForwardTime(std::chrono::seconds(5));
+
+    EXPECT_CALL(result1, NameLookupFailed());
+    ForwardTime(std::chrono::seconds(5));
+}
+
+class DnsResolverConcurrentTest
+    : public DnsResolverTest
+{
+public:
+    services::DnsResolver::WithMaxConcurrentLookups<2> concurrentResolver{ datagramFactory, services::DnsResolver::DnsServers{ dnsServers }, randomDataGenerator };
+    testing::StrictMock<services::NameResolverResultMock> result3;
+};
+
+TEST_F(DnsResolverConcurrentTest, lookups_are_sent_in_parallel_over_one_datagram_exchange)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2);
+    concurrentResolver.Lookup(result1);
+
+    ExpectAndRespondToRequestSendStream(result2, "second.com", dnsServer1, services::IPVersions::ipv4, 10);
+    concurrentResolver.Lookup(result2);
+}
+
+TEST_F(DnsResolverConcurrentTest, responses_are_matched_on_query_id)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2);
+    concurrentResolver.Lookup(result1);
+    ExpectAndRespondToRequestSendStream(result2, "second.com", dnsServer1, services::IPVersions::ipv4, 10);
+    concurrentResolver.Lookup(result2);
+
+    EXPECT_CALL(result2, NameLookupDone(services::IPAddress(hostAddress1), expiration));
+    DataReceived(MakeDnsResponse("second.com", hostAddress1, 10), services::Udpv4Socket{ dnsServer1, 53 });
+
+    EXPECT_CALL(result1, NameLookupDone(services::IPAddress(hostAddress1), expiration));
+    DataReceived(MakeDnsResponse("hostname.com", hostAddress1), services::Udpv4Socket{ dnsServer2, 53 });
+}
+
+TEST_F(DnsResolverConcurrentTest, lookups_time_out_independently)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2);
+    concurrentResolver.Lookup(result1);
+
+    ForwardTime(std::chrono::seconds(2));
+    ExpectAndRespondToRequestSendStream(result2, "second.com", dnsServer1, services::IPVersions::ipv4, 10);
+    concurrentResolver.Lookup(result2);
+
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer1);
+    ForwardTime(std::chrono::seconds(3));
+
+    ExpectAndRespondToRequestSendStream(result2, "second.com", dnsServer2, services::IPVersions::ipv4, 10);
+    ForwardTime(std::chrono::seconds(2));
+}
+
+TEST_F(DnsResolverConcurrentTest, waiting_lookup_is_started_when_a_lookup_finishes)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2);
+    concurrentResolver.Lookup(result1);
+    ExpectAndRespondToRequestSendStream(result2, "second.com", dnsServer1, services::IPVersions::ipv4, 10);
+    concurrentResolver.Lookup(result2);
+    concurrentResolver.Lookup(result3);
+
+    EXPECT_CALL(result1, NameLookupDone(services::IPAddress(hostAddress1), expiration));
+    ExpectAndRespondToRequestSendStream(result3, "third.com", dnsServer2);
+    DataReceived(MakeDnsResponse("hostname.com", hostAddress1), services::Udpv4Socket{ dnsServer2, 53 });
+}
+
+TEST_F(DnsResolverConcurrentTest, cancelled_lookup_waiting_for_send_stream_is_not_retried)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2);
+    concurrentResolver.Lookup(result1);
+    ExpectRequestSendStream(result2, "second.com", dnsServer1);
+    concurrentResolver.Lookup(result2);
+
+    concurrentResolver.CancelLookup(result2);
+
+    EXPECT_CALL(writer, Insert(testing::_, testing::_)).Times(testing::AnyNumber());
+    datagramExchangeObserver->SendStreamAvailable(infra::UnOwnedSharedPtr(writer));
+
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer1);
+    ForwardTime(std::chrono::seconds(5));
+}
+
+TEST_F(DnsResolverConcurrentTest, waiting_lookup_is_started_when_cancelled_lookup_receives_its_send_stream)
+{
+    ExpectListen();
+    ExpectAndRespondToRequestSendStream(result1, "hostname.com", dnsServer2);
+    concurrentResolver.Lookup(result1);
+    ExpectRequestSendStream(result2, "second.com", dnsServer1);
+    concurrentResolver.Lookup(result2);
+    concurrentResolver.Lookup(result3);
+
+    concurrentResolver.CancelLookup(result2);
+
+    EXPECT_CALL(writer, Insert(testing::_, testing::_)).Times(testing::AnyNumber());
+    ExpectAndRespondToRequestSendStream(result3, "third.com", dnsServer2, services::IPVersions::ipv4, 10);
+    datagramExchangeObserver->SendStreamAvailable(infra::UnOwnedSharedPtr(writer));
+}
+
 class DnsResolverTestTooShort
     : public DnsResolverTest
 {};
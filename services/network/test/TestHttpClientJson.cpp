@@ -1,4 +1,5 @@
 #include "infra/stream/test/StreamMock.hpp"
+#include "infra/syntax/test_doubles/JsonPointerVisitorMock.hpp"
 #include "infra/syntax/test_doubles/JsonStreamingParserMock.hpp"
 #include "infra/timer/test_helper/ClockFixture.hpp"
 #include "infra/util/test_helper/BoundedStringMatcher.hpp"
@@ -108,6 +109,32 @@ TEST_F(HttpClientJsonTest, feed_json_data)
     httpClient.Observer().BodyComplete();
 }
 
+TEST_F(HttpClientJsonTest, feed_json_data_in_parts_to_JsonPointerExtractor)
+{
+    std::array<infra::BoundedConstString, 2> pointers{ { "/firmware/url", "/firmware/sha256" } };
+    testing::StrictMock<infra::JsonPointerVisitorMock> pointerVisitor;
+    infra::JsonPointerExtractor::WithMaxNesting<4> extractor{ pointers, pointerVisitor };
+
+    EXPECT_CALL(httpClient, Get("/path", testing::_));
+    EXPECT_CALL(controller, Headers()).WillOnce(testing::Return(headersIn));
+    EXPECT_CALL(controller, TopJsonObjectVisitor()).WillOnce(testing::ReturnRef(extractor));
+    httpClientObserverFactory->ConnectionEstablished([this](infra::SharedPtr<services::HttpClientObserver> client)
+        { httpClient.Attach(client); });
+
+    testing::StrictMock<infra::StreamReaderMock> reader;
+    EXPECT_CALL(reader, Empty()).WillOnce(testing::Return(false)).WillOnce(testing::Return(false)).WillOnce(testing::Return(true));
+    EXPECT_CALL(reader, ExtractContiguousRange(testing::_))
+        .WillOnce(testing::Return(infra::MakeStringByteRange(R"({ "notes": "release notes that are much longer than the value buffer of the parser", "firmware": { "url": "https://)")))
+        .WillOnce(testing::Return(infra::MakeStringByteRange(R"(host/fw.bin", "sha256": "abcd" } })")));
+    EXPECT_CALL(pointerVisitor, VisitString(0, "https://host/fw.bin"));
+    EXPECT_CALL(pointerVisitor, VisitString(1, "abcd"));
+    EXPECT_CALL(pointerVisitor, Close());
+    httpClient.Observer().BodyAvailable(infra::UnOwnedSharedPtr(reader));
+    EXPECT_CALL(controller, Done());
+    EXPECT_CALL(httpClient, CloseConnection());
+    httpClient.Observer().BodyComplete();
+}
+
 TEST_F(HttpClientJsonTest, ParseError_reports_Error)
 {
     EXPECT_CALL(httpClient, Get("/path", testing::_));
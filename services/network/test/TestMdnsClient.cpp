@@ -1,5 +1,6 @@
 #include "infra/stream/StdVectorInputStream.hpp"
 #include "infra/stream/StdVectorOutputStream.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
 #include "infra/util/ConstructBin.hpp"
 #include "infra/util/Function.hpp"
 #include "infra/util/SharedOptional.hpp"
@@ -615,3 +616,184 @@ TEST_F(MdnsClientTest, receiving_additional_records_to_active_query_results_in_d
     EXPECT_CALL(additionalRecordsCallback, callback(services::DnsType::dnsTypeSrv));
     PtrAnswerReceivedWithAdditionalRecords();
 }
+
+class MdnsClientWithCacheTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    ~MdnsClientWithCacheTest()
+    {
+        EXPECT_CALL(multicast, LeaveMulticastGroup(testing::_, mdnsMulticastAddressIpv4.Get<services::IPv4Address>()));
+    }
+
+    std::vector<uint8_t> AQuestion(uint16_t knownAnswers = 0)
+    {
+        return infra::ConstructBin()
+            .Value<services::DnsRecordHeader>({ 0x0000, 0x0000, 0x0001, knownAnswers, 0x0000, 0x0000 })(9)("_instance")(5)("local")(0)
+            .Value<services::DnsQuestionFooter>({ services::DnsType::dnsTypeA, services::DnsClass::dnsClassIn })
+            .Vector();
+    }
+
+    std::vector<uint8_t> AKnownAnswer(infra::Duration ttl)
+    {
+        return infra::ConstructBin()(0xc0)(0x0c)
+            .Value<services::DnsRecordPayload>({ services::DnsType::dnsTypeA, services::DnsClass::dnsClassIn, ttl, 4 })
+            .Value<services::IPv4Address>({ 1, 2, 3, 4 })
+            .Vector();
+    }
+
+    void AAnswerReceived(infra::Duration ttl = std::chrono::seconds(120))
+    {
+        datagramExchange->GetObserver().DataReceived(infra::MakeSharedOnHeap<infra::StdVectorInputStreamReader::WithStorage>(infra::inPlace,
+                                                         infra::ConstructBin()
+                                                             .Value<services::DnsRecordHeader>({ 0x0200, 0x8000, 0, 1, 0, 0 })(9)("_instance")(5)("local")(0)
+                                                             .Value<services::DnsRecordPayload>({ services::DnsType::dnsTypeA, services::DnsClass::dnsClassIn, ttl, 4 })
+                                                             .Value<services::IPv4Address>({ 1, 2, 3, 4 })
+                                                             .Vector()),
+            services::Udpv4Socket{ { 1, 2, 3, 4 }, mdnsPort });
+    }
+
+    void AskAndExpectQuestion(const std::vector<uint8_t>& question)
+    {
+        EXPECT_CALL(*datagramExchange, RequestSendStream(question.size(), testing::_));
+        queryA->Ask();
+
+        infra::StdVectorOutputStreamWriter::WithStorage response;
+        datagramExchange->GetObserver().SendStreamAvailable(infra::UnOwnedSharedPtr(response));
+        EXPECT_EQ(question, response.Storage());
+    }
+
+    testing::StrictMock<services::MulticastMock> multicast;
+    testing::StrictMock<services::DatagramFactoryMock> factory;
+    infra::SharedOptional<testing::StrictMock<services::DatagramExchangeMock>> datagramExchange;
+    infra::Execute execute{ [this]
+        {
+            EXPECT_CALL(factory, Listen(testing::_, mdnsPort, services::IPVersions::ipv4)).WillOnce(testing::Invoke([this](services::DatagramExchangeObserver& observer, uint16_t port, services::IPVersions versions)
+                {
+                    auto ptr = datagramExchange.Emplace();
+                    observer.Attach(*ptr);
+                    return ptr;
+                }));
+            EXPECT_CALL(multicast, JoinMulticastGroup(testing::_, mdnsMulticastAddressIpv4.Get<services::IPv4Address>()));
+        } };
+    services::MdnsRecordCache::WithMaxRecords<4> cache;
+    services::MdnsClient client{ factory, multicast, cache, services::IPVersions::ipv4 };
+
+    infra::MockCallback<void(infra::ConstByteRange data)> callback;
+    infra::Optional<services::MdnsQueryImpl> queryA{ infra::inPlace, client, services::DnsType::dnsTypeA, "_instance", [this](infra::ConstByteRange data)
+        {
+            callback.callback(data);
+        } };
+};
+
+TEST_F(MdnsClientWithCacheTest, query_without_cached_records_has_no_known_answers)
+{
+    AskAndExpectQuestion(AQuestion());
+}
+
+TEST_F(MdnsClientWithCacheTest, cached_answer_is_sent_as_known_answer_and_delivered_from_cache)
+{
+    EXPECT_CALL(callback, callback(testing::_));
+    AAnswerReceived();
+
+    ForwardTime(std::chrono::seconds(20));
+
+    EXPECT_CALL(callback, callback(testing::_));
+    AskAndExpectQuestion(infra::ConstructBin()(AQuestion(1))(AKnownAnswer(std::chrono::seconds(100))).Vector());
+}
+
+TEST_F(MdnsClientWithCacheTest, record_with_less_than_half_ttl_remaining_is_delivered_but_not_sent_as_known_answer)
+{
+    EXPECT_CALL(callback, callback(testing::_)).Times(2);
+    AAnswerReceived();
+
+    ForwardTime(std::chrono::seconds(61));
+    AskAndExpectQuestion(AQuestion());
+}
+
+TEST_F(MdnsClientWithCacheTest, expired_record_is_not_delivered)
+{
+    EXPECT_CALL(callback, callback(testing::_));
+    AAnswerReceived();
+
+    ForwardTime(std::chrono::seconds(120));
+    AskAndExpectQuestion(AQuestion());
+}
+
+TEST_F(MdnsClientWithCacheTest, goodbye_removes_record_from_cache)
+{
+    EXPECT_CALL(callback, callback(testing::_)).Times(2);
+    AAnswerReceived();
+    AAnswerReceived(infra::Duration());
+
+    AskAndExpectQuestion(AQuestion());
+}
+
+TEST_F(MdnsClientWithCacheTest, repeated_answer_refreshes_cached_record)
+{
+    EXPECT_CALL(callback, callback(testing::_)).Times(3);
+    AAnswerReceived();
+    ForwardTime(std::chrono::seconds(100));
+    AAnswerReceived();
+
+    ForwardTime(std::chrono::seconds(20));
+    AskAndExpectQuestion(infra::ConstructBin()(AQuestion(1))(AKnownAnswer(std::chrono::seconds(100))).Vector());
+}
+
+TEST_F(MdnsClientWithCacheTest, cached_record_outlives_query)
+{
+    EXPECT_CALL(callback, callback(testing::_));
+    AAnswerReceived();
+
+    queryA.Emplace(client, services::DnsType::dnsTypeA, "_instance", [this](infra::ConstByteRange data)
+        {
+            callback.callback(data);
+        });
+
+    ForwardTime(std::chrono::seconds(20));
+
+    EXPECT_CALL(callback, callback(testing::_));
+    AskAndExpectQuestion(infra::ConstructBin()(AQuestion(1))(AKnownAnswer(std::chrono::seconds(100))).Vector());
+}
+
+TEST_F(MdnsClientWithCacheTest, cached_record_is_shared_by_queries_for_the_same_record)
+{
+    EXPECT_CALL(callback, callback(testing::_));
+    AAnswerReceived();
+
+    infra::MockCallback<void(infra::ConstByteRange data)> otherCallback;
+    services::MdnsQueryImpl otherQuery{ client, services::DnsType::dnsTypeA, "_instance", [&otherCallback](infra::ConstByteRange data)
+        {
+            otherCallback.callback(data);
+        } };
+
+    ForwardTime(std::chrono::seconds(20));
+
+    auto question = infra::ConstructBin()(AQuestion(1))(AKnownAnswer(std::chrono::seconds(100))).Vector();
+    EXPECT_CALL(*datagramExchange, RequestSendStream(question.size(), testing::_));
+    otherQuery.Ask();
+
+    EXPECT_CALL(otherCallback, callback(testing::_));
+    infra::StdVectorOutputStreamWriter::WithStorage response;
+    datagramExchange->GetObserver().SendStreamAvailable(infra::UnOwnedSharedPtr(response));
+    EXPECT_EQ(question, response.Storage());
+}
+
+TEST_F(MdnsClientWithCacheTest, known_answers_are_sent_as_selected_when_query_was_sized)
+{
+    EXPECT_CALL(callback, callback(testing::_)).Times(2);
+    AAnswerReceived();
+
+    ForwardTime(std::chrono::seconds(20));
+
+    auto question = infra::ConstructBin()(AQuestion(1))(AKnownAnswer(std::chrono::seconds(100))).Vector();
+    EXPECT_CALL(*datagramExchange, RequestSendStream(question.size(), testing::_));
+    queryA->Ask();
+
+    ForwardTime(std::chrono::seconds(50));
+
+    infra::StdVectorOutputStreamWriter::WithStorage response;
+    datagramExchange->GetObserver().SendStreamAvailable(infra::UnOwnedSharedPtr(response));
+    EXPECT_EQ(question, response.Storage());
+}
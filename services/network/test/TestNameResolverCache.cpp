@@ -176,3 +176,87 @@ TEST_F(NameResolverCacheTest, minimum_ttl_is_applied)
     ExpectNameLookupDone(result1, address1, std::chrono::minutes(10));
     lookupResult->NameLookupDone(address1, infra::Now() + std::chrono::minutes(5));
 }
+
+TEST_F(NameResolverCacheTest, least_recently_used_is_removed_on_overflow)
+{
+    AddToCache(hostname1, address1);
+    AddToCache(hostname2, address1);
+
+    ExpectNameLookupDone(result1, address1);
+    resolverCache.Lookup(result1);
+
+    AddToCache(hostname3, address1);
+
+    ExpectNameLookupDone(result1, address1);
+    resolverCache.Lookup(result1);
+
+    Lookup(result2);
+}
+
+TEST_F(NameResolverCacheTest, cache_is_consistent_after_many_replacements)
+{
+    std::array<infra::BoundedConstString, 8> hostnames{ { "a.com", "b.com", "c.com", "d.com", "e.com", "f.com", "g.com", "h.com" } };
+
+    for (auto hostname : hostnames)
+        AddToCache(hostname, address1);
+
+    for (auto hostname : { hostnames[6], hostnames[7] })
+    {
+        testing::StrictMock<services::NameResolverResultMock> result;
+        EXPECT_CALL(result, Hostname()).WillRepeatedly(testing::Return(hostname));
+        ExpectNameLookupDone(result, address1);
+        resolverCache.Lookup(result);
+    }
+}
+
+TEST_F(NameResolverCacheTest, failed_lookup_is_cached)
+{
+    Lookup(result1);
+    NameLookupFailed(result1);
+
+    EXPECT_CALL(result1, NameLookupFailed());
+    resolverCache.Lookup(result1);
+}
+
+TEST_F(NameResolverCacheTest, failed_lookup_expires_after_negative_ttl)
+{
+    Lookup(result1);
+    NameLookupFailed(result1);
+
+    ForwardTime(std::chrono::seconds(30));
+    Lookup(result1);
+}
+
+TEST_F(NameResolverCacheTest, entry_used_shortly_before_expiry_is_prefetched)
+{
+    const services::IPAddress address2{ services::IPv4Address{ 5, 6, 7, 8 } };
+
+    AddToCache(hostname1, address1);
+    ForwardTime(std::chrono::minutes(59));
+
+    EXPECT_CALL(resolver, Lookup(testing::_)).WillOnce(infra::SaveRef<0>(&lookupResult));
+    ExpectNameLookupDone(result1, address1, std::chrono::minutes(1));
+    resolverCache.Lookup(result1);
+
+    lookupResult->NameLookupDone(address2, infra::Now() + std::chrono::hours(1));
+
+    ForwardTime(std::chrono::minutes(30));
+    ExpectNameLookupDone(result1, address2, std::chrono::minutes(30));
+    resolverCache.Lookup(result1);
+}
+
+TEST_F(NameResolverCacheTest, failed_prefetch_keeps_entry)
+{
+    AddToCache(hostname1, address1);
+    ForwardTime(std::chrono::minutes(59));
+
+    EXPECT_CALL(resolver, Lookup(testing::_)).WillOnce(infra::SaveRef<0>(&lookupResult));
+    ExpectNameLookupDone(result1, address1, std::chrono::minutes(1));
+    resolverCache.Lookup(result1);
+
+    lookupResult->NameLookupFailed();
+
+    ExpectNameLookupDone(result1, address1, std::chrono::minutes(1));
+    EXPECT_CALL(resolver, Lookup(testing::_));
+    resolverCache.Lookup(result1);
+}
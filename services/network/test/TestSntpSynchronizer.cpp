@@ -0,0 +1,153 @@
+#include "infra/timer/SlewingDerivedTimerService.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
+#include "services/network/SntpSynchronizer.hpp"
+#include "services/network/test_doubles/DatagramMock.hpp"
+#include "gmock/gmock.h"
+
+class SntpSynchronizerTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    SntpSynchronizerTest()
+        : datagramExchangePtr(infra::UnOwnedSharedPtr(datagramExchange))
+        , clockId(reinterpret_cast<std::ptrdiff_t>(&clockId))
+        , clock(clockId, systemTimerService)
+        , sntpClient(factory, timeWithLocalization)
+        , synchronizer(infra::MakeRange(addresses), sntpClient, clock)
+    {}
+
+    void ExpectRequest(services::IPv4Address address)
+    {
+        EXPECT_CALL(factory, Connect(testing::Ref(sntpClient), services::UdpSocket{ services::Udpv4Socket{ address, 123 } })).WillOnce(testing::Return(datagramExchangePtr));
+        EXPECT_CALL(datagramExchange, RequestSendStream(48));
+    }
+
+    void Respond(infra::Duration offset, infra::Duration delay)
+    {
+        synchronizer.TimeAvailable(delay, offset);
+        ExecuteAllActions();
+    }
+
+    void Start()
+    {
+        ExpectRequest(addresses[0]);
+        synchronizer.Start();
+    }
+
+    void NextPoll()
+    {
+        ExpectRequest(addresses[0]);
+        ForwardTime(std::chrono::seconds(64));
+    }
+
+    void RespondAll(infra::Duration offset1, infra::Duration offset2, infra::Duration offset3, infra::Duration delay = std::chrono::milliseconds(10))
+    {
+        ExpectRequest(addresses[1]);
+        Respond(offset1, delay);
+        ExpectRequest(addresses[2]);
+        Respond(offset2, delay);
+        Respond(offset3, delay);
+    }
+
+    testing::StrictMock<services::DatagramFactoryMock> factory;
+    testing::StrictMock<services::DatagramExchangeMock> datagramExchange;
+    infra::SharedPtr<services::DatagramExchangeMock> datagramExchangePtr;
+    std::ptrdiff_t clockId;
+    infra::SlewingDerivedTimerService clock;
+    services::TimeWithLocalization timeWithLocalization;
+    services::SntpClient sntpClient;
+    std::array<services::IPv4Address, 3> addresses{ { { 10, 0, 0, 1 }, { 10, 0, 0, 2 }, { 10, 0, 0, 3 } } };
+    services::SntpSynchronizer::WithMaxServers<3> synchronizer;
+};
+
+TEST_F(SntpSynchronizerTest, polls_all_servers_in_turn)
+{
+    Start();
+
+    ExpectRequest(addresses[1]);
+    Respond(std::chrono::milliseconds(1), std::chrono::milliseconds(10));
+
+    ExpectRequest(addresses[2]);
+    synchronizer.TimeUnavailable();
+    ExecuteAllActions();
+
+    Respond(std::chrono::milliseconds(1), std::chrono::milliseconds(10));
+
+    NextPoll();
+}
+
+TEST_F(SntpSynchronizerTest, unresponsive_server_is_skipped_after_timeout)
+{
+    Start();
+
+    ExpectRequest(addresses[1]);
+    ForwardTime(std::chrono::seconds(2));
+}
+
+TEST_F(SntpSynchronizerTest, server_sending_deny_is_no_longer_polled)
+{
+    Start();
+
+    ExpectRequest(addresses[1]);
+    synchronizer.KissOfDeath(services::SntpResultObserver::KissCode::deny);
+    ExecuteAllActions();
+
+    ExpectRequest(addresses[2]);
+    Respond(std::chrono::milliseconds(1), std::chrono::milliseconds(10));
+    Respond(std::chrono::milliseconds(1), std::chrono::milliseconds(10));
+
+    ExpectRequest(addresses[1]);
+    ForwardTime(std::chrono::seconds(64));
+}
+
+TEST_F(SntpSynchronizerTest, small_offset_is_slewed)
+{
+    Start();
+    RespondAll(std::chrono::milliseconds(10), std::chrono::milliseconds(10), std::chrono::milliseconds(10));
+
+    EXPECT_EQ(infra::Duration(), clock.GetCurrentShift());
+    EXPECT_EQ(std::chrono::milliseconds(10), clock.GetPendingSlew());
+}
+
+TEST_F(SntpSynchronizerTest, large_offset_is_stepped)
+{
+    Start();
+    RespondAll(std::chrono::seconds(1), std::chrono::seconds(1), std::chrono::seconds(1));
+
+    EXPECT_EQ(std::chrono::seconds(1), clock.GetCurrentShift());
+    EXPECT_EQ(infra::Duration(), clock.GetPendingSlew());
+}
+
+TEST_F(SntpSynchronizerTest, falseticker_is_rejected)
+{
+    Start();
+    RespondAll(std::chrono::milliseconds(10), std::chrono::milliseconds(12), std::chrono::milliseconds(900));
+
+    EXPECT_EQ(std::chrono::milliseconds(11), clock.GetPendingSlew());
+}
+
+TEST_F(SntpSynchronizerTest, sample_with_minimum_delay_is_selected)
+{
+    Start();
+    RespondAll(std::chrono::milliseconds(20), std::chrono::milliseconds(20), std::chrono::milliseconds(20), std::chrono::milliseconds(40));
+    NextPoll();
+    RespondAll(std::chrono::milliseconds(30), std::chrono::milliseconds(30), std::chrono::milliseconds(30), std::chrono::milliseconds(100));
+    synchronizer.Stop();
+    ForwardTime(std::chrono::seconds(64));
+
+    EXPECT_EQ(std::chrono::milliseconds(20), clock.GetCurrentShift());
+}
+
+TEST_F(SntpSynchronizerTest, offset_measured_during_slew_accounts_for_pending_slew)
+{
+    Start();
+    RespondAll(std::chrono::milliseconds(20), std::chrono::milliseconds(20), std::chrono::milliseconds(20));
+    synchronizer.Stop();
+    ForwardTime(std::chrono::seconds(20));
+
+    Start();
+    RespondAll(std::chrono::milliseconds(10), std::chrono::milliseconds(10), std::chrono::milliseconds(10));
+
+    EXPECT_EQ(std::chrono::milliseconds(10), clock.GetPendingSlew());
+}
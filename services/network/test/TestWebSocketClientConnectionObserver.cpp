@@ -93,6 +93,15 @@ TEST_F(WebSocketClientConnectionObserverTest, send_large_frame)
     EXPECT_EQ(data, connection.sentData);
 }
 
+TEST_F(WebSocketClientConnectionObserverTest, send_fragmented_message)
+{
+    webSocket->StartMessage(7);
+    SendData("abcd");
+    SendData("efg");
+    SendData("hi");
+    EXPECT_EQ((std::vector<uint8_t>{ { 0x02, 0x84, 0, 0, 0, 0, 'a', 'b', 'c', 'd', 0x80, 0x83, 0, 0, 0, 0, 'e', 'f', 'g', 0x82, 0x82, 0, 0, 0, 0, 'h', 'i' } }), connection.sentData);
+}
+
 TEST_F(WebSocketClientConnectionObserverTest, receive_frame)
 {
     ExpectDataReceived("abcd");
@@ -116,6 +125,39 @@ TEST_F(WebSocketClientConnectionObserverTest, receive_large_frame)
     ExecuteAllActions();
 }
 
+TEST_F(WebSocketClientConnectionObserverTest, receive_frame_with_64_bit_length)
+{
+    ExpectDataReceived("abc");
+    connection.SimulateDataReceived(std::vector<uint8_t>{ { 0x82, 127, 0, 0, 0, 0, 0, 0, 0, 3, 'a', 'b', 'c' } });
+    ExecuteAllActions();
+}
+
+TEST_F(WebSocketClientConnectionObserverTest, receive_fragmented_message)
+{
+    ExpectDataReceived("abcdefg");
+    connection.SimulateDataReceived(std::vector<uint8_t>{ { 0x02, 0x04, 'a', 'b', 'c', 'd', 0x89, 0x00, 0x80, 0x03, 'e', 'f', 'g' } });
+    ExecuteAllActions();
+    EXPECT_EQ((std::vector<uint8_t>{ { 0x8a, 0x80, 0, 0, 0, 0 } }), connection.sentData);
+}
+
+TEST_F(WebSocketClientConnectionObserverTest, fragmented_text_message_is_skipped)
+{
+    ExpectDataReceived("ab");
+    connection.SimulateDataReceived(std::vector<uint8_t>{ { 0x01, 0x01, 'x', 0x80, 0x01, 'y', 0x82, 0x02, 'a', 'b' } });
+    ExecuteAllActions();
+}
+
+TEST_F(WebSocketClientConnectionObserverTest, read_fragmented_message_after_ack)
+{
+    EXPECT_CALL(connectionObserver, DataReceived()).WillOnce(testing::Invoke([this]()
+        {
+        CheckDataReceived("ab");
+        CheckDataReceived("cd"); }));
+
+    connection.SimulateDataReceived(std::vector<uint8_t>{ { 0x02, 0x02, 'a', 'b', 0x00, 0x01, 'c', 0x80, 0x01, 'd' } });
+    ExecuteAllActions();
+}
+
 TEST_F(WebSocketClientConnectionObserverTest, rewind_reader)
 {
     EXPECT_CALL(connectionObserver, DataReceived()).WillOnce(testing::Invoke([this]()
@@ -253,6 +253,14 @@ TEST_F(WebSocketServerConnectionObserverTest, receive_non_zero_rsv)
     ExecuteAllActions();
 }
 
+TEST_F(WebSocketServerConnectionObserverTest, frame_with_64_bit_length)
+{
+    std::array<uint8_t, 15> receiveData = { 0x82, 0xff, 0, 0, 0, 0, 0, 0, 0, 1, 0xa5, 0xb5, 0xc5, 0xd5, 0x34 };
+
+    ExpectDataReceived({ 0x91 });
+    connection.SimulateDataReceived(receiveData);
+}
+
 TEST_F(WebSocketServerConnectionObserverTest, receive_ping_request)
 {
     std::array<uint8_t, 11> receiveData = { 0x89, 0x85, 0xa5, 0xb5, 0xc5, 0xd5, 0x34, 0x63, 0xa5, 0x7b, 0xc9 };
@@ -301,3 +309,24 @@ TEST_F(WebSocketServerConnectionObserverTest, dont_use_whole_buffer)
     ExecuteAllActions();
     EXPECT_EQ(sendFrame, connection.sentData);
 }
+
+TEST_F(WebSocketServerConnectionObserverTest, send_fragmented_message)
+{
+    webSocket->StartMessage(4);
+
+    {
+        auto writer = SendData({ 0x91, 0x92 });
+        ExecuteAllActions();
+    }
+
+    webSocket->RequestSendStream(2);
+
+    EXPECT_CALL(connectionObserver, SendStreamAvailable(testing::_)).WillOnce(testing::Invoke([this](infra::SharedPtr<infra::StreamWriter> writer)
+        {
+            infra::DataOutputStream::WithErrorPolicy stream(*writer);
+            std::vector<uint8_t> dataToSend{ 0x93, 0x94 };
+            stream << infra::MakeRange(dataToSend); }));
+    ExecuteAllActions();
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0x02, 0x02, 0x91, 0x92, 0x80, 0x02, 0x93, 0x94 }), connection.sentData);
+}
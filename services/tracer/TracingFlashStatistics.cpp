@@ -0,0 +1,22 @@
+#include "services/tracer/TracingFlashStatistics.hpp"
+
+namespace services
+{
+    namespace
+    {
+        void TraceOperation(services::Tracer& tracer, const char* name, const FlashOperationStatistics& statistics)
+        {
+            tracer.Trace() << "Flash " << name << ": count " << statistics.count << ", bytes " << statistics.bytes
+                           << ", max " << static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(statistics.maxLatency).count()) << " us"
+                           << ", latency " << infra::Join(" ", infra::MakeRange(statistics.latencyHistogram));
+        }
+    }
+
+    void TraceFlashStatistics(services::Tracer& tracer, const FlashStatisticsSnapshot& statistics)
+    {
+        TraceOperation(tracer, "read", statistics.read);
+        TraceOperation(tracer, "write", statistics.write);
+        TraceOperation(tracer, "erase", statistics.erase);
+        tracer.Trace() << "Flash erase counts per " << statistics.sectorsPerEraseCounter << " sectors: " << infra::Join(" ", statistics.eraseCounts);
+    }
+}
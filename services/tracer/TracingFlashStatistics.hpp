@@ -0,0 +1,14 @@
+#ifndef SERVICES_TRACING_FLASH_STATISTICS_HPP
+#define SERVICES_TRACING_FLASH_STATISTICS_HPP
+
+#include "services/tracer/Tracer.hpp"
+#include "services/util/FlashStatistics.hpp"
+
+namespace services
+{
+    // Traces one line per operation kind with its count, bytes, maximum latency and latency histogram, followed by a
+    // line with the erase counters
+    void TraceFlashStatistics(services::Tracer& tracer, const FlashStatisticsSnapshot& statistics);
+}
+
+#endif
@@ -0,0 +1,25 @@
+#include "infra/stream/StringOutputStream.hpp"
+#include "services/tracer/TracingFlashStatistics.hpp"
+#include "gtest/gtest.h"
+
+TEST(TracingFlashStatisticsTest, statistics_are_traced)
+{
+    infra::StringOutputStream::WithStorage<512> stream;
+    services::Tracer tracer(stream);
+
+    services::FlashStatisticsSnapshot statistics;
+    statistics.read.Add(16, std::chrono::microseconds(50));
+    statistics.write.Add(256, std::chrono::milliseconds(2));
+    statistics.erase.Add(4096, std::chrono::milliseconds(50));
+    std::array<uint32_t, 3> eraseCounts{ 1, 0, 2 };
+    statistics.sectorsPerEraseCounter = 2;
+    statistics.eraseCounts = eraseCounts;
+
+    services::TraceFlashStatistics(tracer, statistics);
+
+    EXPECT_EQ("\r\nFlash read: count 1, bytes 16, max 50 us, latency 1 0 0 0 0 0"
+              "\r\nFlash write: count 1, bytes 256, max 2000 us, latency 0 0 1 0 0 0"
+              "\r\nFlash erase: count 1, bytes 4096, max 50000 us, latency 0 0 0 1 0 0"
+              "\r\nFlash erase counts per 2 sectors: 1 0 2",
+        stream.Storage());
+}
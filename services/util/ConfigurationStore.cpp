@@ -1,4 +1,7 @@
 #include "services/util/ConfigurationStore.hpp"
+#include "infra/event/EventDispatcher.hpp"
+#include "infra/util/BoundedVector.hpp"
+#include <algorithm>
 
 namespace services
 {
@@ -9,6 +12,7 @@ namespace services
         , sha256(sha256)
     {
         really_assert(blob.size() <= flash.TotalSize());
+        really_assert(verificationBuffer.size() >= 2);
     }
 
     infra::ConstByteRange ConfigurationBlobFlash::CurrentBlob()
@@ -24,15 +28,8 @@ namespace services
     void ConfigurationBlobFlash::Recover(const infra::Function<void(bool success)>& onRecovered)
     {
         this->onRecovered = onRecovered;
-        flash.ReadBuffer(blob, 0, [this]()
-            {
-            if (BlobIsValid())
-            {
-                RecoverCurrentSize();
-                this->onRecovered(true);
-            }
-            else
-                this->onRecovered(false); });
+        flash.ReadBuffer(infra::Head(blob, sizeof(Header)), 0, [this]()
+            { HeaderRecovered(); });
     }
 
     void ConfigurationBlobFlash::Write(uint32_t size, const infra::Function<void()>& onDone)
@@ -59,26 +56,96 @@ namespace services
         return verificationBuffer;
     }
 
-    void ConfigurationBlobFlash::RecoverCurrentSize()
+    ConfigurationBlobFlash::Header ConfigurationBlobFlash::BlobHeader() const
     {
         Header header;
         infra::Copy(infra::Head(blob, sizeof(header)), infra::MakeByteRange(header));
+        return header;
+    }
 
-        currentSize = header.size;
+    void ConfigurationBlobFlash::RecoverCurrentSize()
+    {
+        currentSize = BlobHeader().size;
     }
 
-    bool ConfigurationBlobFlash::BlobIsValid() const
+    void ConfigurationBlobFlash::HeaderRecovered()
     {
-        Header header;
-        infra::Copy(infra::Head(blob, sizeof(header)), infra::MakeByteRange(header));
+        auto header = BlobHeader();
 
-        if (header.size + sizeof(Header) > blob.size())
-            return false;
+        if (header.size > blob.size() - sizeof(Header))
+        {
+            onRecovered(false);
+            return;
+        }
 
-        auto input = infra::Head(infra::DiscardHead(blob, sizeof(header.hash)), header.size + sizeof(Header::size));
-        auto messageHash = sha256.Calculate(input);
+        sha256.Init();
+        sha256.Update(infra::Head(infra::DiscardHead(blob, sizeof(header.hash)), sizeof(header.size)));
 
-        return infra::Head(infra::MakeRange(messageHash), sizeof(header.hash)) == header.hash;
+        recoveryReadIndex = sizeof(Header);
+        recoveryHashIndex = sizeof(Header);
+        recoveryEnd = sizeof(Header) + header.size;
+
+        if (recoveryReadIndex != recoveryEnd)
+            ReadRecoveryBlock();
+        else
+            RecoveryBlocksHashed();
+    }
+
+    void ConfigurationBlobFlash::ReadRecoveryBlock()
+    {
+        recoveryReading = true;
+        flash.ReadBuffer(RecoveryBlock(recoveryReadIndex), recoveryReadIndex, [this]()
+            { RecoveryBlockRead(); });
+    }
+
+    void ConfigurationBlobFlash::RecoveryBlockRead()
+    {
+        recoveryReading = false;
+        recoveryReadIndex += RecoveryBlock(recoveryReadIndex).size();
+
+        // A flash that completes synchronously finishes the next read while the previous block is still being hashed
+        if (!recoveryHashing)
+            HashRecoveryBlocks();
+    }
+
+    void ConfigurationBlobFlash::HashRecoveryBlocks()
+    {
+        recoveryHashing = true;
+
+        while (recoveryHashIndex != recoveryReadIndex)
+        {
+            // Blocks are read directly into the blob, so the next block can be read while this block is hashed
+            if (!recoveryReading && recoveryReadIndex != recoveryEnd)
+                ReadRecoveryBlock();
+
+            auto recoveryBlock = RecoveryBlock(recoveryHashIndex);
+            sha256.Update(recoveryBlock);
+            recoveryHashIndex += recoveryBlock.size();
+        }
+
+        recoveryHashing = false;
+
+        if (recoveryHashIndex == recoveryEnd)
+            RecoveryBlocksHashed();
+    }
+
+    void ConfigurationBlobFlash::RecoveryBlocksHashed()
+    {
+        auto header = BlobHeader();
+        auto messageHash = sha256.Final();
+
+        if (infra::Head(infra::MakeRange(messageHash), sizeof(header.hash)) == header.hash)
+        {
+            RecoverCurrentSize();
+            onRecovered(true);
+        }
+        else
+            onRecovered(false);
+    }
+
+    infra::ByteRange ConfigurationBlobFlash::RecoveryBlock(uint32_t index) const
+    {
+        return infra::Head(infra::DiscardHead(blob, index), std::min<std::size_t>(BlockSize(), recoveryEnd - index));
     }
 
     void ConfigurationBlobFlash::PrepareBlobForWriting()
@@ -96,22 +163,527 @@ namespace services
 
     void ConfigurationBlobFlash::Verify()
     {
+        verificationReadIndex = 0;
+        verificationCompareIndex = 0;
+
+        ReadVerificationBlock();
+    }
+
+    void ConfigurationBlobFlash::ReadVerificationBlock()
+    {
+        verificationReading = true;
+        flash.ReadBuffer(VerificationBlock(verificationReadIndex), verificationReadIndex, [this]()
+            { VerificationBlockRead(); });
+    }
+
+    void ConfigurationBlobFlash::VerificationBlockRead()
+    {
+        verificationReading = false;
+        verificationReadIndex += VerificationBlock(verificationReadIndex).size();
+
+        // A flash that completes synchronously finishes the next read while the previous block is still being compared
+        if (!verificationComparing)
+            CompareVerificationBlocks();
+    }
+
+    void ConfigurationBlobFlash::CompareVerificationBlocks()
+    {
+        verificationComparing = true;
+
+        while (verificationCompareIndex != verificationReadIndex)
+        {
+            // The next block is read into the other half of the verification buffer, which holds an already compared block
+            if (!verificationReading && verificationReadIndex != blob.size())
+                ReadVerificationBlock();
+
+            auto verificationBlock = VerificationBlock(verificationCompareIndex);
+            really_assert(infra::ContentsEqual(verificationBlock, infra::Head(infra::DiscardHead(blob, verificationCompareIndex), verificationBlock.size())));
+            verificationCompareIndex += verificationBlock.size();
+        }
+
+        verificationComparing = false;
+
+        if (verificationCompareIndex == blob.size())
+            onDone();
+    }
+
+    infra::ByteRange ConfigurationBlobFlash::VerificationBlock(uint32_t index) const
+    {
+        auto blockSize = BlockSize();
+        auto block = infra::DiscardHead(infra::Head(verificationBuffer, 2 * blockSize), index / blockSize % 2 * blockSize);
+        return infra::Head(block, std::min<std::size_t>(blockSize, blob.size() - index));
+    }
+
+    std::size_t ConfigurationBlobFlash::BlockSize() const
+    {
+        return verificationBuffer.size() / 2;
+    }
+
+    namespace
+    {
+        // Iterates over the top-level fields of a serialized message, providing the encoding of each field
+        class FieldIterator
+        {
+        public:
+            explicit FieldIterator(infra::ConstByteRange data)
+                : data(data)
+                , stream(data, infra::softFail)
+                , parser(stream)
+            {}
+
+            bool Next()
+            {
+                if (parser.Empty() || parser.FormatFailed())
+                    return false;
+
+                auto start = stream.Reader().Processed().size();
+                auto field = parser.GetField();
+                if (field.first.Is<infra::ProtoLengthDelimited>())
+                    field.first.Get<infra::ProtoLengthDelimited>().SkipEverything();
+
+                if (parser.FormatFailed())
+                    return false;
+
+                fieldNumber = field.second;
+                span = infra::ConstByteRange(data.begin() + start, data.begin() + stream.Reader().Processed().size());
+                return true;
+            }
+
+            bool Failed() const
+            {
+                return parser.FormatFailed();
+            }
+
+            uint32_t FieldNumber() const
+            {
+                return fieldNumber;
+            }
+
+            infra::ConstByteRange Span() const
+            {
+                return span;
+            }
+
+        private:
+            infra::ConstByteRange data;
+            infra::ByteInputStream stream;
+            infra::ProtoParser parser;
+            uint32_t fieldNumber = 0;
+            infra::ConstByteRange span;
+        };
+
+        bool NextOccurrence(FieldIterator& iterator, uint32_t fieldNumber)
+        {
+            while (iterator.Next())
+                if (iterator.FieldNumber() == fieldNumber)
+                    return true;
+
+            return false;
+        }
+
+        std::size_t FieldSize(infra::ConstByteRange data, uint32_t fieldNumber)
+        {
+            std::size_t size = 0;
+
+            FieldIterator iterator(data);
+            while (NextOccurrence(iterator, fieldNumber))
+                size += iterator.Span().size();
+
+            return size;
+        }
+
+        // Fields compare equal when all their occurrences are encoded identically
+        bool FieldsEqual(infra::ConstByteRange x, infra::ConstByteRange y, uint32_t fieldNumber)
+        {
+            FieldIterator iteratorX(x);
+            FieldIterator iteratorY(y);
+
+            while (true)
+            {
+                auto foundX = NextOccurrence(iteratorX, fieldNumber);
+                auto foundY = NextOccurrence(iteratorY, fieldNumber);
+
+                if (foundX != foundY)
+                    return false;
+                if (!foundX)
+                    return true;
+                if (!infra::ContentsEqual(iteratorX.Span(), iteratorY.Span()))
+                    return false;
+            }
+        }
+
+        bool IsFirstOccurrence(infra::ConstByteRange data, const FieldIterator& iterator)
+        {
+            return FieldSize(infra::ConstByteRange(data.begin(), iterator.Span().begin()), iterator.FieldNumber()) == 0;
+        }
+
+        std::size_t RemoveField(infra::ByteRange data, uint32_t fieldNumber)
+        {
+            auto end = data.begin();
+
+            FieldIterator iterator(data);
+            while (iterator.Next())
+                if (iterator.FieldNumber() != fieldNumber)
+                    end = std::copy(iterator.Span().begin(), iterator.Span().end(), end);
+
+            return end - data.begin();
+        }
+
+        bool AddChangedField(infra::BoundedVector<uint32_t>& changedFields, uint32_t fieldNumber)
+        {
+            if (changedFields.full())
+                return false;
+
+            changedFields.push_back(fieldNumber);
+            return true;
+        }
+    }
+
+    ConfigurationBlobJournalFlash::ConfigurationBlobJournalFlash(infra::ByteRange blob, infra::ByteRange journalBuffer, infra::ByteRange verificationBuffer, hal::Flash& flashFirst, hal::Flash& flashSecond, services::Sha256& sha256)
+        : blob(blob)
+        , journalBuffer(journalBuffer)
+        , verificationBuffer(verificationBuffer)
+        , flashFirst(flashFirst)
+        , flashSecond(flashSecond)
+        , sha256(sha256)
+    {
+        really_assert(blob.size() <= flashFirst.TotalSize());
+        really_assert(blob.size() <= flashSecond.TotalSize());
+    }
+
+    infra::ConstByteRange ConfigurationBlobJournalFlash::CurrentBlob()
+    {
+        return infra::Head(infra::DiscardHead(blob, sizeof(SnapshotHeader)), currentSize);
+    }
+
+    infra::ByteRange ConfigurationBlobJournalFlash::MaxBlob()
+    {
+        return infra::DiscardHead(blob, sizeof(SnapshotHeader));
+    }
+
+    void ConfigurationBlobJournalFlash::Recover(const infra::Function<void(bool success)>& onRecovered)
+    {
+        this->onRecovered = onRecovered;
+        flashSecond.ReadBuffer(blob, 0, [this]()
+            {
+                secondValid = SnapshotIsValid();
+                secondGeneration = RecoveredSnapshotHeader().generation;
+                RecoverFirst();
+            });
+    }
+
+    void ConfigurationBlobJournalFlash::Write(uint32_t size, const infra::Function<void()>& onDone)
+    {
+        currentSize = size;
+        this->onDone = onDone;
+
+        if (!compactionRequired && PreparePatch())
+            WritePatch();
+        else
+            WriteSnapshot();
+    }
+
+    void ConfigurationBlobJournalFlash::Erase(const infra::Function<void()>& onDone)
+    {
+        this->onDone = onDone;
+        flashFirst.EraseAll([this]()
+            {
+                flashSecond.EraseAll([this]()
+                    {
+                        current = &flashFirst;
+                        other = &flashSecond;
+                        currentSize = 0;
+                        previousSize = 0;
+                        compactionRequired = true;
+                        this->onDone();
+                    });
+            });
+    }
+
+    bool ConfigurationBlobJournalFlash::SnapshotIsValid() const
+    {
+        auto header = RecoveredSnapshotHeader();
+
+        if (header.size > blob.size() - sizeof(SnapshotHeader))
+            return false;
+
+        auto input = infra::Head(infra::DiscardHead(blob, sizeof(header.hash)), sizeof(SnapshotHeader) - sizeof(header.hash) + header.size);
+        auto messageHash = sha256.Calculate(input);
+
+        return infra::Head(infra::MakeRange(messageHash), sizeof(header.hash)) == header.hash;
+    }
+
+    ConfigurationBlobJournalFlash::SnapshotHeader ConfigurationBlobJournalFlash::RecoveredSnapshotHeader() const
+    {
+        SnapshotHeader header;
+        infra::Copy(infra::Head(blob, sizeof(header)), infra::MakeByteRange(header));
+        return header;
+    }
+
+    void ConfigurationBlobJournalFlash::RecoverFirst()
+    {
+        flashFirst.ReadBuffer(blob, 0, [this]()
+            {
+                auto firstValid = SnapshotIsValid();
+
+                if (firstValid && (!secondValid || static_cast<int32_t>(RecoveredSnapshotHeader().generation - secondGeneration) > 0))
+                    SnapshotRecovered(flashFirst, flashSecond);
+                else if (secondValid)
+                    flashSecond.ReadBuffer(blob, 0, [this]()
+                        { SnapshotRecovered(flashSecond, flashFirst); });
+                else
+                    RecoveryFailed();
+            });
+    }
+
+    void ConfigurationBlobJournalFlash::SnapshotRecovered(hal::Flash& recovered, hal::Flash& unused)
+    {
+        current = &recovered;
+        other = &unused;
+
+        auto header = RecoveredSnapshotHeader();
+        generation = header.generation;
+        currentSize = header.size;
+        writeAddress = sizeof(SnapshotHeader) + currentSize;
+        compactionRequired = false;
+
+        ReplayPatch();
+    }
+
+    void ConfigurationBlobJournalFlash::RecoveryFailed()
+    {
+        current = &flashFirst;
+        other = &flashSecond;
+        currentSize = 0;
+        compactionRequired = true;
+
+        ReplayDone(false);
+    }
+
+    void ConfigurationBlobJournalFlash::ReplayPatch()
+    {
+        if (writeAddress + sizeof(PatchHeader) > current->TotalSize())
+        {
+            compactionRequired = true;
+            ReplayDone(true);
+            return;
+        }
+
+        current->ReadBuffer(infra::Head(journalBuffer, sizeof(PatchHeader)), writeAddress, [this]()
+            {
+                PatchHeader header;
+                infra::Copy(infra::Head(journalBuffer, sizeof(header)), infra::MakeByteRange(header));
+
+                if (std::all_of(journalBuffer.begin(), journalBuffer.begin() + sizeof(header), [](uint8_t byte)
+                        { return byte == 0xff; }))
+                    ReplayDone(true);
+                else if (header.size > journalBuffer.size() - sizeof(PatchHeader) || writeAddress + sizeof(PatchHeader) + header.size > current->TotalSize())
+                {
+                    compactionRequired = true;
+                    ReplayDone(true);
+                }
+                else
+                {
+                    patchSize = header.size;
+                    ReplayPatchContents();
+                }
+            });
+    }
+
+    void ConfigurationBlobJournalFlash::ReplayPatchContents()
+    {
+        current->ReadBuffer(PatchContents(), writeAddress + sizeof(PatchHeader), [this]()
+            {
+                PatchHeader header;
+                infra::Copy(infra::Head(journalBuffer, sizeof(header)), infra::MakeByteRange(header));
+
+                auto input = infra::Head(infra::DiscardHead(journalBuffer, sizeof(header.hash)), sizeof(header.size) + patchSize);
+                auto messageHash = sha256.Calculate(input);
+
+                // A patch of which writing was interrupted is ignored, and since the flash after it cannot be written
+                // anymore, the next write compacts the journal
+                if (infra::Head(infra::MakeRange(messageHash), sizeof(header.hash)) == header.hash && ApplyPatch(PatchContents()))
+                {
+                    writeAddress += sizeof(PatchHeader) + patchSize;
+                    ReplayPatch();
+                }
+                else
+                {
+                    compactionRequired = true;
+                    ReplayDone(true);
+                }
+            });
+    }
+
+    bool ConfigurationBlobJournalFlash::ApplyPatch(infra::ConstByteRange patch)
+    {
+        infra::ByteInputStream stream(patch, infra::softFail);
+        infra::ProtoParser parser(stream);
+
+        while (!parser.Empty())
+        {
+            auto field = parser.GetField();
+            if (parser.FormatFailed() || !field.first.Is<infra::ProtoLengthDelimited>())
+                return false;
+
+            infra::ConstByteRange contents;
+            field.first.Get<infra::ProtoLengthDelimited>().GetBytesReference(contents);
+            if (parser.FormatFailed())
+                return false;
+
+            currentSize = RemoveField(infra::Head(MaxBlob(), currentSize), field.second);
+            if (currentSize + contents.size() > MaxBlob().size())
+                return false;
+
+            infra::Copy(contents, infra::Head(infra::DiscardHead(MaxBlob(), currentSize), contents.size()));
+            currentSize += contents.size();
+        }
+
+        return true;
+    }
+
+    void ConfigurationBlobJournalFlash::ReplayDone(bool success)
+    {
+        previousSize = currentSize;
+        infra::Copy(CurrentBlob(), PreviousBlob());
+
+        other->EraseAll([this, success]()
+            { onRecovered(success); });
+    }
+
+    bool ConfigurationBlobJournalFlash::PreparePatch()
+    {
+        infra::BoundedVector<uint32_t>::WithMaxSize<maxPatchedFields> changedFields;
+        auto previous = PreviousBlob();
+        auto next = CurrentBlob();
+
+        FieldIterator nextFields(next);
+        while (nextFields.Next())
+            if (IsFirstOccurrence(next, nextFields) && !FieldsEqual(previous, next, nextFields.FieldNumber()))
+                if (!AddChangedField(changedFields, nextFields.FieldNumber()))
+                    return false;
+
+        FieldIterator previousFields(previous);
+        while (previousFields.Next())
+            if (IsFirstOccurrence(previous, previousFields) && FieldSize(next, previousFields.FieldNumber()) == 0)
+                if (!AddChangedField(changedFields, previousFields.FieldNumber()))
+                    return false;
+
+        if (nextFields.Failed() || previousFields.Failed())
+            return false;
+
+        // From here on, the previous contents are overwritten by the patch; they are restored when writing is done
+        infra::ByteOutputStream stream(infra::DiscardHead(journalBuffer, sizeof(PatchHeader)), infra::softFail);
+        infra::ProtoFormatter formatter(stream);
+
+        for (auto fieldNumber : changedFields)
+        {
+            formatter.PutLengthDelimitedSize(FieldSize(next, fieldNumber), fieldNumber);
+
+            FieldIterator iterator(next);
+            while (NextOccurrence(iterator, fieldNumber))
+                stream << iterator.Span();
+        }
+
+        patchSize = stream.Writer().Processed().size();
+        return !stream.Failed() && writeAddress + sizeof(PatchHeader) + patchSize <= current->TotalSize();
+    }
+
+    void ConfigurationBlobJournalFlash::WritePatch()
+    {
+        if (patchSize == 0)
+        {
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { WriteDone(); });
+            return;
+        }
+
+        PatchHeader header;
+        header.size = patchSize;
+        infra::Copy(infra::MakeByteRange(header), infra::Head(journalBuffer, sizeof(header)));
+
+        auto input = infra::Head(infra::DiscardHead(journalBuffer, sizeof(header.hash)), sizeof(header.size) + patchSize);
+        auto messageHash = sha256.Calculate(input);
+        infra::Copy(infra::Head(infra::MakeRange(messageHash), sizeof(header.hash)), infra::Head(journalBuffer, sizeof(header.hash)));
+
+        current->WriteBuffer(infra::Head(journalBuffer, sizeof(PatchHeader) + patchSize), writeAddress, [this]()
+            {
+                VerifyWritten(*current, writeAddress, infra::Head(journalBuffer, sizeof(PatchHeader) + patchSize), [this]()
+                    {
+                        writeAddress += sizeof(PatchHeader) + patchSize;
+                        WriteDone();
+                    });
+            });
+    }
+
+    void ConfigurationBlobJournalFlash::WriteSnapshot()
+    {
+        SnapshotHeader header;
+        header.size = currentSize;
+        header.generation = ++generation;
+        infra::Copy(infra::MakeByteRange(header), infra::Head(blob, sizeof(header)));
+
+        auto input = infra::Head(infra::DiscardHead(blob, sizeof(header.hash)), sizeof(SnapshotHeader) - sizeof(header.hash) + currentSize);
+        auto messageHash = sha256.Calculate(input);
+        infra::Copy(infra::Head(infra::MakeRange(messageHash), sizeof(header.hash)), infra::Head(blob, sizeof(header.hash)));
+
+        // The old snapshot and its journal are erased only after the new snapshot is written, so that an interruption
+        // leaves at least one valid snapshot. Recovery prefers the snapshot with the newest generation.
+        other->WriteBuffer(infra::Head(blob, sizeof(SnapshotHeader) + currentSize), 0, [this]()
+            {
+                VerifyWritten(*other, 0, infra::Head(blob, sizeof(SnapshotHeader) + currentSize), [this]()
+                    {
+                        current->EraseAll([this]()
+                            {
+                                std::swap(current, other);
+                                writeAddress = sizeof(SnapshotHeader) + currentSize;
+                                compactionRequired = false;
+                                WriteDone();
+                            });
+                    });
+            });
+    }
+
+    void ConfigurationBlobJournalFlash::WriteDone()
+    {
+        previousSize = currentSize;
+        infra::Copy(CurrentBlob(), PreviousBlob());
+
+        onDone();
+    }
+
+    infra::ByteRange ConfigurationBlobJournalFlash::PreviousBlob()
+    {
+        return infra::Head(infra::DiscardHead(journalBuffer, sizeof(PatchHeader)), previousSize);
+    }
+
+    infra::ByteRange ConfigurationBlobJournalFlash::PatchContents()
+    {
+        return infra::Head(infra::DiscardHead(journalBuffer, sizeof(PatchHeader)), patchSize);
+    }
+
+    void ConfigurationBlobJournalFlash::VerifyWritten(hal::Flash& flash, uint32_t address, infra::ConstByteRange written, const infra::Function<void()>& onVerified)
+    {
+        verificationFlash = &flash;
+        verificationAddress = address;
+        verificationData = written;
         currentVerificationIndex = 0;
+        this->onVerified = onVerified;
 
         VerifyBlock();
     }
 
-    void ConfigurationBlobFlash::VerifyBlock()
+    void ConfigurationBlobJournalFlash::VerifyBlock()
     {
-        if (currentVerificationIndex != blob.size())
-            flash.ReadBuffer(infra::Head(verificationBuffer, blob.size() - currentVerificationIndex), currentVerificationIndex, [this]()
+        if (currentVerificationIndex != verificationData.size())
+            verificationFlash->ReadBuffer(infra::Head(verificationBuffer, verificationData.size() - currentVerificationIndex), verificationAddress + currentVerificationIndex, [this]()
                 {
-                auto verificationBlock = infra::Head(verificationBuffer, blob.size() - currentVerificationIndex);
-                really_assert(infra::ContentsEqual(verificationBlock, infra::Head(infra::DiscardHead(blob, currentVerificationIndex), verificationBuffer.size())));
+                auto verificationBlock = infra::Head(verificationBuffer, verificationData.size() - currentVerificationIndex);
+                really_assert(infra::ContentsEqual(verificationBlock, infra::Head(infra::DiscardHead(verificationData, currentVerificationIndex), verificationBuffer.size())));
                 currentVerificationIndex += verificationBlock.size();
                 VerifyBlock(); });
         else
-            onDone();
+            onVerified();
     }
 
     ConfigurationBlobReadOnlyMemory::ConfigurationBlobReadOnlyMemory(infra::ConstByteRange data)
@@ -195,6 +767,11 @@ namespace services
         , inactiveBlob(&blob2)
     {}
 
+    ConfigurationStoreBase::ConfigurationStoreBase(ConfigurationBlob& blob)
+        : activeBlob(&blob)
+        , inactiveBlob(&blob)
+    {}
+
     uint32_t ConfigurationStoreBase::Write()
     {
         uint32_t thisId = operationId;
@@ -206,7 +783,7 @@ namespace services
             writeRequested = false;
             writingBlob = true;
             Serialize(*activeBlob, [this, thisId]()
-                { inactiveBlob->Erase([this, thisId]()
+                { EraseInactiveBlob([this, thisId]()
                       { BlobWriteDone(); NotifyObservers([thisId](ConfigurationStoreObserver& observer) { observer.OperationDone(thisId); }); }); });
         }
 
@@ -218,7 +795,7 @@ namespace services
         uint32_t thisId = operationId;
         ++operationId;
 
-        inactiveBlob->Erase([this, thisId]()
+        EraseInactiveBlob([this, thisId]()
             { activeBlob->Erase([this, thisId]()
                   { NotifyObservers([thisId](ConfigurationStoreObserver& observer)
                         { observer.OperationDone(thisId); }); }); });
@@ -234,8 +811,10 @@ namespace services
             {
             if (success)
             {
-                inactiveBlob->Erase([this]() { OnBlobLoaded(true); });
+                EraseInactiveBlob([this]() { OnBlobLoaded(true); });
             }
+            else if (activeBlob == inactiveBlob)
+                OnBlobLoaded(false);
             else
             {
                 std::swap(activeBlob, inactiveBlob);
@@ -262,6 +841,14 @@ namespace services
         onRecovered(success);
     }
 
+    void ConfigurationStoreBase::EraseInactiveBlob(const infra::Function<void()>& onDone)
+    {
+        if (inactiveBlob != activeBlob)
+            inactiveBlob->Erase(onDone);
+        else
+            onDone();
+    }
+
     void ConfigurationStoreBase::BlobWriteDone()
     {
         std::swap(activeBlob, inactiveBlob);
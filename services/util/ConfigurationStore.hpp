@@ -41,11 +41,16 @@ namespace services
         };
 
     public:
+        // After writing, the blob is read back in blocks of VerificationSize. The verification buffer holds two blocks,
+        // so that a block is compared while the next block is being read. Recover reads the blob in blocks of the same
+        // size, hashing a block while the next block is being read.
         template<std::size_t Size, std::size_t VerificationSize = 256>
         using WithStorage = infra::WithStorage<infra::WithStorage<ConfigurationBlobFlash,
                                                    std::array<uint8_t, Size + sizeof(Header)>>,
-            std::array<uint8_t, VerificationSize>>;
+            std::array<uint8_t, 2 * VerificationSize>>;
 
+        // verificationBuffer is split into two blocks, so when providing a buffer without using WithStorage, the blob is
+        // verified and recovered in blocks of half the size of that buffer
         ConfigurationBlobFlash(infra::ByteRange blob, infra::ByteRange verificationBuffer, hal::Flash& flash, services::Sha256& sha256);
 
         virtual infra::ConstByteRange CurrentBlob() override;
@@ -58,11 +63,21 @@ namespace services
         infra::ByteRange VerificationBuffer();
 
     private:
+        Header BlobHeader() const;
         void RecoverCurrentSize();
-        bool BlobIsValid() const;
+        void HeaderRecovered();
+        void ReadRecoveryBlock();
+        void RecoveryBlockRead();
+        void HashRecoveryBlocks();
+        void RecoveryBlocksHashed();
+        infra::ByteRange RecoveryBlock(uint32_t index) const;
         void PrepareBlobForWriting();
         void Verify();
-        void VerifyBlock();
+        void ReadVerificationBlock();
+        void VerificationBlockRead();
+        void CompareVerificationBlocks();
+        infra::ByteRange VerificationBlock(uint32_t index) const;
+        std::size_t BlockSize() const;
 
     private:
         infra::ByteRange blob;
@@ -70,9 +85,111 @@ namespace services
         hal::Flash& flash;
         services::Sha256& sha256;
         uint32_t currentSize = 0;
+        uint32_t recoveryReadIndex = 0;
+        uint32_t recoveryHashIndex = 0;
+        uint32_t recoveryEnd = 0;
+        bool recoveryReading = false;
+        bool recoveryHashing = false;
+        uint32_t verificationReadIndex = 0;
+        uint32_t verificationCompareIndex = 0;
+        bool verificationReading = false;
+        bool verificationComparing = false;
+        infra::AutoResetFunction<void(bool success)> onRecovered;
+        infra::AutoResetFunction<void()> onDone;
+    };
+
+    // ConfigurationBlobJournalFlash stores a snapshot of the blob, followed by a journal of patches. A patch holds, for
+    // each top-level field of which the encoding changed, the field number and the new encoding of all occurrences of
+    // that field. A small change is therefore appended to flash, instead of erasing and rewriting the complete blob.
+    // When the journal is full, or when more than maxPatchedFields fields changed, the blob is compacted into a new
+    // snapshot on the other flash, after which the old flash is erased. Recovery loads the newest valid snapshot and
+    // replays its patches.
+    //
+    // Since it alternates between its two flashes itself, it is used as the only blob of a ConfigurationStoreBase.
+    // Besides the blob itself, it keeps the last written contents in RAM to determine which fields changed.
+    class ConfigurationBlobJournalFlash
+        : public ConfigurationBlob
+    {
+    private:
+        struct SnapshotHeader
+        {
+            std::array<uint8_t, 8> hash;
+            uint32_t size;
+            uint32_t generation;
+        };
+
+        struct PatchHeader
+        {
+            std::array<uint8_t, 8> hash;
+            uint32_t size;
+        };
+
+    public:
+        static const std::size_t maxPatchedFields = 16;
+
+        template<std::size_t Size, std::size_t VerificationSize = 256>
+        using WithStorage = infra::WithStorage<infra::WithStorage<infra::WithStorage<ConfigurationBlobJournalFlash,
+                                                                      std::array<uint8_t, Size + sizeof(SnapshotHeader)>>,
+                                                   std::array<uint8_t, Size + sizeof(PatchHeader)>>,
+            std::array<uint8_t, VerificationSize>>;
+
+        ConfigurationBlobJournalFlash(infra::ByteRange blob, infra::ByteRange journalBuffer, infra::ByteRange verificationBuffer, hal::Flash& flashFirst, hal::Flash& flashSecond, services::Sha256& sha256);
+
+        virtual infra::ConstByteRange CurrentBlob() override;
+        virtual infra::ByteRange MaxBlob() override;
+        virtual void Recover(const infra::Function<void(bool success)>& onRecovered) override;
+        virtual void Write(uint32_t size, const infra::Function<void()>& onDone) override;
+        virtual void Erase(const infra::Function<void()>& onDone) override;
+
+    private:
+        bool SnapshotIsValid() const;
+        SnapshotHeader RecoveredSnapshotHeader() const;
+        void RecoverFirst();
+        void SnapshotRecovered(hal::Flash& recovered, hal::Flash& unused);
+        void RecoveryFailed();
+        void ReplayPatch();
+        void ReplayPatchContents();
+        bool ApplyPatch(infra::ConstByteRange patch);
+        void ReplayDone(bool success);
+
+        bool PreparePatch();
+        void WritePatch();
+        void WriteSnapshot();
+        void WriteDone();
+
+        infra::ByteRange PreviousBlob();
+        infra::ByteRange PatchContents();
+        void VerifyWritten(hal::Flash& flash, uint32_t address, infra::ConstByteRange written, const infra::Function<void()>& onVerified);
+        void VerifyBlock();
+
+    private:
+        infra::ByteRange blob;
+        infra::ByteRange journalBuffer;
+        infra::ByteRange verificationBuffer;
+        hal::Flash& flashFirst;
+        hal::Flash& flashSecond;
+        services::Sha256& sha256;
+
+        hal::Flash* current = &flashFirst;
+        hal::Flash* other = &flashSecond;
+        uint32_t currentSize = 0;
+        uint32_t previousSize = 0;
+        uint32_t generation = 0;
+        uint32_t writeAddress = 0;
+        uint32_t patchSize = 0;
+        bool compactionRequired = true;
+
+        bool secondValid = false;
+        uint32_t secondGeneration = 0;
+
+        hal::Flash* verificationFlash = nullptr;
+        uint32_t verificationAddress = 0;
+        infra::ConstByteRange verificationData;
         uint32_t currentVerificationIndex = 0;
+
         infra::AutoResetFunction<void(bool success)> onRecovered;
         infra::AutoResetFunction<void()> onDone;
+        infra::AutoResetFunction<void()> onVerified;
     };
 
     class ConfigurationBlobReadOnlyMemory
@@ -173,6 +290,7 @@ namespace services
     {
     public:
         ConfigurationStoreBase(ConfigurationBlob& blob1, ConfigurationBlob& blob2);
+        explicit ConfigurationStoreBase(ConfigurationBlob& blob); // For a blob that provides its own redundancy, e.g. ConfigurationBlobJournalFlash
 
     public:
         void Recover(const infra::Function<void(bool success)>& onRecovered);
@@ -190,6 +308,7 @@ namespace services
     private:
         void OnBlobLoaded(bool success);
         void BlobWriteDone();
+        void EraseInactiveBlob(const infra::Function<void()>& onDone);
 
     private:
         ConfigurationBlob* activeBlob;
@@ -220,8 +339,11 @@ namespace services
     public:
         template<std::size_t VerificationSize = 256>
         class WithBlobs;
+        template<std::size_t VerificationSize = 256>
+        class WithJournal;
 
         ConfigurationStoreImpl(ConfigurationBlob& blob1, ConfigurationBlob& blob2);
+        explicit ConfigurationStoreImpl(ConfigurationBlob& blob);
 
         virtual const T& Configuration() const override;
         virtual T& Configuration() override;
@@ -249,6 +371,18 @@ namespace services
         ConfigurationBlobFlash blob2;
     };
 
+    template<class T>
+    template<std::size_t VerificationSize>
+    class ConfigurationStoreImpl<T>::WithJournal
+        : public ConfigurationStoreImpl<T>
+    {
+    public:
+        WithJournal(hal::Flash& flashFirst, hal::Flash& flashSecond, services::Sha256& sha256, const infra::Function<void(bool success)>& onRecovered);
+
+    private:
+        typename ConfigurationBlobJournalFlash::WithStorage<T::maxMessageSize, VerificationSize> journal;
+    };
+
     class FactoryDefaultConfigurationStoreBase
         : public ConfigurationStoreInterface
         , protected ConfigurationStoreObserver
@@ -335,6 +469,11 @@ namespace services
         : ConfigurationStoreBase(blob1, blob2)
     {}
 
+    template<class T>
+    ConfigurationStoreImpl<T>::ConfigurationStoreImpl(ConfigurationBlob& blob)
+        : ConfigurationStoreBase(blob)
+    {}
+
     template<class T>
     const T& ConfigurationStoreImpl<T>::Configuration() const
     {
@@ -396,6 +535,15 @@ namespace services
         Recover(onRecovered);
     }
 
+    template<class T>
+    template<std::size_t VerificationSize>
+    ConfigurationStoreImpl<T>::WithJournal<VerificationSize>::WithJournal(hal::Flash& flashFirst, hal::Flash& flashSecond, services::Sha256& sha256, const infra::Function<void(bool success)>& onRecovered)
+        : ConfigurationStoreImpl<T>(journal)
+        , journal(flashFirst, flashSecond, sha256)
+    {
+        Recover(onRecovered);
+    }
+
     template<class T>
     ConfigurationStoreAccess<T>::ConfigurationStoreAccess(ConfigurationStoreInterface& configurationStore, T& configuration)
         : configurationStore(configurationStore)
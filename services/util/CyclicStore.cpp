@@ -3,8 +3,9 @@
 
 namespace services
 {
-    CyclicStore::CyclicStore(hal::Flash& flash)
+    CyclicStore::CyclicStore(hal::Flash& flash, const Config& config)
         : flash(flash)
+        , config(config)
         , claimerAdd(resource)
         , claimerClear(resource)
         , claimerRecover(resource)
@@ -75,6 +76,8 @@ namespace services
     {
         endAddress = 0;
         startAddress = 0;
+        headFirstSequence = 0;
+        headBlockCount = 0;
 
         assert(sequencer.Finished());
         sequencer.Load([this]()
@@ -95,12 +98,27 @@ namespace services
         return Iterator(*this);
     }
 
+    CyclicStore::Iterator CyclicStore::End() const
+    {
+        Iterator result(*this);
+        result.PositionAt(endAddress);
+        return result;
+    }
+
+    uint32_t CyclicStore::NextSequence() const
+    {
+        assert(config.sectorSummaries);
+        return headFirstSequence + headBlockCount;
+    }
+
     void CyclicStore::Recover()
     {
         claimerRecover.Claim([this]()
             {
             endAddress = 0;
             startAddress = 0;
+            headFirstSequence = 0;
+            headBlockCount = 0;
 
             assert(sequencer.Finished());
             sequencer.Load([this]() {
@@ -217,6 +235,7 @@ namespace services
         sequencer.Step([this]()
             {
                         endAddress += blockHeader.BlockLength();
+                        ++headBlockCount;
                         flash.ReadBuffer(infra::MakeByteRange(blockHeader), endAddress, [this]() { sequencer.Continue(); }); });
         sequencer.Else();
         sequencer.Execute([this]()
@@ -252,6 +271,11 @@ namespace services
             { endAddress = flash.StartOfNextSectorCyclical(endAddress); });
         sequencer.EndIf();
         sequencer.EndWhile();
+        sequencer.Execute([this]()
+            {
+                // When the walk ends at the start of the next sector, the counted blocks belong to a completed sector
+                if (flash.AtStartOfSector(endAddress))
+                    headBlockCount = 0; });
     }
 
     void CyclicStore::SanitizeSector(uint32_t sectorIndex)
@@ -266,6 +290,20 @@ namespace services
                     startAddress += sizeof(SectorStatus);
 
                 sanitizeAddress += sizeof(SectorStatus); });
+        sequencer.If([this]()
+            { return config.sectorSummaries; });
+        sequencer.Step([this, &sectorIndex]()
+            { flash.ReadBuffer(infra::MakeByteRange(summary), SummaryAddress(sectorIndex % flash.NumberOfSectors()), [this]()
+                  { sequencer.Continue(); }); });
+        sequencer.Execute([this]()
+            {
+                // A completed sector needs no sanitizing, so only its summary is read
+                if (summary.IsValid())
+                {
+                    headFirstSequence = summary.FirstSequence() + summary.BlockCount();
+                    sanitizeAddress = flash.StartOfNextSectorCyclical(sanitizeAddress);
+                } });
+        sequencer.EndIf();
         sequencer.While([this, &sectorIndex]()
             { return flash.SectorOfAddress(sanitizeAddress) == sectorIndex % flash.NumberOfSectors(); });
         sequencer.Step([this, &sectorIndex]()
@@ -276,6 +314,9 @@ namespace services
                 bool continueSequencer = true;
                 auto oldSanitizeAddress = sanitizeAddress;
 
+                if (blockHeader.status == BlockStatus::dataReady || blockHeader.status == BlockStatus::erased)
+                    ++headFirstSequence;
+
                 if (blockHeader.status == BlockStatus::dataReady || blockHeader.status == BlockStatus::writingData || blockHeader.status == BlockStatus::erased)
                     sanitizeAddress = (sanitizeAddress + sizeof(blockHeader) + blockHeader.BlockLength()) % flash.TotalSize();
                 else if (blockHeader.status == BlockStatus::writingLength)
@@ -364,12 +405,23 @@ namespace services
     void CyclicStore::FillSectorIfDataDoesNotFit(std::size_t size)
     {
         sequencer.If([this, size]()
-            { return flash.AddressOffsetInSector(endAddress) + sizeof(BlockHeader) + size > flash.SizeOfSector(flash.SectorOfAddress(endAddress)); });
+            { return flash.AddressOffsetInSector(endAddress) + sizeof(BlockHeader) + size > UsableSizeOfSector(flash.SectorOfAddress(endAddress)); });
         sequencer.Step([this]()
             {
-                blockHeader.status = BlockStatus::emptyUntilEnd;
-                flash.WriteBuffer(infra::MakeByteRange(blockHeader.status), endAddress, [this]() { sequencer.Continue(); });
+                // When the blocks end exactly at the sector summary, the summary itself marks the end of the sector
+                if (config.sectorSummaries && endAddress == SummaryAddress(flash.SectorOfAddress(endAddress)))
+                    infra::EventDispatcher::Instance().Schedule([this]() { sequencer.Continue(); });
+                else
+                {
+                    blockHeader.status = BlockStatus::emptyUntilEnd;
+                    flash.WriteBuffer(infra::MakeByteRange(blockHeader.status), endAddress, [this]() { sequencer.Continue(); });
+                }
+
                 endAddress = flash.StartOfNextSectorCyclical(endAddress); });
+        sequencer.If([this]()
+            { return config.sectorSummaries; });
+        WriteSectorSummary();
+        sequencer.EndIf();
         sequencer.EndIf();
     }
 
@@ -403,7 +455,7 @@ namespace services
             { return !partialAddStarted; });
         sequencer.Step([this, range]() // Write status 'writing length'
             {
-                assert(sizeof(BlockHeader) + range.size() + remainingPartialSize + 1 <= flash.SizeOfSector(flash.SectorOfAddress(endAddress)));
+                assert(sizeof(BlockHeader) + range.size() + remainingPartialSize + 1 <= UsableSizeOfSector(flash.SectorOfAddress(endAddress)));
                 blockHeader.status = BlockStatus::writingLength;
                 flash.WriteBuffer(infra::MakeByteRange(blockHeader.status), endAddress, [this]() { sequencer.Continue(); }); });
         sequencer.Step([this, range]() // Write length
@@ -426,6 +478,7 @@ namespace services
                 blockHeader.status = BlockStatus::dataReady;
                 flash.WriteBuffer(infra::MakeByteRange(blockHeader.status), endAddress, [this]() { sequencer.Continue(); });
                 endAddress += partialSizeWritten + 3;
+                ++headBlockCount;
                 partialSizeWritten = 0;
                 partialAddStarted = false;
                 if (endAddress == flash.TotalSize())
@@ -438,6 +491,57 @@ namespace services
             } });
     }
 
+    void CyclicStore::WriteSectorSummary()
+    {
+        sequencer.Step([this]()
+            {
+                summary.Set(headFirstSequence, headBlockCount);
+                flash.WriteBuffer(infra::Head(infra::MakeByteRange(summary), sizeof(summary) - sizeof(summary.valid)), SummaryAddress(PreviousSector(flash.SectorOfAddress(endAddress))), [this]()
+                    { sequencer.Continue(); }); });
+        sequencer.Step([this]()
+            {
+                summary.valid = SectorSummary::validMarker;
+                flash.WriteBuffer(infra::MakeByteRange(summary.valid), SummaryAddress(PreviousSector(flash.SectorOfAddress(endAddress))) + sizeof(summary) - sizeof(summary.valid), [this]()
+                    { sequencer.Continue(); });
+
+                headFirstSequence += headBlockCount;
+                headBlockCount = 0; });
+    }
+
+    uint32_t CyclicStore::UsableSizeOfSector(uint32_t sectorIndex) const
+    {
+        if (config.sectorSummaries)
+            return flash.SizeOfSector(sectorIndex) - sizeof(SectorSummary);
+        else
+            return flash.SizeOfSector(sectorIndex);
+    }
+
+    uint32_t CyclicStore::SummaryAddress(uint32_t sectorIndex) const
+    {
+        return flash.AddressOfSector(sectorIndex) + UsableSizeOfSector(sectorIndex);
+    }
+
+    uint32_t CyclicStore::PreviousSector(uint32_t sectorIndex) const
+    {
+        return (sectorIndex + flash.NumberOfSectors() - 1) % flash.NumberOfSectors();
+    }
+
+    uint32_t CyclicStore::LastSectorInUse() const
+    {
+        if (flash.AtStartOfSector(endAddress))
+            return PreviousSector(flash.SectorOfAddress(endAddress));
+        else
+            return flash.SectorOfAddress(endAddress);
+    }
+
+    uint32_t CyclicStore::NumberOfSectorsInUse() const
+    {
+        if (startAddress == endAddress)
+            return 0;
+
+        return (LastSectorInUse() + flash.NumberOfSectors() - flash.SectorOfAddress(startAddress)) % flash.NumberOfSectors() + 1;
+    }
+
     CyclicStore::Iterator::Iterator(const CyclicStore& store)
         : store(store)
         , loadStartAddressDelayed(true)
@@ -452,6 +556,8 @@ namespace services
         , loadStartAddressDelayed(other.loadStartAddressDelayed)
         , address(other.address)
         , claimer(store.resource)
+        , sectorStatus(other.sectorStatus)
+        , firstSectorToRead(other.firstSectorToRead)
     {
         store.iterators.push_front(*this);
     }
@@ -485,11 +591,7 @@ namespace services
 
         claimer.Claim([this, onDone]()
             {
-            if (loadStartAddressDelayed)
-            {
-                loadStartAddressDelayed = false;
-                address = store.startAddress;
-            }
+            LoadStartAddressIfDelayed();
 
             assert(sequencer.Finished());
             sequencer.Load([this, onDone]()
@@ -542,6 +644,189 @@ namespace services
             }); });
     }
 
+    void CyclicStore::Iterator::ReadPrevious(infra::ByteRange buffer, const infra::Function<void(infra::ByteRange result)>& onDone)
+    {
+        searchBuffer = buffer;
+
+        claimer.Claim([this, onDone]()
+            {
+            LoadStartAddressIfDelayed();
+
+            assert(sequencer.Finished());
+            sequencer.Load([this, onDone]()
+            {
+                sequencer.Execute([this]()
+                {
+                    walkMode = WalkMode::previous;
+                    walkSector = store.flash.SectorOfAddress(address);
+                    walkEnd = address;
+
+                    if (store.flash.AtStartOfSector(address) && address != store.startAddress)
+                    {
+                        walkSector = store.PreviousSector(walkSector);
+                        walkEnd = EndOfSector(walkSector);
+                    }
+
+                    walkedSectors = 0;
+                    searching = true;
+                });
+                sequencer.While([this]() { return searching; });
+                    WalkSector();
+                    sequencer.Execute([this]()
+                    {
+                        if (candidateFound || walkSector == store.flash.SectorOfAddress(store.startAddress) || ++walkedSectors == store.flash.NumberOfSectors())
+                            searching = false;
+                        else
+                        {
+                            walkSector = store.PreviousSector(walkSector);
+                            walkEnd = EndOfSector(walkSector);
+                        }
+                    });
+                sequencer.EndWhile();
+                sequencer.If([this]() { return candidateFound; });
+                    sequencer.Step([this]()
+                    {
+                        readBuffer = infra::Head(searchBuffer, candidateLength);
+                        store.flash.ReadBuffer(readBuffer, candidate + sizeof(BlockHeader), [this]() { sequencer.Continue(); });
+                        PositionAt(candidate);
+                        addressPreviousBlockHeader = candidate;
+                        previousErased = false;
+                    });
+                sequencer.EndIf();
+                sequencer.Execute([this, onDone]()
+                {
+                    if (!candidateFound)
+                        readBuffer.clear();
+
+                    auto onDoneCopy = onDone;
+                    auto readBufferCopy = readBuffer;
+                    claimer.Release();
+                    onDoneCopy(readBufferCopy);
+                });
+            }); });
+    }
+
+    void CyclicStore::Iterator::Seek(infra::ByteRange buffer, const infra::Function<bool(infra::ConstByteRange item)>& isBefore, const infra::Function<void()>& onDone)
+    {
+        searchBuffer = buffer;
+        this->isBefore = isBefore;
+
+        claimer.Claim([this, onDone]()
+            {
+            assert(sequencer.Finished());
+            sequencer.Load([this, onDone]()
+            {
+                sequencer.Execute([this]()
+                {
+                    walkMode = WalkMode::probe;
+                    low = 0;
+                    high = store.NumberOfSectorsInUse();
+                });
+                sequencer.While([this]() { return low != high; });
+                    sequencer.Execute([this]()
+                    {
+                        middle = (low + high) / 2;
+                        walkSector = SectorInUse(middle);
+                        walkEnd = EndOfSector(walkSector);
+                    });
+                    WalkSector();
+                    sequencer.Execute([this]()
+                    {
+                        if (!candidateFound || probeBefore)
+                            low = middle + 1;
+                        else
+                            high = middle;
+                    });
+                sequencer.EndWhile();
+                sequencer.If([this]() { return low == 0; });
+                    sequencer.Execute([this]() { PositionAtStart(); });
+                sequencer.Else();
+                    sequencer.Execute([this]()
+                    {
+                        walkMode = WalkMode::firstNotBefore;
+                        walkSector = SectorInUse(low - 1);
+                        walkEnd = EndOfSector(walkSector);
+                    });
+                    WalkSector();
+                    sequencer.Execute([this]()
+                    {
+                        if (candidateFound)
+                            PositionAt(candidate);
+                        else if (walkSector == store.LastSectorInUse())
+                            PositionAt(store.endAddress);
+                        else
+                            PositionAt(store.flash.StartOfNextSectorCyclical(store.flash.AddressOfSector(walkSector)));
+                    });
+                sequencer.EndIf();
+                sequencer.Execute([this, onDone]()
+                {
+                    auto onDoneCopy = onDone;
+                    this->isBefore = nullptr;
+                    claimer.Release();
+                    onDoneCopy();
+                });
+            }); });
+    }
+
+    void CyclicStore::Iterator::SeekSequence(uint32_t sequence, const infra::Function<void(bool found)>& onDone)
+    {
+        assert(store.config.sectorSummaries);
+        targetSequence = sequence;
+
+        claimer.Claim([this, onDone]()
+            {
+            assert(sequencer.Finished());
+            sequencer.Load([this, onDone]()
+            {
+                sequencer.Execute([this]()
+                {
+                    candidatePresent = false;
+                    low = 0;
+                    high = store.NumberOfSectorsInUse();
+                });
+                sequencer.While([this]() { return low != high; });
+                    sequencer.Execute([this]()
+                    {
+                        middle = (low + high) / 2;
+                        walkSector = SectorInUse(middle);
+                    });
+                    ReadSectorFirstSequence();
+                    sequencer.Execute([this]()
+                    {
+                        if (!sectorFirstSequenceKnown || static_cast<int32_t>(sectorFirstSequence - targetSequence) <= 0)
+                            low = middle + 1;
+                        else
+                            high = middle;
+                    });
+                sequencer.EndWhile();
+                sequencer.If([this]() { return low != 0; });
+                    sequencer.Execute([this]() { walkSector = SectorInUse(low - 1); });
+                    ReadSectorFirstSequence();
+                    sequencer.If([this]() { return sectorFirstSequenceKnown; });
+                        sequencer.Execute([this]()
+                        {
+                            walkMode = WalkMode::sequence;
+                            walkSequence = sectorFirstSequence;
+                            walkEnd = EndOfSector(walkSector);
+                        });
+                        WalkSector();
+                        sequencer.Execute([this]()
+                        {
+                            if (candidatePresent)
+                                PositionAt(candidate);
+                        });
+                    sequencer.EndIf();
+                sequencer.EndIf();
+                sequencer.Execute([this, onDone]()
+                {
+                    auto onDoneCopy = onDone;
+                    auto found = candidatePresent;
+                    claimer.Release();
+                    onDoneCopy(found);
+                });
+            }); });
+    }
+
     void CyclicStore::Iterator::SectorIsErased(uint32_t sectorIndex)
     {
         if (store.flash.SectorOfAddress(address) == sectorIndex)
@@ -559,6 +844,152 @@ namespace services
         return (loadStartAddressDelayed ? store.startAddress : address) == (other.loadStartAddressDelayed ? other.store.startAddress : other.address);
     }
 
+    void CyclicStore::Iterator::LoadStartAddressIfDelayed()
+    {
+        if (loadStartAddressDelayed)
+        {
+            loadStartAddressDelayed = false;
+            address = store.startAddress;
+        }
+    }
+
+    void CyclicStore::Iterator::PositionAtStart()
+    {
+        loadStartAddressDelayed = true;
+        firstSectorToRead = true;
+        sectorStatus = SectorStatus::used;
+        previousErased = true;
+    }
+
+    void CyclicStore::Iterator::PositionAt(uint32_t newAddress)
+    {
+        loadStartAddressDelayed = false;
+        address = newAddress;
+        firstSectorToRead = false;
+        sectorStatus = SectorStatus::used;
+        previousErased = true;
+    }
+
+    void CyclicStore::Iterator::WalkSector()
+    {
+        sequencer.Execute([this]()
+            {
+                walkAddress = store.flash.AddressOfSector(walkSector) + sizeof(SectorStatus);
+                walkDone = false;
+                candidateFound = false; });
+        sequencer.While([this]()
+            { return !walkDone; });
+        sequencer.Step([this]()
+            {
+                if (walkAddress >= walkEnd || walkAddress + sizeof(BlockHeader) > EndOfSector(walkSector))
+                {
+                    walkDone = true;
+                    infra::EventDispatcher::Instance().Schedule([this]() { sequencer.Continue(); });
+                }
+                else
+                    store.flash.ReadBuffer(infra::MakeByteRange(blockHeader), walkAddress, [this]() { sequencer.Continue(); }); });
+        sequencer.If([this]()
+            { return !walkDone && blockHeader.status == BlockStatus::dataReady && BlockFitsInWalkSector() && (walkMode == WalkMode::probe || walkMode == WalkMode::firstNotBefore); });
+        sequencer.Step([this]()
+            {
+                readBuffer = infra::Head(searchBuffer, blockHeader.BlockLength());
+                store.flash.ReadBuffer(readBuffer, walkAddress + sizeof(BlockHeader), [this]() { sequencer.Continue(); }); });
+        sequencer.EndIf();
+        sequencer.Execute([this]()
+            {
+                if (!walkDone)
+                    VisitBlock(); });
+        sequencer.EndWhile();
+    }
+
+    void CyclicStore::Iterator::VisitBlock()
+    {
+        auto status = blockHeader.status;
+        auto next = walkAddress + sizeof(BlockHeader) + blockHeader.BlockLength();
+
+        if (status == BlockStatus::writingLength)
+            next = walkAddress + sizeof(BlockHeader);
+        else if (status != BlockStatus::dataReady && status != BlockStatus::erased && status != BlockStatus::writingData)
+        {
+            walkDone = true;
+            return;
+        }
+        else if (!BlockFitsInWalkSector())
+        {
+            walkDone = true;
+            return;
+        }
+
+        if (status == BlockStatus::dataReady)
+        {
+            if (walkMode == WalkMode::previous)
+            {
+                candidateFound = true;
+                candidate = walkAddress;
+                candidateLength = blockHeader.BlockLength();
+            }
+            else if (walkMode == WalkMode::probe)
+            {
+                candidateFound = true;
+                probeBefore = isBefore(readBuffer);
+                walkDone = true;
+            }
+            else if (walkMode == WalkMode::firstNotBefore && !isBefore(readBuffer))
+            {
+                candidateFound = true;
+                candidate = walkAddress;
+                walkDone = true;
+            }
+        }
+
+        if (walkMode == WalkMode::sequence && (status == BlockStatus::dataReady || status == BlockStatus::erased))
+        {
+            if (walkSequence == targetSequence)
+            {
+                candidateFound = true;
+                candidatePresent = status == BlockStatus::dataReady;
+                candidate = walkAddress;
+                walkDone = true;
+            }
+            else
+                ++walkSequence;
+        }
+
+        walkAddress = next;
+    }
+
+    bool CyclicStore::Iterator::BlockFitsInWalkSector() const
+    {
+        return walkAddress + sizeof(BlockHeader) + blockHeader.BlockLength() <= EndOfSector(walkSector);
+    }
+
+    void CyclicStore::Iterator::ReadSectorFirstSequence()
+    {
+        sequencer.Step([this]()
+            { store.flash.ReadBuffer(infra::MakeByteRange(summary), store.SummaryAddress(walkSector), [this]()
+                  { sequencer.Continue(); }); });
+        sequencer.Execute([this]()
+            {
+                sectorFirstSequenceKnown = true;
+
+                if (summary.IsValid())
+                    sectorFirstSequence = summary.FirstSequence();
+                else if (walkSector == store.LastSectorInUse())
+                    sectorFirstSequence = store.headFirstSequence;
+                else
+                    sectorFirstSequenceKnown = false; });
+    }
+
+    uint32_t CyclicStore::Iterator::EndOfSector(uint32_t sectorIndex) const
+    {
+        return store.flash.AddressOfSector(sectorIndex) + store.flash.SizeOfSector(sectorIndex);
+    }
+
+    uint32_t CyclicStore::Iterator::SectorInUse(uint32_t index) const
+    {
+        return (store.flash.SectorOfAddress(store.startAddress) + index) % store.flash.NumberOfSectors();
+    }
+
     void CyclicStore::Iterator::ReadSectorStatusIfAtStart()
     {
         sequencer.Execute([this]()
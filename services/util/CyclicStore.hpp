@@ -5,6 +5,7 @@
 #include "infra/event/ClaimableResource.hpp"
 #include "infra/util/IntrusiveForwardList.hpp"
 #include "infra/util/Sequencer.hpp"
+#include <array>
 
 namespace services
 {
@@ -13,7 +14,18 @@ namespace services
     public:
         class Iterator;
 
-        explicit CyclicStore(hal::Flash& flash);
+        struct Config
+        {
+            Config()
+            {}
+
+            // With sector summaries, each sector ends in a summary that is written when the store moves on to the
+            // next sector. It holds the sequence number of the first item in the sector and the number of items, so
+            // that recovery does not need to walk the items of completed sectors, and so that SeekSequence is supported.
+            bool sectorSummaries = false;
+        };
+
+        explicit CyclicStore(hal::Flash& flash, const Config& config = Config());
         CyclicStore(const CyclicStore& other) = delete;
         CyclicStore& operator=(const CyclicStore& other) = delete;
 
@@ -23,6 +35,10 @@ namespace services
         void ClearUrgent(const infra::Function<void()>& onDone);
 
         Iterator Begin() const;
+        Iterator End() const;
+
+        // Items are numbered in the order in which they are added, starting at 0 after Clear. Requires sector summaries.
+        uint32_t NextSequence() const;
 
     private:
         void AddClaimed(infra::ConstByteRange range);
@@ -38,6 +54,13 @@ namespace services
         void FillSectorIfDataDoesNotFit(std::size_t size);
         void WriteSectorStatusIfAtStartOfSector();
         void WriteRange(infra::ConstByteRange range);
+        void WriteSectorSummary();
+
+        uint32_t UsableSizeOfSector(uint32_t sectorIndex) const;
+        uint32_t SummaryAddress(uint32_t sectorIndex) const;
+        uint32_t PreviousSector(uint32_t sectorIndex) const;
+        uint32_t LastSectorInUse() const;
+        uint32_t NumberOfSectorsInUse() const;
 
     private:
         using Length = uint16_t;
@@ -77,6 +100,56 @@ namespace services
             }
         };
 
+        // The summary starts with an emptyUntilEnd marker, so that walking over the blocks of a sector ends at the
+        // summary. The valid marker is written last, so that an interrupted summary is not used.
+        struct SectorSummary
+        {
+            BlockStatus status = BlockStatus::emptyUntilEnd;
+            std::array<uint8_t, 4> firstSequence{};
+            std::array<uint8_t, 4> blockCount{};
+            uint8_t valid = 0xff;
+
+            static const uint8_t validMarker = 0xfe;
+
+            bool IsValid() const
+            {
+                return status == BlockStatus::emptyUntilEnd && valid == validMarker;
+            }
+
+            uint32_t FirstSequence() const
+            {
+                return Get(firstSequence);
+            }
+
+            uint32_t BlockCount() const
+            {
+                return Get(blockCount);
+            }
+
+            void Set(uint32_t firstSequence, uint32_t blockCount)
+            {
+                status = BlockStatus::emptyUntilEnd;
+                Put(this->firstSequence, firstSequence);
+                Put(this->blockCount, blockCount);
+                valid = 0xff;
+            }
+
+        private:
+            static uint32_t Get(const std::array<uint8_t, 4>& bytes)
+            {
+                return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+            }
+
+            static void Put(std::array<uint8_t, 4>& bytes, uint32_t value)
+            {
+                for (auto& byte : bytes)
+                {
+                    byte = static_cast<uint8_t>(value);
+                    value >>= 8;
+                }
+            }
+        };
+
     public:
         class Iterator
             : public infra::IntrusiveForwardList<Iterator>::NodeType
@@ -90,11 +163,42 @@ namespace services
             void Read(infra::ByteRange buffer, const infra::Function<void(infra::ByteRange result)>& onDone);
             void ErasePrevious(const infra::Function<void()>& onDone); // Erase the item that just hase been read
 
+            // Reads the item before the current position, and moves the position to that item, so that a subsequent Read
+            // returns it again. Finding the previous item walks the block headers of its sector.
+            void ReadPrevious(infra::ByteRange buffer, const infra::Function<void(infra::ByteRange result)>& onDone);
+            // Moves the position to the first item for which isBefore returns false. Items must be added in ascending order
+            // of the key that isBefore inspects, e.g. a timestamp at the start of each item. Sectors are binary searched on
+            // their first item, after which a single sector is walked. buffer receives (the head of) the inspected items.
+            void Seek(infra::ByteRange buffer, const infra::Function<bool(infra::ConstByteRange item)>& isBefore, const infra::Function<void()>& onDone);
+            // Moves the position to the item with the given sequence number. When that item is not present anymore, found is
+            // false and the position is unchanged. Requires sector summaries.
+            void SeekSequence(uint32_t sequence, const infra::Function<void(bool found)>& onDone);
+
             void SectorIsErased(uint32_t sectorIndex);
 
             bool operator==(const Iterator& other) const;
 
         private:
+            friend class CyclicStore;
+
+            enum class WalkMode : uint8_t
+            {
+                previous,
+                probe,
+                firstNotBefore,
+                sequence
+            };
+
+            void LoadStartAddressIfDelayed();
+            void PositionAtStart();
+            void PositionAt(uint32_t newAddress);
+            void WalkSector();
+            void VisitBlock();
+            bool BlockFitsInWalkSector() const;
+            void ReadSectorFirstSequence();
+            uint32_t EndOfSector(uint32_t sectorIndex) const;
+            uint32_t SectorInUse(uint32_t index) const;
+
             void ReadSectorStatusIfAtStart();
             void ReadBlockHeader();
             void ReadData();
@@ -119,10 +223,36 @@ namespace services
 
             bool previousErased = true; // When the iterator is constructed, it is pointing at the start. Since no previous item exists, it does not need to be erased
             uint32_t addressPreviousBlockHeader;
+
+            WalkMode walkMode = WalkMode::previous;
+            uint32_t walkSector = 0;
+            uint32_t walkAddress = 0;
+            uint32_t walkEnd = 0;
+            uint32_t walkSequence = 0;
+            uint32_t walkedSectors = 0;
+            bool walkDone = false;
+            bool searching = false;
+
+            bool candidateFound = false;
+            bool candidatePresent = false;
+            uint32_t candidate = 0;
+            Length candidateLength = 0;
+            bool probeBefore = false;
+
+            uint32_t low = 0;
+            uint32_t high = 0;
+            uint32_t middle = 0;
+            uint32_t targetSequence = 0;
+            bool sectorFirstSequenceKnown = false;
+            uint32_t sectorFirstSequence = 0;
+            SectorSummary summary;
+            infra::ByteRange searchBuffer;
+            infra::Function<bool(infra::ConstByteRange item)> isBefore;
         };
 
     private:
         hal::Flash& flash;
+        Config config;
         mutable uint32_t startAddress = 0; // In startAddress the starting point for reading is cached; this is not observable behaviour but a performance optimization. Therefore it is mutable.
         uint32_t endAddress = 0;
         uint32_t sanitizeAddress = 0;
@@ -155,6 +285,9 @@ namespace services
 
         SectorStatus sectorStatus = SectorStatus::empty;
         BlockHeader blockHeader;
+        SectorSummary summary;
+        uint32_t headFirstSequence = 0;
+        uint32_t headBlockCount = 0;
         RecoverPhase recoverPhase = RecoverPhase::searchingStartOrEmpty;
 
         mutable infra::IntrusiveForwardList<Iterator> iterators;
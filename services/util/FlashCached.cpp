@@ -0,0 +1,306 @@
+#include "services/util/FlashCached.hpp"
+#include "infra/event/EventDispatcher.hpp"
+#include "infra/util/ReallyAssert.hpp"
+#include <algorithm>
+
+namespace services
+{
+    FlashCached::FlashCached(infra::MemoryRange<CacheLine> lines, infra::ByteRange cache, infra::ByteRange pageBuffer, hal::Flash& master, const Config& config)
+        : lines(lines)
+        , cache(cache)
+        , pageBuffer(pageBuffer)
+        , master(master)
+        , config(config)
+    {
+        really_assert(lines.size() >= 2);
+        really_assert(cache.size() == lines.size() * pageBuffer.size());
+        really_assert(master.TotalSize() % pageBuffer.size() == 0);
+    }
+
+    uint32_t FlashCached::NumberOfSectors() const
+    {
+        return master.NumberOfSectors();
+    }
+
+    uint32_t FlashCached::SizeOfSector(uint32_t sectorIndex) const
+    {
+        return master.SizeOfSector(sectorIndex);
+    }
+
+    uint32_t FlashCached::SectorOfAddress(uint32_t address) const
+    {
+        return master.SectorOfAddress(address);
+    }
+
+    uint32_t FlashCached::AddressOfSector(uint32_t sectorIndex) const
+    {
+        return master.AddressOfSector(sectorIndex);
+    }
+
+    void FlashCached::WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+    {
+        writeData = buffer;
+        this->address = address;
+        this->onDone = onDone;
+        operation = Operation::write;
+        StartOrDefer();
+    }
+
+    void FlashCached::ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+    {
+        readData = buffer;
+        this->address = address;
+        this->onDone = onDone;
+        operation = Operation::read;
+        StartOrDefer();
+    }
+
+    void FlashCached::EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone)
+    {
+        eraseBegin = beginIndex;
+        eraseEnd = endIndex;
+        this->onDone = onDone;
+        operation = Operation::erase;
+        StartOrDefer();
+    }
+
+    void FlashCached::Flush(const infra::Function<void()>& onDone)
+    {
+        this->onDone = onDone;
+        operation = Operation::flush;
+        StartOrDefer();
+    }
+
+    void FlashCached::StartOrDefer()
+    {
+        // An operation requested while a background flush is in progress is started when the flush is done
+        if (!backgroundFlushing)
+            Start();
+    }
+
+    void FlashCached::Start()
+    {
+        switch (operation)
+        {
+            case Operation::read:
+                ContinueRead();
+                break;
+            case Operation::write:
+                if (config.combineWrites)
+                    ContinueWrite();
+                else
+                {
+                    UpdateCachedLines(address, writeData);
+                    master.WriteBuffer(writeData, address, [this]()
+                        { Done(); });
+                }
+                break;
+            case Operation::erase:
+                FlushPending([this]()
+                    { Erase(); });
+                break;
+            case Operation::flush:
+                FlushPending([this]()
+                    { Done(); });
+                break;
+            default:
+                std::abort();
+        }
+    }
+
+    void FlashCached::Done()
+    {
+        operation = Operation::none;
+
+        if (pendingSize != 0)
+            flushTimer.Start(config.flushDelay, [this]()
+                { BackgroundFlush(); });
+
+        onDone();
+    }
+
+    void FlashCached::ContinueRead()
+    {
+        while (!readData.empty())
+        {
+            auto pageAddress = PageAddress(address);
+            auto line = FindLine(pageAddress);
+
+            if (line == nullptr)
+            {
+                // Pending writes are programmed first, so that the underlying flash holds the latest data
+                FlushPending([this]()
+                    { Load(PageAddress(address)); });
+                return;
+            }
+
+            Touch(*line);
+            auto offset = address - pageAddress;
+            auto size = std::min<std::size_t>(readData.size(), PageSize() - offset);
+            infra::Copy(infra::Head(infra::DiscardHead(LineData(*line), offset), size), infra::Head(readData, size));
+            readData.pop_front(size);
+            address += size;
+        }
+
+        infra::EventDispatcher::Instance().Schedule([this]()
+            { Done(); });
+    }
+
+    void FlashCached::Load(uint32_t pageAddress)
+    {
+        auto sequential = lastLoadedPage != invalidAddress && pageAddress == lastLoadedPage + PageSize();
+
+        LoadPage(pageAddress, [this, sequential]()
+            {
+                auto nextPage = lastLoadedPage + PageSize();
+
+                if (sequential && nextPage < master.TotalSize() && FindLine(nextPage) == nullptr)
+                    LoadPage(nextPage, [this]()
+                        { ContinueRead(); });
+                else
+                    ContinueRead(); });
+    }
+
+    void FlashCached::LoadPage(uint32_t pageAddress, const infra::Function<void()>& onLoaded)
+    {
+        this->onLoaded = onLoaded;
+        loadingLine = &Victim();
+        loadingLine->address = invalidAddress;
+        loadingAddress = pageAddress;
+
+        master.ReadBuffer(LineData(*loadingLine), pageAddress, [this]()
+            {
+                loadingLine->address = loadingAddress;
+                Touch(*loadingLine);
+                lastLoadedPage = loadingAddress;
+                this->onLoaded(); });
+    }
+
+    void FlashCached::ContinueWrite()
+    {
+        while (!writeData.empty())
+        {
+            if (pendingSize != 0 && (address != pendingAddress + pendingSize || PageAddress(address) != PageAddress(pendingAddress)))
+            {
+                FlushPending([this]()
+                    { ContinueWrite(); });
+                return;
+            }
+
+            if (pendingSize == 0)
+                pendingAddress = address;
+
+            auto size = std::min<std::size_t>(writeData.size(), PageSize() - (address - PageAddress(address)));
+            infra::Copy(infra::Head(writeData, size), infra::Head(infra::DiscardHead(pageBuffer, pendingSize), size));
+            UpdateCachedLines(address, infra::Head(writeData, size));
+            pendingSize += size;
+            address += size;
+            writeData.pop_front(size);
+
+            if (address == PageAddress(pendingAddress) + PageSize())
+            {
+                FlushPending([this]()
+                    { ContinueWrite(); });
+                return;
+            }
+        }
+
+        infra::EventDispatcher::Instance().Schedule([this]()
+            { Done(); });
+    }
+
+    void FlashCached::Erase()
+    {
+        InvalidateLines(master.AddressOfSector(eraseBegin), eraseEnd == master.NumberOfSectors() ? master.TotalSize() : master.AddressOfSector(eraseEnd));
+        lastLoadedPage = invalidAddress;
+
+        master.EraseSectors(eraseBegin, eraseEnd, [this]()
+            { Done(); });
+    }
+
+    void FlashCached::FlushPending(const infra::Function<void()>& onFlushed)
+    {
+        this->onFlushed = onFlushed;
+
+        if (pendingSize == 0)
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { this->onFlushed(); });
+        else
+            master.WriteBuffer(infra::Head(pageBuffer, pendingSize), pendingAddress, [this]()
+                {
+                    pendingSize = 0;
+                    this->onFlushed(); });
+    }
+
+    void FlashCached::BackgroundFlush()
+    {
+        if (operation != Operation::none || pendingSize == 0)
+            return;
+
+        backgroundFlushing = true;
+        FlushPending([this]()
+            {
+                backgroundFlushing = false;
+
+                if (operation != Operation::none)
+                    Start(); });
+    }
+
+    FlashCached::CacheLine* FlashCached::FindLine(uint32_t pageAddress)
+    {
+        for (auto& line : lines)
+            if (line.address == pageAddress)
+                return &line;
+
+        return nullptr;
+    }
+
+    FlashCached::CacheLine& FlashCached::Victim()
+    {
+        return *std::min_element(lines.begin(), lines.end(), [](const CacheLine& x, const CacheLine& y)
+            { return (x.address == invalidAddress ? 0 : x.lastUsed + 1) < (y.address == invalidAddress ? 0 : y.lastUsed + 1); });
+    }
+
+    void FlashCached::Touch(CacheLine& line)
+    {
+        line.lastUsed = ++useCounter;
+    }
+
+    infra::ByteRange FlashCached::LineData(const CacheLine& line) const
+    {
+        auto index = &line - lines.begin();
+        return infra::ByteRange(cache.begin() + index * PageSize(), cache.begin() + (index + 1) * PageSize());
+    }
+
+    void FlashCached::UpdateCachedLines(uint32_t address, infra::ConstByteRange data)
+    {
+        for (auto& line : lines)
+            if (line.address != invalidAddress && line.address < address + data.size() && address < line.address + PageSize())
+            {
+                auto begin = std::max(line.address, address);
+                auto end = std::min<uint32_t>(line.address + PageSize(), address + data.size());
+                auto lineData = LineData(line);
+
+                // Programming can only clear bits, so the cached data is what flash will contain: the AND of old and new data
+                for (auto i = begin; i != end; ++i)
+                    lineData[i - line.address] &= data[i - address];
+            }
+    }
+
+    void FlashCached::InvalidateLines(uint32_t begin, uint32_t end)
+    {
+        for (auto& line : lines)
+            if (line.address != invalidAddress && line.address >= begin && line.address < end)
+                line.address = invalidAddress;
+    }
+
+    uint32_t FlashCached::PageAddress(uint32_t address) const
+    {
+        return address - address % PageSize();
+    }
+
+    uint32_t FlashCached::PageSize() const
+    {
+        return pageBuffer.size();
+    }
+}
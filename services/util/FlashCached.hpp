@@ -0,0 +1,120 @@
+#ifndef SERVICES_FLASH_CACHED_HPP
+#define SERVICES_FLASH_CACHED_HPP
+
+#include "hal/interfaces/Flash.hpp"
+#include "infra/timer/Timer.hpp"
+#include "infra/util/AutoResetFunction.hpp"
+#include "infra/util/WithStorage.hpp"
+#include <array>
+
+namespace services
+{
+    // FlashCached decorates a flash with a page cache, so that many small reads, like those of block headers and
+    // status bytes, result in few page-sized reads of the underlying flash. Pages are evicted least recently used
+    // first. When a read misses on the page following the previously loaded page, the page after it is read ahead.
+    //
+    // Writes are written through, and update cached pages. When combineWrites is configured, adjacent writes are
+    // collected in a page buffer, which is programmed when it is full, when a non-adjacent write or an erase is
+    // requested, on Flush, or flushDelay after the last write. Since the completion of a combined write only signals
+    // that its data is buffered, users that depend on data being programmed must call Flush.
+    class FlashCached
+        : public hal::Flash
+    {
+    public:
+        struct Config
+        {
+            Config()
+            {}
+
+            bool combineWrites = false;
+            infra::Duration flushDelay = std::chrono::milliseconds(10);
+        };
+
+        struct CacheLine
+        {
+            uint32_t address = invalidAddress;
+            uint32_t lastUsed = 0;
+        };
+
+        template<std::size_t Pages, std::size_t PageSize = 256>
+        using WithStorage = infra::WithStorage<infra::WithStorage<infra::WithStorage<FlashCached,
+                                                                      std::array<CacheLine, Pages>>,
+                                                   std::array<uint8_t, Pages * PageSize>>,
+            std::array<uint8_t, PageSize>>;
+
+        FlashCached(infra::MemoryRange<CacheLine> lines, infra::ByteRange cache, infra::ByteRange pageBuffer, hal::Flash& master, const Config& config = Config());
+
+        virtual uint32_t NumberOfSectors() const override;
+        virtual uint32_t SizeOfSector(uint32_t sectorIndex) const override;
+        virtual uint32_t SectorOfAddress(uint32_t address) const override;
+        virtual uint32_t AddressOfSector(uint32_t sectorIndex) const override;
+        virtual void WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        virtual void EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone) override;
+
+        void Flush(const infra::Function<void()>& onDone);
+
+    private:
+        enum class Operation : uint8_t
+        {
+            none,
+            read,
+            write,
+            erase,
+            flush
+        };
+
+        void StartOrDefer();
+        void Start();
+        void Done();
+
+        void ContinueRead();
+        void Load(uint32_t pageAddress);
+        void LoadPage(uint32_t pageAddress, const infra::Function<void()>& onLoaded);
+        void ContinueWrite();
+        void Erase();
+
+        void FlushPending(const infra::Function<void()>& onFlushed);
+        void BackgroundFlush();
+
+        CacheLine* FindLine(uint32_t pageAddress);
+        CacheLine& Victim();
+        void Touch(CacheLine& line);
+        infra::ByteRange LineData(const CacheLine& line) const;
+        void UpdateCachedLines(uint32_t address, infra::ConstByteRange data);
+        void InvalidateLines(uint32_t begin, uint32_t end);
+        uint32_t PageAddress(uint32_t address) const;
+        uint32_t PageSize() const;
+
+    private:
+        static const uint32_t invalidAddress = 0xffffffff;
+
+        infra::MemoryRange<CacheLine> lines;
+        infra::ByteRange cache;
+        infra::ByteRange pageBuffer;
+        hal::Flash& master;
+        Config config;
+
+        uint32_t useCounter = 0;
+        uint32_t lastLoadedPage = invalidAddress;
+        CacheLine* loadingLine = nullptr;
+        uint32_t loadingAddress = 0;
+
+        uint32_t pendingAddress = 0;
+        uint32_t pendingSize = 0;
+        infra::TimerSingleShot flushTimer;
+        bool backgroundFlushing = false;
+
+        Operation operation = Operation::none;
+        infra::ByteRange readData;
+        infra::ConstByteRange writeData;
+        uint32_t address = 0;
+        uint32_t eraseBegin = 0;
+        uint32_t eraseEnd = 0;
+        infra::AutoResetFunction<void()> onDone;
+        infra::AutoResetFunction<void()> onLoaded;
+        infra::AutoResetFunction<void()> onFlushed;
+    };
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include "services/util/FlashPrioritizedAccess.hpp"
+#include "infra/event/EventDispatcher.hpp"
+#include "infra/util/ReallyAssert.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace services
+{
+    FlashPrioritizedAccessMaster::FlashPrioritizedAccessMaster(hal::Flash& master, const Config& config)
+        : master(master)
+        , config(config)
+    {
+        really_assert(config.sliceSize != 0 && config.sectorsPerEraseSlice != 0);
+    }
+
+    FlashPrioritizedAccessMaster::~FlashPrioritizedAccessMaster()
+    {
+        really_assert(clients.empty());
+    }
+
+    void FlashPrioritizedAccessMaster::Register(FlashPrioritizedAccess& client)
+    {
+        clients.push_back(client);
+    }
+
+    void FlashPrioritizedAccessMaster::Unregister(FlashPrioritizedAccess& client)
+    {
+        really_assert(current != &client);
+        clients.erase(client);
+    }
+
+    void FlashPrioritizedAccessMaster::Request()
+    {
+        if (current == nullptr)
+            ExecuteSlice();
+    }
+
+    void FlashPrioritizedAccessMaster::ExecuteSlice()
+    {
+        current = SelectClient();
+        if (current == nullptr)
+            return;
+
+        // The client moves to the back, so that clients of equal priority are served round robin
+        clients.erase(*current);
+        clients.push_back(*current);
+
+        switch (current->operation)
+        {
+            case FlashPrioritizedAccess::Operation::read:
+                sliceSize = std::min<uint32_t>(current->readBuffer.size(), config.sliceSize - current->address % config.sliceSize);
+                master.ReadBuffer(infra::Head(current->readBuffer, sliceSize), current->address, [this]()
+                    { SliceDone(); });
+                break;
+            case FlashPrioritizedAccess::Operation::write:
+                sliceSize = std::min<uint32_t>(current->writeBuffer.size(), config.sliceSize - current->address % config.sliceSize);
+                master.WriteBuffer(infra::Head(current->writeBuffer, sliceSize), current->address, [this]()
+                    { SliceDone(); });
+                break;
+            case FlashPrioritizedAccess::Operation::erase:
+                sliceSize = std::min(current->eraseEnd - current->eraseBegin, config.sectorsPerEraseSlice);
+                master.EraseSectors(current->eraseBegin, current->eraseBegin + sliceSize, [this]()
+                    { SliceDone(); });
+                break;
+            default:
+                std::abort();
+        }
+    }
+
+    void FlashPrioritizedAccessMaster::SliceDone()
+    {
+        auto& client = *current;
+        bool finished = false;
+
+        switch (client.operation)
+        {
+            case FlashPrioritizedAccess::Operation::read:
+                client.readBuffer.pop_front(sliceSize);
+                client.address += sliceSize;
+                finished = client.readBuffer.empty();
+                break;
+            case FlashPrioritizedAccess::Operation::write:
+                client.writeBuffer.pop_front(sliceSize);
+                client.address += sliceSize;
+                finished = client.writeBuffer.empty();
+                break;
+            case FlashPrioritizedAccess::Operation::erase:
+                client.eraseBegin += sliceSize;
+                finished = client.eraseBegin == client.eraseEnd;
+                break;
+            default:
+                std::abort();
+        }
+
+        current = nullptr;
+
+        if (finished)
+        {
+            client.operation = FlashPrioritizedAccess::Operation::none;
+            client.onDone();
+        }
+
+        Request();
+    }
+
+    FlashPrioritizedAccess* FlashPrioritizedAccessMaster::SelectClient()
+    {
+        FlashPrioritizedAccess* selected = nullptr;
+
+        for (auto& client : clients)
+            if (client.operation != FlashPrioritizedAccess::Operation::none && (selected == nullptr || client.priority > selected->priority))
+                selected = &client;
+
+        return selected;
+    }
+
+    FlashPrioritizedAccess::FlashPrioritizedAccess(FlashPrioritizedAccessMaster& master, uint8_t priority)
+        : master(master)
+        , priority(priority)
+    {
+        master.Register(*this);
+    }
+
+    FlashPrioritizedAccess::~FlashPrioritizedAccess()
+    {
+        master.Unregister(*this);
+    }
+
+    uint32_t FlashPrioritizedAccess::NumberOfSectors() const
+    {
+        return master.master.NumberOfSectors();
+    }
+
+    uint32_t FlashPrioritizedAccess::SizeOfSector(uint32_t sectorIndex) const
+    {
+        return master.master.SizeOfSector(sectorIndex);
+    }
+
+    uint32_t FlashPrioritizedAccess::SectorOfAddress(uint32_t address) const
+    {
+        return master.master.SectorOfAddress(address);
+    }
+
+    uint32_t FlashPrioritizedAccess::AddressOfSector(uint32_t sectorIndex) const
+    {
+        return master.master.AddressOfSector(sectorIndex);
+    }
+
+    void FlashPrioritizedAccess::WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+    {
+        writeBuffer = buffer;
+        this->address = address;
+        Start(Operation::write, onDone);
+    }
+
+    void FlashPrioritizedAccess::ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+    {
+        readBuffer = buffer;
+        this->address = address;
+        Start(Operation::read, onDone);
+    }
+
+    void FlashPrioritizedAccess::EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone)
+    {
+        eraseBegin = beginIndex;
+        eraseEnd = endIndex;
+        Start(Operation::erase, onDone);
+    }
+
+    void FlashPrioritizedAccess::Start(Operation operation, const infra::Function<void()>& onDone)
+    {
+        really_assert(this->operation == Operation::none);
+
+        this->onDone = onDone;
+
+        // Empty operations complete without accessing the flash
+        if ((operation == Operation::read && readBuffer.empty()) || (operation == Operation::write && writeBuffer.empty()) || (operation == Operation::erase && eraseBegin == eraseEnd))
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { this->onDone(); });
+        else
+        {
+            this->operation = operation;
+            master.Request();
+        }
+    }
+}
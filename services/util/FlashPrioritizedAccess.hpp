@@ -0,0 +1,102 @@
+#ifndef SERVICES_FLASH_PRIORITIZED_ACCESS_HPP
+#define SERVICES_FLASH_PRIORITIZED_ACCESS_HPP
+
+#include "hal/interfaces/Flash.hpp"
+#include "infra/util/AutoResetFunction.hpp"
+#include "infra/util/IntrusiveList.hpp"
+
+namespace services
+{
+    class FlashPrioritizedAccess;
+
+    // FlashPrioritizedAccessMaster shares a flash between multiple FlashPrioritizedAccess clients. Unlike
+    // FlashMultipleAccessMaster, which grants the flash for the duration of a complete operation, operations are
+    // executed in slices: reads and writes of at most sliceSize bytes, not crossing a sliceSize boundary, and erases
+    // of sectorsPerEraseSlice sectors. After each slice, the next slice is taken from the pending client with the
+    // highest priority, so that a read of a high priority client waits for at most one slice of a long erase or write.
+    //
+    // Clients of equal priority are served round robin. Clients of lower priority are served only when no client
+    // of higher priority has an operation pending.
+    class FlashPrioritizedAccessMaster
+    {
+    public:
+        struct Config
+        {
+            Config()
+            {}
+
+            uint32_t sliceSize = 256;
+            uint32_t sectorsPerEraseSlice = 1;
+        };
+
+        explicit FlashPrioritizedAccessMaster(hal::Flash& master, const Config& config = Config());
+        FlashPrioritizedAccessMaster(const FlashPrioritizedAccessMaster& other) = delete;
+        FlashPrioritizedAccessMaster& operator=(const FlashPrioritizedAccessMaster& other) = delete;
+        ~FlashPrioritizedAccessMaster();
+
+    private:
+        friend class FlashPrioritizedAccess;
+
+        void Register(FlashPrioritizedAccess& client);
+        void Unregister(FlashPrioritizedAccess& client);
+        void Request();
+
+        void ExecuteSlice();
+        void SliceDone();
+        FlashPrioritizedAccess* SelectClient();
+
+    private:
+        hal::Flash& master;
+        Config config;
+        infra::IntrusiveList<FlashPrioritizedAccess> clients;
+        FlashPrioritizedAccess* current = nullptr;
+        uint32_t sliceSize = 0;
+    };
+
+    class FlashPrioritizedAccess
+        : public hal::Flash
+        , public infra::IntrusiveList<FlashPrioritizedAccess>::NodeType
+    {
+    public:
+        // Higher values take precedence
+        FlashPrioritizedAccess(FlashPrioritizedAccessMaster& master, uint8_t priority);
+        FlashPrioritizedAccess(const FlashPrioritizedAccess& other) = delete;
+        FlashPrioritizedAccess& operator=(const FlashPrioritizedAccess& other) = delete;
+        ~FlashPrioritizedAccess();
+
+        virtual uint32_t NumberOfSectors() const override;
+        virtual uint32_t SizeOfSector(uint32_t sectorIndex) const override;
+        virtual uint32_t SectorOfAddress(uint32_t address) const override;
+        virtual uint32_t AddressOfSector(uint32_t sectorIndex) const override;
+        virtual void WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        virtual void EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone) override;
+
+    private:
+        friend class FlashPrioritizedAccessMaster;
+
+        enum class Operation : uint8_t
+        {
+            none,
+            read,
+            write,
+            erase
+        };
+
+        void Start(Operation operation, const infra::Function<void()>& onDone);
+
+    private:
+        FlashPrioritizedAccessMaster& master;
+        uint8_t priority;
+
+        Operation operation = Operation::none;
+        infra::ByteRange readBuffer;
+        infra::ConstByteRange writeBuffer;
+        uint32_t address = 0;
+        uint32_t eraseBegin = 0;
+        uint32_t eraseEnd = 0;
+        infra::AutoResetFunction<void()> onDone;
+    };
+}
+
+#endif
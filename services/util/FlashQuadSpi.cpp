@@ -3,12 +3,55 @@
 
 namespace services
 {
-    FlashQuadSpi::FlashQuadSpi(hal::QuadSpi& spi, uint32_t numberOfSectors, uint8_t commandPageProgram)
+    const uint8_t FlashQuadSpi::commandRead = 0x03;
+    const uint8_t FlashQuadSpi::commandFastRead = 0x0b;
+    const uint8_t FlashQuadSpi::commandDualOutputFastRead = 0x3b;
+    const uint8_t FlashQuadSpi::commandQuadOutputFastRead = 0x6b;
+    const uint8_t FlashQuadSpi::commandQuadIoFastRead = 0xeb;
+
+    FlashQuadSpi::ReadCommand FlashQuadSpi::Read()
+    {
+        return ReadCommand{ commandRead, hal::QuadSpi::Lines::SingleSpeed(), 0 };
+    }
+
+    FlashQuadSpi::ReadCommand FlashQuadSpi::FastRead(uint8_t dummyCycles, hal::QuadSpi::Lines lines)
+    {
+        return ReadCommand{ commandFastRead, lines, dummyCycles };
+    }
+
+    FlashQuadSpi::ReadCommand FlashQuadSpi::DualOutputFastRead(uint8_t dummyCycles)
+    {
+        return ReadCommand{ commandDualOutputFastRead, hal::QuadSpi::Lines::MixedSpeed(1, 1, 2), dummyCycles };
+    }
+
+    FlashQuadSpi::ReadCommand FlashQuadSpi::QuadOutputFastRead(uint8_t dummyCycles)
+    {
+        return ReadCommand{ commandQuadOutputFastRead, hal::QuadSpi::Lines::MixedSpeed(1, 1, 4), dummyCycles };
+    }
+
+    FlashQuadSpi::ReadCommand FlashQuadSpi::QuadIoFastRead(uint8_t dummyCycles, bool continuousRead, hal::QuadSpi::Lines lines)
+    {
+        // Mode bits 0xa0 keep most devices in continuous read mode, 0x00 ends it
+        return ReadCommand{ commandQuadIoFastRead, lines, dummyCycles, infra::MakeOptional<uint8_t>(0), continuousRead ? infra::MakeOptional<uint8_t>(0xa0) : infra::none };
+    }
+
+    FlashQuadSpi::FlashQuadSpi(hal::QuadSpi& spi, uint32_t numberOfSectors, uint8_t commandPageProgram, const ReadCommand& readCommand)
         : hal::FlashHomogeneous(numberOfSectors, sizeSector)
         , spi(spi)
         , commandPageProgram(commandPageProgram)
+        , readCommand(readCommand)
     {}
 
+    void FlashQuadSpi::ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+    {
+        auto instruction = continuousReadActive ? infra::none : infra::MakeOptional(readCommand.instruction);
+        auto modeBits = readCommand.continuousModeBits != infra::none ? readCommand.continuousModeBits : readCommand.modeBits;
+        const hal::QuadSpi::Header header{ instruction, ConvertAddress(address, modeBits), {}, readCommand.dummyCycles };
+
+        continuousReadActive = readCommand.continuousModeBits != infra::none;
+        spi.ReceiveData(header, buffer, readCommand.lines, onDone);
+    }
+
     void FlashQuadSpi::WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone)
     {
         this->onDone = onDone;
@@ -24,6 +67,7 @@ namespace services
         sectorIndex = beginIndex;
         sequencer.Load([this, endIndex]()
             {
+            ExitContinuousReadIfActive();
             sequencer.While([this, endIndex]() { return sectorIndex != endIndex; });
             sequencer.Step([this]() { WriteEnable(); });
             sequencer.Step([this, endIndex]() { EraseSomeSectors(endIndex); });
@@ -36,6 +80,7 @@ namespace services
     {
         sequencer.Load([this]()
             {
+            ExitContinuousReadIfActive();
             sequencer.While([this]() { return !this->buffer.empty(); });
             sequencer.Step([this]() { WriteEnable(); });
             sequencer.Step([this]() { PageProgram(); });
@@ -60,4 +105,39 @@ namespace services
     {
         return hal::QuadSpi::AddressToVector(address, 3);
     }
+
+    infra::BoundedVector<uint8_t>::WithMaxSize<4> FlashQuadSpi::ConvertAddress(uint32_t address, infra::Optional<uint8_t> modeBits) const
+    {
+        if (modeBits != infra::none)
+            return hal::QuadSpi::AddressToVector((address << 8) | *modeBits, 4);
+        else
+            return ConvertAddress(address);
+    }
+
+    void FlashQuadSpi::ExitContinuousReadIfActive()
+    {
+        sequencer.If([this]()
+            { return continuousReadActive; });
+        sequencer.Step([this]()
+            { SendExitContinuousRead([this]()
+                  { sequencer.Continue(); }); });
+        sequencer.EndIf();
+    }
+
+    void FlashQuadSpi::ExitContinuousReadIfActive(const infra::Function<void()>& onExited)
+    {
+        if (continuousReadActive)
+            SendExitContinuousRead(onExited);
+        else
+            onExited();
+    }
+
+    void FlashQuadSpi::SendExitContinuousRead(const infra::Function<void()>& onExited)
+    {
+        // In continuous read mode the device interprets the first byte as address, so a read without instruction
+        // with ending mode bits is sent before any other command
+        const hal::QuadSpi::Header header{ infra::none, ConvertAddress(0, readCommand.modeBits), {}, readCommand.dummyCycles };
+        continuousReadActive = false;
+        spi.ReceiveData(header, infra::MakeByteRange(exitReadData), readCommand.lines, onExited);
+    }
 }
@@ -9,6 +9,10 @@
 
 namespace services
 {
+    // FlashQuadSpi reads with a ReadCommand that is chosen by the subclass, or passed to its constructor. When the
+    // read command has continuous mode bits, the device stays in continuous read mode after the first read, and
+    // subsequent reads are sent without instruction. Continuous read mode is exited before any command that is not a
+    // read; subclasses that send such commands outside of a program or erase call ExitContinuousReadIfActive first.
     class FlashQuadSpi
         : public hal::FlashHomogeneous
     {
@@ -17,9 +21,32 @@ namespace services
         static const uint32_t sizeSector = 4096;
         static const uint32_t sizePage = 256;
 
+        static const uint8_t commandRead;
+        static const uint8_t commandFastRead;
+        static const uint8_t commandDualOutputFastRead;
+        static const uint8_t commandQuadOutputFastRead;
+        static const uint8_t commandQuadIoFastRead;
+
+        struct ReadCommand
+        {
+            uint8_t instruction;
+            hal::QuadSpi::Lines lines;
+            uint8_t dummyCycles;
+            // Mode bits are sent as the byte following the address; when continuousModeBits is set, those are sent instead
+            infra::Optional<uint8_t> modeBits = infra::none;
+            infra::Optional<uint8_t> continuousModeBits = infra::none;
+        };
+
+        static ReadCommand Read();
+        static ReadCommand FastRead(uint8_t dummyCycles = 8, hal::QuadSpi::Lines lines = hal::QuadSpi::Lines::SingleSpeed());
+        static ReadCommand DualOutputFastRead(uint8_t dummyCycles = 8);
+        static ReadCommand QuadOutputFastRead(uint8_t dummyCycles = 8);
+        static ReadCommand QuadIoFastRead(uint8_t dummyCycles = 4, bool continuousRead = false, hal::QuadSpi::Lines lines = hal::QuadSpi::Lines::MixedSpeed(1, 4, 4));
+
     public:
-        FlashQuadSpi(hal::QuadSpi& spi, uint32_t numberOfSectors, uint8_t commandPageProgram);
+        FlashQuadSpi(hal::QuadSpi& spi, uint32_t numberOfSectors, uint8_t commandPageProgram, const ReadCommand& readCommand);
 
+        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
         virtual void WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
         virtual void EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone) override;
 
@@ -27,11 +54,17 @@ namespace services
         void WriteBufferSequence();
         virtual void PageProgram();
         infra::BoundedVector<uint8_t>::WithMaxSize<4> ConvertAddress(uint32_t address) const;
+        infra::BoundedVector<uint8_t>::WithMaxSize<4> ConvertAddress(uint32_t address, infra::Optional<uint8_t> modeBits) const;
+        void ExitContinuousReadIfActive();
+        void ExitContinuousReadIfActive(const infra::Function<void()>& onExited);
 
         virtual void WriteEnable() = 0;
         virtual void EraseSomeSectors(uint32_t endIndex) = 0;
         virtual void HoldWhileWriteInProgress() = 0;
 
+    private:
+        void SendExitContinuousRead(const infra::Function<void()>& onExited);
+
     protected:
         hal::QuadSpi& spi;
         infra::Sequencer sequencer;
@@ -40,6 +73,9 @@ namespace services
         uint32_t address = 0;
         uint32_t sectorIndex = 0;
         uint8_t commandPageProgram;
+        ReadCommand readCommand;
+        bool continuousReadActive = false;
+        uint8_t exitReadData = 0;
     };
 }
 
@@ -15,8 +15,8 @@ namespace services
     const uint8_t FlashQuadSpiCypressFll::commandExitQpi = 0xf5;
     const uint8_t FlashQuadSpiCypressFll::commandReadUniqueId = 0x4b;
 
-    FlashQuadSpiCypressFll::FlashQuadSpiCypressFll(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors)
-        : FlashQuadSpi(spi, numberOfSectors, commandPageProgram)
+    FlashQuadSpiCypressFll::FlashQuadSpiCypressFll(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors, const ReadCommand& readCommand)
+        : FlashQuadSpi(spi, numberOfSectors, commandPageProgram, readCommand)
         , onInitialized(onInitialized)
     {
         sequencer.Load([this]()
@@ -26,16 +26,14 @@ namespace services
             sequencer.Step([this]() { infra::EventDispatcher::Instance().Schedule([this]() { this->onInitialized(); }); }); });
     }
 
-    void FlashQuadSpiCypressFll::ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
-    {
-        const hal::QuadSpi::Header header{ infra::MakeOptional(commandReadData), hal::QuadSpi::AddressToVector(address << 8, 4), {}, 8 };
-        spi.ReceiveData(header, buffer, hal::QuadSpi::Lines::QuadSpeed(), onDone);
-    }
-
     void FlashQuadSpiCypressFll::SwitchToSingleSpeed(infra::Function<void()> onDone)
     {
-        static const hal::QuadSpi::Header exitQpiHeader{ infra::MakeOptional(commandExitQpi), {}, {}, 0 };
-        spi.SendData(exitQpiHeader, {}, hal::QuadSpi::Lines::QuadSpeed(), onDone);
+        onCommandDone = onDone;
+        ExitContinuousReadIfActive([this]()
+            {
+                static const hal::QuadSpi::Header exitQpiHeader{ infra::MakeOptional(commandExitQpi), {}, {}, 0 };
+                spi.SendData(exitQpiHeader, {}, hal::QuadSpi::Lines::QuadSpeed(), [this]()
+                    { onCommandDone(); }); });
     }
 
     void FlashQuadSpiCypressFll::SwitchToQuadSpeed()
@@ -113,7 +111,12 @@ namespace services
 
     void FlashQuadSpiCypressFll::ReadFlashId(infra::ByteRange buffer, infra::Function<void()> onDone)
     {
-        static const hal::QuadSpi::Header readUniqueIdHeader{ infra::MakeOptional(commandReadUniqueId), {}, {}, 16 };
-        spi.ReceiveData(readUniqueIdHeader, buffer, hal::QuadSpi::Lines::QuadSpeed(), onDone);
+        flashIdBuffer = buffer;
+        onCommandDone = onDone;
+        ExitContinuousReadIfActive([this]()
+            {
+                static const hal::QuadSpi::Header readUniqueIdHeader{ infra::MakeOptional(commandReadUniqueId), {}, {}, 16 };
+                spi.ReceiveData(readUniqueIdHeader, flashIdBuffer, hal::QuadSpi::Lines::QuadSpeed(), [this]()
+                    { onCommandDone(); }); });
     }
 }
@@ -27,11 +27,9 @@ namespace services
 
         static const uint8_t statusFlagWriteInProgress = 1;
 
-        FlashQuadSpiCypressFll(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors = 4096);
+        FlashQuadSpiCypressFll(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors = 4096, const ReadCommand& readCommand = QuadIoFastRead(8, false, hal::QuadSpi::Lines::QuadSpeed()));
 
     public:
-        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
-
         void SwitchToSingleSpeed(infra::Function<void()> onDone);
 
         // implement FlashId
@@ -50,6 +48,8 @@ namespace services
     private:
         infra::TimerSingleShot initDelayTimer;
         infra::Function<void()> onInitialized;
+        infra::AutoResetFunction<void()> onCommandDone;
+        infra::ByteRange flashIdBuffer;
     };
 }
 
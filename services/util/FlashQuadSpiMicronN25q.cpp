@@ -16,8 +16,8 @@ namespace services
 
     const uint8_t FlashQuadSpiMicronN25q::volatileRegisterForQuadSpeed = 0x5f;
 
-    FlashQuadSpiMicronN25q::FlashQuadSpiMicronN25q(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors)
-        : FlashQuadSpi(spi, numberOfSectors, commandPageProgram)
+    FlashQuadSpiMicronN25q::FlashQuadSpiMicronN25q(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors, const ReadCommand& readCommand)
+        : FlashQuadSpi(spi, numberOfSectors, commandPageProgram, readCommand)
         , onInitialized(onInitialized)
     {
         sequencer.Load([this]()
@@ -28,13 +28,6 @@ namespace services
             sequencer.Step([this]() { infra::EventDispatcher::Instance().Schedule([this]() { this->onInitialized(); }); }); });
     }
 
-    void FlashQuadSpiMicronN25q::ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
-    {
-        const hal::QuadSpi::Header header{ infra::MakeOptional(commandReadData), ConvertAddress(address), {}, 10 };
-
-        spi.ReceiveData(header, buffer, hal::QuadSpi::Lines::QuadSpeed(), onDone);
-    }
-
     void FlashQuadSpiMicronN25q::WriteEnableSingleSpeed()
     {
         static const hal::QuadSpi::Header writeEnableHeader{ infra::MakeOptional(commandWriteEnable), {}, {}, 0 };
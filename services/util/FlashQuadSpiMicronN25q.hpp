@@ -23,10 +23,7 @@ namespace services
         static const uint8_t statusFlagWriteInProgress = 1;
         static const uint8_t volatileRegisterForQuadSpeed;
 
-        FlashQuadSpiMicronN25q(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors = 4096);
-
-    public:
-        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        FlashQuadSpiMicronN25q(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors = 4096, const ReadCommand& readCommand = FastRead(10, hal::QuadSpi::Lines::QuadSpeed()));
 
     private:
         void WriteEnableSingleSpeed();
@@ -11,20 +11,13 @@ namespace services
     const uint8_t FlashQuadSpiSingleSpeed::commandEraseBlock = 0xd8;
     const uint8_t FlashQuadSpiSingleSpeed::commandEraseChip = 0x60;
 
-    FlashQuadSpiSingleSpeed::FlashQuadSpiSingleSpeed(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors)
-        : FlashQuadSpi(spi, numberOfSectors, commandPageProgram)
+    FlashQuadSpiSingleSpeed::FlashQuadSpiSingleSpeed(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors, const ReadCommand& readCommand)
+        : FlashQuadSpi(spi, numberOfSectors, commandPageProgram, readCommand)
         , onInitialized(onInitialized)
         , initDelayTimer(std::chrono::milliseconds(100), [this]()
               { this->onInitialized(); })
     {}
 
-    void FlashQuadSpiSingleSpeed::ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
-    {
-        const hal::QuadSpi::Header header{ infra::MakeOptional(commandReadData), hal::QuadSpi::AddressToVector(address, 3), {}, 0 };
-
-        spi.ReceiveData(header, buffer, hal::QuadSpi::Lines::SingleSpeed(), onDone);
-    }
-
     void FlashQuadSpiSingleSpeed::PageProgram()
     {
         hal::QuadSpi::Header pageProgramHeader{ infra::MakeOptional(commandPageProgram), ConvertAddress(address), {}, 0 };
@@ -20,10 +20,7 @@ namespace services
 
         static const uint8_t statusFlagWriteInProgress = 1;
 
-        FlashQuadSpiSingleSpeed(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors = 4096);
-
-    public:
-        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
+        FlashQuadSpiSingleSpeed(hal::QuadSpi& spi, infra::Function<void()> onInitialized, uint32_t numberOfSectors = 4096, const ReadCommand& readCommand = Read());
 
     protected:
         virtual void PageProgram() override;
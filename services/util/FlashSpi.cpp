@@ -1,8 +1,22 @@
 #include "services/util/FlashSpi.hpp"
 #include "infra/event/EventDispatcher.hpp"
+#include <algorithm>
 
 namespace services
 {
+    namespace
+    {
+        FlashSpi::Config ConfigWithSubSectors(uint32_t numberOfSubSectors)
+        {
+            FlashSpi::Config config;
+            config.numberOfSubSectors = numberOfSubSectors;
+            return config;
+        }
+
+        const std::array<uint8_t, 4> sfdpSignature = { 'S', 'F', 'D', 'P' };
+        const std::size_t sfdpHeaderSize = 16;
+        const uint32_t maxSizeThreeByteAddressing = 1 << 24;
+    }
 
     const uint8_t FlashSpi::commandPageProgram = 0x02;
     const uint8_t FlashSpi::commandReadData = 0x03;
@@ -12,13 +26,39 @@ namespace services
     const uint8_t FlashSpi::commandEraseSector = 0xd8;
     const uint8_t FlashSpi::commandEraseBulk = 0xc7;
     const uint8_t FlashSpi::commandReadId = 0x9f;
+    const uint8_t FlashSpi::commandPageProgram4Byte = 0x12;
+    const uint8_t FlashSpi::commandReadData4Byte = 0x13;
+    const uint8_t FlashSpi::commandEraseSubSector4Byte = 0x21;
+    const uint8_t FlashSpi::commandEraseSector4Byte = 0xdc;
+    const uint8_t FlashSpi::commandReadSfdp = 0x5a;
 
     FlashSpi::FlashSpi(hal::SpiMaster& spi, uint32_t numberOfSubSectors, uint32_t timerId, infra::Function<void()> onInitialized)
-        : hal::FlashHomogeneous(numberOfSubSectors, sizeSubSector)
+        : FlashSpi(spi, ConfigWithSubSectors(numberOfSubSectors), timerId, onInitialized)
+    {}
+
+    FlashSpi::FlashSpi(hal::SpiMaster& spi, const Config& config, uint32_t timerId, infra::Function<void()> onInitialized)
+        : hal::FlashHomogeneous(config.numberOfSubSectors, sizeSubSector)
         , spi(spi)
+        , config(config)
         , delayTimer(timerId)
     {
-        onInitialized();
+        if (config.discoverParameters)
+        {
+            this->onInitialized = onInitialized;
+            DiscoverParameters();
+        }
+        else
+            onInitialized();
+    }
+
+    const FlashSpi::Config& FlashSpi::Parameters() const
+    {
+        return config;
+    }
+
+    uint32_t FlashSpi::NumberOfSectors() const
+    {
+        return config.numberOfSubSectors;
     }
 
     void FlashSpi::WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone)
@@ -40,10 +80,8 @@ namespace services
     {
         readBuffer = buffer;
         this->onDone = onDone;
-        instructionAndAddress.instruction = commandReadData;
-        instructionAndAddress.address = ConvertAddress(address);
 
-        spi.SendData(infra::MakeByteRange(instructionAndAddress), hal::SpiAction::continueSession, [this]()
+        spi.SendData(InstructionAndAddress(commandReadData, commandReadData4Byte, address), hal::SpiAction::continueSession, [this]()
             { spi.ReceiveData(readBuffer, hal::SpiAction::stop, [this]()
                   { this->onDone(); }); });
     }
@@ -72,14 +110,93 @@ namespace services
                   { this->onDone(); }); });
     }
 
-    std::array<uint8_t, 3> FlashSpi::ConvertAddress(uint32_t address) const
+    infra::ConstByteRange FlashSpi::InstructionAndAddress(uint8_t instruction, uint8_t instruction4Byte, uint32_t address)
+    {
+        auto size = config.extendedAddressing ? 4 : 3;
+
+        instructionAndAddress[0] = config.extendedAddressing ? instruction4Byte : instruction;
+        for (auto i = 0; i != size; ++i)
+            instructionAndAddress[1 + i] = static_cast<uint8_t>(address >> (8 * (size - 1 - i)));
+
+        return infra::Head(infra::MakeRange(instructionAndAddress), 1 + size);
+    }
+
+    void FlashSpi::DiscoverParameters()
+    {
+        sequencer.Load([this]()
+            {
+                sequencer.Step([this]()
+                    { ReadSfdp(0, sfdpHeaderSize); });
+                sequencer.Execute([this]()
+                    { ApplySfdpHeader(); });
+                sequencer.If([this]()
+                    { return basicParametersSize != 0; });
+                    sequencer.Step([this]()
+                        { ReadSfdp(basicParametersAddress, basicParametersSize); });
+                    sequencer.Execute([this]()
+                        { ApplyBasicParameters(); });
+                sequencer.EndIf();
+                sequencer.Execute([this]()
+                    { infra::EventDispatcher::Instance().Schedule([this]()
+                          { onInitialized(); }); }); });
+    }
+
+    void FlashSpi::ReadSfdp(uint32_t address, std::size_t size)
+    {
+        instructionAndAddress = { commandReadSfdp, static_cast<uint8_t>(address >> 16), static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address), 0 };
+        readBuffer = infra::Head(infra::MakeRange(sfdp), size);
+
+        spi.SendData(infra::MakeRange(instructionAndAddress), hal::SpiAction::continueSession, [this]()
+            { spi.ReceiveData(readBuffer, hal::SpiAction::stop, [this]()
+                  { sequencer.Continue(); }); });
+    }
+
+    void FlashSpi::ApplySfdpHeader()
+    {
+        // The first parameter header describes the basic flash parameter table, which has ID 0xff00
+        auto valid = std::equal(sfdpSignature.begin(), sfdpSignature.end(), sfdp.begin()) && sfdp[8] == 0 && sfdp[15] == 0xff && sfdp[11] >= 2;
+
+        basicParametersAddress = sfdp[12] | (sfdp[13] << 8) | (sfdp[14] << 16);
+        basicParametersSize = valid ? std::min<std::size_t>(sfdp[11] * 4, sfdp.size()) : 0;
+    }
+
+    void FlashSpi::ApplyBasicParameters()
+    {
+        static const std::array<infra::Duration, 4> eraseUnits = { std::chrono::milliseconds(1), std::chrono::milliseconds(16), std::chrono::milliseconds(128), std::chrono::seconds(1) };
+        static const std::array<infra::Duration, 4> bulkEraseUnits = { std::chrono::milliseconds(16), std::chrono::milliseconds(256), std::chrono::seconds(4), std::chrono::seconds(64) };
+        static const std::array<infra::Duration, 2> pageProgramUnits = { std::chrono::microseconds(8), std::chrono::microseconds(64) };
+
+        auto density = BasicParameter(1);
+        uint64_t size = (density & 0x80000000) == 0 ? (static_cast<uint64_t>(density) + 1) / 8 : uint64_t(1) << ((density & 0x7fffffff) - 3);
+        auto addressBytes = (BasicParameter(0) >> 17) & 3;
+
+        config.numberOfSubSectors = static_cast<uint32_t>(size / sizeSubSector);
+        config.extendedAddressing = addressBytes == 2 || (addressBytes == 1 && size > maxSizeThreeByteAddressing);
+
+        if (basicParametersSize >= 10 * 4)
+            for (std::size_t type = 0; type != 4; ++type)
+            {
+                auto eraseSize = (BasicParameter(7 + type / 2) >> (16 * (type % 2))) & 0xff;
+                auto timing = BasicParameter(9) >> (4 + 7 * type);
+                auto typical = ((timing & 0x1f) + 1) * eraseUnits[(timing >> 5) & 3];
+
+                if (eraseSize != 0 && uint32_t(1) << eraseSize == sizeSubSector)
+                    config.typicalSubSectorEraseTime = typical;
+                else if (eraseSize != 0 && uint32_t(1) << eraseSize == sizeSector)
+                    config.typicalSectorEraseTime = typical;
+            }
+
+        if (basicParametersSize >= 11 * 4)
+        {
+            auto timing = BasicParameter(10);
+            config.typicalPageProgramTime = (((timing >> 8) & 0x1f) + 1) * pageProgramUnits[(timing >> 13) & 1];
+            config.typicalBulkEraseTime = (((timing >> 24) & 0x1f) + 1) * bulkEraseUnits[(timing >> 29) & 3];
+        }
+    }
+
+    uint32_t FlashSpi::BasicParameter(std::size_t index) const
     {
-        uint32_t linearAddress = address;
-        std::array<uint8_t, 3> result;
-        result[0] = static_cast<uint8_t>(linearAddress >> 16);
-        result[1] = static_cast<uint8_t>(linearAddress >> 8);
-        result[2] = static_cast<uint8_t>(linearAddress);
-        return result;
+        return sfdp[index * 4] | (sfdp[index * 4 + 1] << 8) | (sfdp[index * 4 + 2] << 16) | (static_cast<uint32_t>(sfdp[index * 4 + 3]) << 24);
     }
 
     void FlashSpi::WriteEnable()
@@ -95,12 +212,12 @@ namespace services
         writeBuffer = infra::Head(buffer, sizePage - AddressOffsetInSector(address) % sizePage);
         buffer.pop_front(writeBuffer.size());
 
-        instructionAndAddress.instruction = commandPageProgram;
-        instructionAndAddress.address = ConvertAddress(address);
+        auto instruction = InstructionAndAddress(commandPageProgram, commandPageProgram4Byte, address);
+        ExpectDuration(config.typicalPageProgramTime);
 
         address += writeBuffer.size();
 
-        spi.SendData(infra::MakeByteRange(instructionAndAddress), hal::SpiAction::continueSession, [this]()
+        spi.SendData(instruction, hal::SpiAction::continueSession, [this]()
             { spi.SendData(writeBuffer, hal::SpiAction::stop, [this]()
                   { sequencer.Continue(); }); });
     }
@@ -126,44 +243,69 @@ namespace services
 
     void FlashSpi::SendEraseSubSector(uint32_t subSectorIndex)
     {
-        instructionAndAddress.instruction = commandEraseSubSector;
-        instructionAndAddress.address = ConvertAddress(AddressOfSector(subSectorIndex));
+        ExpectDuration(config.typicalSubSectorEraseTime);
 
-        spi.SendData(infra::MakeByteRange(instructionAndAddress), hal::SpiAction::stop, [this]()
+        spi.SendData(InstructionAndAddress(commandEraseSubSector, commandEraseSubSector4Byte, AddressOfSector(subSectorIndex)), hal::SpiAction::stop, [this]()
             { sequencer.Continue(); });
     }
 
     void FlashSpi::SendEraseSector(uint32_t subSectorIndex)
     {
-        instructionAndAddress.instruction = commandEraseSector;
-        instructionAndAddress.address = ConvertAddress(AddressOfSector(subSectorIndex));
+        ExpectDuration(config.typicalSectorEraseTime);
 
-        spi.SendData(infra::MakeByteRange(instructionAndAddress), hal::SpiAction::stop, [this]()
+        spi.SendData(InstructionAndAddress(commandEraseSector, commandEraseSector4Byte, AddressOfSector(subSectorIndex)), hal::SpiAction::stop, [this]()
             { sequencer.Continue(); });
     }
 
     void FlashSpi::SendEraseBulk()
     {
-        instructionAndAddress.instruction = commandEraseBulk;
+        static const uint8_t instruction = commandEraseBulk;
+
+        ExpectDuration(config.typicalBulkEraseTime);
 
-        spi.SendData(infra::MakeByteRange(instructionAndAddress.instruction), hal::SpiAction::stop, [this]()
+        spi.SendData(infra::MakeByteRange(instruction), hal::SpiAction::stop, [this]()
             { sequencer.Continue(); });
     }
 
+    void FlashSpi::ExpectDuration(infra::Duration typical)
+    {
+        typicalTime = typical;
+        backoff = config.pollInterval;
+    }
+
     void FlashSpi::HoldWhileWriteInProgress()
     {
         sequencer.Step([this]()
-            { ReadStatusRegister(); });
+            {
+                waitStart = delayTimer.Now();
+                ReadStatusRegister(); });
         sequencer.While([this]()
-            { return (statusRegister & 1) == 1; });
+            { return (statusRegister & statusFlagWriteInProgress) == statusFlagWriteInProgress; });
         sequencer.Step([this]()
-            { delayTimer.Start(std::chrono::milliseconds(1), [this]()
-                  { sequencer.Continue(); }); });
+            { WaitBeforePoll(); });
         sequencer.Step([this]()
             { ReadStatusRegister(); });
         sequencer.EndWhile();
     }
 
+    void FlashSpi::WaitBeforePoll()
+    {
+        auto elapsed = delayTimer.Now() - waitStart;
+
+        if (elapsed < typicalTime && typicalTime - elapsed < config.pollInterval)
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { sequencer.Continue(); });
+        else if (elapsed < typicalTime)
+            delayTimer.Start(typicalTime - elapsed, [this]()
+                { sequencer.Continue(); });
+        else
+        {
+            delayTimer.Start(backoff, [this]()
+                { sequencer.Continue(); });
+            backoff = std::min(backoff * 2, std::max(typicalTime / 4, config.pollInterval));
+        }
+    }
+
     void FlashSpi::ReadStatusRegister()
     {
         static const uint8_t instruction = commandReadStatusRegister;
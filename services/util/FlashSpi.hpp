@@ -10,6 +10,13 @@
 
 namespace services
 {
+    // FlashSpi drives a serial NOR flash. After each page program and erase, the status register is polled until
+    // the operation completes. When the typical duration of an operation is known, the first poll after the initial one
+    // is delayed until that duration has passed, or, when that is shorter than pollInterval, the status is polled again
+    // immediately. Operations that take longer than typical are polled with an exponentially increasing interval.
+    //
+    // Devices larger than 16 MB are accessed with the 4-byte address instructions. With discoverParameters configured,
+    // size, address mode and typical durations are read from the device's SFDP table before onInitialized is called.
     class FlashSpi
         : public hal::FlashHomogeneous
         , public hal::FlashId
@@ -23,6 +30,11 @@ namespace services
         static const uint8_t commandEraseSector;
         static const uint8_t commandEraseBulk;
         static const uint8_t commandReadId;
+        static const uint8_t commandPageProgram4Byte;
+        static const uint8_t commandReadData4Byte;
+        static const uint8_t commandEraseSubSector4Byte;
+        static const uint8_t commandEraseSector4Byte;
+        static const uint8_t commandReadSfdp;
 
         static const uint32_t nrOfSubSectors = 512;
 
@@ -32,10 +44,31 @@ namespace services
 
         static const uint8_t statusFlagWriteInProgress = 1;
 
+        struct Config
+        {
+            Config()
+            {}
+
+            uint32_t numberOfSubSectors = nrOfSubSectors;
+            bool extendedAddressing = false;
+            bool discoverParameters = false;
+
+            // A duration of zero means that the typical duration is unknown
+            infra::Duration typicalPageProgramTime = infra::Duration::zero();
+            infra::Duration typicalSubSectorEraseTime = infra::Duration::zero();
+            infra::Duration typicalSectorEraseTime = infra::Duration::zero();
+            infra::Duration typicalBulkEraseTime = infra::Duration::zero();
+            infra::Duration pollInterval = std::chrono::milliseconds(1);
+        };
+
         explicit FlashSpi(hal::SpiMaster& spi, uint32_t numberOfSubSectors = nrOfSubSectors, uint32_t timerId = infra::systemTimerServiceId, infra::Function<void()> onInitialized = infra::emptyFunction);
+        FlashSpi(hal::SpiMaster& spi, const Config& config, uint32_t timerId = infra::systemTimerServiceId, infra::Function<void()> onInitialized = infra::emptyFunction);
+
+        const Config& Parameters() const;
 
     public:
         // implement Flash
+        virtual uint32_t NumberOfSectors() const override;
         virtual void WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
         virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override;
         virtual void EraseSectors(uint32_t beginIndex, uint32_t endIndex, infra::Function<void()> onDone) override;
@@ -44,7 +77,13 @@ namespace services
         virtual void ReadFlashId(infra::ByteRange buffer, infra::Function<void()> onDone) override;
 
     private:
-        std::array<uint8_t, 3> ConvertAddress(uint32_t address) const;
+        infra::ConstByteRange InstructionAndAddress(uint8_t instruction, uint8_t instruction4Byte, uint32_t address);
+
+        void DiscoverParameters();
+        void ReadSfdp(uint32_t address, std::size_t size);
+        void ApplySfdpHeader();
+        void ApplyBasicParameters();
+        uint32_t BasicParameter(std::size_t index) const;
 
         void WriteEnable();
         void PageProgram();
@@ -52,11 +91,14 @@ namespace services
         void SendEraseSubSector(uint32_t subSectorIndex);
         void SendEraseSector(uint32_t subSectorIndex);
         void SendEraseBulk();
+        void ExpectDuration(infra::Duration typical);
         void HoldWhileWriteInProgress();
+        void WaitBeforePoll();
         void ReadStatusRegister();
 
     private:
         hal::SpiMaster& spi;
+        Config config;
         infra::Sequencer sequencer;
         infra::TimerSingleShot delayTimer;
         infra::AutoResetFunction<void()> onDone;
@@ -67,11 +109,16 @@ namespace services
         uint32_t sectorIndex = 0;
         uint8_t statusRegister = 0;
 
-        struct InstructionAndAddress
-        {
-            uint8_t instruction = 0;
-            std::array<uint8_t, 3> address = {};
-        } instructionAndAddress;
+        infra::Duration typicalTime;
+        infra::Duration backoff;
+        infra::TimePoint waitStart;
+
+        infra::AutoResetFunction<void()> onInitialized;
+        std::array<uint8_t, 44> sfdp;
+        uint32_t basicParametersAddress = 0;
+        std::size_t basicParametersSize = 0;
+
+        std::array<uint8_t, 5> instructionAndAddress;
     };
 }
 
@@ -0,0 +1,137 @@
+#include "services/util/FlashStatistics.hpp"
+#include "infra/util/ReallyAssert.hpp"
+#include <algorithm>
+
+namespace services
+{
+    void FlashOperationStatistics::Add(uint64_t bytes, infra::Duration latency)
+    {
+        ++count;
+        this->bytes += bytes;
+        maxLatency = std::max(maxLatency, latency);
+
+        std::size_t bucket = 0;
+        for (infra::Duration bound = std::chrono::microseconds(100); bucket != numberOfLatencyBuckets - 1 && latency >= bound; bound *= 10)
+            ++bucket;
+
+        ++latencyHistogram[bucket];
+    }
+
+    template<class T>
+    FlashStatisticsBase<T>::FlashStatisticsBase(infra::MemoryRange<uint32_t> eraseCounts, hal::FlashBase<T>& master, uint32_t timerServiceId)
+        : eraseCounts(eraseCounts)
+        , master(master)
+        , timerServiceId(timerServiceId)
+        , sectorsPerEraseCounter((master.NumberOfSectors() + eraseCounts.size() - 1) / eraseCounts.size())
+    {
+        really_assert(!eraseCounts.empty());
+        Reset();
+    }
+
+    template<class T>
+    FlashStatisticsSnapshot FlashStatisticsBase<T>::Statistics() const
+    {
+        return FlashStatisticsSnapshot{ read, write, erase, sectorsPerEraseCounter, infra::Head(eraseCounts, (master.NumberOfSectors() + sectorsPerEraseCounter - 1) / sectorsPerEraseCounter) };
+    }
+
+    template<class T>
+    void FlashStatisticsBase<T>::Reset()
+    {
+        read = FlashOperationStatistics();
+        write = FlashOperationStatistics();
+        erase = FlashOperationStatistics();
+        std::fill(eraseCounts.begin(), eraseCounts.end(), 0);
+    }
+
+    template<class T>
+    T FlashStatisticsBase<T>::NumberOfSectors() const
+    {
+        return master.NumberOfSectors();
+    }
+
+    template<class T>
+    uint32_t FlashStatisticsBase<T>::SizeOfSector(T sectorIndex) const
+    {
+        return master.SizeOfSector(sectorIndex);
+    }
+
+    template<class T>
+    T FlashStatisticsBase<T>::SectorOfAddress(T address) const
+    {
+        return master.SectorOfAddress(address);
+    }
+
+    template<class T>
+    T FlashStatisticsBase<T>::AddressOfSector(T sectorIndex) const
+    {
+        return master.AddressOfSector(sectorIndex);
+    }
+
+    template<class T>
+    void FlashStatisticsBase<T>::WriteBuffer(infra::ConstByteRange buffer, T address, infra::Function<void()> onDone)
+    {
+        Start(write, buffer.size(), onDone);
+        master.WriteBuffer(buffer, address, [this]()
+            { Done(); });
+    }
+
+    template<class T>
+    void FlashStatisticsBase<T>::ReadBuffer(infra::ByteRange buffer, T address, infra::Function<void()> onDone)
+    {
+        Start(read, buffer.size(), onDone);
+        master.ReadBuffer(buffer, address, [this]()
+            { Done(); });
+    }
+
+    template<class T>
+    void FlashStatisticsBase<T>::EraseSectors(T beginIndex, T endIndex, infra::Function<void()> onDone)
+    {
+        eraseBegin = beginIndex;
+        eraseEnd = endIndex;
+        Start(erase, EndAddressOfSectors(endIndex) - master.AddressOfSector(beginIndex), onDone);
+        master.EraseSectors(beginIndex, endIndex, [this]()
+            {
+                CountErasures(eraseBegin, eraseEnd);
+                Done(); });
+    }
+
+    template<class T>
+    void FlashStatisticsBase<T>::Start(FlashOperationStatistics& statistics, uint64_t bytes, const infra::Function<void()>& onDone)
+    {
+        really_assert(current == nullptr);
+
+        this->onDone = onDone;
+        current = &statistics;
+        currentBytes = bytes;
+        start = infra::Now(timerServiceId);
+    }
+
+    template<class T>
+    void FlashStatisticsBase<T>::Done()
+    {
+        current->Add(currentBytes, infra::Now(timerServiceId) - start);
+        current = nullptr;
+        onDone();
+    }
+
+    template<class T>
+    void FlashStatisticsBase<T>::CountErasures(T beginIndex, T endIndex)
+    {
+        while (beginIndex != endIndex)
+        {
+            auto counter = beginIndex / sectorsPerEraseCounter;
+            auto endOfCounter = std::min<T>((counter + 1) * sectorsPerEraseCounter, endIndex);
+            eraseCounts[counter] += static_cast<uint32_t>(endOfCounter - beginIndex);
+            beginIndex = endOfCounter;
+        }
+    }
+
+    template<class T>
+    T FlashStatisticsBase<T>::EndAddressOfSectors(T endIndex) const
+    {
+        return endIndex == master.NumberOfSectors() ? master.TotalSize() : master.AddressOfSector(endIndex);
+    }
+
+    template class FlashStatisticsBase<uint32_t>;
+    template class FlashStatisticsBase<uint64_t>;
+}
@@ -0,0 +1,92 @@
+#ifndef SERVICES_FLASH_STATISTICS_HPP
+#define SERVICES_FLASH_STATISTICS_HPP
+
+#include "hal/interfaces/Flash.hpp"
+#include "infra/timer/Timer.hpp"
+#include "infra/util/AutoResetFunction.hpp"
+#include "infra/util/MemoryRange.hpp"
+#include "infra/util/WithStorage.hpp"
+#include <array>
+
+namespace services
+{
+    struct FlashOperationStatistics
+    {
+        // Bucket i counts operations with a latency below 100us * 10^i; the last bucket counts all slower operations
+        static const std::size_t numberOfLatencyBuckets = 6;
+
+        void Add(uint64_t bytes, infra::Duration latency);
+
+        uint32_t count = 0;
+        uint64_t bytes = 0;
+        infra::Duration maxLatency = infra::Duration::zero();
+        std::array<uint32_t, numberOfLatencyBuckets> latencyHistogram{};
+    };
+
+    struct FlashStatisticsSnapshot
+    {
+        FlashOperationStatistics read;
+        FlashOperationStatistics write;
+        FlashOperationStatistics erase;
+
+        // eraseCounts[i] holds the number of erasures of sectors [i * sectorsPerEraseCounter, (i + 1) * sectorsPerEraseCounter)
+        uint64_t sectorsPerEraseCounter = 1;
+        infra::MemoryRange<const uint32_t> eraseCounts;
+    };
+
+    template<class T>
+    class FlashStatisticsBase;
+
+    using FlashStatistics = FlashStatisticsBase<uint32_t>;
+    using FlashStatistics64 = FlashStatisticsBase<uint64_t>;
+
+    // FlashStatisticsBase decorates a flash with counters of operations, bytes read, programmed and erased, latency
+    // histograms, and erase counts per sector. When the flash has more sectors than there are erase counters, each
+    // counter covers a group of consecutive sectors.
+    template<class T>
+    class FlashStatisticsBase
+        : public hal::FlashBase<T>
+    {
+    public:
+        template<std::size_t EraseCounters>
+        using WithEraseCounters = infra::WithStorage<FlashStatisticsBase<T>, std::array<uint32_t, EraseCounters>>;
+
+        FlashStatisticsBase(infra::MemoryRange<uint32_t> eraseCounts, hal::FlashBase<T>& master, uint32_t timerServiceId = infra::systemTimerServiceId);
+
+        FlashStatisticsSnapshot Statistics() const;
+        void Reset();
+
+        virtual T NumberOfSectors() const override;
+        virtual uint32_t SizeOfSector(T sectorIndex) const override;
+        virtual T SectorOfAddress(T address) const override;
+        virtual T AddressOfSector(T sectorIndex) const override;
+        virtual void WriteBuffer(infra::ConstByteRange buffer, T address, infra::Function<void()> onDone) override;
+        virtual void ReadBuffer(infra::ByteRange buffer, T address, infra::Function<void()> onDone) override;
+        virtual void EraseSectors(T beginIndex, T endIndex, infra::Function<void()> onDone) override;
+
+    private:
+        void Start(FlashOperationStatistics& statistics, uint64_t bytes, const infra::Function<void()>& onDone);
+        void Done();
+        void CountErasures(T beginIndex, T endIndex);
+        T EndAddressOfSectors(T endIndex) const;
+
+    private:
+        infra::MemoryRange<uint32_t> eraseCounts;
+        hal::FlashBase<T>& master;
+        uint32_t timerServiceId;
+        T sectorsPerEraseCounter;
+
+        FlashOperationStatistics read;
+        FlashOperationStatistics write;
+        FlashOperationStatistics erase;
+
+        infra::AutoResetFunction<void()> onDone;
+        FlashOperationStatistics* current = nullptr;
+        uint64_t currentBytes = 0;
+        infra::TimePoint start;
+        T eraseBegin = 0;
+        T eraseEnd = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,631 @@
+#include "services/util/KeyValueStoreFlash.hpp"
+#include "infra/event/EventDispatcher.hpp"
+#include "infra/util/CrcCcittCalculator.hpp"
+#include "infra/util/ReallyAssert.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace services
+{
+    uint32_t KeyValueStoreFlash::RecordHeader::Key() const
+    {
+        return key[0] | (key[1] << 8) | (key[2] << 16) | (static_cast<uint32_t>(key[3]) << 24);
+    }
+
+    void KeyValueStoreFlash::RecordHeader::SetKey(uint32_t key)
+    {
+        this->key = { static_cast<uint8_t>(key), static_cast<uint8_t>(key >> 8), static_cast<uint8_t>(key >> 16), static_cast<uint8_t>(key >> 24) };
+    }
+
+    uint16_t KeyValueStoreFlash::RecordHeader::Length() const
+    {
+        return lengthLsb + static_cast<uint16_t>(lengthMsb << 8);
+    }
+
+    void KeyValueStoreFlash::RecordHeader::SetLength(uint16_t length)
+    {
+        lengthLsb = static_cast<uint8_t>(length);
+        lengthMsb = static_cast<uint8_t>(length >> 8);
+    }
+
+    uint16_t KeyValueStoreFlash::RecordHeader::Checksum() const
+    {
+        return checksumLsb + static_cast<uint16_t>(checksumMsb << 8);
+    }
+
+    void KeyValueStoreFlash::RecordHeader::SetChecksum(uint16_t checksum)
+    {
+        checksumLsb = static_cast<uint8_t>(checksum);
+        checksumMsb = static_cast<uint8_t>(checksum >> 8);
+    }
+
+    uint32_t KeyValueStoreFlash::IndexTraits::Hash(const IndexEntry& entry)
+    {
+        return KeyHash(entry.key);
+    }
+
+    bool KeyValueStoreFlash::IndexTraits::IsEmpty(const IndexEntry& entry)
+    {
+        return entry.address == emptyAddress;
+    }
+
+    KeyValueStoreFlash::IndexEntry KeyValueStoreFlash::IndexTraits::Empty()
+    {
+        return IndexEntry{ 0, emptyAddress, 0 };
+    }
+
+    KeyValueStoreFlash::KeyValueStoreFlash(infra::MemoryRange<IndexEntry> indexSlots, infra::ByteRange recordBuffer, hal::Flash& flash)
+        : index(indexSlots)
+        , maxKeys(indexSlots.size() / 2)
+        , recordBuffer(recordBuffer)
+        , flash(flash)
+        , claimerWrite(resource)
+        , claimerRemove(resource)
+        , claimerRead(resource)
+        , claimerGarbageCollect(resource)
+        , claimerRecover(resource)
+    {
+        assert(flash.NumberOfSectors() >= 3);
+        assert(recordBuffer.size() > recordHeaderSize);
+        assert(indexSlots.size() >= 2);
+
+        Recover();
+    }
+
+    void KeyValueStoreFlash::Write(uint32_t key, infra::ConstByteRange value, const infra::Function<void(bool success)>& onDone)
+    {
+        assert(value.size() <= MaxValueSize());
+
+        onWriteDone = onDone;
+        claimerWrite.Claim([this, key, value]()
+            { WriteClaimed(RecordStatus::value, key, value); });
+    }
+
+    void KeyValueStoreFlash::Remove(uint32_t key, const infra::Function<void()>& onDone)
+    {
+        onRemoveDone = onDone;
+        claimerRemove.Claim([this, key]()
+            { WriteClaimed(RecordStatus::removed, key, infra::ConstByteRange()); });
+    }
+
+    void KeyValueStoreFlash::Read(uint32_t key, infra::ByteRange buffer, const infra::Function<void(infra::ByteRange result)>& onDone)
+    {
+        onReadDone = onDone;
+        claimerRead.Claim([this, key, buffer]()
+            { ReadClaimed(key, buffer); });
+    }
+
+    bool KeyValueStoreFlash::Contains(uint32_t key) const
+    {
+        return Find(key) != nullptr;
+    }
+
+    std::size_t KeyValueStoreFlash::ValueSize(uint32_t key) const
+    {
+        auto entry = Find(key);
+
+        if (entry != nullptr)
+            return entry->length;
+        else
+            return 0;
+    }
+
+    std::size_t KeyValueStoreFlash::MaxValueSize() const
+    {
+        return std::min<std::size_t>(recordBuffer.size(), SectorPayloadSize() / 2) - recordHeaderSize;
+    }
+
+    uint32_t KeyValueStoreFlash::Capacity() const
+    {
+        // Since a record occupies at most half of a sector, each full sector is filled for more than half with records.
+        // When live records are limited to half of all sectors but two, compaction therefore always ends with two
+        // empty sectors: one to write to, and one reserved for garbage collection.
+        return (flash.NumberOfSectors() - 2) * (SectorPayloadSize() / 2);
+    }
+
+    bool KeyValueStoreFlash::GarbageCollecting() const
+    {
+        return garbageCollecting;
+    }
+
+    void KeyValueStoreFlash::WriteClaimed(RecordStatus status, uint32_t key, infra::ConstByteRange value)
+    {
+        auto& claimer = status == RecordStatus::value ? claimerWrite : claimerRemove;
+
+        if (status == RecordStatus::removed && !Contains(key))
+        {
+            claimer.Release();
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { onRemoveDone(); });
+            return;
+        }
+
+        if (status == RecordStatus::value && !FitsInStore(key, value.size()))
+        {
+            claimer.Release();
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { onWriteDone(false); });
+            return;
+        }
+
+        if (!SpaceAvailable(recordHeaderSize + value.size()))
+        {
+            // The remaining space is needed by garbage collection; try again after garbage collection has progressed.
+            // Since live records never exceed Capacity(), garbage collection is guaranteed to free a sector.
+            really_assert(garbageCollecting);
+            claimer.Release();
+            claimer.Claim([this, status, key, value]()
+                { WriteClaimed(status, key, value); });
+            return;
+        }
+
+        auto& header = BufferedRecordHeader();
+        header.status = status;
+        header.SetKey(key);
+        header.SetLength(static_cast<uint16_t>(value.size()));
+        std::copy(value.begin(), value.end(), recordBuffer.begin() + recordHeaderSize);
+        header.SetChecksum(CalculateChecksum());
+        record = infra::Head(recordBuffer, recordHeaderSize + value.size());
+
+        assert(sequencer.Finished());
+        sequencer.Load([this]()
+            {
+            AppendRecord();
+            sequencer.Execute([this]() { WriteRecordDone(); }); });
+    }
+
+    void KeyValueStoreFlash::WriteRecordDone()
+    {
+        ApplyRecord(recordAddress);
+
+        if (BufferedRecordHeader().status == RecordStatus::value)
+        {
+            claimerWrite.Release();
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { onWriteDone(true); });
+        }
+        else
+        {
+            claimerRemove.Release();
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { onRemoveDone(); });
+        }
+    }
+
+    bool KeyValueStoreFlash::FitsInStore(uint32_t key, std::size_t size) const
+    {
+        auto entry = Find(key);
+
+        if (entry == nullptr)
+            return index.size() < maxKeys && liveSize + recordHeaderSize + size <= Capacity();
+        else
+            return liveSize - entry->length + size <= Capacity();
+    }
+
+    void KeyValueStoreFlash::ReadClaimed(uint32_t key, infra::ByteRange buffer)
+    {
+        auto entry = Find(key);
+
+        if (entry == nullptr)
+        {
+            readResult = infra::Head(buffer, 0);
+            claimerRead.Release();
+            infra::EventDispatcher::Instance().Schedule([this]()
+                { onReadDone(readResult); });
+        }
+        else
+        {
+            assert(buffer.size() >= entry->length);
+            readResult = infra::Head(buffer, entry->length);
+            flash.ReadBuffer(readResult, entry->address + recordHeaderSize, [this]()
+                {
+                claimerRead.Release();
+                onReadDone(readResult); });
+        }
+    }
+
+    void KeyValueStoreFlash::Recover()
+    {
+        claimerRecover.Claim([this]()
+            {
+            assert(sequencer.Finished());
+            sequencer.Load([this]()
+            {
+                sequencer.ForEach(sectorIndex, 0, flash.NumberOfSectors());
+                    FindHeadSector();
+                sequencer.EndForEach(sectorIndex);
+                sequencer.If([this]() { return headFound; });
+                    FindOldestSector();
+                sequencer.Else();
+                    sequencer.Execute([this]()
+                    {
+                        // Nothing is stored; the last sector acts as a full head, so that the first write opens sector 0
+                        headSector = flash.NumberOfSectors() - 1;
+                        headAddress = EndOfSector(headSector);
+                        headSequence = 0xffff;
+                        emptySectors = flash.NumberOfSectors();
+                    });
+                sequencer.EndIf();
+                sequencer.ForEach(sectorIndex, 0, emptySectors);
+                    EraseSectorIfNotBlank();
+                sequencer.EndForEach(sectorIndex);
+                sequencer.ForEach(sectorIndex, 0, flash.NumberOfSectors() - emptySectors);
+                    ReplaySector();
+                sequencer.EndForEach(sectorIndex);
+                sequencer.Execute([this]()
+                {
+                    claimerRecover.Release();
+
+                    if (emptySectors < 2)
+                        StartGarbageCollection();
+                });
+            }); });
+    }
+
+    void KeyValueStoreFlash::FindHeadSector()
+    {
+        sequencer.Step([this]()
+            { flash.ReadBuffer(infra::MakeByteRange(sectorHeader), flash.AddressOfSector(sectorIndex), [this]()
+                  { sequencer.Continue(); }); });
+        sequencer.Execute([this]()
+            {
+            if (sectorIndex == 0)
+                firstSectorHeader = sectorHeader;
+            else
+                ConsiderHeadCandidate(sectorIndex - 1, previousSectorHeader, sectorHeader);
+
+            if (sectorIndex == flash.NumberOfSectors() - 1)
+                ConsiderHeadCandidate(sectorIndex, sectorHeader, firstSectorHeader);
+
+            previousSectorHeader = sectorHeader; });
+    }
+
+    void KeyValueStoreFlash::FindOldestSector()
+    {
+        // Used sectors form a cyclic run of consecutive sequence numbers ending at the head
+        sequencer.Execute([this]()
+            {
+            emptySectors = flash.NumberOfSectors() - 1;
+            scanSector = headSector;
+            scanning = true; });
+        sequencer.While([this]()
+            { return scanning && emptySectors != 0; });
+            sequencer.Step([this]()
+                {
+                scanSector = PreviousSector(scanSector);
+                flash.ReadBuffer(infra::MakeByteRange(sectorHeader), flash.AddressOfSector(scanSector), [this]() { sequencer.Continue(); }); });
+            sequencer.Execute([this]()
+                {
+                if (sectorHeader.status == SectorStatus::used && sectorHeader.Sequence() == static_cast<uint16_t>(headSequence - (flash.NumberOfSectors() - emptySectors)))
+                    --emptySectors;
+                else
+                    scanning = false; });
+        sequencer.EndWhile();
+    }
+
+    void KeyValueStoreFlash::EraseSectorIfNotBlank()
+    {
+        // An interrupted erase leaves a sector that may look empty at first sight. Only the sector erased last can
+        // have been interrupted, so only that sector is checked completely; of other empty sectors only the header is checked.
+        sequencer.Execute([this]()
+            {
+            scanSector = (headSector + 1 + sectorIndex) % flash.NumberOfSectors();
+            scanAddress = flash.AddressOfSector(scanSector);
+            scanning = true;
+            blank = true; });
+        sequencer.While([this]()
+            { return scanning; });
+            sequencer.Step([this]()
+                {
+                bool erasedLast = headFound && sectorIndex + 1 == emptySectors;
+                readResult = infra::Head(recordBuffer, erasedLast ? std::min<std::size_t>(recordBuffer.size(), EndOfSector(scanSector) - scanAddress) : sizeof(SectorHeader));
+                flash.ReadBuffer(readResult, scanAddress, [this]() { sequencer.Continue(); }); });
+            sequencer.Execute([this]()
+                {
+                blank = std::all_of(readResult.begin(), readResult.end(), [](uint8_t byte) { return byte == 0xff; });
+                scanAddress += readResult.size();
+                scanning = blank && headFound && sectorIndex + 1 == emptySectors && scanAddress != EndOfSector(scanSector); });
+        sequencer.EndWhile();
+        sequencer.If([this]()
+            { return !blank; });
+            sequencer.Step([this]()
+                { flash.EraseSector(scanSector, [this]()
+                      { sequencer.Continue(); }); });
+        sequencer.EndIf();
+    }
+
+    void KeyValueStoreFlash::ReplaySector()
+    {
+        sequencer.Execute([this]()
+            {
+            scanSector = (OldestSector() + sectorIndex) % flash.NumberOfSectors();
+            scanAddress = flash.AddressOfSector(scanSector) + sizeof(SectorHeader);
+            scanning = true;
+            sealed = false; });
+        sequencer.While([this]()
+            { return scanning; });
+            ReplayRecord();
+        sequencer.EndWhile();
+        sequencer.Execute([this]()
+            {
+            // No records are appended after an invalid record, since its contents cannot be trusted
+            if (scanSector == headSector)
+                headAddress = sealed ? EndOfSector(headSector) : scanAddress; });
+    }
+
+    void KeyValueStoreFlash::ReplayRecord()
+    {
+        sequencer.If([this]()
+            { return scanAddress + recordHeaderSize <= EndOfSector(scanSector); });
+            sequencer.Step([this]()
+                { flash.ReadBuffer(infra::Head(recordBuffer, recordHeaderSize), scanAddress, [this]()
+                      { sequencer.Continue(); }); });
+            sequencer.If([this]()
+                { return BufferedRecordHeaderIsBlank(); });
+                sequencer.Execute([this]()
+                    { scanning = false; });
+            sequencer.ElseIf([this]()
+                {
+                auto& header = BufferedRecordHeader();
+                return (header.status == RecordStatus::value || header.status == RecordStatus::removed)
+                    && header.Length() <= recordBuffer.size() - recordHeaderSize
+                    && scanAddress + recordHeaderSize + header.Length() <= EndOfSector(scanSector); });
+                sequencer.Step([this]()
+                    { flash.ReadBuffer(infra::ByteRange(recordBuffer.begin() + recordHeaderSize, recordBuffer.begin() + recordHeaderSize + BufferedRecordHeader().Length()), scanAddress + recordHeaderSize, [this]()
+                          { sequencer.Continue(); }); });
+                sequencer.Execute([this]()
+                    {
+                    if (CalculateChecksum() == BufferedRecordHeader().Checksum())
+                    {
+                        ApplyRecord(scanAddress);
+                        scanAddress += recordHeaderSize + BufferedRecordHeader().Length();
+                    }
+                    else
+                    {
+                        sealed = true;
+                        scanning = false;
+                    } });
+            sequencer.Else();
+                sequencer.Execute([this]()
+                    {
+                    sealed = true;
+                    scanning = false; });
+            sequencer.EndIf();
+        sequencer.Else();
+            sequencer.Execute([this]()
+                { scanning = false; });
+        sequencer.EndIf();
+    }
+
+    void KeyValueStoreFlash::ApplyRecord(uint32_t address)
+    {
+        auto& header = BufferedRecordHeader();
+
+        if (header.status == RecordStatus::value)
+            AddOrUpdate(header.Key(), address, header.Length());
+        else
+            RemoveFromIndex(header.Key());
+    }
+
+    void KeyValueStoreFlash::StartGarbageCollection()
+    {
+        if (!garbageCollecting)
+        {
+            garbageCollecting = true;
+            collectAddress = flash.AddressOfSector(OldestSector()) + sizeof(SectorHeader);
+            claimerGarbageCollect.Claim([this]()
+                { CollectClaimed(); });
+        }
+    }
+
+    void KeyValueStoreFlash::CollectClaimed()
+    {
+        // Each claim copies one record, so that other operations are interleaved with garbage collection. Records that
+        // are not referenced by the index are dropped; this includes removal records, since the oldest sector holds no
+        // older records that they need to hide.
+        assert(sequencer.Finished());
+        sequencer.Load([this]()
+            {
+            sequencer.Execute([this]() { BufferedRecordHeader().status = RecordStatus::empty; });
+            sequencer.If([this]() { return collectAddress + recordHeaderSize <= EndOfSector(OldestSector()); });
+                sequencer.Step([this]()
+                {
+                    flash.ReadBuffer(infra::Head(recordBuffer, recordHeaderSize), collectAddress, [this]() { sequencer.Continue(); });
+                });
+            sequencer.EndIf();
+            sequencer.If([this]() { return BufferedRecordHeader().status != RecordStatus::empty; });
+                sequencer.If([this]()
+                {
+                    auto entry = Find(BufferedRecordHeader().Key());
+                    return BufferedRecordHeader().status == RecordStatus::value && entry != nullptr && entry->address == collectAddress;
+                });
+                    sequencer.Step([this]()
+                    {
+                        record = infra::Head(recordBuffer, recordHeaderSize + BufferedRecordHeader().Length());
+                        flash.ReadBuffer(infra::DiscardHead(infra::Head(recordBuffer, record.size()), recordHeaderSize), collectAddress + recordHeaderSize, [this]() { sequencer.Continue(); });
+                    });
+                    AppendRecord();
+                    sequencer.Execute([this]() { ApplyRecord(recordAddress); });
+                sequencer.EndIf();
+                sequencer.Execute([this]() { collectAddress += recordHeaderSize + BufferedRecordHeader().Length(); });
+            sequencer.Else();
+                sequencer.Step([this]()
+                {
+                    flash.EraseSector(OldestSector(), [this]() { sequencer.Continue(); });
+                });
+                sequencer.Execute([this]()
+                {
+                    ++emptySectors;
+                    collectAddress = flash.AddressOfSector(OldestSector()) + sizeof(SectorHeader);
+                });
+            sequencer.EndIf();
+            sequencer.Execute([this]()
+            {
+                claimerGarbageCollect.Release();
+
+                if (emptySectors < 2)
+                    claimerGarbageCollect.Claim([this]() { CollectClaimed(); });
+                else
+                    garbageCollecting = false;
+            }); });
+    }
+
+    void KeyValueStoreFlash::AppendRecord()
+    {
+        sequencer.If([this]()
+            { return !FitsInHeadSector(record.size()); });
+            OpenNextSector();
+        sequencer.EndIf();
+        sequencer.Step([this]()
+            {
+            recordAddress = headAddress;
+            headAddress += record.size();
+            flash.WriteBuffer(record, recordAddress, [this]() { sequencer.Continue(); }); });
+    }
+
+    void KeyValueStoreFlash::OpenNextSector()
+    {
+        sequencer.Step([this]()
+            {
+            assert(emptySectors != 0);
+
+            headSector = NextSector(headSector);
+            headAddress = flash.AddressOfSector(headSector) + sizeof(SectorHeader);
+            --emptySectors;
+            ++headSequence;
+
+            sectorHeader.status = SectorStatus::used;
+            sectorHeader.SetSequence(headSequence);
+            flash.WriteBuffer(infra::MakeByteRange(sectorHeader), flash.AddressOfSector(headSector), [this]() { sequencer.Continue(); }); });
+        sequencer.Execute([this]()
+            {
+            if (emptySectors < 2)
+                StartGarbageCollection(); });
+    }
+
+    bool KeyValueStoreFlash::FitsInHeadSector(std::size_t size) const
+    {
+        return headAddress + size <= EndOfSector(headSector);
+    }
+
+    bool KeyValueStoreFlash::SpaceAvailable(std::size_t size) const
+    {
+        // The last empty sector is reserved for garbage collection. Once garbage collection has taken it, the head
+        // sector is reserved as well, since it must hold the remaining live records of the sector being collected.
+        return emptySectors >= 2 || (emptySectors == 1 && FitsInHeadSector(size));
+    }
+
+    KeyValueStoreFlash::RecordHeader& KeyValueStoreFlash::BufferedRecordHeader() const
+    {
+        return reinterpret_cast<RecordHeader&>(*recordBuffer.begin());
+    }
+
+    uint16_t KeyValueStoreFlash::CalculateChecksum() const
+    {
+        auto& header = BufferedRecordHeader();
+
+        infra::CrcCcittCalculator crc;
+        crc.Update(infra::MakeByteRange(header.key));
+        crc.Update(infra::ConstByteRange(&header.lengthLsb, &header.lengthMsb + 1));
+        crc.Update(infra::ConstByteRange(recordBuffer.begin() + recordHeaderSize, recordBuffer.begin() + recordHeaderSize + header.Length()));
+        return crc.Result();
+    }
+
+    bool KeyValueStoreFlash::BufferedRecordHeaderIsBlank() const
+    {
+        auto header = infra::Head(recordBuffer, recordHeaderSize);
+        return std::all_of(header.begin(), header.end(), [](uint8_t byte)
+            { return byte == 0xff; });
+    }
+
+    void KeyValueStoreFlash::ConsiderHeadCandidate(uint32_t sector, const SectorHeader& header, const SectorHeader& next)
+    {
+        bool endOfRun = next.status != SectorStatus::used || next.Sequence() != static_cast<uint16_t>(header.Sequence() + 1);
+
+        if (header.status == SectorStatus::used && endOfRun && (!headFound || static_cast<int16_t>(header.Sequence() - headSequence) > 0))
+        {
+            headFound = true;
+            headSector = sector;
+            headSequence = header.Sequence();
+        }
+    }
+
+    uint32_t KeyValueStoreFlash::NextSector(uint32_t sector) const
+    {
+        ++sector;
+        if (sector == flash.NumberOfSectors())
+            sector = 0;
+
+        return sector;
+    }
+
+    uint32_t KeyValueStoreFlash::PreviousSector(uint32_t sector) const
+    {
+        if (sector == 0)
+            sector = flash.NumberOfSectors();
+
+        return sector - 1;
+    }
+
+    uint32_t KeyValueStoreFlash::OldestSector() const
+    {
+        return (headSector + 1 + emptySectors) % flash.NumberOfSectors();
+    }
+
+    uint32_t KeyValueStoreFlash::SectorPayloadSize() const
+    {
+        return flash.SizeOfSector(0) - sizeof(SectorHeader);
+    }
+
+    uint32_t KeyValueStoreFlash::EndOfSector(uint32_t sector) const
+    {
+        return flash.AddressOfSector(sector) + flash.SizeOfSector(sector);
+    }
+
+    KeyValueStoreFlash::IndexEntry* KeyValueStoreFlash::Find(uint32_t key)
+    {
+        return index.find(KeyHash(key), [key](const IndexEntry& entry)
+            { return entry.key == key; });
+    }
+
+    const KeyValueStoreFlash::IndexEntry* KeyValueStoreFlash::Find(uint32_t key) const
+    {
+        return index.find(KeyHash(key), [key](const IndexEntry& entry)
+            { return entry.key == key; });
+    }
+
+    void KeyValueStoreFlash::AddOrUpdate(uint32_t key, uint32_t address, uint16_t length)
+    {
+        auto entry = Find(key);
+
+        if (entry != nullptr)
+        {
+            liveSize -= recordHeaderSize + entry->length;
+            *entry = IndexEntry{ key, address, length };
+        }
+        else
+        {
+            really_assert(index.size() < maxKeys);
+            index.insert(IndexEntry{ key, address, length });
+        }
+
+        liveSize += recordHeaderSize + length;
+    }
+
+    void KeyValueStoreFlash::RemoveFromIndex(uint32_t key)
+    {
+        auto entry = Find(key);
+
+        if (entry != nullptr)
+        {
+            liveSize -= recordHeaderSize + entry->length;
+            index.erase(*entry);
+        }
+    }
+
+    uint32_t KeyValueStoreFlash::KeyHash(uint32_t key)
+    {
+        // Multiplicative hashing spreads consecutive keys over the index
+        return static_cast<uint32_t>(key * 2654435761u);
+    }
+}
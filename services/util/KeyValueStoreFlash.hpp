@@ -0,0 +1,206 @@
+#ifndef SERVICES_KEY_VALUE_STORE_FLASH_HPP
+#define SERVICES_KEY_VALUE_STORE_FLASH_HPP
+
+#include "hal/interfaces/Flash.hpp"
+#include "infra/event/ClaimableResource.hpp"
+#include "infra/util/AutoResetFunction.hpp"
+#include "infra/util/OpenAddressingIndex.hpp"
+#include "infra/util/Sequencer.hpp"
+#include "infra/util/WithStorage.hpp"
+#include <array>
+
+namespace services
+{
+    // KeyValueStoreFlash appends each written value as a record to flash, so that updating a small value costs a single
+    // program operation instead of an erase and rewrite of all data. A RAM index maps each key to the location of its
+    // latest record; it is rebuilt on construction by replaying all records.
+    //
+    // Sectors are filled one after the other, cyclically. When only one empty sector remains, the oldest sector is
+    // garbage collected in the background: its live records are copied to the head one by one, interleaved with other
+    // operations, after which the sector is erased. Since sectors are reused in order, wear is spread evenly.
+    //
+    // All sectors must be of equal size, and the flash must consist of at least three sectors. The total size of
+    // all live records may not exceed Capacity(), so that garbage collection always frees a sector; a write that would
+    // exceed it fails.
+    class KeyValueStoreFlash
+    {
+    public:
+        struct IndexEntry
+        {
+            uint32_t key;
+            uint32_t address;
+            uint16_t length;
+        };
+
+        static const std::size_t recordHeaderSize = 9;
+
+        // Entries are found through an open addressing index with twice as many slots as there are keys.
+        // The record buffer holds one complete record, so that it is programmed in one operation.
+        template<std::size_t MaxKeys, std::size_t MaxValueSize>
+        using WithStorage = infra::WithStorage<infra::WithStorage<KeyValueStoreFlash,
+                                                   std::array<IndexEntry, 2 * MaxKeys>>,
+            std::array<uint8_t, recordHeaderSize + MaxValueSize>>;
+
+        KeyValueStoreFlash(infra::MemoryRange<IndexEntry> indexSlots, infra::ByteRange recordBuffer, hal::Flash& flash);
+        KeyValueStoreFlash(const KeyValueStoreFlash& other) = delete;
+        KeyValueStoreFlash& operator=(const KeyValueStoreFlash& other) = delete;
+
+        // On completion, success is false when the value is not written because the store is full: either all keys are
+        // in use, or the value does not fit in Capacity()
+        void Write(uint32_t key, infra::ConstByteRange value, const infra::Function<void(bool success)>& onDone);
+        void Remove(uint32_t key, const infra::Function<void()>& onDone);
+        // On completion, result holds the value; it is empty when no value is stored for key
+        void Read(uint32_t key, infra::ByteRange buffer, const infra::Function<void(infra::ByteRange result)>& onDone);
+
+        bool Contains(uint32_t key) const;
+        std::size_t ValueSize(uint32_t key) const;
+        std::size_t MaxValueSize() const;
+        uint32_t Capacity() const;
+        bool GarbageCollecting() const;
+
+    private:
+        enum class SectorStatus : uint8_t
+        {
+            empty = 0xff,
+            used = 0xfe
+        };
+
+        enum class RecordStatus : uint8_t
+        {
+            empty = 0xff,
+            value = 0xfe,
+            removed = 0xfc
+        };
+
+        struct SectorHeader
+        {
+            SectorStatus status = SectorStatus::empty;
+            uint8_t sequenceLsb = 0xff;
+            uint8_t sequenceMsb = 0xff;
+
+            uint16_t Sequence() const
+            {
+                return sequenceLsb + static_cast<uint16_t>(sequenceMsb << 8);
+            }
+
+            void SetSequence(uint16_t sequence)
+            {
+                sequenceLsb = static_cast<uint8_t>(sequence);
+                sequenceMsb = static_cast<uint8_t>(sequence >> 8);
+            }
+        };
+
+        // The checksum covers key, length and value; it detects records of which programming was interrupted
+        struct RecordHeader
+        {
+            RecordStatus status = RecordStatus::empty;
+            std::array<uint8_t, 4> key;
+            uint8_t lengthLsb = 0;
+            uint8_t lengthMsb = 0;
+            uint8_t checksumLsb = 0;
+            uint8_t checksumMsb = 0;
+
+            uint32_t Key() const;
+            void SetKey(uint32_t key);
+            uint16_t Length() const;
+            void SetLength(uint16_t length);
+            uint16_t Checksum() const;
+            void SetChecksum(uint16_t checksum);
+        };
+
+        static_assert(sizeof(RecordHeader) == recordHeaderSize, "Record header must not contain padding");
+
+        struct IndexTraits
+        {
+            static uint32_t Hash(const IndexEntry& entry);
+            static bool IsEmpty(const IndexEntry& entry);
+            static IndexEntry Empty();
+        };
+
+    private:
+        void WriteClaimed(RecordStatus status, uint32_t key, infra::ConstByteRange value);
+        bool FitsInStore(uint32_t key, std::size_t size) const;
+        void WriteRecordDone();
+        void ReadClaimed(uint32_t key, infra::ByteRange buffer);
+
+        void Recover();
+        void FindHeadSector();
+        void FindOldestSector();
+        void EraseSectorIfNotBlank();
+        void ReplaySector();
+        void ReplayRecord();
+        void ApplyRecord(uint32_t address);
+
+        void StartGarbageCollection();
+        void CollectClaimed();
+
+        void AppendRecord();
+        void OpenNextSector();
+        bool FitsInHeadSector(std::size_t size) const;
+        bool SpaceAvailable(std::size_t size) const;
+
+        RecordHeader& BufferedRecordHeader() const;
+        uint16_t CalculateChecksum() const;
+        bool BufferedRecordHeaderIsBlank() const;
+        void ConsiderHeadCandidate(uint32_t sector, const SectorHeader& header, const SectorHeader& next);
+
+        uint32_t NextSector(uint32_t sector) const;
+        uint32_t PreviousSector(uint32_t sector) const;
+        uint32_t OldestSector() const;
+        uint32_t SectorPayloadSize() const;
+        uint32_t EndOfSector(uint32_t sector) const;
+
+        IndexEntry* Find(uint32_t key);
+        const IndexEntry* Find(uint32_t key) const;
+        void AddOrUpdate(uint32_t key, uint32_t address, uint16_t length);
+        void RemoveFromIndex(uint32_t key);
+
+        static uint32_t KeyHash(uint32_t key);
+
+    private:
+        static const uint32_t emptyAddress = 0xffffffff;
+
+        infra::OpenAddressingIndex<IndexEntry, IndexTraits> index;
+        std::size_t maxKeys;
+        infra::ByteRange recordBuffer;
+        hal::Flash& flash;
+
+        infra::Sequencer sequencer;
+        infra::ClaimableResource resource;
+        infra::ClaimableResource::Claimer::WithSize<4 * sizeof(void*)> claimerWrite;
+        infra::ClaimableResource::Claimer::WithSize<4 * sizeof(void*)> claimerRemove;
+        infra::ClaimableResource::Claimer::WithSize<4 * sizeof(void*)> claimerRead;
+        infra::ClaimableResource::Claimer::WithSize<4 * sizeof(void*)> claimerGarbageCollect;
+        infra::ClaimableResource::Claimer::WithSize<4 * sizeof(void*)> claimerRecover;
+        infra::AutoResetFunction<void(bool success)> onWriteDone;
+        infra::AutoResetFunction<void()> onRemoveDone;
+        infra::AutoResetFunction<void(infra::ByteRange result)> onReadDone;
+
+        uint32_t liveSize = 0;
+
+        uint32_t headSector = 0;
+        uint32_t headAddress = 0;
+        uint16_t headSequence = 0;
+        uint32_t emptySectors = 0;
+        bool headFound = false;
+
+        infra::ConstByteRange record;
+        uint32_t recordAddress = 0;
+        infra::ByteRange readResult;
+
+        bool garbageCollecting = false;
+        uint32_t collectAddress = 0;
+
+        uint32_t sectorIndex = 0;
+        SectorHeader sectorHeader;
+        SectorHeader previousSectorHeader;
+        SectorHeader firstSectorHeader;
+        uint32_t scanSector = 0;
+        uint32_t scanAddress = 0;
+        bool scanning = false;
+        bool blank = true;
+        bool sealed = false;
+    };
+}
+
+#endif
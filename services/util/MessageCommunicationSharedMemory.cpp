@@ -0,0 +1,176 @@
+#include "services/util/MessageCommunicationSharedMemory.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace services
+{
+    namespace detail
+    {
+        static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory requires lock-free atomics");
+
+        // Head and tail are placed in separate cache lines, so that producer and consumer do not contend on them
+        SharedMemoryRing::SharedMemoryRing(infra::ByteRange memory)
+            : head(*reinterpret_cast<std::atomic<uint32_t>*>(memory.begin()))
+            , tail(*reinterpret_cast<std::atomic<uint32_t>*>(memory.begin() + cacheLineSize))
+            , data(memory.begin() + 2 * cacheLineSize, memory.begin() + 2 * cacheLineSize + ((memory.size() - 2 * cacheLineSize) & ~std::size_t(1)))
+        {
+            assert(memory.size() > 2 * cacheLineSize + 8);
+            assert(reinterpret_cast<uintptr_t>(memory.begin()) % alignof(std::atomic<uint32_t>) == 0);
+        }
+
+        infra::Optional<infra::ByteRange> SharedMemoryRing::Reserve(std::size_t size)
+        {
+            assert(size <= MaxMessageSize());
+
+            auto recordSize = RecordSize(size);
+            auto h = head.load(std::memory_order_relaxed);
+            auto t = tail.load(std::memory_order_acquire);
+
+            // Two bytes are always kept free, so that a full ring is distinguished from an empty one
+            if (h >= t && recordSize <= data.size() - h - (t == 0 ? sizeof(uint16_t) : 0))
+                reserved = h;
+            else if (h >= t && recordSize + sizeof(uint16_t) <= t)
+            {
+                SetLengthAt(h, wrapMarker);
+                reserved = 0;
+            }
+            else if (h < t && recordSize + sizeof(uint16_t) <= t - h)
+                reserved = h;
+            else
+                return infra::none;
+
+            return infra::MakeOptional(infra::ByteRange(data.begin() + reserved + sizeof(uint16_t), data.begin() + reserved + sizeof(uint16_t) + size));
+        }
+
+        void SharedMemoryRing::Commit(std::size_t size)
+        {
+            SetLengthAt(reserved, static_cast<uint16_t>(size));
+            head.store(Advance(reserved, RecordSize(size)), std::memory_order_release);
+        }
+
+        infra::Optional<infra::ConstByteRange> SharedMemoryRing::Peek()
+        {
+            auto t = tail.load(std::memory_order_relaxed);
+            auto h = head.load(std::memory_order_acquire);
+
+            if (t != h && LengthAt(t) == wrapMarker)
+            {
+                t = 0;
+                tail.store(t, std::memory_order_release);
+            }
+
+            if (t == h)
+                return infra::none;
+
+            return infra::MakeOptional(infra::ConstByteRange(data.begin() + t + sizeof(uint16_t), data.begin() + t + sizeof(uint16_t) + LengthAt(t)));
+        }
+
+        void SharedMemoryRing::Pop()
+        {
+            auto t = tail.load(std::memory_order_relaxed);
+            tail.store(Advance(t, RecordSize(LengthAt(t))), std::memory_order_release);
+        }
+
+        std::size_t SharedMemoryRing::MaxMessageSize() const
+        {
+            // Whatever the position of an empty ring, either the space up to the end or the space from the start
+            // holds a record of half the ring
+            auto maxRecordSize = ((data.size() - sizeof(uint16_t)) / 2) & ~std::size_t(1);
+            return std::min<std::size_t>(maxRecordSize - sizeof(uint16_t), wrapMarker - 1);
+        }
+
+        std::size_t SharedMemoryRing::RecordSize(std::size_t size)
+        {
+            return (sizeof(uint16_t) + size + 1) & ~std::size_t(1);
+        }
+
+        uint16_t SharedMemoryRing::LengthAt(uint32_t position) const
+        {
+            uint16_t result;
+            std::memcpy(&result, data.begin() + position, sizeof(result));
+            return result;
+        }
+
+        void SharedMemoryRing::SetLengthAt(uint32_t position, uint16_t length)
+        {
+            std::memcpy(data.begin() + position, &length, sizeof(length));
+        }
+
+        uint32_t SharedMemoryRing::Advance(uint32_t position, std::size_t size) const
+        {
+            position += static_cast<uint32_t>(size);
+
+            if (position == data.size())
+                return 0;
+            else
+                return position;
+        }
+    }
+
+    MessageCommunicationSharedMemory::MessageCommunicationSharedMemory(infra::ByteRange sendMemory, infra::ByteRange receiveMemory)
+        : sendRing(sendMemory)
+        , receiveRing(receiveMemory)
+    {}
+
+    void MessageCommunicationSharedMemory::Poll()
+    {
+        TrySend();
+        TryReceive();
+    }
+
+    void MessageCommunicationSharedMemory::RequestSendMessage(uint16_t size)
+    {
+        assert(requestedSendSize == infra::none);
+        requestedSendSize = size;
+        TrySend();
+    }
+
+    std::size_t MessageCommunicationSharedMemory::MaxSendMessageSize() const
+    {
+        return sendRing.MaxMessageSize();
+    }
+
+    void MessageCommunicationSharedMemory::TrySend()
+    {
+        if (requestedSendSize != infra::none && sendWriter.Allocatable() && HasObserver())
+        {
+            auto range = sendRing.Reserve(*requestedSendSize);
+
+            if (range != infra::none)
+            {
+                requestedSendSize = infra::none;
+                GetObserver().SendMessageStreamAvailable(sendWriter.Emplace(sendRing, *range));
+            }
+        }
+    }
+
+    void MessageCommunicationSharedMemory::TryReceive()
+    {
+        if (receiving)
+            return;
+
+        receiving = true;
+
+        while (HasObserver() && receiveReader.Allocatable())
+        {
+            auto message = receiveRing.Peek();
+            if (message == infra::none)
+                break;
+
+            GetObserver().ReceivedMessage(receiveReader.Emplace(*message));
+        }
+
+        receiving = false;
+    }
+
+    MessageCommunicationSharedMemory::SendWriter::SendWriter(detail::SharedMemoryRing& ring, infra::ByteRange range)
+        : infra::ByteOutputStreamWriter(range)
+        , ring(ring)
+    {}
+
+    MessageCommunicationSharedMemory::SendWriter::~SendWriter()
+    {
+        ring.Commit(Processed().size());
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef SERVICES_MESSAGE_COMMUNICATION_SHARED_MEMORY_HPP
+#define SERVICES_MESSAGE_COMMUNICATION_SHARED_MEMORY_HPP
+
+#include "infra/stream/ByteInputStream.hpp"
+#include "infra/stream/ByteOutputStream.hpp"
+#include "infra/util/Optional.hpp"
+#include "infra/util/SharedOptional.hpp"
+#include "services/util/MessageCommunication.hpp"
+#include <atomic>
+
+namespace services
+{
+    namespace detail
+    {
+        // Single-producer single-consumer ring of length-prefixed messages. The ring keeps offsets instead of pointers,
+        // so that producer and consumer may map its memory at different addresses, for example in different processes.
+        // The memory must be zero-initialized before either side uses the ring.
+        class SharedMemoryRing
+        {
+        public:
+            explicit SharedMemoryRing(infra::ByteRange memory);
+
+            // Producer side
+            infra::Optional<infra::ByteRange> Reserve(std::size_t size);
+            void Commit(std::size_t size);
+
+            // Consumer side
+            infra::Optional<infra::ConstByteRange> Peek();
+            void Pop();
+
+            std::size_t MaxMessageSize() const;
+
+        private:
+            static constexpr std::size_t cacheLineSize = 64;
+            static constexpr uint16_t wrapMarker = 0xffff;
+
+            static std::size_t RecordSize(std::size_t size);
+            uint16_t LengthAt(uint32_t position) const;
+            void SetLengthAt(uint32_t position, uint16_t length);
+            uint32_t Advance(uint32_t position, std::size_t size) const;
+
+        private:
+            std::atomic<uint32_t>& head;
+            std::atomic<uint32_t>& tail;
+            infra::ByteRange data;
+            uint32_t reserved = 0;
+        };
+    }
+
+    // MessageCommunication between two parties that share memory, e.g. two subsystems in one process or two processes
+    // that map the same shared memory object. Each party sends through one ring and receives through the other, so the
+    // peer constructs its MessageCommunicationSharedMemory with sendMemory and receiveMemory swapped.
+    // Messages are written into and read from the shared memory directly, without intermediate copies.
+    class MessageCommunicationSharedMemory
+        : public MessageCommunication
+    {
+    public:
+        MessageCommunicationSharedMemory(infra::ByteRange sendMemory, infra::ByteRange receiveMemory);
+
+        // The peer does not notify of its actions; Poll checks for newly received messages and for space freed by
+        // the peer. Invoke it when the peer may have acted, e.g. periodically or whenever the event loop is idle.
+        void Poll();
+
+        // Implementation of MessageCommunication
+        virtual void RequestSendMessage(uint16_t size) override;
+        virtual std::size_t MaxSendMessageSize() const override;
+
+    private:
+        void TrySend();
+        void TryReceive();
+
+    private:
+        class SendWriter
+            : public infra::ByteOutputStreamWriter
+        {
+        public:
+            SendWriter(detail::SharedMemoryRing& ring, infra::ByteRange range);
+            SendWriter(const SendWriter& other) = delete;
+            SendWriter& operator=(const SendWriter& other) = delete;
+            ~SendWriter();
+
+        private:
+            detail::SharedMemoryRing& ring;
+        };
+
+    private:
+        detail::SharedMemoryRing sendRing;
+        detail::SharedMemoryRing receiveRing;
+        infra::Optional<uint16_t> requestedSendSize;
+        bool receiving = false;
+
+        infra::NotifyingSharedOptional<SendWriter> sendWriter{ [this]()
+            {
+                TrySend();
+            } };
+        infra::NotifyingSharedOptional<infra::ByteInputStreamReader> receiveReader{ [this]()
+            {
+                receiveRing.Pop();
+                TryReceive();
+            } };
+    };
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include "services/util/Sha256.hpp"
+#include "infra/util/ReallyAssert.hpp"
+
+namespace services
+{
+    void Sha256::Init()
+    {
+        incrementalInput = infra::ConstByteRange();
+    }
+
+    void Sha256::Update(infra::ConstByteRange input)
+    {
+        if (incrementalInput.empty())
+            incrementalInput = input;
+        else
+        {
+            really_assert(input.begin() == incrementalInput.end());
+            incrementalInput = infra::ConstByteRange(incrementalInput.begin(), input.end());
+        }
+    }
+
+    Sha256::Digest Sha256::Final()
+    {
+        return Calculate(incrementalInput);
+    }
+}
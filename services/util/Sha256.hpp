@@ -16,6 +16,17 @@ namespace services
         using Digest = std::array<uint8_t, 32>;
 
         virtual Digest Calculate(infra::ConstByteRange input) const = 0;
+
+        // Incremental hashing of input that is not available in one piece, e.g. because it is read from flash in
+        // blocks: Init starts a new digest, Update adds input, and Final returns the digest of all input since Init.
+        // The default implementation requires successive inputs to be adjacent in memory, and hashes them with
+        // Calculate in Final.
+        virtual void Init();
+        virtual void Update(infra::ConstByteRange input);
+        virtual Digest Final();
+
+    private:
+        infra::ConstByteRange incrementalInput;
     };
 }
 
@@ -3,13 +3,38 @@
 #include "mbedtls/sha256.h"
 #include "mbedtls/version.h"
 #include <cassert>
+#include <new>
 
 #if MBEDTLS_VERSION_MAJOR < 3
 #define mbedtls_sha256 mbedtls_sha256_ret
+#define mbedtls_sha256_starts mbedtls_sha256_starts_ret
+#define mbedtls_sha256_update mbedtls_sha256_update_ret
+#define mbedtls_sha256_finish mbedtls_sha256_finish_ret
 #endif
 
 namespace services
 {
+    namespace
+    {
+        mbedtls_sha256_context& Context(void* storage)
+        {
+            return *static_cast<mbedtls_sha256_context*>(storage);
+        }
+    }
+
+    Sha256MbedTls::Sha256MbedTls()
+    {
+        static_assert(sizeof(mbedtls_sha256_context) <= sizeof(context), "Storage too small for mbedtls_sha256_context");
+        static_assert(alignof(mbedtls_sha256_context) <= alignof(decltype(context)), "Storage not aligned for mbedtls_sha256_context");
+
+        mbedtls_sha256_init(new (&context) mbedtls_sha256_context);
+    }
+
+    Sha256MbedTls::~Sha256MbedTls()
+    {
+        mbedtls_sha256_free(&Context(&context));
+    }
+
     std::array<uint8_t, 32> Sha256MbedTls::Calculate(infra::ConstByteRange input) const
     {
         std::array<uint8_t, 32> output;
@@ -19,4 +44,26 @@ namespace services
 
         return output;
     }
+
+    void Sha256MbedTls::Init()
+    {
+        EMIL_MAYBE_UNUSED auto result = mbedtls_sha256_starts(&Context(&context), 0);
+        assert(result == 0);
+    }
+
+    void Sha256MbedTls::Update(infra::ConstByteRange input)
+    {
+        EMIL_MAYBE_UNUSED auto result = mbedtls_sha256_update(&Context(&context), input.begin(), input.size());
+        assert(result == 0);
+    }
+
+    std::array<uint8_t, 32> Sha256MbedTls::Final()
+    {
+        std::array<uint8_t, 32> output;
+
+        EMIL_MAYBE_UNUSED auto result = mbedtls_sha256_finish(&Context(&context), output.data());
+        assert(result == 0);
+
+        return output;
+    }
 }
@@ -2,6 +2,7 @@
 #define SERVICES_SHA256_MBEDTLS_HPP
 
 #include "services/util/Sha256.hpp"
+#include <type_traits>
 
 namespace services
 {
@@ -9,7 +10,18 @@ namespace services
         : public Sha256
     {
     public:
+        Sha256MbedTls();
+        ~Sha256MbedTls();
+
         std::array<uint8_t, 32> Calculate(infra::ConstByteRange input) const override;
+
+        void Init() override;
+        void Update(infra::ConstByteRange input) override;
+        std::array<uint8_t, 32> Final() override;
+
+    private:
+        // Holds an mbedtls_sha256_context, so that users of this class do not depend on the mbedtls headers
+        std::aligned_storage<128, alignof(uint64_t)>::type context;
     };
 }
 
@@ -7,6 +7,7 @@
 #include "services/util/ConfigurationStore.hpp"
 #include "services/util/Sha256MbedTls.hpp"
 #include "gmock/gmock.h"
+#include <map>
 
 namespace
 {
@@ -20,6 +21,30 @@ namespace
         static const uint32_t maxMessageSize = 16;
     };
 
+    class Sha256Mock
+        : public services::Sha256
+    {
+    public:
+        MOCK_CONST_METHOD1(Calculate, Digest(infra::ConstByteRange input));
+        MOCK_METHOD0(Init, void());
+        MOCK_METHOD1(Update, void(infra::ConstByteRange input));
+        MOCK_METHOD0(Final, Digest());
+    };
+
+    // Only implements Calculate, so incremental hashing uses the default implementation of Sha256
+    class Sha256CalculateOnly
+        : public services::Sha256
+    {
+    public:
+        virtual Digest Calculate(infra::ConstByteRange input) const override
+        {
+            return sha256.Calculate(input);
+        }
+
+    private:
+        services::Sha256MbedTls sha256;
+    };
+
     struct DataProxy
     {
         void Serialize(infra::ProtoFormatter& formatter)
@@ -48,18 +73,29 @@ public:
 
     MOCK_METHOD1(OnLoaded, void(bool success));
 
-    void RecoverFromFlash()
+    void RecoverHeader(const std::array<uint8_t, 8>& hash, uint32_t size)
     {
         EXPECT_CALL(flash, ReadBuffer(testing::_, 0, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
         configurationBlob.Recover([this](bool success)
             { OnLoaded(success); });
 
+        EXPECT_EQ(12, buffer.size());
         infra::ByteOutputStream stream(buffer);
-        std::array<uint8_t, 8> hash = { 0x21, 0xcc, 0xca, 0x8b, 0xe7, 0x6b, 0x58, 0x7f };
-        uint32_t size = 8;
-        std::array<uint8_t, 8> data = { 0, 1, 2, 3, 4, 5, 6, 7 };
+        stream << hash << size;
+    }
 
-        stream << hash << size << data;
+    void RecoverData(const std::array<uint8_t, 8>& data)
+    {
+        EXPECT_CALL(flash, ReadBuffer(testing::_, 12, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
+        onReadDone();
+
+        infra::Copy(data, buffer);
+    }
+
+    void RecoverFromFlash()
+    {
+        RecoverHeader({ 0x21, 0xcc, 0xca, 0x8b, 0xe7, 0x6b, 0x58, 0x7f }, 8);
+        RecoverData({ 0, 1, 2, 3, 4, 5, 6, 7 });
 
         EXPECT_CALL(*this, OnLoaded(true));
         onReadDone();
@@ -82,7 +118,7 @@ TEST_F(ConfigurationBlobTest, fail_to_recover_from_empty_flash)
     configurationBlob.Recover([this](bool success)
         { OnLoaded(success); });
 
-    EXPECT_EQ(20, buffer.size());
+    EXPECT_EQ(12, buffer.size());
     std::fill(buffer.begin(), buffer.end(), 0xff);
 
     EXPECT_CALL(*this, OnLoaded(false));
@@ -91,14 +127,7 @@ TEST_F(ConfigurationBlobTest, fail_to_recover_from_empty_flash)
 
 TEST_F(ConfigurationBlobTest, fail_to_recover_when_size_is_too_big)
 {
-    EXPECT_CALL(flash, ReadBuffer(testing::_, 0, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
-    configurationBlob.Recover([this](bool success)
-        { OnLoaded(success); });
-
-    infra::ByteOutputStream stream(buffer);
-    std::array<uint8_t, 8> hash = {};
-    uint32_t size = 9;
-    stream << hash << size;
+    RecoverHeader({}, 9);
 
     EXPECT_CALL(*this, OnLoaded(false));
     onReadDone();
@@ -106,15 +135,8 @@ TEST_F(ConfigurationBlobTest, fail_to_recover_when_size_is_too_big)
 
 TEST_F(ConfigurationBlobTest, fail_to_recover_when_hash_is_incorrect)
 {
-    EXPECT_CALL(flash, ReadBuffer(testing::_, 0, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
-    configurationBlob.Recover([this](bool success)
-        { OnLoaded(success); });
-
-    infra::ByteOutputStream stream(buffer);
-    std::array<uint8_t, 8> hash = {};
-    uint32_t size = 8;
-    std::array<uint8_t, 8> data = { 0, 1, 2, 3, 4, 5, 6, 7 };
-    stream << hash << size << data;
+    RecoverHeader({}, 8);
+    RecoverData({ 0, 1, 2, 3, 4, 5, 6, 7 });
 
     EXPECT_CALL(*this, OnLoaded(false));
     onReadDone();
@@ -122,20 +144,117 @@ TEST_F(ConfigurationBlobTest, fail_to_recover_when_hash_is_incorrect)
 
 TEST_F(ConfigurationBlobTest, recover_from_flash)
 {
-    EXPECT_CALL(flash, ReadBuffer(testing::_, 0, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
-    configurationBlob.Recover([this](bool success)
-        { OnLoaded(success); });
+    RecoverFromFlash();
 
-    infra::ByteOutputStream stream(buffer);
-    std::array<uint8_t, 8> hash = { 0x21, 0xcc, 0xca, 0x8b, 0xe7, 0x6b, 0x58, 0x7f };
-    uint32_t size = 8;
-    std::array<uint8_t, 8> data = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    EXPECT_EQ((std::array<uint8_t, 8>{ 0, 1, 2, 3, 4, 5, 6, 7 }), configurationBlob.CurrentBlob());
+}
 
-    stream << hash << size << data;
+TEST_F(ConfigurationBlobTest, recover_empty_blob_without_reading_data)
+{
+    RecoverHeader({ 0xdf, 0x3f, 0x61, 0x98, 0x04, 0xa9, 0x2f, 0xdb }, 0);
 
     EXPECT_CALL(*this, OnLoaded(true));
     onReadDone();
 
+    EXPECT_TRUE(configurationBlob.CurrentBlob().empty());
+}
+
+TEST(ConfigurationBlobRecoveryTest, recover_hashes_block_while_reading_next_block)
+{
+    testing::StrictMock<hal::CleanFlashMock> flash(1, 32);
+    testing::StrictMock<Sha256Mock> sha256;
+    services::ConfigurationBlobFlash::WithStorage<20, 8> configurationBlob(flash, sha256);
+    infra::VerifyingFunctionMock<void(bool)> onRecovered(true);
+
+    std::array<uint8_t, 8> hash = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::array<uint8_t, 20> data = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+    infra::ByteRange buffer;
+    infra::Function<void()> onReadDone;
+
+    EXPECT_CALL(flash, ReadBuffer(testing::_, 0, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
+    configurationBlob.Recover(onRecovered);
+    infra::ByteOutputStream stream(buffer);
+    stream << hash << uint32_t(20);
+
+    {
+        testing::InSequence sequence;
+        EXPECT_CALL(sha256, Init());
+        EXPECT_CALL(sha256, Update(infra::CheckByteRangeContents(std::vector<uint8_t>{ 20, 0, 0, 0 })));
+        EXPECT_CALL(flash, ReadBuffer(testing::_, 12, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
+    }
+    onReadDone();
+    EXPECT_EQ(8, buffer.size());
+    infra::Copy(infra::Head(infra::MakeRange(data), 8), buffer);
+
+    {
+        testing::InSequence sequence;
+        EXPECT_CALL(flash, ReadBuffer(testing::_, 20, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
+        EXPECT_CALL(sha256, Update(infra::CheckByteRangeContents(infra::Head(infra::MakeRange(data), 8))));
+    }
+    onReadDone();
+    EXPECT_EQ(8, buffer.size());
+    infra::Copy(infra::Head(infra::DiscardHead(infra::MakeRange(data), 8), 8), buffer);
+
+    {
+        testing::InSequence sequence;
+        EXPECT_CALL(flash, ReadBuffer(testing::_, 28, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&buffer), testing::SaveArg<2>(&onReadDone)));
+        EXPECT_CALL(sha256, Update(infra::CheckByteRangeContents(infra::Head(infra::DiscardHead(infra::MakeRange(data), 8), 8))));
+    }
+    onReadDone();
+    EXPECT_EQ(4, buffer.size());
+    infra::Copy(infra::DiscardHead(infra::MakeRange(data), 16), buffer);
+
+    services::Sha256::Digest digest{};
+    infra::Copy(hash, infra::Head(infra::MakeRange(digest), 8));
+    {
+        testing::InSequence sequence;
+        EXPECT_CALL(sha256, Update(infra::CheckByteRangeContents(infra::DiscardHead(infra::MakeRange(data), 16))));
+        EXPECT_CALL(sha256, Final()).WillOnce(testing::Return(digest));
+    }
+    onReadDone();
+
+    EXPECT_EQ(data, configurationBlob.CurrentBlob());
+}
+
+TEST(ConfigurationBlobRecoveryTest, recover_from_flash_that_completes_synchronously)
+{
+    testing::StrictMock<hal::CleanFlashMock> flash(1, 32);
+    services::Sha256MbedTls sha256;
+    services::ConfigurationBlobFlash::WithStorage<20, 8> configurationBlob(flash, sha256);
+
+    std::array<uint8_t, 20> data = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+    std::vector<uint8_t> contents = { 0xd5, 0x7c, 0xc0, 0x01, 0x13, 0xaf, 0x2e, 0xaf, 20, 0, 0, 0 };
+    contents.insert(contents.end(), data.begin(), data.end());
+
+    EXPECT_CALL(flash, ReadBuffer(testing::_, testing::_, testing::_)).Times(4).WillRepeatedly(testing::Invoke([&contents](infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+        {
+        infra::Copy(infra::Head(infra::DiscardHead(infra::MakeRange(contents), address), buffer.size()), buffer);
+        onDone(); }));
+
+    infra::VerifyingFunctionMock<void(bool)> onRecovered(true);
+    configurationBlob.Recover(onRecovered);
+
+    EXPECT_EQ(data, configurationBlob.CurrentBlob());
+}
+
+TEST(ConfigurationBlobRecoveryTest, recover_with_sha256_that_only_calculates)
+{
+    testing::StrictMock<hal::CleanFlashMock> flash(1, 32);
+    Sha256CalculateOnly sha256;
+    services::ConfigurationBlobFlash::WithStorage<20, 8> configurationBlob(flash, sha256);
+
+    std::array<uint8_t, 20> data = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+    std::vector<uint8_t> contents = { 0xd5, 0x7c, 0xc0, 0x01, 0x13, 0xaf, 0x2e, 0xaf, 20, 0, 0, 0 };
+    contents.insert(contents.end(), data.begin(), data.end());
+
+    EXPECT_CALL(flash, ReadBuffer(testing::_, testing::_, testing::_)).Times(4).WillRepeatedly(testing::Invoke([&contents](infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone)
+        {
+        infra::Copy(infra::Head(infra::DiscardHead(infra::MakeRange(contents), address), buffer.size()), buffer);
+        onDone(); }));
+
+    infra::VerifyingFunctionMock<void(bool)> onRecovered(true);
+    configurationBlob.Recover(onRecovered);
+
     EXPECT_EQ(data, configurationBlob.CurrentBlob());
 }
 
@@ -176,6 +295,40 @@ TEST_F(ConfigurationBlobTest, Write_writes_to_flash)
     onWriteDone();
 }
 
+TEST_F(ConfigurationBlobTest, Write_reads_next_verification_block_while_comparing_previous_block)
+{
+    RecoverFromFlash();
+
+    std::array<uint8_t, 8> data = { 1, 2, 3, 4, 5, 6, 7, 0 };
+    infra::Copy(data, configurationBlob.MaxBlob());
+
+    infra::ConstByteRange writeBuffer;
+    EXPECT_CALL(flash, WriteBuffer(testing::_, 0, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&writeBuffer), testing::SaveArg<2>(&onWriteDone)));
+    infra::VerifyingFunctionMock<void()> writeDone;
+    configurationBlob.Write(8, writeDone);
+
+    std::vector<uint8_t> written(writeBuffer.begin(), writeBuffer.end());
+    infra::ByteRange readBuffer;
+    infra::Function<void()> onReadDone;
+
+    EXPECT_CALL(flash, ReadBuffer(testing::_, 0, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&readBuffer), testing::SaveArg<2>(&onReadDone)));
+    onWriteDone();
+    infra::Copy(infra::Head(infra::MakeRange(written), 8), readBuffer);
+    auto firstBlock = readBuffer;
+
+    EXPECT_CALL(flash, ReadBuffer(testing::_, 8, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&readBuffer), testing::SaveArg<2>(&onReadDone)));
+    onReadDone();
+    EXPECT_NE(firstBlock.begin(), readBuffer.begin());
+    infra::Copy(infra::Head(infra::DiscardHead(infra::MakeRange(written), 8), 8), readBuffer);
+
+    EXPECT_CALL(flash, ReadBuffer(testing::_, 16, testing::_)).WillOnce(testing::DoAll(testing::SaveArg<0>(&readBuffer), testing::SaveArg<2>(&onReadDone)));
+    onReadDone();
+    EXPECT_EQ(4, readBuffer.size());
+    infra::Copy(infra::DiscardHead(infra::MakeRange(written), 16), readBuffer);
+
+    onReadDone();
+}
+
 TEST_F(ConfigurationBlobTest, Erase_erases_flash)
 {
     EXPECT_CALL(flash, EraseSectors(0, 1, testing::_)).WillOnce(testing::SaveArg<2>(&onEraseDone));
@@ -1012,3 +1165,217 @@ TEST_F(FactoryDefaultConfigurationStoreReadOnlyMemoryIntegrationTest, factory_de
                   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }),
         flashBlob2.sectors[0]);
 }
+
+class ConfigurationBlobJournalFlashTest
+    : public testing::Test
+    , public infra::EventDispatcherFixture
+{
+public:
+    ConfigurationBlobJournalFlashTest()
+    {
+        EXPECT_FALSE(Recover());
+    }
+
+    bool Recover()
+    {
+        bool result = false;
+
+        configurationBlob.Emplace(flashFirst, flashSecond, sha256);
+        configurationBlob->Recover([&result](bool success)
+            { result = success; });
+        ExecuteAllActions();
+
+        return result;
+    }
+
+    void Write(const std::map<uint32_t, uint32_t>& fields)
+    {
+        infra::ByteOutputStream stream(configurationBlob->MaxBlob());
+        infra::ProtoFormatter formatter(stream);
+        for (auto& field : fields)
+            formatter.PutVarIntField(field.second, field.first);
+
+        infra::VerifyingFunctionMock<void()> done;
+        configurationBlob->Write(stream.Writer().Processed().size(), [&done]()
+            { done.callback(); });
+        ExecuteAllActions();
+    }
+
+    std::map<uint32_t, uint32_t> Fields()
+    {
+        std::map<uint32_t, uint32_t> result;
+
+        infra::ByteInputStream stream(configurationBlob->CurrentBlob());
+        infra::ProtoParser parser(stream);
+        while (!parser.Empty())
+        {
+            auto field = parser.GetField();
+            result[field.second] = static_cast<uint32_t>(field.first.Get<uint64_t>());
+        }
+
+        return result;
+    }
+
+    std::vector<uint8_t> Bytes(const hal::FlashStub& flash, std::size_t start, std::size_t size)
+    {
+        return std::vector<uint8_t>(flash.sectors[0].begin() + start, flash.sectors[0].begin() + start + size);
+    }
+
+    static const std::size_t snapshotHeaderSize = 16;
+    static const std::size_t patchHeaderSize = 12;
+
+    services::Sha256MbedTls sha256;
+    hal::FlashStub flashFirst{ 1, 64 };
+    hal::FlashStub flashSecond{ 1, 64 };
+    infra::Optional<services::ConfigurationBlobJournalFlash::WithStorage<16, 8>> configurationBlob;
+};
+
+TEST_F(ConfigurationBlobJournalFlashTest, first_Write_stores_snapshot)
+{
+    Write({ { 1, 5 }, { 2, 6 } });
+
+    EXPECT_EQ((std::vector<uint8_t>{ 4, 0, 0, 0, 1, 0, 0, 0, 0x08, 5, 0x10, 6, 0xff }), Bytes(flashSecond, 8, 13));
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flashFirst.sectors[0]);
+}
+
+TEST_F(ConfigurationBlobJournalFlashTest, changed_field_is_appended_as_patch)
+{
+    Write({ { 1, 5 }, { 2, 6 } });
+    Write({ { 1, 5 }, { 2, 7 } });
+
+    EXPECT_EQ((std::vector<uint8_t>{ 4, 0, 0, 0, 0x12, 2, 0x10, 7, 0xff }), Bytes(flashSecond, snapshotHeaderSize + 4 + 8, 9));
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flashFirst.sectors[0]);
+}
+
+TEST_F(ConfigurationBlobJournalFlashTest, unchanged_contents_are_not_written)
+{
+    Write({ { 1, 5 }, { 2, 6 } });
+    Write({ { 1, 5 }, { 2, 6 } });
+
+    EXPECT_EQ(std::vector<uint8_t>(64 - snapshotHeaderSize - 4, 0xff), Bytes(flashSecond, snapshotHeaderSize + 4, 64 - snapshotHeaderSize - 4));
+}
+
+TEST_F(ConfigurationBlobJournalFlashTest, patches_are_replayed_on_recovery)
+{
+    Write({ { 1, 5 }, { 2, 6 } });
+    Write({ { 1, 5 }, { 2, 7 } });
+    Write({ { 2, 7 }, { 3, 8 } });
+
+    EXPECT_TRUE(Recover());
+    EXPECT_EQ((std::map<uint32_t, uint32_t>{ { 2, 7 }, { 3, 8 } }), Fields());
+
+    Write({ { 2, 9 }, { 3, 8 } });
+    EXPECT_TRUE(Recover());
+    EXPECT_EQ((std::map<uint32_t, uint32_t>{ { 2, 9 }, { 3, 8 } }), Fields());
+}
+
+TEST_F(ConfigurationBlobJournalFlashTest, full_journal_is_compacted_into_other_flash)
+{
+    Write({ { 1, 5 }, { 2, 0 } });
+
+    for (uint32_t i = 1; i != 4; ++i)
+        Write({ { 1, 5 }, { 2, i } });
+
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flashSecond.sectors[0]);
+    EXPECT_EQ((std::vector<uint8_t>{ 4, 0, 0, 0, 2, 0, 0, 0, 0x08, 5, 0x10, 3 }), Bytes(flashFirst, 8, 12));
+
+    EXPECT_TRUE(Recover());
+    EXPECT_EQ((std::map<uint32_t, uint32_t>{ { 1, 5 }, { 2, 3 } }), Fields());
+}
+
+TEST_F(ConfigurationBlobJournalFlashTest, interrupted_patch_is_ignored_and_next_Write_compacts)
+{
+    Write({ { 1, 5 }, { 2, 6 } });
+    Write({ { 1, 5 }, { 2, 7 } });
+    flashSecond.sectors[0][snapshotHeaderSize + 4 + patchHeaderSize + 3] = 0xff;
+
+    EXPECT_TRUE(Recover());
+    EXPECT_EQ((std::map<uint32_t, uint32_t>{ { 1, 5 }, { 2, 6 } }), Fields());
+
+    Write({ { 1, 5 }, { 2, 8 } });
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flashSecond.sectors[0]);
+
+    EXPECT_TRUE(Recover());
+    EXPECT_EQ((std::map<uint32_t, uint32_t>{ { 1, 5 }, { 2, 8 } }), Fields());
+}
+
+TEST_F(ConfigurationBlobJournalFlashTest, newest_snapshot_is_recovered_after_interrupted_compaction)
+{
+    Write({ { 1, 5 } });
+    auto oldSnapshot = flashSecond.sectors[0];
+
+    for (uint32_t i = 6; i != 9; ++i)
+        Write({ { 1, i } });
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flashSecond.sectors[0]);
+
+    flashSecond.sectors[0] = oldSnapshot;
+
+    EXPECT_TRUE(Recover());
+    EXPECT_EQ((std::map<uint32_t, uint32_t>{ { 1, 8 } }), Fields());
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flashSecond.sectors[0]);
+}
+
+class ConfigurationStoreJournalIntegrationTest
+    : public testing::Test
+    , public infra::EventDispatcherFixture
+{
+public:
+    struct Data
+    {
+        void Serialize(infra::ProtoFormatter& formatter)
+        {
+            formatter.PutVarIntField(a, 1);
+            formatter.PutVarIntField(b, 2);
+        }
+
+        void Deserialize(infra::ProtoParser& parser)
+        {
+            while (!parser.Empty())
+            {
+                auto field = parser.GetField();
+                if (field.second == 1)
+                    a = static_cast<uint32_t>(field.first.Get<uint64_t>());
+                else
+                    b = static_cast<uint32_t>(field.first.Get<uint64_t>());
+            }
+        }
+
+    public:
+        static const uint32_t maxMessageSize = 12;
+
+        uint32_t a = 0;
+        uint32_t b = 0;
+    };
+
+    void ConstructConfigurationStore(bool expectedSuccess)
+    {
+        infra::VerifyingFunctionMock<void(bool)> recovered(expectedSuccess);
+        configurationStore.Emplace(flashFirst, flashSecond, sha256, [&recovered](bool success)
+            { recovered.callback(success); });
+        ExecuteAllActions();
+    }
+
+    services::Sha256MbedTls sha256;
+    hal::FlashStub flashFirst{ 1, 64 };
+    hal::FlashStub flashSecond{ 1, 64 };
+    infra::Optional<services::ConfigurationStoreImpl<Data>::WithJournal<>> configurationStore;
+};
+
+TEST_F(ConfigurationStoreJournalIntegrationTest, configuration_is_written_as_patches_and_recovered)
+{
+    ConstructConfigurationStore(false);
+
+    configurationStore->Configuration().a = 1;
+    configurationStore->Write();
+    ExecuteAllActions();
+
+    configurationStore->Configuration().b = 2;
+    configurationStore->Write();
+    ExecuteAllActions();
+
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flashFirst.sectors[0]);
+
+    ConstructConfigurationStore(true);
+    EXPECT_EQ(1, configurationStore->Configuration().a);
+    EXPECT_EQ(2, configurationStore->Configuration().b);
+}
@@ -827,3 +827,204 @@ TEST_F(CyclicStoreTest, when_iterator_is_at_the_end_of_flash_newly_added_item_is
     cyclicStore.Add(KeepBytesAlive({ 21, 22, 23, 24, 25, 26 }), infra::emptyFunction);
     EXPECT_EQ((std::vector<uint8_t>{ 21, 22, 23, 24, 25, 26 }), Read(iterator));
 }
+
+TEST_F(CyclicStoreTest, ReadPrevious_reads_items_in_reverse_order)
+{
+    AddItem(KeepBytesAlive({ 1 }));
+    AddItem(KeepBytesAlive({ 2 }));
+    AddItem(KeepBytesAlive({ 3 }));
+
+    services::CyclicStore::Iterator iterator = cyclicStore.End();
+
+    std::vector<uint8_t> result;
+    std::array<uint8_t, 4> buffer;
+    auto readPrevious = [&]()
+    {
+        result.clear();
+        iterator.ReadPrevious(buffer, [&result](infra::ByteRange data)
+            { result.assign(data.begin(), data.end()); });
+        ExecuteAllActions();
+        return result;
+    };
+
+    EXPECT_EQ((std::vector<uint8_t>{ 3 }), readPrevious());
+    EXPECT_EQ((std::vector<uint8_t>{ 2 }), readPrevious());
+    EXPECT_EQ((std::vector<uint8_t>{ 1 }), readPrevious());
+    EXPECT_EQ((std::vector<uint8_t>{}), readPrevious());
+
+    EXPECT_EQ((std::vector<uint8_t>{ 1 }), Read(iterator));
+    EXPECT_EQ((std::vector<uint8_t>{ 2 }), Read(iterator));
+}
+
+TEST_F(CyclicStoreTest, Seek_positions_at_first_item_that_is_not_before)
+{
+    AddItem(KeepBytesAlive({ 1 }));
+    AddItem(KeepBytesAlive({ 2 }));
+    AddItem(KeepBytesAlive({ 3 }));
+
+    services::CyclicStore::Iterator iterator = cyclicStore.Begin();
+    std::array<uint8_t, 1> buffer;
+    infra::VerifyingFunctionMock<void()> done;
+    iterator.Seek(buffer, [](infra::ConstByteRange item)
+        { return item.front() < 2; },
+        [&done]()
+        { done.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_EQ((std::vector<uint8_t>{ 2 }), Read(iterator));
+    EXPECT_EQ((std::vector<uint8_t>{ 3 }), Read(iterator));
+}
+
+class CyclicStoreSectorSummaryTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    CyclicStoreSectorSummaryTest()
+    {
+        config.sectorSummaries = true;
+        ReConstructCyclicStore();
+    }
+
+    void ReConstructCyclicStore()
+    {
+        cyclicStore.Emplace(flash, config);
+        ExecuteAllActions();
+    }
+
+    void AddItems(uint8_t from, uint8_t to)
+    {
+        for (uint8_t i = from; i != to; ++i)
+        {
+            std::array<uint8_t, 4> item{ i, i, i, i };
+            cyclicStore->Add(item, infra::emptyFunction);
+            ExecuteAllActions();
+        }
+    }
+
+    std::vector<uint8_t> Read(services::CyclicStore::Iterator& iterator)
+    {
+        std::vector<uint8_t> result;
+        std::array<uint8_t, 4> buffer;
+
+        iterator.Read(buffer, [&result](infra::ByteRange data)
+            { result.assign(data.begin(), data.end()); });
+        ExecuteAllActions();
+
+        return result;
+    }
+
+    std::vector<uint8_t> ReadPrevious(services::CyclicStore::Iterator& iterator)
+    {
+        std::vector<uint8_t> result;
+        std::array<uint8_t, 4> buffer;
+
+        iterator.ReadPrevious(buffer, [&result](infra::ByteRange data)
+            { result.assign(data.begin(), data.end()); });
+        ExecuteAllActions();
+
+        return result;
+    }
+
+    bool SeekSequence(services::CyclicStore::Iterator& iterator, uint32_t sequence)
+    {
+        bool result = false;
+        iterator.SeekSequence(sequence, [&result](bool found)
+            { result = found; });
+        ExecuteAllActions();
+
+        return result;
+    }
+
+    std::vector<uint8_t> Item(uint8_t i)
+    {
+        return std::vector<uint8_t>{ i, i, i, i };
+    }
+
+    // Each sector holds three items of four bytes, followed by a summary of ten bytes
+    hal::FlashStub flash{ 4, 32 };
+    services::CyclicStore::Config config;
+    infra::Optional<services::CyclicStore> cyclicStore;
+};
+
+TEST_F(CyclicStoreSectorSummaryTest, summary_is_written_when_store_moves_to_next_sector)
+{
+    AddItems(0, 4);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0x7f, 0, 0, 0, 0, 3, 0, 0, 0, 0xfe }), std::vector<uint8_t>(flash.sectors[0].begin() + 22, flash.sectors[0].end()));
+    EXPECT_EQ(4, cyclicStore->NextSequence());
+}
+
+TEST_F(CyclicStoreSectorSummaryTest, sequence_and_items_are_recovered)
+{
+    AddItems(0, 7);
+    ReConstructCyclicStore();
+
+    EXPECT_EQ(7, cyclicStore->NextSequence());
+
+    auto iterator = cyclicStore->Begin();
+    for (uint8_t i = 0; i != 7; ++i)
+        EXPECT_EQ(Item(i), Read(iterator));
+    EXPECT_EQ(std::vector<uint8_t>{}, Read(iterator));
+}
+
+TEST_F(CyclicStoreSectorSummaryTest, SeekSequence_positions_at_item)
+{
+    AddItems(0, 7);
+    auto iterator = cyclicStore->Begin();
+
+    EXPECT_TRUE(SeekSequence(iterator, 4));
+    EXPECT_EQ(Item(4), Read(iterator));
+    EXPECT_EQ(Item(5), Read(iterator));
+
+    EXPECT_TRUE(SeekSequence(iterator, 0));
+    EXPECT_EQ(Item(0), Read(iterator));
+
+    EXPECT_TRUE(SeekSequence(iterator, 6));
+    EXPECT_EQ(Item(6), Read(iterator));
+
+    EXPECT_FALSE(SeekSequence(iterator, 7));
+}
+
+TEST_F(CyclicStoreSectorSummaryTest, sequence_continues_after_sectors_are_reused)
+{
+    AddItems(0, 20);
+    ReConstructCyclicStore();
+
+    EXPECT_EQ(20, cyclicStore->NextSequence());
+
+    auto iterator = cyclicStore->Begin();
+    auto oldest = Read(iterator);
+    ASSERT_FALSE(oldest.empty());
+
+    EXPECT_FALSE(SeekSequence(iterator, 0));
+    EXPECT_TRUE(SeekSequence(iterator, oldest.front()));
+    EXPECT_EQ(oldest, Read(iterator));
+
+    EXPECT_TRUE(SeekSequence(iterator, 19));
+    EXPECT_EQ(Item(19), Read(iterator));
+    EXPECT_EQ(std::vector<uint8_t>{}, Read(iterator));
+}
+
+TEST_F(CyclicStoreSectorSummaryTest, ReadPrevious_crosses_sectors_from_End)
+{
+    AddItems(0, 20);
+
+    auto iterator = cyclicStore->End();
+    for (uint8_t i = 19; i != 13; --i)
+        EXPECT_EQ(Item(i), ReadPrevious(iterator));
+}
+
+TEST_F(CyclicStoreSectorSummaryTest, Seek_binary_searches_sectors)
+{
+    AddItems(0, 11);
+
+    auto iterator = cyclicStore->Begin();
+    std::array<uint8_t, 1> buffer;
+    iterator.Seek(buffer, [](infra::ConstByteRange item)
+        { return item.front() < 8; },
+        infra::emptyFunction);
+    ExecuteAllActions();
+
+    EXPECT_EQ(Item(8), Read(iterator));
+}
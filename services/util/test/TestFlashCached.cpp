@@ -0,0 +1,247 @@
+#include "hal/interfaces/test_doubles/FlashStub.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
+#include "infra/util/test_helper/MockCallback.hpp"
+#include "services/util/FlashCached.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    class CountingFlashStub
+        : public hal::FlashStub
+    {
+    public:
+        using hal::FlashStub::FlashStub;
+
+        virtual void WriteBuffer(infra::ConstByteRange buffer, uint32_t address, infra::Function<void()> onDone) override
+        {
+            writes.push_back(std::make_pair(address, buffer.size()));
+            hal::FlashStub::WriteBuffer(buffer, address, onDone);
+        }
+
+        virtual void ReadBuffer(infra::ByteRange buffer, uint32_t address, infra::Function<void()> onDone) override
+        {
+            reads.push_back(std::make_pair(address, buffer.size()));
+            hal::FlashStub::ReadBuffer(buffer, address, onDone);
+        }
+
+        std::vector<std::pair<uint32_t, std::size_t>> writes;
+        std::vector<std::pair<uint32_t, std::size_t>> reads;
+    };
+}
+
+class FlashCachedTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    FlashCachedTest()
+    {
+        for (std::size_t sector = 0; sector != flash.sectors.size(); ++sector)
+            for (std::size_t i = 0; i != flash.sectors[sector].size(); ++i)
+                flash.sectors[sector][i] = static_cast<uint8_t>(sector * 64 + i);
+    }
+
+    std::vector<uint8_t> Read(uint32_t address, std::size_t size)
+    {
+        std::vector<uint8_t> result(size, 0);
+        infra::VerifyingFunctionMock<void()> done;
+        cached->ReadBuffer(infra::MakeRange(result), address, [&done]()
+            { done.callback(); });
+        ExecuteAllActions();
+        return result;
+    }
+
+    void Write(const std::vector<uint8_t>& data, uint32_t address)
+    {
+        infra::VerifyingFunctionMock<void()> done;
+        cached->WriteBuffer(infra::MakeRange(data), address, [&done]()
+            { done.callback(); });
+        ExecuteAllActions();
+    }
+
+    std::vector<uint8_t> Expected(uint32_t address, std::size_t size)
+    {
+        std::vector<uint8_t> result;
+        for (std::size_t i = 0; i != size; ++i)
+            result.push_back(static_cast<uint8_t>(address + i));
+        return result;
+    }
+
+    CountingFlashStub flash{ 2, 64 };
+    infra::Optional<services::FlashCached::WithStorage<3, 16>> cached{ infra::inPlace, flash };
+};
+
+TEST_F(FlashCachedTest, geometry_is_forwarded)
+{
+    EXPECT_EQ(2, cached->NumberOfSectors());
+    EXPECT_EQ(64, cached->SizeOfSector(1));
+    EXPECT_EQ(1, cached->SectorOfAddress(70));
+    EXPECT_EQ(64, cached->AddressOfSector(1));
+}
+
+TEST_F(FlashCachedTest, small_reads_within_a_page_cost_one_page_read)
+{
+    EXPECT_EQ(Expected(2, 2), Read(2, 2));
+    EXPECT_EQ(Expected(8, 4), Read(8, 4));
+    EXPECT_EQ(Expected(0, 16), Read(0, 16));
+
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 0, 16 } }), flash.reads);
+}
+
+TEST_F(FlashCachedTest, read_spanning_pages_loads_each_page_and_reads_ahead)
+{
+    EXPECT_EQ(Expected(70, 20), Read(70, 20));
+
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 64, 16 }, { 80, 16 }, { 96, 16 } }), flash.reads);
+}
+
+TEST_F(FlashCachedTest, sequential_miss_reads_ahead_next_page)
+{
+    Read(0, 4);
+    Read(16, 4);
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 0, 16 }, { 16, 16 }, { 32, 16 } }), flash.reads);
+
+    EXPECT_EQ(Expected(32, 4), Read(32, 4));
+    EXPECT_EQ(3, flash.reads.size());
+}
+
+TEST_F(FlashCachedTest, least_recently_used_page_is_evicted)
+{
+    Read(0, 1);
+    Read(64, 1);
+    Read(96, 1);
+    Read(0, 1);
+    Read(112, 1);
+
+    flash.reads.clear();
+    Read(0, 1);
+    Read(112, 1);
+    EXPECT_TRUE(flash.reads.empty());
+
+    Read(64, 1);
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 64, 16 } }), flash.reads);
+}
+
+TEST_F(FlashCachedTest, write_updates_cached_page)
+{
+    flash.sectors[0] = std::vector<uint8_t>(64, 0xff);
+    Read(0, 16);
+
+    Write({ 1, 2 }, 4);
+
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 4, 2 } }), flash.writes);
+    EXPECT_EQ((std::vector<uint8_t>{ 0xff, 1, 2, 0xff }), Read(3, 4));
+    EXPECT_EQ(1, flash.reads.size());
+}
+
+TEST_F(FlashCachedTest, repeated_write_to_cached_page_clears_bits_like_flash)
+{
+    flash.sectors[0] = std::vector<uint8_t>(64, 0xff);
+    Read(0, 16);
+
+    Write({ 0xf0, 0x0f }, 4);
+    Write({ 0x3c, 0x3c }, 4);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0x30, 0x0c }), Read(4, 2));
+    EXPECT_EQ((std::vector<uint8_t>{ 0x30, 0x0c }), std::vector<uint8_t>(flash.sectors[0].begin() + 4, flash.sectors[0].begin() + 6));
+    EXPECT_EQ(1, flash.reads.size());
+}
+
+TEST_F(FlashCachedTest, erase_invalidates_cached_pages)
+{
+    Read(64, 4);
+
+    infra::VerifyingFunctionMock<void()> done;
+    cached->EraseSectors(1, 2, [&done]()
+        { done.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_EQ(std::vector<uint8_t>(4, 0xff), Read(64, 4));
+    EXPECT_EQ(2, flash.reads.size());
+}
+
+class FlashCachedCombiningTest
+    : public FlashCachedTest
+{
+public:
+    FlashCachedCombiningTest()
+    {
+        flash.sectors[0] = std::vector<uint8_t>(64, 0xff);
+        cached.Emplace(flash, config);
+    }
+
+    services::FlashCached::Config config = MakeConfig();
+
+    static services::FlashCached::Config MakeConfig()
+    {
+        services::FlashCached::Config config;
+        config.combineWrites = true;
+        return config;
+    }
+};
+
+TEST_F(FlashCachedCombiningTest, adjacent_writes_are_programmed_together_after_flush_delay)
+{
+    Write({ 1, 2 }, 2);
+    Write({ 3 }, 4);
+    Write({ 4, 5 }, 5);
+    EXPECT_TRUE(flash.writes.empty());
+
+    ForwardTime(std::chrono::milliseconds(10));
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 2, 5 } }), flash.writes);
+    EXPECT_EQ((std::vector<uint8_t>{ 0xff, 1, 2, 3, 4, 5, 0xff }), std::vector<uint8_t>(flash.sectors[0].begin() + 1, flash.sectors[0].begin() + 8));
+}
+
+TEST_F(FlashCachedCombiningTest, flush_programs_pending_writes)
+{
+    Write({ 1, 2 }, 2);
+
+    infra::VerifyingFunctionMock<void()> done;
+    cached->Flush([&done]()
+        { done.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 2, 2 } }), flash.writes);
+}
+
+TEST_F(FlashCachedCombiningTest, full_page_is_programmed_immediately)
+{
+    Write(std::vector<uint8_t>(8, 1), 16);
+    Write(std::vector<uint8_t>(12, 2), 24);
+
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 16, 16 } }), flash.writes);
+
+    ForwardTime(std::chrono::milliseconds(10));
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 16, 16 }, { 32, 4 } }), flash.writes);
+    EXPECT_EQ((std::vector<uint8_t>{ 2, 2, 2, 2, 0xff }), std::vector<uint8_t>(flash.sectors[0].begin() + 32, flash.sectors[0].begin() + 37));
+}
+
+TEST_F(FlashCachedCombiningTest, non_adjacent_write_flushes_pending_data)
+{
+    Write({ 1 }, 2);
+    Write({ 2 }, 8);
+
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 2, 1 } }), flash.writes);
+}
+
+TEST_F(FlashCachedCombiningTest, repeated_write_to_cached_page_clears_bits_like_flash)
+{
+    Read(0, 16);
+
+    Write({ 0xf0, 0x0f }, 4);
+    Write({ 0x3c, 0x3c }, 4);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0x30, 0x0c }), Read(4, 2));
+    EXPECT_EQ(1, flash.reads.size());
+
+    ForwardTime(std::chrono::milliseconds(10));
+    EXPECT_EQ((std::vector<uint8_t>{ 0x30, 0x0c }), std::vector<uint8_t>(flash.sectors[0].begin() + 4, flash.sectors[0].begin() + 6));
+}
+
+TEST_F(FlashCachedCombiningTest, read_sees_pending_writes)
+{
+    Write({ 1, 2 }, 2);
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0xff, 1, 2, 0xff }), Read(1, 4));
+    EXPECT_EQ((std::vector<std::pair<uint32_t, std::size_t>>{ { 2, 2 } }), flash.writes);
+}
@@ -0,0 +1,137 @@
+#include "hal/interfaces/test_doubles/FlashMock.hpp"
+#include "infra/event/test_helper/EventDispatcherFixture.hpp"
+#include "infra/util/test_helper/MockCallback.hpp"
+#include "services/util/FlashPrioritizedAccess.hpp"
+#include "gtest/gtest.h"
+
+class FlashPrioritizedAccessTest
+    : public testing::Test
+    , public infra::EventDispatcherFixture
+{
+public:
+    static services::FlashPrioritizedAccessMaster::Config MakeConfig()
+    {
+        services::FlashPrioritizedAccessMaster::Config config;
+        config.sliceSize = 4;
+        return config;
+    }
+
+    void Done()
+    {
+        flash.done();
+        ExecuteAllActions();
+    }
+
+    testing::StrictMock<hal::FlashMock> flash{ 4, 16 };
+    services::FlashPrioritizedAccessMaster master{ flash, MakeConfig() };
+    services::FlashPrioritizedAccess background{ master, 0 };
+    services::FlashPrioritizedAccess foreground{ master, 1 };
+    services::FlashPrioritizedAccess otherBackground{ master, 0 };
+};
+
+TEST_F(FlashPrioritizedAccessTest, geometry_is_forwarded)
+{
+    EXPECT_EQ(4, foreground.NumberOfSectors());
+    EXPECT_EQ(16, foreground.SizeOfSector(0));
+    EXPECT_EQ(2, foreground.SectorOfAddress(32));
+    EXPECT_EQ(48, foreground.AddressOfSector(3));
+}
+
+TEST_F(FlashPrioritizedAccessTest, read_is_split_in_slices)
+{
+    std::array<uint8_t, 6> buffer;
+    infra::VerifyingFunctionMock<void()> done;
+
+    EXPECT_CALL(flash, readBufferMock(2)).WillOnce(testing::Return(std::vector<uint8_t>{ 1, 2 }));
+    foreground.ReadBuffer(buffer, 2, [&done]()
+        { done.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_CALL(flash, readBufferMock(4)).WillOnce(testing::Return(std::vector<uint8_t>{ 3, 4, 5, 6 }));
+    Done();
+    Done();
+
+    EXPECT_EQ((std::array<uint8_t, 6>{ 1, 2, 3, 4, 5, 6 }), buffer);
+}
+
+TEST_F(FlashPrioritizedAccessTest, erase_is_split_in_sectors)
+{
+    infra::VerifyingFunctionMock<void()> done;
+
+    EXPECT_CALL(flash, eraseSectorsMock(0, 1));
+    background.EraseSectors(0, 2, [&done]()
+        { done.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_CALL(flash, eraseSectorsMock(1, 2));
+    Done();
+    Done();
+}
+
+TEST_F(FlashPrioritizedAccessTest, high_priority_read_interleaves_with_long_erase)
+{
+    infra::MockCallback<void()> eraseDone;
+    infra::MockCallback<void()> readDone;
+    std::array<uint8_t, 2> buffer;
+
+    EXPECT_CALL(flash, eraseSectorsMock(0, 1));
+    background.EraseSectors(0, 3, [&eraseDone]()
+        { eraseDone.callback(); });
+    foreground.ReadBuffer(buffer, 40, [&readDone]()
+        { readDone.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_CALL(flash, readBufferMock(40)).WillOnce(testing::Return(std::vector<uint8_t>{ 1, 2 }));
+    Done();
+
+    testing::InSequence s;
+    EXPECT_CALL(readDone, callback());
+    EXPECT_CALL(flash, eraseSectorsMock(1, 2));
+    Done();
+
+    EXPECT_CALL(flash, eraseSectorsMock(2, 3));
+    Done();
+    EXPECT_CALL(eraseDone, callback());
+    Done();
+}
+
+TEST_F(FlashPrioritizedAccessTest, clients_of_equal_priority_are_served_round_robin)
+{
+    std::vector<uint8_t> data1{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::vector<uint8_t> data2{ 9, 10, 11, 12, 13, 14, 15, 16 };
+
+    testing::InSequence s;
+    EXPECT_CALL(flash, writeBufferMock(std::vector<uint8_t>{ 1, 2, 3, 4 }, 0));
+    background.WriteBuffer(data1, 0, infra::emptyFunction);
+    otherBackground.WriteBuffer(data2, 16, infra::emptyFunction);
+    ExecuteAllActions();
+
+    EXPECT_CALL(flash, writeBufferMock(std::vector<uint8_t>{ 9, 10, 11, 12 }, 16));
+    Done();
+    EXPECT_CALL(flash, writeBufferMock(std::vector<uint8_t>{ 5, 6, 7, 8 }, 4));
+    Done();
+    EXPECT_CALL(flash, writeBufferMock(std::vector<uint8_t>{ 13, 14, 15, 16 }, 20));
+    Done();
+    Done();
+}
+
+TEST_F(FlashPrioritizedAccessTest, next_operation_may_be_started_from_completion)
+{
+    struct
+    {
+        std::array<uint8_t, 1> buffer;
+        infra::VerifyingFunctionMock<void()> done;
+    } second;
+
+    EXPECT_CALL(flash, readBufferMock(0)).WillOnce(testing::Return(std::vector<uint8_t>{ 1 }));
+    foreground.ReadBuffer(second.buffer, 0, [this, &second]()
+        { foreground.ReadBuffer(second.buffer, 8, [&second]()
+              { second.done.callback(); }); });
+    ExecuteAllActions();
+
+    EXPECT_CALL(flash, readBufferMock(8)).WillOnce(testing::Return(std::vector<uint8_t>{ 2 }));
+    Done();
+    Done();
+
+    EXPECT_EQ(2, second.buffer[0]);
+}
@@ -241,3 +241,83 @@ TEST_F(FlashQuadSpiCypressFllTest, EraseAllErasesChip)
         { finished.callback(); });
     ExecuteAllActions();
 }
+
+class FlashQuadSpiCypressFllContinuousReadTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    FlashQuadSpiCypressFllContinuousReadTest()
+        : flash(spiStub, onInitialized, 4096, services::FlashQuadSpi::QuadIoFastRead(8, true, hal::QuadSpi::Lines::QuadSpeed()))
+    {
+        EXPECT_CALL(spiStub, SendDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiCypressFll::commandEnterQpi), {}, {}, 0 },
+                                 infra::ConstByteRange(), hal::QuadSpi::Lines::SingleSpeed()));
+
+        ForwardTime(std::chrono::milliseconds(100));
+        testing::Mock::VerifyAndClear(&spiStub);
+        testing::Mock::VerifyAndClear(&onInitialized);
+
+        EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiCypressFll::commandReadData), hal::QuadSpi::AddressToVector(0xa0, 4), {}, 8 }, hal::QuadSpi::Lines::QuadSpeed()))
+            .WillOnce(testing::Return(infra::MakeByteRange(receiveData)));
+        flash.ReadBuffer(readBuffer, 0, infra::emptyFunction);
+        ExecuteAllActions();
+    }
+
+    void ExpectExitContinuousRead()
+    {
+        EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::none, hal::QuadSpi::AddressToVector(0, 4), {}, 8 }, hal::QuadSpi::Lines::QuadSpeed()))
+            .WillOnce(testing::Return(infra::MakeByteRange(receiveData)));
+    }
+
+    testing::StrictMock<hal::QuadSpiStub> spiStub;
+    infra::VerifyingFunctionMock<void()> onInitialized;
+    services::FlashQuadSpiCypressFll flash;
+
+    std::array<uint8_t, 1> receiveData = { 1 };
+    std::array<uint8_t, 1> readBuffer;
+    testing::StrictMock<infra::MockCallback<void()>> finished;
+};
+
+TEST_F(FlashQuadSpiCypressFllContinuousReadTest, ContinuousReadIsExitedBeforeReadFlashId)
+{
+    testing::InSequence s;
+    std::array<uint8_t, 4> flashId = { 1, 2, 3, 4 };
+    ExpectExitContinuousRead();
+    EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiCypressFll::commandReadUniqueId), {}, {}, 16 }, hal::QuadSpi::Lines::QuadSpeed()))
+        .WillOnce(testing::Return(infra::MakeByteRange(flashId)));
+    EXPECT_CALL(finished, callback());
+
+    std::array<uint8_t, 4> buffer;
+    flash.ReadFlashId(buffer, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_EQ(flashId, buffer);
+}
+
+TEST_F(FlashQuadSpiCypressFllContinuousReadTest, ContinuousReadIsExitedBeforeSwitchToSingleSpeed)
+{
+    testing::InSequence s;
+    ExpectExitContinuousRead();
+    EXPECT_CALL(spiStub, SendDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiCypressFll::commandExitQpi), {}, {}, 0 }, infra::ConstByteRange(), hal::QuadSpi::Lines::QuadSpeed()));
+    EXPECT_CALL(finished, callback());
+
+    flash.SwitchToSingleSpeed([this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+}
+
+TEST_F(FlashQuadSpiCypressFllContinuousReadTest, ContinuousReadIsExitedOnlyOnce)
+{
+    std::array<uint8_t, 4> flashId = { 1, 2, 3, 4 };
+    ExpectExitContinuousRead();
+    EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiCypressFll::commandReadUniqueId), {}, {}, 16 }, hal::QuadSpi::Lines::QuadSpeed()))
+        .Times(2)
+        .WillRepeatedly(testing::Return(infra::MakeByteRange(flashId)));
+
+    std::array<uint8_t, 4> buffer;
+    flash.ReadFlashId(buffer, infra::emptyFunction);
+    ExecuteAllActions();
+    flash.ReadFlashId(buffer, infra::emptyFunction);
+    ExecuteAllActions();
+}
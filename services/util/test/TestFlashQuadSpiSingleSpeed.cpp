@@ -238,3 +238,75 @@ TEST_F(FlashQuadSpiSingleSpeedTest, EraseAllErasesChip)
         { finished.callback(); });
     ExecuteAllActions();
 }
+
+class FlashQuadSpiSingleSpeedFastReadTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    testing::StrictMock<hal::QuadSpiStub> spiStub;
+    infra::MockCallback<void()> onInitialized;
+    testing::StrictMock<infra::MockCallback<void()>> finished;
+};
+
+TEST_F(FlashQuadSpiSingleSpeedFastReadTest, QuadOutputFastReadUsesDummyCyclesAndFourDataLines)
+{
+    services::FlashQuadSpiSingleSpeed flash(spiStub, [this]()
+        { onInitialized.callback(); }, 4096, services::FlashQuadSpi::QuadOutputFastRead(8));
+
+    std::array<uint8_t, 4> receiveData = { 1, 2, 3, 4 };
+    EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpi::commandQuadOutputFastRead), hal::QuadSpi::AddressToVector(0x123456, 3), {}, 8 }, hal::QuadSpi::Lines::MixedSpeed(1, 1, 4)))
+        .WillOnce(testing::Return(infra::MakeByteRange(receiveData)));
+    EXPECT_CALL(finished, callback());
+
+    std::array<uint8_t, 4> buffer;
+    flash.ReadBuffer(buffer, 0x123456, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_EQ(receiveData, buffer);
+}
+
+TEST_F(FlashQuadSpiSingleSpeedFastReadTest, ContinuousReadOmitsInstructionAfterFirstRead)
+{
+    services::FlashQuadSpiSingleSpeed flash(spiStub, [this]()
+        { onInitialized.callback(); }, 4096, services::FlashQuadSpi::QuadIoFastRead(4, true));
+
+    std::array<uint8_t, 4> receiveData = { 1, 2, 3, 4 };
+    EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpi::commandQuadIoFastRead), hal::QuadSpi::AddressToVector(0x123456a0, 4), {}, 4 }, hal::QuadSpi::Lines::MixedSpeed(1, 4, 4)))
+        .WillOnce(testing::Return(infra::MakeByteRange(receiveData)));
+    EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::none, hal::QuadSpi::AddressToVector(0x123458a0, 4), {}, 4 }, hal::QuadSpi::Lines::MixedSpeed(1, 4, 4)))
+        .WillOnce(testing::Return(infra::MakeByteRange(receiveData)));
+    EXPECT_CALL(finished, callback()).Times(2);
+
+    std::array<uint8_t, 4> buffer;
+    flash.ReadBuffer(buffer, 0x123456, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+    flash.ReadBuffer(buffer, 0x123458, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+}
+
+TEST_F(FlashQuadSpiSingleSpeedFastReadTest, ContinuousReadIsExitedBeforeWrite)
+{
+    services::FlashQuadSpiSingleSpeed flash(spiStub, [this]()
+        { onInitialized.callback(); }, 4096, services::FlashQuadSpi::QuadIoFastRead(4, true));
+
+    std::array<uint8_t, 1> receiveData = { 1 };
+    EXPECT_CALL(spiStub, ReceiveDataMock(testing::_, testing::_)).WillOnce(testing::Return(infra::MakeByteRange(receiveData)));
+    std::array<uint8_t, 1> buffer;
+    flash.ReadBuffer(buffer, 0, infra::emptyFunction);
+    ExecuteAllActions();
+
+    testing::InSequence s;
+    const std::array<uint8_t, 4> sendData = { 1, 2, 3, 4 };
+    EXPECT_CALL(spiStub, ReceiveDataMock(hal::QuadSpi::Header{ infra::none, hal::QuadSpi::AddressToVector(0, 4), {}, 4 }, hal::QuadSpi::Lines::MixedSpeed(1, 4, 4)))
+        .WillOnce(testing::Return(infra::MakeByteRange(receiveData)));
+    EXPECT_CALL(spiStub, SendDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiSingleSpeed::commandWriteEnable), {}, {}, 0 }, infra::ConstByteRange(), hal::QuadSpi::Lines::SingleSpeed()));
+    EXPECT_CALL(spiStub, SendDataMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiSingleSpeed::commandPageProgram), hal::QuadSpi::AddressToVector(0, 3), {}, 0 }, infra::MakeByteRange(sendData), hal::QuadSpi::Lines::SingleSpeed()));
+    EXPECT_CALL(spiStub, PollStatusMock(hal::QuadSpi::Header{ infra::MakeOptional(services::FlashQuadSpiSingleSpeed::commandReadStatusRegister), {}, {}, 0 }, 1, 0, 1, hal::QuadSpi::Lines::SingleSpeed()));
+
+    flash.WriteBuffer(sendData, 0, infra::emptyFunction);
+    ExecuteAllActions();
+}
@@ -276,3 +276,137 @@ TEST_F(FlashSpiTest, EraseAllErasesBulk)
         { finished.callback(); });
     ExecuteAllActions();
 }
+
+class FlashSpiConfiguredTest
+    : public FlashSpiTest
+{
+public:
+    void ExpectReadStatus(uint8_t status)
+    {
+        EXPECT_CALL(spiMock, SendDataMock(CreateInstruction(services::FlashSpi::commandReadStatusRegister), hal::SpiAction::continueSession));
+        EXPECT_CALL(spiMock, ReceiveDataMock(hal::SpiAction::stop)).WillOnce(testing::Return(std::vector<uint8_t>{ status }));
+    }
+
+    std::vector<uint8_t> CreateExtendedInstructionAndAddress(uint8_t instruction, uint32_t address)
+    {
+        return std::vector<uint8_t>{ instruction, static_cast<uint8_t>(address >> 24), static_cast<uint8_t>(address >> 16), static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address) };
+    }
+
+    std::vector<uint8_t> CreateDwords(const std::vector<uint32_t>& dwords)
+    {
+        std::vector<uint8_t> result;
+        for (auto dword : dwords)
+            for (auto i = 0; i != 4; ++i)
+                result.push_back(static_cast<uint8_t>(dword >> (8 * i)));
+        return result;
+    }
+
+    services::FlashSpi::Config config;
+};
+
+TEST_F(FlashSpiConfiguredTest, extended_addressing_uses_4_byte_instructions)
+{
+    config.extendedAddressing = true;
+    services::FlashSpi extendedFlash(spiMock, config);
+
+    EXPECT_CALL(spiMock, SendDataMock(CreateExtendedInstructionAndAddress(services::FlashSpi::commandReadData4Byte, 0x01234567), hal::SpiAction::continueSession));
+    EXPECT_CALL(spiMock, ReceiveDataMock(hal::SpiAction::stop)).WillOnce(testing::Return(std::vector<uint8_t>{ 1 }));
+
+    std::vector<uint8_t> buffer(1, 0);
+    extendedFlash.ReadBuffer(buffer, 0x01234567, infra::emptyFunction);
+    ExecuteAllActions();
+
+    testing::InSequence s;
+    EXPECT_CALL(spiMock, SendDataMock(CreateInstruction(services::FlashSpi::commandWriteEnable), hal::SpiAction::stop));
+    EXPECT_CALL(spiMock, SendDataMock(CreateExtendedInstructionAndAddress(services::FlashSpi::commandEraseSubSector4Byte, 0x01000000), hal::SpiAction::stop));
+    ExpectReadStatus(0);
+    EXPECT_CALL(finished, callback());
+
+    extendedFlash.EraseSectors(4096, 4097, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+}
+
+TEST_F(FlashSpiConfiguredTest, status_is_polled_immediately_while_within_typical_page_program_time)
+{
+    config.typicalPageProgramTime = std::chrono::microseconds(500);
+    services::FlashSpi tunedFlash(spiMock, config);
+
+    testing::InSequence s;
+    const std::vector<uint8_t> sendData = { 1, 2, 3, 4 };
+    EXPECT_CALL(spiMock, SendDataMock(CreateInstruction(services::FlashSpi::commandWriteEnable), hal::SpiAction::stop));
+    EXPECT_CALL(spiMock, SendDataMock(CreateInstructionAndAddress(services::FlashSpi::commandPageProgram, 0), hal::SpiAction::continueSession));
+    EXPECT_CALL(spiMock, SendDataMock(sendData, hal::SpiAction::stop));
+    ExpectReadStatus(1);
+    ExpectReadStatus(1);
+    ExpectReadStatus(0);
+    EXPECT_CALL(finished, callback());
+
+    tunedFlash.WriteBuffer(sendData, 0, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+}
+
+TEST_F(FlashSpiConfiguredTest, erase_is_polled_after_typical_time_and_then_with_backoff)
+{
+    config.typicalSubSectorEraseTime = std::chrono::milliseconds(10);
+    services::FlashSpi tunedFlash(spiMock, config);
+
+    EXPECT_CALL(spiMock, SendDataMock(CreateInstruction(services::FlashSpi::commandWriteEnable), hal::SpiAction::stop));
+    EXPECT_CALL(spiMock, SendDataMock(CreateInstructionAndAddress(services::FlashSpi::commandEraseSubSector, 0), hal::SpiAction::stop));
+    ExpectReadStatus(1);
+    tunedFlash.EraseSector(0, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+
+    ForwardTime(std::chrono::milliseconds(9));
+    ExpectReadStatus(1);
+    ForwardTime(std::chrono::milliseconds(1));
+    ExpectReadStatus(1);
+    ForwardTime(std::chrono::milliseconds(1));
+
+    ForwardTime(std::chrono::milliseconds(1));
+    ExpectReadStatus(0);
+    EXPECT_CALL(finished, callback());
+    ForwardTime(std::chrono::milliseconds(1));
+}
+
+TEST_F(FlashSpiConfiguredTest, parameters_are_discovered_from_sfdp)
+{
+    config.discoverParameters = true;
+
+    testing::InSequence s;
+    EXPECT_CALL(spiMock, SendDataMock(std::vector<uint8_t>{ services::FlashSpi::commandReadSfdp, 0, 0, 0, 0 }, hal::SpiAction::continueSession));
+    EXPECT_CALL(spiMock, ReceiveDataMock(hal::SpiAction::stop)).WillOnce(testing::Return(std::vector<uint8_t>{ 'S', 'F', 'D', 'P', 6, 1, 0, 0xff, 0, 6, 1, 11, 0x30, 0, 0, 0xff }));
+    EXPECT_CALL(spiMock, SendDataMock(std::vector<uint8_t>{ services::FlashSpi::commandReadSfdp, 0, 0, 0x30, 0 }, hal::SpiAction::continueSession));
+    EXPECT_CALL(spiMock, ReceiveDataMock(hal::SpiAction::stop)).WillOnce(testing::Return(CreateDwords({ 0x000220e5, 0x8000001c, 0, 0, 0, 0, 0, 0x520f200c, 0x0000d810, 0x00a40220, 0x49002a00 })));
+    EXPECT_CALL(finished, callback());
+
+    services::FlashSpi discoveredFlash(spiMock, config, infra::systemTimerServiceId, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_EQ(8192, discoveredFlash.NumberOfSectors());
+    EXPECT_EQ(32 * 1024 * 1024, discoveredFlash.TotalSize());
+    EXPECT_TRUE(discoveredFlash.Parameters().extendedAddressing);
+    EXPECT_EQ(std::chrono::microseconds(704), discoveredFlash.Parameters().typicalPageProgramTime);
+    EXPECT_EQ(std::chrono::milliseconds(48), discoveredFlash.Parameters().typicalSubSectorEraseTime);
+    EXPECT_EQ(std::chrono::milliseconds(160), discoveredFlash.Parameters().typicalSectorEraseTime);
+    EXPECT_EQ(std::chrono::seconds(40), discoveredFlash.Parameters().typicalBulkEraseTime);
+}
+
+TEST_F(FlashSpiConfiguredTest, configuration_is_kept_without_valid_sfdp)
+{
+    config.discoverParameters = true;
+
+    EXPECT_CALL(spiMock, SendDataMock(std::vector<uint8_t>{ services::FlashSpi::commandReadSfdp, 0, 0, 0, 0 }, hal::SpiAction::continueSession));
+    EXPECT_CALL(spiMock, ReceiveDataMock(hal::SpiAction::stop)).WillOnce(testing::Return(std::vector<uint8_t>(16, 0xff)));
+    EXPECT_CALL(finished, callback());
+
+    services::FlashSpi discoveredFlash(spiMock, config, infra::systemTimerServiceId, [this]()
+        { finished.callback(); });
+    ExecuteAllActions();
+
+    EXPECT_EQ(512, discoveredFlash.NumberOfSectors());
+    EXPECT_FALSE(discoveredFlash.Parameters().extendedAddressing);
+}
@@ -0,0 +1,119 @@
+#include "hal/interfaces/test_doubles/FlashMock.hpp"
+#include "hal/interfaces/test_doubles/FlashStub.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
+#include "infra/util/test_helper/MockCallback.hpp"
+#include "services/util/FlashStatistics.hpp"
+#include "gtest/gtest.h"
+
+class FlashStatisticsTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    testing::StrictMock<hal::FlashMock> flash{ 8, 16 };
+    services::FlashStatistics::WithEraseCounters<8> statistics{ flash };
+};
+
+TEST_F(FlashStatisticsTest, geometry_is_forwarded)
+{
+    EXPECT_EQ(8, statistics.NumberOfSectors());
+    EXPECT_EQ(16, statistics.SizeOfSector(1));
+    EXPECT_EQ(1, statistics.SectorOfAddress(20));
+    EXPECT_EQ(32, statistics.AddressOfSector(2));
+}
+
+TEST_F(FlashStatisticsTest, read_is_counted_with_latency)
+{
+    std::array<uint8_t, 4> buffer;
+    infra::VerifyingFunctionMock<void()> done;
+
+    EXPECT_CALL(flash, readBufferMock(10)).WillOnce(testing::Return(std::vector<uint8_t>{ 1, 2, 3, 4 }));
+    statistics.ReadBuffer(buffer, 10, done);
+    ForwardTime(std::chrono::milliseconds(5));
+    flash.done();
+
+    auto snapshot = statistics.Statistics();
+    EXPECT_EQ(1, snapshot.read.count);
+    EXPECT_EQ(4, snapshot.read.bytes);
+    EXPECT_EQ(std::chrono::milliseconds(5), snapshot.read.maxLatency);
+    EXPECT_EQ((std::array<uint32_t, 6>{ 0, 0, 1, 0, 0, 0 }), snapshot.read.latencyHistogram);
+    EXPECT_EQ(0, snapshot.write.count);
+    EXPECT_EQ(0, snapshot.erase.count);
+}
+
+TEST_F(FlashStatisticsTest, writes_are_accumulated)
+{
+    std::array<uint8_t, 3> data{ 1, 2, 3 };
+
+    EXPECT_CALL(flash, writeBufferMock(std::vector<uint8_t>{ 1, 2, 3 }, 0));
+    statistics.WriteBuffer(data, 0, [] {});
+    flash.done();
+
+    EXPECT_CALL(flash, writeBufferMock(std::vector<uint8_t>{ 1, 2, 3 }, 3));
+    statistics.WriteBuffer(data, 3, [] {});
+    ForwardTime(std::chrono::seconds(2));
+    flash.done();
+
+    auto snapshot = statistics.Statistics();
+    EXPECT_EQ(2, snapshot.write.count);
+    EXPECT_EQ(6, snapshot.write.bytes);
+    EXPECT_EQ((std::array<uint32_t, 6>{ 1, 0, 0, 0, 0, 1 }), snapshot.write.latencyHistogram);
+}
+
+TEST_F(FlashStatisticsTest, erase_counts_sectors_and_bytes)
+{
+    EXPECT_CALL(flash, eraseSectorsMock(2, 4));
+    statistics.EraseSectors(2, 4, [] {});
+    flash.done();
+
+    EXPECT_CALL(flash, eraseSectorsMock(0, 8));
+    statistics.EraseAll([] {});
+    flash.done();
+
+    auto snapshot = statistics.Statistics();
+    EXPECT_EQ(2, snapshot.erase.count);
+    EXPECT_EQ(160, snapshot.erase.bytes);
+    EXPECT_EQ(1, snapshot.sectorsPerEraseCounter);
+    EXPECT_EQ((std::vector<uint32_t>{ 1, 1, 2, 2, 1, 1, 1, 1 }), (std::vector<uint32_t>(snapshot.eraseCounts.begin(), snapshot.eraseCounts.end())));
+}
+
+TEST_F(FlashStatisticsTest, erase_counters_cover_groups_of_sectors_when_storage_is_small)
+{
+    services::FlashStatistics::WithEraseCounters<3> grouped{ flash };
+
+    EXPECT_CALL(flash, eraseSectorsMock(2, 7));
+    grouped.EraseSectors(2, 7, [] {});
+    flash.done();
+
+    auto snapshot = grouped.Statistics();
+    EXPECT_EQ(3, snapshot.sectorsPerEraseCounter);
+    EXPECT_EQ((std::vector<uint32_t>{ 1, 3, 1 }), (std::vector<uint32_t>(snapshot.eraseCounts.begin(), snapshot.eraseCounts.end())));
+}
+
+TEST_F(FlashStatisticsTest, Reset_clears_statistics)
+{
+    EXPECT_CALL(flash, eraseSectorsMock(0, 1));
+    statistics.EraseSectors(0, 1, [] {});
+    flash.done();
+
+    statistics.Reset();
+
+    auto snapshot = statistics.Statistics();
+    EXPECT_EQ(0, snapshot.erase.count);
+    EXPECT_EQ(0, snapshot.eraseCounts[0]);
+}
+
+TEST(FlashStatistics64Test, counts_operations_on_64_bit_flash)
+{
+    infra::ClockFixture clock;
+    hal::FlashStub64 flash(4, 16);
+    services::FlashStatistics64::WithEraseCounters<4> statistics{ flash };
+
+    statistics.EraseSectors(1, 3, [] {});
+    clock.ExecuteAllActions();
+
+    auto snapshot = statistics.Statistics();
+    EXPECT_EQ(1, snapshot.erase.count);
+    EXPECT_EQ(32, snapshot.erase.bytes);
+    EXPECT_EQ((std::vector<uint32_t>{ 0, 1, 1, 0 }), (std::vector<uint32_t>(snapshot.eraseCounts.begin(), snapshot.eraseCounts.end())));
+}
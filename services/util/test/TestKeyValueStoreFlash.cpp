@@ -0,0 +1,317 @@
+#include "hal/interfaces/test_doubles/FlashStub.hpp"
+#include "infra/timer/test_helper/ClockFixture.hpp"
+#include "infra/util/test_helper/MockCallback.hpp"
+#include "services/util/KeyValueStoreFlash.hpp"
+#include "gtest/gtest.h"
+#include <functional>
+#include <set>
+
+class KeyValueStoreFlashTest
+    : public testing::Test
+    , public infra::ClockFixture
+{
+public:
+    KeyValueStoreFlashTest()
+    {
+        ConstructStore();
+    }
+
+    void ConstructStore()
+    {
+        store.Emplace(flash);
+        ExecuteAllActions();
+    }
+
+    void Write(uint32_t key, const std::vector<uint8_t>& value, bool success = true)
+    {
+        infra::VerifyingFunctionMock<void(bool)> done(success);
+        store->Write(key, infra::MakeRange(value), [&done](bool success)
+            { done.callback(success); });
+        ExecuteAllActions();
+    }
+
+    void Remove(uint32_t key)
+    {
+        infra::VerifyingFunctionMock<void()> done;
+        store->Remove(key, [&done]()
+            { done.callback(); });
+        ExecuteAllActions();
+    }
+
+    std::vector<uint8_t> Read(uint32_t key)
+    {
+        std::vector<uint8_t> result;
+        std::array<uint8_t, 16> buffer;
+
+        store->Read(key, buffer, [&result](infra::ByteRange value)
+            { result.assign(value.begin(), value.end()); });
+        ExecuteAllActions();
+
+        return result;
+    }
+
+    void ExecuteActionsUntil(const std::function<bool()>& condition)
+    {
+        while (!condition() && !IsIdle())
+            ExecuteFirstAction();
+
+        ASSERT_TRUE(condition());
+    }
+
+    void FillFirstSectors()
+    {
+        // Sector 0 holds key 1 and key 2, sector 1 holds two updates of key 2. Another update of key 2 opens sector 2,
+        // after which sector 0 is garbage collected: key 1 is copied to sector 2, and sector 0 is erased.
+        Write(1, std::vector<uint8_t>(16, 1));
+        Write(2, std::vector<uint8_t>(16, 2));
+        Write(2, std::vector<uint8_t>(16, 3));
+        Write(2, std::vector<uint8_t>(16, 4));
+    }
+
+    hal::FlashStub flash{ 4, 64 };
+    infra::Optional<services::KeyValueStoreFlash::WithStorage<4, 16>> store;
+};
+
+TEST_F(KeyValueStoreFlashTest, empty_store_contains_nothing)
+{
+    EXPECT_FALSE(store->Contains(1));
+    EXPECT_EQ(std::vector<uint8_t>{}, Read(1));
+    EXPECT_EQ(16, store->MaxValueSize());
+    EXPECT_EQ(60, store->Capacity());
+}
+
+TEST_F(KeyValueStoreFlashTest, written_value_is_read_back)
+{
+    Write(1, { 5, 6, 7 });
+
+    EXPECT_TRUE(store->Contains(1));
+    EXPECT_EQ(3, store->ValueSize(1));
+    EXPECT_EQ((std::vector<uint8_t>{ 5, 6, 7 }), Read(1));
+}
+
+TEST_F(KeyValueStoreFlashTest, write_appends_record_after_sector_header)
+{
+    Write(0x04030201, { 5, 6 });
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0xfe, 0, 0, 0xfe, 1, 2, 3, 4, 2, 0 }), std::vector<uint8_t>(flash.sectors[0].begin(), flash.sectors[0].begin() + 10));
+    EXPECT_EQ((std::vector<uint8_t>{ 5, 6, 0xff }), std::vector<uint8_t>(flash.sectors[0].begin() + 12, flash.sectors[0].begin() + 15));
+}
+
+TEST_F(KeyValueStoreFlashTest, update_appends_new_record)
+{
+    Write(1, { 5 });
+    Write(1, { 6, 7 });
+
+    EXPECT_EQ((std::vector<uint8_t>{ 6, 7 }), Read(1));
+    EXPECT_EQ(0xfe, flash.sectors[0][3 + 10]);
+    EXPECT_EQ(0xff, flash.sectors[0][3 + 10 + 11]);
+}
+
+TEST_F(KeyValueStoreFlashTest, removed_key_is_not_found)
+{
+    Write(1, { 5 });
+    Write(2, { 6 });
+    Remove(1);
+
+    EXPECT_FALSE(store->Contains(1));
+    EXPECT_EQ(std::vector<uint8_t>{}, Read(1));
+    EXPECT_EQ(std::vector<uint8_t>{ 6 }, Read(2));
+}
+
+TEST_F(KeyValueStoreFlashTest, removing_absent_key_does_not_write)
+{
+    Remove(1);
+
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flash.sectors[0]);
+}
+
+TEST_F(KeyValueStoreFlashTest, values_are_recovered)
+{
+    Write(1, { 5 });
+    Write(2, { 6, 7 });
+    Write(1, { 8 });
+    Remove(2);
+
+    ConstructStore();
+
+    EXPECT_EQ(std::vector<uint8_t>{ 8 }, Read(1));
+    EXPECT_FALSE(store->Contains(2));
+
+    Write(3, { 9 });
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>{ 9 }, Read(3));
+}
+
+TEST_F(KeyValueStoreFlashTest, interrupted_record_is_ignored_on_recovery)
+{
+    Write(1, { 5 });
+    Write(1, { 6, 7 });
+    flash.sectors[0][3 + 10 + 10] = 0xff;
+
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>{ 5 }, Read(1));
+
+    Write(2, { 8 });
+    EXPECT_EQ(0xfe, flash.sectors[1][0]);
+
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>{ 5 }, Read(1));
+    EXPECT_EQ(std::vector<uint8_t>{ 8 }, Read(2));
+}
+
+TEST_F(KeyValueStoreFlashTest, garbage_collection_copies_live_records_and_erases_oldest_sector)
+{
+    Write(1, { 1 });
+
+    for (uint8_t i = 0; i != 20; ++i)
+        Write(2, { i });
+
+    EXPECT_EQ(std::vector<uint8_t>{ 1 }, Read(1));
+    EXPECT_EQ(std::vector<uint8_t>{ 19 }, Read(2));
+    EXPECT_FALSE(store->GarbageCollecting());
+
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>{ 1 }, Read(1));
+    EXPECT_EQ(std::vector<uint8_t>{ 19 }, Read(2));
+}
+
+TEST_F(KeyValueStoreFlashTest, sectors_are_used_cyclically)
+{
+    std::set<std::size_t> usedSectors;
+
+    for (uint8_t i = 0; i != 60; ++i)
+    {
+        Write(i % 3, { i });
+
+        if (i % 7 == 0)
+            ConstructStore();
+
+        for (std::size_t sector = 0; sector != flash.sectors.size(); ++sector)
+            if (flash.sectors[sector][0] != 0xff)
+                usedSectors.insert(sector);
+    }
+
+    EXPECT_EQ(std::vector<uint8_t>{ 57 }, Read(0));
+    EXPECT_EQ(std::vector<uint8_t>{ 58 }, Read(1));
+    EXPECT_EQ(std::vector<uint8_t>{ 59 }, Read(2));
+    EXPECT_EQ(4, usedSectors.size());
+}
+
+TEST_F(KeyValueStoreFlashTest, write_waits_while_garbage_collection_needs_remaining_space)
+{
+    FillFirstSectors();
+
+    // Writing value 5 starts garbage collection of the first sector, which copies key 1 to the head sector. The
+    // head sector then has no room for value 6, and the last empty sector is reserved for garbage collection.
+    std::vector<uint8_t> value5(16, 5);
+    struct
+    {
+        std::vector<uint8_t> value = std::vector<uint8_t>(16, 6);
+        infra::VerifyingFunctionMock<void(bool)> done{ true };
+    } second;
+
+    store->Write(2, infra::MakeRange(value5), [this, &second](bool success)
+        {
+            EXPECT_TRUE(store->GarbageCollecting());
+            store->Write(2, infra::MakeRange(second.value), [&second](bool success)
+                { second.done.callback(success); });
+        });
+    ExecuteAllActions();
+
+    EXPECT_EQ(std::vector<uint8_t>(16, 1), Read(1));
+    EXPECT_EQ(second.value, Read(2));
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flash.sectors[0]);
+
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>(16, 1), Read(1));
+    EXPECT_EQ(second.value, Read(2));
+}
+
+TEST_F(KeyValueStoreFlashTest, write_fails_when_values_exceed_capacity)
+{
+    Write(1, std::vector<uint8_t>(16, 1));
+    Write(2, std::vector<uint8_t>(16, 2));
+    Write(3, { 3 });
+    Write(4, {}, false);
+    Write(3, { 3, 3 }, false);
+
+    EXPECT_FALSE(store->Contains(4));
+    EXPECT_EQ(std::vector<uint8_t>{ 3 }, Read(3));
+
+    Write(3, { 4 });
+    EXPECT_EQ(std::vector<uint8_t>{ 4 }, Read(3));
+
+    Remove(1);
+    Write(4, {});
+    EXPECT_TRUE(store->Contains(4));
+}
+
+TEST_F(KeyValueStoreFlashTest, write_of_new_key_fails_when_all_keys_are_in_use)
+{
+    for (uint8_t key = 0; key != 4; ++key)
+        Write(key, { key });
+
+    Write(4, { 4 }, false);
+    EXPECT_FALSE(store->Contains(4));
+
+    Write(3, { 5 });
+    EXPECT_EQ(std::vector<uint8_t>{ 5 }, Read(3));
+}
+
+TEST_F(KeyValueStoreFlashTest, values_are_recovered_after_power_loss_during_garbage_collection_copy)
+{
+    FillFirstSectors();
+
+    std::vector<uint8_t> value5(16, 5);
+    store->Write(2, infra::MakeRange(value5), [](bool success) {});
+
+    // The copy of key 1 is the second record in sector 2; its programming is interrupted before the last value byte
+    auto copyAddress = 3 + 25;
+    ExecuteActionsUntil([this, copyAddress]()
+        { return flash.sectors[2][copyAddress] != 0xff; });
+    auto image = flash.sectors;
+    image[2][copyAddress + 24] = 0xff;
+    ExecuteAllActions();
+
+    flash.sectors = image;
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>(16, 1), Read(1));
+    EXPECT_EQ(value5, Read(2));
+
+    Write(3, { 3 });
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>(16, 1), Read(1));
+    EXPECT_EQ(value5, Read(2));
+    EXPECT_EQ(std::vector<uint8_t>{ 3 }, Read(3));
+}
+
+TEST_F(KeyValueStoreFlashTest, values_are_recovered_after_power_loss_during_sector_erase)
+{
+    FillFirstSectors();
+
+    std::vector<uint8_t> value5(16, 5);
+    store->Write(2, infra::MakeRange(value5), [](bool success) {});
+
+    auto collectedSector = flash.sectors[0];
+    ExecuteActionsUntil([this]()
+        { return flash.sectors[0][0] == 0xff; });
+    ExecuteAllActions();
+
+    // The interrupted erase cleared the sector header, but left the records of sector 0 in place
+    auto image = flash.sectors;
+    image[0] = collectedSector;
+    std::fill(image[0].begin(), image[0].begin() + 3, 0xff);
+
+    flash.sectors = image;
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>(64, 0xff), flash.sectors[0]);
+    EXPECT_EQ(std::vector<uint8_t>(16, 1), Read(1));
+    EXPECT_EQ(value5, Read(2));
+
+    for (uint8_t i = 6; i != 10; ++i)
+        Write(2, std::vector<uint8_t>(16, i));
+
+    ConstructStore();
+    EXPECT_EQ(std::vector<uint8_t>(16, 1), Read(1));
+    EXPECT_EQ(std::vector<uint8_t>(16, 9), Read(2));
+}
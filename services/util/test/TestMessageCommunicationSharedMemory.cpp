@@ -0,0 +1,132 @@
+#include "infra/stream/ByteInputStream.hpp"
+#include "infra/stream/ByteOutputStream.hpp"
+#include "services/util/MessageCommunicationSharedMemory.hpp"
+#include "gmock/gmock.h"
+
+namespace
+{
+    class MessageCommunicationObserverMock
+        : public services::MessageCommunicationObserver
+    {
+    public:
+        using services::MessageCommunicationObserver::MessageCommunicationObserver;
+
+        MOCK_METHOD1(SendMessageStreamAvailable, void(infra::SharedPtr<infra::StreamWriter>&& writer));
+        MOCK_METHOD1(ReceivedMessage, void(infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader));
+    };
+}
+
+class MessageCommunicationSharedMemoryTest
+    : public testing::Test
+{
+public:
+    void Send(services::MessageCommunication& from, MessageCommunicationObserverMock& fromObserver, const std::vector<uint8_t>& message)
+    {
+        EXPECT_CALL(fromObserver, SendMessageStreamAvailable(testing::_)).WillOnce(testing::Invoke([&message](infra::SharedPtr<infra::StreamWriter>&& writer)
+            {
+                infra::DataOutputStream::WithErrorPolicy stream(*writer);
+                stream << infra::MakeRange(message);
+            }));
+        from.RequestSendMessage(static_cast<uint16_t>(message.size()));
+    }
+
+    void ExpectReceivedMessage(MessageCommunicationObserverMock& observer, const std::vector<uint8_t>& expected)
+    {
+        EXPECT_CALL(observer, ReceivedMessage(testing::_)).WillOnce(testing::Invoke([expected](infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader)
+            {
+                infra::DataInputStream::WithErrorPolicy stream(*reader);
+                std::vector<uint8_t> data(stream.Available(), 0);
+                stream >> infra::MakeRange(data);
+
+                EXPECT_EQ(expected, data);
+            }));
+    }
+
+    alignas(64) std::array<uint8_t, 128 + 32> memoryAToB{};
+    alignas(64) std::array<uint8_t, 128 + 32> memoryBToA{};
+    services::MessageCommunicationSharedMemory communicationA{ infra::MakeRange(memoryAToB), infra::MakeRange(memoryBToA) };
+    services::MessageCommunicationSharedMemory communicationB{ infra::MakeRange(memoryBToA), infra::MakeRange(memoryAToB) };
+    testing::StrictMock<MessageCommunicationObserverMock> observerA{ communicationA };
+    testing::StrictMock<MessageCommunicationObserverMock> observerB{ communicationB };
+};
+
+TEST_F(MessageCommunicationSharedMemoryTest, MaxSendMessageSize_fits_in_half_of_the_ring)
+{
+    EXPECT_EQ(12, communicationA.MaxSendMessageSize());
+}
+
+TEST_F(MessageCommunicationSharedMemoryTest, sent_message_is_received_by_peer_on_poll)
+{
+    Send(communicationA, observerA, { 1, 2, 3 });
+
+    ExpectReceivedMessage(observerB, { 1, 2, 3 });
+    communicationB.Poll();
+}
+
+TEST_F(MessageCommunicationSharedMemoryTest, messages_are_sent_in_both_directions)
+{
+    Send(communicationA, observerA, { 1, 2, 3 });
+    Send(communicationB, observerB, { 4, 5 });
+
+    ExpectReceivedMessage(observerA, { 4, 5 });
+    communicationA.Poll();
+    ExpectReceivedMessage(observerB, { 1, 2, 3 });
+    communicationB.Poll();
+}
+
+TEST_F(MessageCommunicationSharedMemoryTest, received_message_refers_to_shared_memory)
+{
+    Send(communicationA, observerA, { 1, 2, 3 });
+
+    EXPECT_CALL(observerB, ReceivedMessage(testing::_)).WillOnce(testing::Invoke([this](infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader)
+        {
+            auto range = reader->ExtractContiguousRange(3);
+            EXPECT_GE(range.begin(), memoryAToB.data());
+            EXPECT_LT(range.end(), memoryAToB.data() + memoryAToB.size());
+        }));
+    communicationB.Poll();
+}
+
+TEST_F(MessageCommunicationSharedMemoryTest, next_message_is_received_after_reader_is_released)
+{
+    Send(communicationA, observerA, { 1 });
+    Send(communicationA, observerA, { 2 });
+
+    infra::SharedPtr<infra::StreamReaderWithRewinding> savedReader;
+    EXPECT_CALL(observerB, ReceivedMessage(testing::_)).WillOnce(testing::Invoke([&savedReader](infra::SharedPtr<infra::StreamReaderWithRewinding>&& reader)
+        {
+            savedReader = std::move(reader);
+        }));
+    communicationB.Poll();
+    testing::Mock::VerifyAndClearExpectations(&observerB);
+
+    ExpectReceivedMessage(observerB, { 2 });
+    savedReader = nullptr;
+}
+
+TEST_F(MessageCommunicationSharedMemoryTest, send_waits_until_peer_frees_space)
+{
+    Send(communicationA, observerA, { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 });
+    Send(communicationA, observerA, { 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23 });
+    testing::Mock::VerifyAndClearExpectations(&observerA);
+
+    communicationA.RequestSendMessage(12);
+
+    {
+        testing::InSequence sequence;
+        ExpectReceivedMessage(observerB, { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 });
+        ExpectReceivedMessage(observerB, { 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23 });
+    }
+    communicationB.Poll();
+
+    std::vector<uint8_t> message{ 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35 };
+    EXPECT_CALL(observerA, SendMessageStreamAvailable(testing::_)).WillOnce(testing::Invoke([&message](infra::SharedPtr<infra::StreamWriter>&& writer)
+        {
+            infra::DataOutputStream::WithErrorPolicy stream(*writer);
+            stream << infra::MakeRange(message);
+        }));
+    communicationA.Poll();
+
+    ExpectReceivedMessage(observerB, message);
+    communicationB.Poll();
+}
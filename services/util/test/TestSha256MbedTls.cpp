@@ -0,0 +1,36 @@
+#include "services/util/Sha256MbedTls.hpp"
+#include "gtest/gtest.h"
+
+class Sha256MbedTlsTest
+    : public testing::Test
+{
+public:
+    services::Sha256MbedTls sha256;
+    const std::array<uint8_t, 32> abcDigest{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+};
+
+TEST_F(Sha256MbedTlsTest, Calculate_returns_digest)
+{
+    EXPECT_EQ(abcDigest, sha256.Calculate(infra::MakeStringByteRange("abc")));
+}
+
+TEST_F(Sha256MbedTlsTest, incremental_digest_equals_digest_of_complete_input)
+{
+    sha256.Init();
+    sha256.Update(infra::MakeStringByteRange("a"));
+    sha256.Update(infra::MakeStringByteRange("bc"));
+
+    EXPECT_EQ(abcDigest, sha256.Final());
+}
+
+TEST_F(Sha256MbedTlsTest, Init_restarts_digest)
+{
+    sha256.Init();
+    sha256.Update(infra::MakeStringByteRange("xyz"));
+
+    sha256.Init();
+    sha256.Update(infra::MakeStringByteRange("abc"));
+
+    EXPECT_EQ(abcDigest, sha256.Final());
+}